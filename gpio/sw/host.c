@@ -24,6 +24,18 @@
 // scan codes from the keyboard buffer, converts them to ASCII, and sends them
 // to the host CPU.
 //
+//   The ASCII characters don't go straight to the host - they go into a small
+// FIFO, and ServiceHost() hands them over one at a time as the host reads them.
+// ServiceHost() is a polled state machine that never waits, and it's called
+// every time WaitKey() looks for another scan code.  That way we can go on
+// translating scan codes while the host is busy (say, scrolling the screen)
+// and a burst of typing, or an arrow key's escape sequence, doesn't have to
+// fit in the keyboard's 16 byte scan code buffer.  We only wait for the host
+// when the FIFO itself is full.  In the DEBUG version the FIFO's high water
+// mark and the number of times it filled up, as well as the number of scan
+// code buffer overflows, are kept in g_bHostHighWater, g_wHostFull and
+// g_wKeyOverflows.
+//
 // PS2 to ASCII translation notes
 // ------------------------------
 //   All printing characters send their corresponding ASCII codes, as do TAB (0x09),
@@ -82,6 +94,12 @@
 //			  #ifdef options into external hardware jumpers that can
 //			  be changed at runtime.
 //			Don't call putchar() in SendHost() unless DEBUG is defined!
+// 17-Oct-26	RLA	Add the output FIFO and ServiceHost() so that we don't
+//			  have to wait for the host after every character.
+//			Count FIFO and scan code buffer overflows in DEBUG.
+//			Let HOSTBUFLEN be overridden (for tools/kbdsim).
+//			CAPS LOCK release fell off the end of DoShift().
+//			DoExtended() is void.
 //--
 
 // Include files...
@@ -106,6 +124,50 @@ sbit m_fRightShiftDown = m_bKeyFlags^2; //  -> right  "    "   "  "   "   "
 sbit m_fControlDown    = m_bKeyFlags^3; //  -> control key     "  "   "   "
 sbit m_fCapsLockOn     = m_bKeyFlags^4;	//  -> CAPS LOCK mode is on
 
+//   The ASCII output FIFO.  SendHost() adds characters at m_bHostPut and
+// ServiceHost() takes them from m_bHostGet, and both pointers are left at the
+// last byte used, the same as the keyboard buffer in keyboard.a51.  The size
+// MUST be a power of two, and it comes out of the 2051's 128 bytes of RAM...
+#ifndef HOSTBUFLEN
+#define HOSTBUFLEN	16
+#endif
+PRIVATE BYTE m_abHostBuffer[HOSTBUFLEN];	// characters for the host
+PRIVATE BYTE m_bHostGet, m_bHostPut;		// FIFO pointers
+PRIVATE bit  m_fHostBusy;			// the host hasn't read P1 yet
+
+// Statistics for the DEBUG version...
+#ifdef DEBUG
+PUBLIC BYTE g_bHostHighWater;		// most characters ever in the FIFO
+PUBLIC WORD g_wHostFull;		// times SendHost() found it full
+PUBLIC WORD g_wKeyOverflows;		// scan code buffer overflows
+#endif
+
+
+//++
+//   This routine is the host handshake, as a polled state machine.  If the
+// host has read the last character then finish that handshake, and if the
+// host is free and there's something in the FIFO then start the next one.
+// It never waits for anything.
+//
+//   KEY_DATA_RDY is on the INT1 pin, but it reads zero while a character is
+// waiting and goes back to one when the host reads it, and INT1 interrupts on
+// a falling edge or a low level - neither of which is the event we want.
+// That's why this is polled instead.
+//--
+PRIVATE void ServiceHost (void)
+{
+  if (m_fHostBusy) {
+    if (KEY_DATA_RDY == 0) return;
+    SET_KEY_DATA_RDY = 0;  m_fHostBusy = FALSE;
+    LED_OFF;
+  }
+  if (m_bHostGet == m_bHostPut) return;
+  m_bHostGet = (m_bHostGet+1) & (HOSTBUFLEN-1);
+  LED_ON;
+  P1 = m_abHostBuffer[m_bHostGet];  SET_KEY_DATA_RDY = 1;
+  m_fHostBusy = TRUE;
+}
+
 
 //++
 //   This routine returns a scan code from the keyboard buffer.  If the
@@ -115,9 +177,14 @@ PRIVATE BYTE WaitKey (void)
 {
   int nKey;
   while (TRUE) {
+    ServiceHost();
     if ((nKey = GetKey()) != -1) return LOBYTE(nKey);
     if ((g_bKeyFlags & KEYBOARD_ERROR_BITS) != 0) {
-      DBGOUT(("KBD: Keyboard re-initialized (0x%02bX) !!\n", g_bKeyFlags));
+#ifdef DEBUG
+      if ((g_bKeyFlags & KEYBOARD_OVERFLOW) != 0) ++g_wKeyOverflows;
+#endif
+      DBGOUT(("KBD: Keyboard re-initialized (0x%02bX, %u overflows) !!\n",
+        g_bKeyFlags, g_wKeyOverflows));
       InitializeKeyboard();
     }
   }
@@ -125,21 +192,28 @@ PRIVATE BYTE WaitKey (void)
 
 
 //++
-//   This routine will send one ASCII character to the host CPU.  If the
-// buffer isn't free (because the host hasn't yet read the last character)
-// then it will wait (forever, if necessary) for the host.  
+//   This routine will send one ASCII character to the host CPU by adding it to
+// the FIFO.  If the FIFO is full then it will wait (forever, if necessary) for
+// the host to make room.  Either way, it gets the handshake going if the host
+// isn't already busy...
 //--
 PRIVATE void SendHost (BYTE ch)
 {
-  LED_ON;
-  P1 = ch;  SET_KEY_DATA_RDY = 1;
-  while (KEY_DATA_RDY == 0) ;
-  SET_KEY_DATA_RDY = 0;
-  LED_OFF;
+  BYTE bPut = (m_bHostPut+1) & (HOSTBUFLEN-1);
+#ifdef DEBUG
+  if (bPut == m_bHostGet) ++g_wHostFull;
+#endif
+  while (bPut == m_bHostGet) ServiceHost();
+  m_abHostBuffer[bPut] = ch;  m_bHostPut = bPut;
 #ifdef DEBUG
+  if (((bPut - m_bHostGet) & (HOSTBUFLEN-1)) > g_bHostHighWater) {
+    g_bHostHighWater = (bPut - m_bHostGet) & (HOSTBUFLEN-1);
+    DBGOUT(("HOST: FIFO high water %bu (%u times full)\n", g_bHostHighWater, g_wHostFull));
+  }
   // for testing only!!
   putchar(ch);
 #endif
+  ServiceHost();
 }
 
 
@@ -221,9 +295,9 @@ PRIVATE BOOL DoShift (BYTE bKey, BOOL fRelease, BOOL fExtended)
       m_fControlDown = ~fRelease;  return TRUE;
 
     // CAPS LOCK key...
-    case 0x58:  
-      if (fRelease) break;
-      m_fCapsLockOn = ~m_fCapsLockOn;  return TRUE;
+    case 0x58:
+      if (!fRelease) m_fCapsLockOn = ~m_fCapsLockOn;
+      return TRUE;
 
     // Alt key (ignored)...
     case 0x11:  return TRUE;
@@ -329,7 +403,7 @@ PRIVATE BOOL DoKeypad (BYTE bKey, BOOL fRelease)
 //   The up and down arrow keys are used in Setup mode to move the cursor, but
 // all others are ignored while in Setup.
 //--
-PRIVATE DoExtended (void)
+PRIVATE void DoExtended (void)
 {
   BYTE bExtended = WaitKey();  BOOL fRelease = FALSE;
   if (bExtended == 0xF0) {
@@ -467,6 +541,7 @@ PUBLIC void ConvertKeys (void)
 {
   BYTE bKey;  BOOL fRelease;
   m_bKeyFlags = 0;
+  m_bHostGet = m_bHostPut = 0;  m_fHostBusy = FALSE;
   SendHost('K' | 0x80);  SendHost ('B');  SendHost(VERSION);
   DBGOUT(("ConvertKeys() initialized ...\n"));
   while (TRUE) {
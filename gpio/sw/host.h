@@ -21,10 +21,18 @@
 //REVISION HISTORY:
 // dd-mmm-yy    who     description
 //  5-Feb-06	RLA	New file.
+// 17-Oct-26	RLA	Add the DEBUG FIFO statistics.
 //--
 #ifndef _host_h_
 #define _host_h_
 
 PUBLIC void ConvertKeys (void);
 
+// Output FIFO and scan code buffer statistics (DEBUG version only) ...
+#ifdef DEBUG
+extern BYTE g_bHostHighWater;
+extern WORD g_wHostFull;
+extern WORD g_wKeyOverflows;
+#endif
+
 #endif	// _host_h_
@@ -22,11 +22,13 @@
 //REVISION HISTORY:
 // dd-mmm-yy    who     description
 //  5-Feb-06	RLA	New file.
+// 17-Oct-26	RLA	Add KEYBOARD_OVERFLOW.
 //--
 #ifndef _keyboard_h_
 #define _keyboard_h_
 
 #define KEYBOARD_ERROR_BITS	0xF0
+#define KEYBOARD_OVERFLOW	0x10	// m_fKeyOverflow in keyboard.a51
 
 // Function prototypes...
 extern void InitializeKeyboard (void);
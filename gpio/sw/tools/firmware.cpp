@@ -0,0 +1,56 @@
+//++
+//firmware.cpp - host.c and scancode.c, compiled for KBDSIM
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This file is part of the Spare Time Gizmos' Elf 2000 GPIO firmware.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   This is the real firmware - host.c (as hostsim.inc, which is host.c with
+// its sbit declarations turned into SBIT macros) and scancode.c - compiled
+// with g++ against the stand in regx051.h.  It's one file so that KBDSIM can
+// look at host.c's private output FIFO, which is all the code below does.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#include "hostsim.inc"		// ../host.c
+#include "scancode.c"		// ../scancode.c
+
+// The ports ...
+unsigned char P1, P3_0 = 1, P3_1 = 1, P3_5 = 1;
+CSetDataReady P3_4;
+CDataReady P3_3;
+
+
+unsigned HostFIFOSize()
+{
+  //++
+  // Return the most characters the output FIFO can hold ...
+  //--
+  return HOSTBUFLEN-1;
+}
+
+
+unsigned HostFIFODepth()
+{
+  //++
+  // And how many it holds right now ...
+  //--
+  return (m_bHostPut - m_bHostGet) & (HOSTBUFLEN-1);
+}
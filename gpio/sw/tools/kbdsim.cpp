@@ -0,0 +1,701 @@
+//++
+//kbdsim.cpp - run the PS/2 keyboard firmware on a PC, and time it
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This file is part of the Spare Time Gizmos' Elf 2000 GPIO firmware.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   KBDSIM runs the GPIO card's keyboard firmware - the real host.c and
+// scancode.c, compiled with g++ (see firmware.cpp) - against a model of the
+// rest of the AT89C2051 and of the things connected to it.  It types a stream
+// of scan codes on a simulated PS/2 keyboard, bit by bit, and reports what
+// got to the simulated host, what got lost and why, how long it all took,
+// and how much of the PS/2 clock period the keyboard interrupt uses up.
+//
+//   Time is counted in 8051 machine cycles (12 clocks at 11.0592MHz, or
+// 1.085us).  There are four parts to the model -
+//
+//   * The keyboard.  Every byte is a start bit, eight data bits, odd parity
+//     and a stop bit, with a falling clock edge in the middle of each bit.
+//     The data changes on the rising edges, half a period before each
+//     falling edge, and bytes in the same burst are BYTE_GAP bit times apart.
+//     Each key takes one typematic period - the make codes at the start of it
+//     and the break codes half way thru.
+//
+//   * keyboard.a51.  KEYBOARD_BIT, KEYBOARD_TIMEOUT, PutKey, GetKey and
+//     InitializeKeyboard are written out again in C++ here, state for state,
+//     and each path thru the ISRs takes the number of machine cycles its
+//     instructions do.  Each ISR starts the interrupt latency after its
+//     request (or after the previous ISR, or after GetKey turns EX0 back on)
+//     and it samples KEYBOARD_DATA when the instruction that reads it does,
+//     so a late ISR reads the wrong bit just like the real thing.  A clock
+//     edge that arrives while IE0 is still set is lost.
+//
+//   * host.c.  The real code, except that it only uses up time where it
+//     polls - every GetKey() and every read of KEY_DATA_RDY - and in
+//     SendHost().  Those costs are estimates (the _CYCLES constants below)
+//     and not counted from a C51 listing, but the interrupts steal their time
+//     from it the same way.
+//
+//   * The host.  It reads each character the moment it's ready, as long as
+//     it's been at least -H microseconds since the last one, and every -N
+//     characters it goes away for -S milliseconds (a VT52 scroll, say).
+//
+//   The same scan codes are also run thru the firmware once with no timing at
+//   all, and that's what the host should have received.  If it didn't, the
+//   differences are dropped or garbled keys.
+//
+// USAGE:
+//	kbdsim [-k kHz] [-l cycles] [-T rate] [-H us] [-S ms] [-N chars]
+//	       [-n count] [-t text | -f file] [-a] [-s] [-v]
+//
+//	-k kHz		PS/2 clock frequency (default 12)
+//	-l cycles	interrupt latency, 3 to 9 (default 4, see below)
+//	-T rate		keys per second (default 30, the fastest typematic rate)
+//	-H us		time the host takes for each character (default 100)
+//	-S ms		how long the host goes away for ...
+//	-N chars	... and how often (default never)
+//	-n count	how many times to type the text (default 10)
+//	-t text		what to type (see below)
+//	-f file		or replay scan codes from a file instead
+//	-a		install the application keypad jumper
+//	-s		install the swap CAPS LOCK and CONTROL jumper
+//	-v		print what the host received
+//
+//   The text is typed with the shift key as needed, and {UP}, {DOWN},
+// {RIGHT}, {LEFT}, {ENTER}, {ESC}, {TAB} and {BS} type those keys.  The arrow
+// keys make escape sequences, so they're the interesting ones.  A scan code
+// file has one burst of scan codes (hex bytes) on each line, and each line
+// takes half a typematic period.  Anything after a "#" is a comment.
+//
+//   The interrupt latency is from the clock edge to the first instruction of
+// the ISR, including the LCALL.  It's three cycles at best, and nine at the
+// very worst (after a RETI, then a MUL).  The main loop is mostly one and two
+// cycle instructions, so four is about as bad as it usually gets - but it's
+// worse while GetKey() has EX0 off, and the simulation takes that into
+// account.  PS/2 keyboards have clocks anywhere from 10 to 16.7kHz.
+//
+//   The exit status is 0 if the host got what it should have, 1 if it didn't,
+// and 2 for anything else.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#include <stdio.h>		// printf(), fprintf(), etc ...
+#include <stdlib.h>		// exit(), strtod(), ...
+#include <string.h>		// strchr(), strncmp(), ...
+#include <unistd.h>		// getopt() ...
+#include <string>		// C++ std::string class
+#include <vector>		// C++ std::vector template
+#include <algorithm>		// std::upper_bound(), std::max(), ...
+#include "kbdsim.hpp"		// declarations for this program
+typedef unsigned char BYTE;	// (standard.h has too much C51 in it)
+
+// Exit status codes ...
+#define EXIT_OK		0	// the host got what it should have
+#define EXIT_DROPPED	1	// it didn't
+#define EXIT_ERROR	2	// anything else
+
+// The 8051 ...
+#define CPU_CLOCK	11059200.0	// crystal frequency (Hz)
+#define CLOCKS_PER_CYCLE 12		// crystal clocks per machine cycle
+#define KEYBUFLEN	16		// keyboard.a51's scan code buffer
+#define TIMEOUT_CYCLES	0x708		// timer 0 starts at $F8F8 (TH0 and TL0!)
+#define TIMER_WRAP	65536		// and then it just keeps counting
+
+// The keyboard ...
+#define BYTE_GAP	2		// idle bit times between bytes in a burst
+#define DEFAULT_TEXT	"The Quick Brown Fox{ENTER}{UP}{UP}{LEFT}{RIGHT}{DOWN}jumps over the lazy dog 0123456789{ENTER}"
+
+//   Estimated host.c costs, in machine cycles.  GetKey() has EX0 off for the
+// first MASK_CYCLES of a call (a little longer when it finds something) ...
+#define POLL_CYCLES	24	// one WaitKey() loop with nothing to do
+#define KEY_CYCLES	150	// GetKey() returning a key, and translating it
+#define MASK_CYCLES	5	// CLR EX0 ... SETB EX0 when the buffer's empty
+#define MASK_KEY_CYCLES	11	//  ... and when it isn't
+#define READY_CYCLES	10	// ServiceHost() testing KEY_DATA_RDY
+#define SEND_CYCLES	40	// SendHost() and starting the handshake
+#define RESET_CYCLES	20	// InitializeKeyboard()
+
+// g_bKeyFlags bits (these have to agree with keyboard.a51) ...
+#define KEY_BUSY	0x01	// m_fKeyBusy
+#define KEY_OVERFLOW	0x10	// m_fKeyOverflow
+#define KEY_PARITY	0x20	// m_fKeyParity
+#define KEY_FRAMING	0x40	// m_fKeyFraming
+#define KEY_TIMEOUT	0x80	// m_fKeyTimeout
+
+//   Every path thru KEYBOARD_BIT and KEYBOARD_TIMEOUT, with the cycle (from
+// the vector) where it samples KEYBOARD_DATA and how many cycles it takes in
+// all.  It's 20 cycles from the vector to the state routine (LJMP, the five
+// PUSHes, MOV DPTR, MOV A, RL A, JMP @A+DPTR and the table's AJMP) and 12
+// from KEYRET back (five POPs and RETI) ...
+#define ISR_DISPATCH	20
+#define ISR_RETURN	12
+enum {
+  P_START, P_START_BAD, P_DATA, P_PARITY_ODD, P_PARITY_EVEN, P_PARITY_BAD,
+  P_STOP, P_STOP_FULL, P_STOP_BAD, P_ERROR, P_TIMEOUT, P_COUNT
+};
+struct ISR_PATH {
+  const char *pszName;		// what it's called in the report
+  unsigned    nSample;		// cycle that reads KEYBOARD_DATA (0 if none)
+  unsigned    nCycles;		// total length, vector to RETI
+};
+static const ISR_PATH g_aPaths[P_COUNT] = {
+  {"start bit",		ISR_DISPATCH,   ISR_DISPATCH+14+ISR_RETURN},
+  {"bad start bit",	ISR_DISPATCH,   ISR_DISPATCH+7+ISR_RETURN},
+  {"data bit",		ISR_DISPATCH+1, ISR_DISPATCH+7+ISR_RETURN},
+  {"parity (odd)",	ISR_DISPATCH+3, ISR_DISPATCH+6+ISR_RETURN},
+  {"parity (even)",	ISR_DISPATCH+3, ISR_DISPATCH+8+ISR_RETURN},
+  {"bad parity",	ISR_DISPATCH+3, ISR_DISPATCH+10+ISR_RETURN},
+  {"stop bit",		ISR_DISPATCH+2, ISR_DISPATCH+22+ISR_RETURN},
+  {"stop, buffer full",	ISR_DISPATCH+2, ISR_DISPATCH+20+ISR_RETURN},
+  {"bad stop bit",	ISR_DISPATCH+2, ISR_DISPATCH+9+ISR_RETURN},
+  {"error state",	0,		ISR_DISPATCH+ISR_RETURN},
+  {"timeout",		0,		2+6}
+};
+#define START_TIMER	(ISR_DISPATCH+11)	// timer 0 starts counting here
+
+// One falling edge of the PS/2 clock ...
+struct EDGE {
+  double dTime;			// when (machine cycles)
+  BYTE   bBit;			// and the data bit that goes with it
+};
+
+// Options ...
+static double   g_dPeriod;		// PS/2 clock period (machine cycles)
+static double   g_dLatency = 4;		// interrupt latency (machine cycles)
+static double   g_dHostChar;		// host time per character (cycles)
+static double   g_dHostStall = 0;	// host stall time (cycles)
+static unsigned g_nHostEvery = 0;	// and how often (characters)
+static bool     g_fIdeal;		// true for the reference run
+
+// The keyboard ...
+static std::vector<BYTE> g_abStream;	// every scan code, in order
+static std::vector<EDGE> g_Edges;	// and every clock edge
+static size_t   g_nEdge;		// next edge not yet seen by the ISR
+static size_t   g_nStream;		// next byte for the reference run
+
+// keyboard.a51 ...
+volatile BYTE   g_bKeyFlags;		// g_bKeyFlags, of course
+static unsigned g_nKeyState;		// m_bKeyState
+static BYTE     g_bKeyData;		// m_bKeyData
+static BYTE     g_abKeyBuffer[KEYBUFLEN];	// m_abKeyBuffer
+static unsigned g_nKeyGet, g_nKeyPut;	// m_bKeyGet and m_bKeyPut
+static bool     g_fTimerOn;		// TR0
+static double   g_dTimer;		// when timer 0 overflows
+
+// The CPU ...
+static double   g_dNow;			// what time it is
+static double   g_dISRDone;		// when the last ISR returned
+static double   g_dLimit;		// give up at this time
+
+// The host ...
+static bool     g_fHostBusy;		// KEY_DATA_RDY is low
+static double   g_dHostRead;		// when the host reads it
+static double   g_dHostFree;		// when it can read the next one
+static std::string g_sReceived;		// what the host got
+static double   g_dFirstChar, g_dLastChar;	// and when
+
+// Statistics ...
+static unsigned g_anPaths[P_COUNT];	// times each ISR path ran
+static unsigned g_nLostEdges;		// clock edges merged with the one before
+static unsigned g_nScanCodes;		// bytes that made it into the buffer
+static unsigned g_nOverflows, g_nParity, g_nFraming, g_nTimeouts;
+static unsigned g_nResets;		// InitializeKeyboard() calls from host.c
+static unsigned g_nKeyHighWater;	// most scan codes ever in the buffer
+static unsigned g_nHostHighWater;	// most characters ever in host.c's FIFO
+static double   g_dWorstSample;		// latest sample after its clock edge
+static double   g_dWorstISR;		// longest edge to RETI
+
+// Thrown when the run is over ...
+struct SIM_DONE {};
+
+
+static void Usage()
+{
+  fprintf(stderr, "usage: kbdsim [-k kHz] [-l cycles] [-T rate] [-H us] [-S ms] [-N chars]\n");
+  fprintf(stderr, "              [-n count] [-t text | -f file] [-a] [-s] [-v]\n");
+  exit(EXIT_ERROR);
+}
+
+
+static double Microseconds (double dCycles)
+{
+  //++
+  // Convert machine cycles to microseconds ...
+  //--
+  return dCycles * CLOCKS_PER_CYCLE * 1000000.0 / CPU_CLOCK;
+}
+
+
+static double Cycles (double dMicroseconds)
+{
+  //++
+  // And the other way ...
+  //--
+  return dMicroseconds * CPU_CLOCK / CLOCKS_PER_CYCLE / 1000000.0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//   T H E   K E Y B O A R D
+///////////////////////////////////////////////////////////////////////////////
+
+static void SendByte (BYTE bData, double &dTime)
+{
+  //++
+  //   Add the eleven clock edges for one byte, starting at dTime, and update
+  // dTime to when the keyboard can send the next one ...
+  //--
+  BYTE bParity = 1;
+  g_Edges.push_back({dTime, 0});
+  for (unsigned i = 0;  i < 8;  ++i) {
+    BYTE bBit = (bData >> i) & 1;  bParity ^= bBit;
+    g_Edges.push_back({dTime + (i+1)*g_dPeriod, bBit});
+  }
+  g_Edges.push_back({dTime + 9*g_dPeriod, bParity});
+  g_Edges.push_back({dTime + 10*g_dPeriod, 1});
+  dTime += (11+BYTE_GAP) * g_dPeriod;
+  g_abStream.push_back(bData);
+}
+
+
+static void SendBursts (const std::vector<std::vector<BYTE> > &Bursts, double dRate)
+{
+  //++
+  //   Turn a list of bursts of scan codes into clock edges, with a burst every
+  // half a typematic period, or as soon after that as the keyboard is free ...
+  //--
+  double dTime = g_dPeriod, dSlot = Cycles(1000000.0 / dRate / 2.0);
+  for (size_t i = 0;  i < Bursts.size();  ++i) {
+    dTime = std::max(dTime, i*dSlot);
+    for (size_t j = 0;  j < Bursts[i].size();  ++j) SendByte(Bursts[i][j], dTime);
+  }
+}
+
+
+static BYTE DataAt (double dTime)
+{
+  //++
+  //   Return what KEYBOARD_DATA is at dTime.  Each bit is there from half a
+  // period before its clock edge to half a period after it, and the line
+  // idles high ...
+  //--
+  double dHalf = g_dPeriod / 2.0;
+  std::vector<EDGE>::const_iterator it = std::upper_bound(g_Edges.begin(), g_Edges.end(), dTime+dHalf,
+    [] (double d, const EDGE &e) {return d < e.dTime;});
+  if (it == g_Edges.begin()) return 1;
+  --it;
+  return (dTime < it->dTime+dHalf) ? it->bBit : 1;
+}
+
+
+static bool TypeText (const std::string &sText, unsigned nCount, std::vector<std::vector<BYTE> > &Bursts)
+{
+  //++
+  //   Turn some text into make and break bursts, with the shift key where it's
+  // needed.  The scan code for each character is the first one in the
+  // firmware's own table that makes it (so the digits come from the top row
+  // and not the keypad) ...
+  //--
+  static const struct {const char *pszName;  BYTE bCode;  bool fExtended;} aKeys[] = {
+    {"{UP}", 0x75, true}, {"{DOWN}", 0x72, true}, {"{RIGHT}", 0x74, true},
+    {"{LEFT}", 0x6B, true}, {"{ENTER}", 0x5A, false}, {"{ESC}", 0x76, false},
+    {"{TAB}", 0x0D, false}, {"{BS}", 0x66, false}
+  };
+  for (unsigned n = 0;  n < nCount;  ++n) {
+    for (size_t i = 0;  i < sText.length();  ) {
+      std::vector<BYTE> abMake, abBreak;  bool fFound = false;
+      for (size_t k = 0;  k < sizeof(aKeys)/sizeof(aKeys[0]);  ++k) {
+	size_t cb = strlen(aKeys[k].pszName);
+	if (sText.compare(i, cb, aKeys[k].pszName) != 0) continue;
+	if (aKeys[k].fExtended) {abMake.push_back(0xE0);  abBreak.push_back(0xE0);}
+	abMake.push_back(aKeys[k].bCode);
+	abBreak.push_back(0xF0);  abBreak.push_back(aKeys[k].bCode);
+	i += cb;  fFound = true;  break;
+      }
+      for (unsigned nShift = 0;  !fFound && (nShift < 2);  ++nShift) {
+	for (unsigned nCode = 0;  !fFound && (nCode < 128);  ++nCode) {
+	  if (g_abScanCodes[nCode][nShift] != (BYTE) sText[i]) continue;
+	  if (nShift != 0) abMake.push_back(0x12);
+	  abMake.push_back(nCode);
+	  abBreak.push_back(0xF0);  abBreak.push_back(nCode);
+	  if (nShift != 0) {abBreak.push_back(0xF0);  abBreak.push_back(0x12);}
+	  ++i;  fFound = true;
+	}
+      }
+      if (!fFound) {
+	fprintf(stderr, "kbdsim: there's no key for \"%c\"\n", sText[i]);  return false;
+      }
+      Bursts.push_back(abMake);  Bursts.push_back(abBreak);
+    }
+  }
+  return true;
+}
+
+
+static bool ReadScanCodes (const char *pszFile, std::vector<std::vector<BYTE> > &Bursts)
+{
+  //++
+  // Read a scan code file - one burst of hex bytes on each line ...
+  //--
+  FILE *f = fopen(pszFile, "r");
+  if (f == NULL) {perror(pszFile);  return false;}
+  char szLine[512];
+  while (fgets(szLine, sizeof(szLine), f) != NULL) {
+    char *psz = strchr(szLine, '#');
+    if (psz != NULL) *psz = '\0';
+    std::vector<BYTE> abBurst;  char *pszEnd;
+    for (psz = szLine;  ;  psz = pszEnd) {
+      unsigned long l = strtoul(psz, &pszEnd, 16);
+      if (pszEnd == psz) break;
+      if (l > 0xFF) {
+	fprintf(stderr, "kbdsim: %s: %lX isn't a byte\n", pszFile, l);  fclose(f);  return false;
+      }
+      abBurst.push_back((BYTE) l);
+    }
+    if (!abBurst.empty()) Bursts.push_back(abBurst);
+  }
+  fclose(f);
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//   K E Y B O A R D . A 5 1
+///////////////////////////////////////////////////////////////////////////////
+
+static void PutKey()
+{
+  //++
+  // Add m_bKeyData to the buffer, or set m_fKeyOverflow if it's full ...
+  //--
+  unsigned nPut = (g_nKeyPut+1) & (KEYBUFLEN-1);
+  if (nPut == g_nKeyGet) {
+    g_bKeyFlags |= KEY_OVERFLOW;  ++g_nOverflows;  return;
+  }
+  g_nKeyPut = nPut;  g_abKeyBuffer[nPut] = g_bKeyData;  ++g_nScanCodes;
+  g_nKeyHighWater = std::max(g_nKeyHighWater, (g_nKeyPut - g_nKeyGet) & (KEYBUFLEN-1));
+}
+
+
+static unsigned KeyboardBit (double dVector)
+{
+  //++
+  //   KEYBOARD_BIT, starting at dVector.  Returns the path it took (see
+  // g_aPaths) ...
+  //--
+  switch (g_nKeyState) {
+    case 0:
+      if (DataAt(dVector + g_aPaths[P_START].nSample) != 0) {
+	g_bKeyFlags |= KEY_FRAMING;  ++g_nFraming;  g_nKeyState = 11;  return P_START_BAD;
+      }
+      g_bKeyFlags |= KEY_BUSY;  g_bKeyData = 0;
+      g_fTimerOn = true;  g_dTimer = dVector + START_TIMER + TIMEOUT_CYCLES;
+      ++g_nKeyState;  return P_START;
+
+    case 1: case 2: case 3: case 4: case 5: case 6: case 7: case 8:
+      g_bKeyData = (g_bKeyData >> 1) | (DataAt(dVector + g_aPaths[P_DATA].nSample) << 7);
+      ++g_nKeyState;  return P_DATA;
+
+    case 9: {
+      // Odd parity - the bit has to be one if the data has an even number ...
+      BYTE bOdd = 0;
+      for (BYTE b = g_bKeyData;  b != 0;  b >>= 1) bOdd ^= b & 1;
+      BYTE bBit = DataAt(dVector + g_aPaths[P_PARITY_ODD].nSample);
+      if (bBit == bOdd) {
+	g_bKeyFlags |= KEY_PARITY;  ++g_nParity;  g_nKeyState = 11;  return P_PARITY_BAD;
+      }
+      ++g_nKeyState;  return (bOdd != 0) ? P_PARITY_ODD : P_PARITY_EVEN;
+    }
+
+    case 10:
+      g_bKeyFlags &= ~KEY_BUSY;  g_fTimerOn = false;
+      if (DataAt(dVector + g_aPaths[P_STOP].nSample) == 0) {
+	g_bKeyFlags |= KEY_FRAMING;  ++g_nFraming;  g_nKeyState = 11;  return P_STOP_BAD;
+      }
+      g_nKeyState = 0;
+      if (((g_nKeyPut+1) & (KEYBUFLEN-1)) == g_nKeyGet) {PutKey();  return P_STOP_FULL;}
+      PutKey();  return P_STOP;
+
+    default:
+      return P_ERROR;
+  }
+}
+
+
+static unsigned KeyboardTimeout()
+{
+  //++
+  //   KEYBOARD_TIMEOUT.  Note that it doesn't stop the timer, so it'll go off
+  // again in another 65536 cycles unless a start bit reloads it first ...
+  //--
+  g_bKeyFlags |= KEY_TIMEOUT;  g_bKeyFlags &= ~KEY_BUSY;  ++g_nTimeouts;
+  g_nKeyState = 0;  g_dTimer += TIMER_WRAP;
+  return P_TIMEOUT;
+}
+
+
+static void Run (double dWork, double dMasked=0)
+{
+  //++
+  //   Run the main program for dWork cycles, the first dMasked of them with
+  // EX0 off, and run any interrupts that come along.  They stop the main
+  // program while they run, so this can take longer than dWork ...
+  //--
+  if (g_fIdeal) return;
+  double dMaskEnd = g_dNow + dMasked;
+  while (true) {
+    //   Work out when each interrupt would get the CPU.  INT0 has priority
+    // if they both want it at once ...
+    double dINT0 = 1e300, dTimer = 1e300;
+    if (g_nEdge < g_Edges.size())
+      dINT0 = std::max(std::max(g_Edges[g_nEdge].dTime, g_dISRDone), dMaskEnd) + g_dLatency;
+    if (g_fTimerOn)
+      dTimer = std::max(g_dTimer, g_dISRDone) + g_dLatency;
+    double dVector = std::max(std::min(dINT0, dTimer), g_dNow);
+    if (dVector >= g_dNow+dWork) break;
+    dWork -= dVector - g_dNow;
+
+    //   Run the ISR.  Any other clock edges before the LCALL clears IE0 are
+    // lost ...
+    unsigned nPath;  double dRequest;
+    if (dINT0 <= dTimer) {
+      dRequest = g_Edges[g_nEdge++].dTime;
+      while ((g_nEdge < g_Edges.size()) && (g_Edges[g_nEdge].dTime < dVector-2)) {
+	++g_nEdge;  ++g_nLostEdges;
+      }
+      nPath = KeyboardBit(dVector);
+      if (g_aPaths[nPath].nSample != 0)
+	g_dWorstSample = std::max(g_dWorstSample, dVector + g_aPaths[nPath].nSample - dRequest);
+    } else {
+      dRequest = g_dTimer;  nPath = KeyboardTimeout();
+    }
+    ++g_anPaths[nPath];
+    g_dNow = g_dISRDone = dVector + g_aPaths[nPath].nCycles;
+    g_dWorstISR = std::max(g_dWorstISR, g_dNow - dRequest);
+  }
+  g_dNow += dWork;
+  if (g_dNow > g_dLimit) throw SIM_DONE();
+}
+
+
+void InitializeKeyboard()
+{
+  //++
+  // Reset the buffer, the state and the flags ...
+  //--
+  g_nKeyGet = g_nKeyPut = 0;  g_nKeyState = 0;  g_bKeyFlags = 0;
+  g_fTimerOn = false;  ++g_nResets;
+  Run(RESET_CYCLES);
+}
+
+
+int GetKey()
+{
+  //++
+  //   Return the next scan code, or -1 if there isn't one.  This is also where
+  // we notice that everything's been typed and sent to the host, and stop ...
+  //--
+  g_nHostHighWater = std::max(g_nHostHighWater, HostFIFODepth());
+  bool fIdle = (HostFIFODepth() == 0) && (!g_fHostBusy || (g_dNow >= g_dHostRead));
+  if (g_fIdeal) {
+    if (g_nStream < g_abStream.size()) return g_abStream[g_nStream++];
+    if (fIdle) throw SIM_DONE();
+    return -1;
+  }
+  if (g_nKeyGet == g_nKeyPut) {
+    if (fIdle && (g_nEdge == g_Edges.size()) && (g_dNow > g_Edges.back().dTime+g_dPeriod))
+      throw SIM_DONE();
+    Run(POLL_CYCLES, MASK_CYCLES);
+    return -1;
+  }
+  g_nKeyGet = (g_nKeyGet+1) & (KEYBUFLEN-1);
+  BYTE bKey = g_abKeyBuffer[g_nKeyGet];
+  Run(KEY_CYCLES, MASK_KEY_CYCLES);
+  return bKey;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//   T H E   H O S T
+///////////////////////////////////////////////////////////////////////////////
+
+void SetDataReady (bool fSet)
+{
+  //++
+  //   Setting the KEY_DATA_RDY flip-flop hands P1 to the host, and it'll read
+  // it as soon as it's free.  Clearing it again doesn't do anything ...
+  //--
+  if (!fSet) {Run(1);  return;}
+  g_nHostHighWater = std::max(g_nHostHighWater, HostFIFODepth()+1);
+  Run(SEND_CYCLES);
+  g_sReceived += (char) P1;  g_fHostBusy = true;
+  g_dHostRead = std::max(g_dNow, g_dHostFree);
+  g_dHostFree = g_dHostRead + g_dHostChar;
+  if ((g_nHostEvery != 0) && ((g_sReceived.length() % g_nHostEvery) == 0)) g_dHostFree += g_dHostStall;
+  if (g_sReceived.length() == 1) g_dFirstChar = g_dHostRead;
+  g_dLastChar = g_dHostRead;
+}
+
+
+BYTE DataReady()
+{
+  //++
+  // KEY_DATA_RDY is zero until the host reads the data ...
+  //--
+  if (g_fIdeal) {g_fHostBusy = false;  return 1;}
+  Run(READY_CYCLES);
+  if (g_fHostBusy && (g_dNow >= g_dHostRead)) g_fHostBusy = false;
+  return g_fHostBusy ? 0 : 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//   T H E   R E P O R T
+///////////////////////////////////////////////////////////////////////////////
+
+static void Budget()
+{
+  //++
+  //   Compare every path thru the ISRs with the PS/2 clock.  An edge can come
+  // just after GetKey() turns EX0 off, so the worst case is the latency plus
+  // MASK_KEY_CYCLES.  Then each path has to read KEYBOARD_DATA before the
+  // keyboard changes it (half a period after the edge) and has to be done
+  // before the next edge (a whole period) ...
+  //--
+  double dHalf = g_dPeriod / 2.0, dFastest = 0, dDelay = g_dLatency + MASK_KEY_CYCLES;
+  printf("ISR budget at %.4fMHz (%.3fus per cycle), %.0f cycles of latency plus %u with EX0 off\n",
+    CPU_CLOCK/1000000.0, Microseconds(1), g_dLatency, MASK_KEY_CYCLES);
+  printf("PS/2 clock %.1fkHz - %.1f cycles, low for %.1f\n\n", CPU_CLOCK/CLOCKS_PER_CYCLE/g_dPeriod/1000.0, g_dPeriod, dHalf);
+  printf("  path                sample           total\n");
+  for (unsigned i = 0;  i < P_COUNT;  ++i) {
+    double dSample = g_aPaths[i].nSample + dDelay, dTotal = g_aPaths[i].nCycles + dDelay;
+    if (g_aPaths[i].nSample != 0) {
+      printf("  %-18s  %3.0f %5.1fus %-4s", g_aPaths[i].pszName, dSample, Microseconds(dSample),
+	(dSample < dHalf) ? "ok" : "LATE");
+      dFastest = std::max(dFastest, 2.0*dSample);
+    } else
+      printf("  %-18s  %18s", g_aPaths[i].pszName, "");
+    printf("  %3.0f %5.1fus %s\n", dTotal, Microseconds(dTotal), (dTotal <= g_dPeriod) ? "ok" : "SLOW");
+    if (i != P_TIMEOUT) dFastest = std::max(dFastest, dTotal);
+  }
+  printf("\nfastest PS/2 clock this ISR can keep up with %.1fkHz\n\n",
+    CPU_CLOCK/CLOCKS_PER_CYCLE/dFastest/1000.0);
+}
+
+
+static std::string Printable (const std::string &s)
+{
+  //++
+  // Make the host's characters printable ...
+  //--
+  std::string sOut;  char sz[8];
+  for (size_t i = 0;  i < s.length();  ++i) {
+    BYTE b = (BYTE) s[i];
+    if ((b >= ' ') && (b < 0x7F) && (b != '\\')) {sOut += (char) b;  continue;}
+    snprintf(sz, sizeof(sz), "\\%02X", b);  sOut += sz;
+    if (b == '\r') sOut += '\n';
+  }
+  return sOut;
+}
+
+
+static void Report (const std::string &sExpected, bool fTimeout)
+{
+  //++
+  // Say what happened in the timed run ...
+  //--
+  unsigned nISRs = 0;
+  for (unsigned i = 0;  i < P_COUNT;  ++i) nISRs += g_anPaths[i];
+  printf("simulated %.2f seconds%s\n", Microseconds(g_dNow)/1000000.0, fTimeout ? " (and gave up)" : "");
+  printf("scan codes   %zu sent, %u received, %u overflows, %u keyboard resets\n",
+    g_abStream.size(), g_nScanCodes, g_nOverflows, g_nResets);
+  printf("errors       %u clock edges lost, %u framing, %u parity, %u timeouts\n",
+    g_nLostEdges, g_nFraming, g_nParity, g_nTimeouts);
+  printf("interrupts   %u, worst %.0f cycles from clock edge to RETI, latest sample %.0f cycles after its edge\n",
+    nISRs, g_dWorstISR, g_dWorstSample);
+  printf("buffers      scan codes %u of %u, host FIFO %u of %u\n",
+    g_nKeyHighWater, KEYBUFLEN-1, g_nHostHighWater, HostFIFOSize());
+  size_t nMatch = 0;
+  while ((nMatch < sExpected.length()) && (nMatch < g_sReceived.length()) && (sExpected[nMatch] == g_sReceived[nMatch])) ++nMatch;
+  printf("characters   %zu expected, %zu received", sExpected.length(), g_sReceived.length());
+  if (g_sReceived == sExpected)
+    printf(", all correct\n");
+  else
+    printf(", first difference at %zu, %zu dropped\n", nMatch,
+      (sExpected.length() > g_sReceived.length()) ? sExpected.length()-g_sReceived.length() : (size_t) 0);
+  double dTime = Microseconds(g_dLastChar - g_dFirstChar) / 1000000.0;
+  if (dTime > 0)
+    printf("throughput   %.1f characters and %.1f scan codes a second\n",
+      (g_sReceived.length()-1) / dTime, g_nScanCodes / (Microseconds(g_dNow)/1000000.0));
+}
+
+
+int main (int argc, char *argv[])
+{
+  double dClock = 12.0, dRate = 30.0, dHostChar = 100.0;
+  unsigned nCount = 10;  bool fVerbose = false;
+  const char *pszText = DEFAULT_TEXT, *pszFile = NULL;
+  int nOption;
+
+  // Parse the command line ...
+  while ((nOption = getopt(argc, argv, "k:l:T:H:S:N:n:t:f:asv")) != -1) {
+    switch (nOption) {
+      case 'k': dClock = strtod(optarg, NULL);  break;
+      case 'l': g_dLatency = strtod(optarg, NULL);  break;
+      case 'T': dRate = strtod(optarg, NULL);  break;
+      case 'H': dHostChar = strtod(optarg, NULL);  break;
+      case 'S': g_dHostStall = Cycles(strtod(optarg, NULL) * 1000.0);  break;
+      case 'N': g_nHostEvery = strtoul(optarg, NULL, 10);  break;
+      case 'n': nCount = strtoul(optarg, NULL, 10);  break;
+      case 't': pszText = optarg;  break;
+      case 'f': pszFile = optarg;  break;
+      case 'a': P3_1 = 0;  break;
+      case 's': P3_0 = 0;  break;
+      case 'v': fVerbose = true;  break;
+      default:  Usage();
+    }
+  }
+  if ((optind != argc) || (dClock <= 0) || (dRate <= 0) || (nCount == 0)) Usage();
+  g_dPeriod = Cycles(1000.0 / dClock);  g_dHostChar = Cycles(dHostChar);
+
+  // Make up the scan codes ...
+  std::vector<std::vector<BYTE> > Bursts;
+  if (pszFile != NULL) {
+    if (!ReadScanCodes(pszFile, Bursts)) return EXIT_ERROR;
+  } else {
+    if (!TypeText(pszText, nCount, Bursts)) return EXIT_ERROR;
+  }
+  if (Bursts.empty()) {
+    fprintf(stderr, "kbdsim: nothing to type\n");  return EXIT_ERROR;
+  }
+  SendBursts(Bursts, dRate);
+  Budget();
+
+  //   Run it once with no timing, to find out what the host should get, and
+  // then for real.  ConvertKeys() never returns - we throw SIM_DONE from
+  // GetKey() when it's all over ...
+  g_fIdeal = true;
+  try {InitializeKeyboard();  ConvertKeys();} catch (SIM_DONE &) {}
+  std::string sExpected = g_sReceived;
+  g_fIdeal = false;  g_sReceived.clear();  g_fHostBusy = false;  g_dHostFree = 0;
+  g_nResets = 0;  g_nKeyHighWater = g_nHostHighWater = 0;
+  g_dLimit = g_Edges.back().dTime + Cycles(10000000.0);
+  try {InitializeKeyboard();  g_nResets = 0;  ConvertKeys();} catch (SIM_DONE &) {}
+  Report(sExpected, g_dNow > g_dLimit);
+  if (fVerbose) printf("\n%s\n", Printable(g_sReceived).c_str());
+  return (g_sReceived == sExpected) ? EXIT_OK : EXIT_DROPPED;
+}
@@ -0,0 +1,54 @@
+//++
+//kbdsim.hpp - declarations shared by KBDSIM and the firmware
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This file is part of the Spare Time Gizmos' Elf 2000 GPIO firmware.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   These are the routines in kbdsim.cpp that stand in for the hardware and
+// for keyboard.a51, and the ones in firmware.cpp that KBDSIM uses to look
+// inside host.c.  This is included by the stand in regx051.h, so it mustn't
+// use any of the C51 keywords that file defines away (or any C++ headers).
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#ifndef _kbdsim_hpp_
+#define _kbdsim_hpp_
+
+// The ports (firmware.cpp) - P1 is the data for the host, P3_0 and P3_1
+// are the option jumpers (zero when installed) and P3_5 is the LED ...
+extern unsigned char P1, P3_0, P3_1, P3_5;
+
+// The host handshake (kbdsim.cpp) ...
+extern void SetDataReady (bool fSet);
+extern unsigned char DataReady();
+
+// keyboard.a51 (kbdsim.cpp) ...
+extern void InitializeKeyboard (void);
+extern int GetKey (void);
+extern volatile unsigned char g_bKeyFlags;
+
+// host.c and scancode.c (firmware.cpp) ...
+extern void ConvertKeys (void);
+extern unsigned HostFIFOSize();
+extern unsigned HostFIFODepth();
+extern const unsigned char g_abScanCodes[128][4];
+
+#endif	// _kbdsim_hpp_
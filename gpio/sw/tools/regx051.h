@@ -0,0 +1,83 @@
+//++
+//regx051.h - stand in for the Keil AT89C2051 header, for KBDSIM
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This file is part of the Spare Time Gizmos' Elf 2000 GPIO firmware.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   When KBDSIM compiles host.c with g++ this file is found instead of the
+// real ../regx051.h (Makefile copies host.c here first - see hostsim.inc).
+// It defines away the C51 memory space keywords and replaces the port bits
+// that host.c and gpio.h use with objects that call the simulator, so that
+// reading KEY_DATA_RDY and writing SET_KEY_DATA_RDY take time and drive the
+// simulated host.
+//
+//   C51 bits are a bit of a problem.  A bit variable is just a BYTE here, and
+// an sbit (which the Makefile turns into "#define name SBIT(byte,bit)") is a
+// CBit, which reads and writes one bit of the byte.  Both read as FALSE or
+// TRUE (0x00 or 0xFF) rather than 0 or 1, so that "x = ~x" and "x = ~fFlag"
+// do the same thing they do on the 8051, and anything non-zero in the low
+// byte sets them.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#ifndef __AT89x051_H__
+#define __AT89x051_H__
+#include "kbdsim.hpp"		// the simulator's side of all this
+
+// C51 memory spaces and types ...
+#define code
+#define data
+#define idata
+#define xdata
+#define bdata
+#define bit	unsigned char
+
+// One bit of a bdata byte ...
+class CBit {
+public:
+  CBit (volatile unsigned char &b, int nBit) : m_b(b), m_bMask(1 << nBit) {}
+  operator unsigned char() const {return ((m_b & m_bMask) != 0) ? 0xFF : 0x00;}
+  CBit &operator= (int n) {
+    if ((unsigned char) n != 0) m_b |= m_bMask;  else m_b &= ~m_bMask;
+    return *this;
+  }
+private:
+  volatile unsigned char &m_b;  unsigned char m_bMask;
+};
+#define SBIT(b,n)	CBit(b,n)
+
+// SET_KEY_DATA_RDY (P3.4) - writing a one starts the handshake ...
+class CSetDataReady {
+public:
+  CSetDataReady &operator= (int n) {SetDataReady(n != 0);  return *this;}
+};
+
+// KEY_DATA_RDY (P3.3) - zero while the host hasn't read P1 ...
+class CDataReady {
+public:
+  operator unsigned char() const {return DataReady();}
+};
+
+// The port bits with side effects (P1 and the rest are in kbdsim.hpp) ...
+extern CSetDataReady P3_4;		// SET_KEY_DATA_RDY
+extern CDataReady P3_3;			// KEY_DATA_RDY
+
+#endif	// __AT89x051_H__
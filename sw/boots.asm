@@ -390,8 +390,87 @@
 ; 119   -- BIOS and Visual/02 changes for ElfOS v5 from Gaston Williams.
 ;
 ; 120	-- F_IDESIZE returns zero in P1 if the drive is bad, not D!
+;
+; 121	-- Add MONEXT, a second chunk of EPROM for monitor extensions, and
+;	   the LOAD command to download a whole HEX file at full speed.
+;
+; 122	-- Add SET TERMINAL INTERRUPT/POLLED - an interrupt driven console
+;	   input driver with the 16550 FIFOs and RTS flow control.  SHOW
+;	   TERMINAL shows the driver and the number of receiver overruns.
+;
+; 123	-- Add SET VIDEO FAST/SLOW, which turns the VT1802 display off while
+;	   monitor commands run.
+;
+; 124	-- Rewrite MEMDMP to build each line in a buffer with a table driven
+;	   hex conversion and type it with TMSG, which sends a string directly
+;	   to the UART or the VT1802 without calling the BIOS for every byte.
+;
+; 125	-- Replace TEST RAM with a RAM test engine - March C-, Knaizuk and
+;	   Hartmann, data and address bus tests and QUICK, with page unrolled
+;	   inner loops, an optional address range and the time for each pass.
+;	   Add MONEXT2 for the part of it that doesn't fit at MONEXT.
+;
+; 126	-- Add SET FASTBOOT ON/OFF.  With fast boot on, a reset that finds the
+;	   SRAM key and the NVR valid skips the EPROM checksum, SRAM sizing,
+;	   RTC ticking test and speaker beep.
+;
+; 127	-- Add HELPLZ - the help text can be compressed by the ROMLZ tool and
+;	   expanded again a block at a time into DSKBUF.
+;
+; 128	-- Add DKINIT, DKREAD and DKWRIT at MONEXT3 - multi sector IDE reads
+;	   and writes with READ/WRITE MULTIPLE and unrolled data loops - and
+;	   TEST DISK to measure the transfer rate.
+;
+; 129	-- Add DCREAD, DCWRIT and DCFLSH - a write back, least recently used
+;	   sector cache of DCSLOTS sectors in front of DKREAD and DKWRIT, at
+;	   MONEXT4 - and SHOW DISK CACHE.
+;
+; 130	-- Add IDECACHE - save the IDE size and model in NVR, and at startup
+;	   just check that the master is ready and type the saved data.  SHOW
+;	   IDE still does the full reset and identify, and updates NVR.
+;
+; 131	-- Add PROFILE - CALL a program and count its PC, a page at a time,
+;	   from the RTC periodic interrupt.  Move the SET VIDEO FAST code into
+;	   the gap before HLDHI, and let each help text block refer back to
+;	   the one before it.
+;
+; 132	-- Add TIME, at MONEXT6 - CALL a program with the PROFILE sampler
+;	   running and type the elapsed time and estimated machine cycles.
+;
+; 133	-- Add TRACE and SHOW TRACE (alternate Elf2K EPROM only) - single step
+;	   a program through a RAM thunk and keep a history and counts.  The
+;	   rest of TRACE lives at MONEXT7 and MONEXT8.
+;
+; 134	-- Find out whether the CPU is an 1802 or an 1804/5/6 during POST and
+;	   remember it in CPUTYP.  With CDP1805 defined, use a faster SCRT
+;	   CALL and RETURN, at MONEXT9, when the CPU is an 1804/5/6.
+;
+; 135	-- Add HEXDL, a hex digit converter that's called with SEP T2 instead
+;	   of thru SCRT, and use it in GHEX2 and in HEXSCN, which replaces
+;	   F_HEXIN for SCANP1.  They live at MONEXT10 on the Elf2K.
+;
+; 136	-- Add FILL, MOVE, COMPARE and SEARCH (MEMCMDS, PicoElf only).  They go
+;	   a page at a time, with unrolled loops for whole pages, and check
+;	   for a BREAK between pages.
+;
+; 137	-- Add CHECKSUM (MEMCRC, not in the Elf2K EPROM), which types the
+;	   CRC-16/XMODEM of a block of memory using a table that it builds in
+;	   DSKBUF.  It lives at MONEXT12 and MONEXT13.
+;
+; 138	-- Add SAVE (SAVEHEX, Elf2K only), which types a block of memory as an
+;	   Intel .HEX file at UART speed.  It lives at MONEXT14, between the
+;	   BIOS and the extended BIOS.
+;
+; 139	-- Add REMOTE (PicoElf only), binary packets that let a program on the
+;	   host read and write memory and registers and run programs.  There's
+;	   room for it because the PicoElf help text is now compressed too, and
+;	   the help decompressor goes at HLPEXT when there's no MONEXT2.
+;
+; 140	-- Add PARALLEL (PPIXFER, alternate Elf2K EPROM only), which loads and
+;	   saves memory thru the GPIO PPI in mode 2 for a program on the host.
+;	   The alternate EPROM's help text is compressed now to make room.
 ;--
-MONVER	.EQU	120
+MONVER	.EQU	140
 
 ; SUGGESTIONS FOR ENHANCEMENTS
 ; Add hardware flow control for loading HEX files over UART?
@@ -448,13 +527,44 @@ DSKBUF	.EQU	SCREEN-512
 DSKBUF	.EQU	RAMPAGE-512
 #endif
 
+;   If there's a disk cache then its DCSLOTS sectors are just below DSKBUF,
+; and the tags (four bytes for each slot) and the hit and miss counts are on
+; the page below that.  See DCREAD ...
+#ifdef DCSLOTS
+DCBUF	.EQU	DSKBUF-(DCSLOTS*512)	; cached sectors
+DCTAGS	.EQU	DCBUF-(DCSLOTS*4)-8	; slot tags
+DCHITS	.EQU	DCBUF-8			; number of cache hits
+DCMISS	.EQU	DCBUF-6			;  ... and misses
+#endif
+
+;   MEMDMP builds each line of its output in the last few bytes of DSKBUF.
+; The layout is "xxxx>  hh hh ... hh  cccccccccccccccc\r\n" and DMPASC is
+; the offset of the ASCII part.  Note that an EXAMINE of those bytes shows
+; the line being built rather than what was there before!
+DMPLEN	.EQU	75	; length of one line, including the null
+DMPASC	.EQU	56	; offset of the ASCII part
+DMPBUF	.EQU	DSKBUF+512-DMPLEN
+
 ;   Since the CDP1802 stack grows downward, ideally we'd like to pack all
 ; the static variables into the high part of the data page, and then start
 ; the stack just below the first variable.  Unfortunately there's no easy
 ; way to do that, so we just make an educated guess...
-	.ORG	$+120
+#ifdef UARTIRQ
+;   In interrupt mode (see SET TERMINAL INTERRUPT) console input is buffered
+; here.  It lives at the bottom of the stack space so that the low byte of
+; its address can double as the index, and that leaves 87 bytes for the stack
+; which is still a lot more than the monitor ever uses...
+RXBSIZ	.EQU	32	; size of the buffer (must be a power of two!)
+RXBUF:	.BLOCK	RXBSIZ	; console input ring buffer
+#endif
+	.ORG	RAMPAGE+119
 STACK	.EQU	$-1
 
+;   CPUTYP is zero if the CPU is a CDP1802 and non-zero for an 1804/5/6.  It's
+; set during POST, just before SCRT is initialized (see CPUINI), and it must
+; be the first byte above the stack ...
+CPUTYP:	.BLOCK	1	; CPU type (0 for the 1802)
+
 ;   If the bytes in this "key" matches with the EPROM signature then the
 ; SRAM contents are valid. 
 KEY:	.BLOCK	5	; 3 "key" bytes plus the EPROM checksum...
@@ -491,11 +601,18 @@ BAUD0:	.BLOCK	1	; [NVR]   "    "   "  UART settings from RF.0
 ; tempted to take shortcuts and make assumptions about the order of these
 ; items!
 TIMBUF:	.BLOCK	6	; buffer for the DA[TIME] command
-BATTOK:	.BLOCK	1	; 1 if RAM battery backup is OK
+PRFTIM	.EQU	TIMBUF	; non-zero if PROFILE is really TIME (see TIMCMD)
+BATTOK:	.BLOCK	1	; non-zero if SRAM contents are OK (1 after a fast boot)
 VRTC:	.BLOCK	1	; CDP1861 vertical retrace counter
 PASSK:	.BLOCK	2	; pass count for MEMTEST and other diagnostics
 ERRORK:	.BLOCK	2	; error  "    "     "     "    "        "
 UARTOK:	.BLOCK	1	; non-zero if a high speed UART is present
+#ifdef UARTIRQ
+TTYIRQ:	.BLOCK	1	; non-zero for the interrupt driven console
+RXPUT:	.BLOCK	1	; RXBUF fill pointer (changed only by UISR!)
+RXGET:	.BLOCK	1	;   "   empty   "    (changed only by UGETC)
+OVRUNK:	.BLOCK	2	; count of console receiver overruns
+#endif
 
 ;   The following two bytes contain the version numbers of the PS/2 keyboard
 ; APU firmware (that's the firmware in our 89C2051 chip on the Elf 2000 GPIO
@@ -506,6 +623,9 @@ UARTOK:	.BLOCK	1	; non-zero if a high speed UART is present
 #ifdef ELF2K
 PS2VER:	.BLOCK	1	; PS2 keyboard version number
 VIDVER:	.BLOCK	1	; VT52 emulator video card version
+#ifdef VIDEO
+VIDFST:	.BLOCK	1	; non-zero for SET VIDEO FAST (must follow VIDVER!)
+#endif
 #endif
 
 ;   These three bytes are used for the power fail auto restart/auto bootstrap
@@ -591,6 +711,7 @@ NVRDEFAULT:
 	.DB	ABTNONE, $80, 0	; default boot/restart flag
 	.DB	0, 0		; default software and hardware UART settings
 	.DB	MONVER		; associated monitor version number
+	.DB	FBOFF		; fast boot off
 
 	.EJECT
 ;	.SBTTL	POST Code Summary
@@ -657,6 +778,13 @@ SYSINI:	POST($99)		; POST code 99 - the CPU is alive!
 	DIS			; disable interrupts ...
 	.DB	$00		; ... and set X=P=0
 
+;   If SET FASTBOOT ON and this is a warm start, FBTEST skips the slow tests
+; and goes straight to DPDONE with T2.0 non-zero.  Otherwise it comes back to
+; ROMCHK with T2.0 zero and we do the whole thing...
+#ifdef MONEXT
+	LBR	FBTEST		; see if we can do a fast boot
+#endif
+
 ;   There are supposed to be some rudimentary CPU tests here, but I never
 ; got around to writing any!  We'll just fall into the EPROM checksum test...
 
@@ -750,6 +878,11 @@ SIZME2:	DEC	P1		; back to the last writable location
 ; SRAM (location KEY:) against the signature built into EPROM.  If they
 ; match, then we assume the RAM is initialized and we proceed with the current
 ; RAM contents.
+;
+;   FBTEST (SET FASTBOOT) jumps here too, with T2.0 = 2, to check the key for
+; a fast boot.  Then a mismatch goes to KEYBAD, which starts the full POST,
+; rather than to DPTEST, and BATTOK ends up 1 rather than $FF.  On the normal
+; path T2.0 is zero and KEYBAD is the same as DPTEST...
 RAMTS1:	SEX	PC0		; just in case
 	POST($87)		; POST code 87 - RAM initialization test
 	RLDI(SP,STACK-1)	; try to point SP at some RAM somewhere
@@ -758,7 +891,7 @@ RAMTS1:	SEX	PC0		; just in case
 	INP	SWITCHES	; and read the switches
 	ANI	$FE		; ignore the LSB for this test
 	XRI	$42		; are they set to 0x42 or 0x43 ??
-	LBZ	DPTEST		; yes - force ram initialization
+	LBZ	KEYBAD		; yes - force ram initialization
 #endif
 	RLDI(P1,KEY)		; P1 points to the SRAM key
 	RLDI(P2,CHKSUM)		; and P2 points to the EPROM checksum
@@ -767,24 +900,33 @@ RAMTS1:	SEX	PC0		; just in case
 ; Compare the SRAM key with the EPROM signature...
 	LDXA			; get the first byte of the key
 	XRI	'r'		; test it
-	LBNZ	DPTEST		; branch if the key doesn't match
+	LBNZ	KEYBAD		; branch if the key doesn't match
 	LDXA			; next byte
 	XRI	'l'		; ...
-	LBNZ	DPTEST		; ...
+	LBNZ	KEYBAD		; ...
 	LDXA			; and the third
 	XRI	'a'		; ...
-	LBNZ	DPTEST		; ...
+	LBNZ	KEYBAD		; ...
 	LDN	P2		; finally, test the last two bytes ...
 	XOR			;  ... against the EPROM checksum
-	LBNZ	DPTEST		; ...
+	LBNZ	KEYBAD		; ...
 	IRX\ INC P2		; advance both pointers
 	LDN	P2		; and test one more byte
 	XOR			; ...
-	LBNZ	DPTEST		; ...
+	LBNZ	KEYBAD		; ...
 
-; Here if the current RAM contents are valid...
-	RLDI(DP,BATTOK)		; set the "battery OK" flag
+;   Here if the current RAM contents are valid.  P1 still points into the
+; data page, so that saves a byte loading DP...
+	GHI	P1		; set the "battery OK" flag
+	PHI	DP		; ...
+	LDI	LOW(BATTOK)	; ...
+	PLO	DP		; ...
+#ifdef MONEXT
+	GLO	T2		; $FF normally, or 1 for a fast boot
+	SMI	1		; ...
+#else
 	LDI	$FF		; ...
+#endif
 	STR	DP		; ...
 	LBR	DPDONE		; and then proceed with the initialization
 
@@ -801,6 +943,9 @@ RAMTS1:	SEX	PC0		; just in case
 ; the memory addressing beyond that, and it's not much to speak of.  Once
 ; the monitor is running, the RAMTEST command can be used for a much more
 ; exhaustive memory test...
+#ifndef MONEXT
+KEYBAD:				; no fast boot - a bad key always comes here
+#endif
 DPTEST:	SEX	PC0		; back to the regular X register
 	POST($86)		; monitor data page test
 	RLDI(DP,RAMPAGE+$FF)	; point to the monitor's data page
@@ -913,12 +1058,16 @@ RTCINI:
 ; the clock is ticking...
 	SEX	PC0		; X=P
 	WNVR(NVRA,DV1)		; be sure the oscillator is enabled
+#ifdef MONEXT
+	GLO	T2		; waiting for a tick can take a whole second,
+	LBNZ	NVRL1A		;  ... so skip it on a fast boot
+#endif
 NVRL1:	SEX	PC0		; X=P again
 	POST($75)		; POST code 75 RTC not ticking
 	RNVR(NVRA)		; read status register A
 	ANI	UIP		; test the update in progress bit
 	BZ	NVRL1		; wait for it to set
-	SEX	PC0		; X=P
+NVRL1A:	SEX	PC0		; X=P
 	POST($74)		; NVR battery dead
 	RNVR(NVRD)		; read control register D
 	XRI	VRT		; the VRT bit should be set, all others zero
@@ -941,11 +1090,11 @@ NVRL1:	SEX	PC0		; X=P again
 NVRL2:	SEX	PC0		; wait for the PF flag to set, and clear again
 	RNVR(NVRC)		; read register C
 	ANI	PF		; check the PF bit
-	BZ	NVRL2		; wait for it to set
+	LBZ	NVRL2		; wait for it to set
 NVRL3:	SEX	PC0		; ...
 	RNVR(NVRC)		; read register C
 	ANI	PF		; check the PF bit
-	BNZ	NVRL3		; wait for it to clear
+	LBNZ	NVRL3		; wait for it to clear
 	SEX	PC0		; turn off the square wave output
 	WNVR(NVRB,DM+HR24+DSE)	; ...
 	WNVR(NVRA,DV1)		; and turn off the divider chain
@@ -1062,13 +1211,17 @@ NOUART:
 ; because the delay is calculated for a 3MHz clock.  At 1.77Mhz it'll be about
 ; 1.69x longer and at 5Mhz it'll be 1.66x shorter!
 	POST($59)		; start of speaker test
+#ifdef MONEXT
+	GLO	T2		; no beep on a fast boot
+	LBNZ	SPTST2		; ...
+#endif
 	OUT	GPIO		; turn the speaker on
 	.DB	SPTONE		;  ... with a fixed tone
 	RLDI(P1,$51FF)		; 20991 iterations of this loop
 SPTST1:	DEC	P1		; [2] count down
 	GHI	P1		; [2] and wait for zero
 	BNZ	SPTST1		; [2] ...
-	OUT	GPIO		; then turn the speaker off
+SPTST2:	OUT	GPIO		; then turn the speaker off
 	.DB	SPOFF		; ...
 
 ;   We'd like to do some simple tests on the 8255 PPI to be sure its address
@@ -1225,7 +1378,7 @@ SYSI2B:	SEX	PC0		; do POST() one last time
 	POST($40)		; ...
 	RLDI(SP,STACK)		; initialize the stack pointer
 	RLDI(A,SYSIN3)		; continue processing from SYSIN3:
-	LBR	F_INITCALL	; and intialize the SCRT routines
+	LBR	CPUINI		; identify the CPU and intialize SCRT
 
 ;   Change the POST to 19 to indicate that all hardware tests have passed.
 ; Post codes in the range $10..$19 are used for various software initialization
@@ -1287,6 +1440,9 @@ SYSI3B:
 	RLDI(P1,VIDVER)		;  ... so we can save it in VIDVER
 	POPD			; ...
 	STR	P1		; ...
+	INC	P1		; and a reset always cancels SET VIDEO FAST
+	LDI	0		;  ... (VIDFST is next to VIDVER)
+	STR	P1		; ...
 #endif
 
 ;   Now initialize (or re-initialize) the console serial port.  The console can
@@ -1327,7 +1483,12 @@ RAMSIZE	.EQU	(RAMPAGE+$100) / 1024
 	LBNZ	SYSIN4		; branch if battery backup was OK
 	INLMES("INITIALIZED")	; SRAM was initialized from scratch
 	LBR	SYSI4A		; ...
-SYSIN4:	INLMES("CONTENTS OK")	; current SRAM contents were used
+SYSIN4:
+#ifdef MONEXT
+	CALL(FBMSG)		; "CONTENTS OK" or "FAST BOOT"
+#else
+	INLMES("CONTENTS OK")	; current SRAM contents were used
+#endif
 
 ; That's the end of line 1. Next, print all the copyright notice(s)...
 SYSI4A:	CALL(TCRLF)		; ...
@@ -1339,7 +1500,11 @@ SYSI4A:	CALL(TCRLF)		; ...
 
 ;  Probe for a master and/or slave ide drive and identify what we find...
 SYSI5A:	OUTI(LEDS,$14)		; POST code for IDE master
+#ifdef IDECACHE
+	LDI	$80		; test the master, with the data saved in NVR
+#else
 	LDI	0		; first test the IDE master drive
+#endif
 	CALL(PROBE)		; ...
 ;   Currently the IDE slave isn't supported by the BIOS, so there's no reason
 ; to probe for it.  It just makes the boot take longer!
@@ -1451,7 +1616,7 @@ MAIN1:	RLDI(SP,STACK)	; reset the stack pointer to the TOS
 ; in the monitor too!) but if the video is active then we can't do that...
 #ifdef VIDEO
 	CALL(ISCRTC)	; is the video card active:
-	BDF	MAIN10	; yep - skip this
+	LBDF	MAIN10	; yep - skip this
 #endif
 	RLDI(1,TRAP)	; allow breakpoints to be used inside monitor commands
 MAIN10:
@@ -1460,7 +1625,17 @@ MAIN10:
 	INLMES(">>>")	; print the monitor prompt
 	RLDI(P1,CMDBUF)	; address of the command line buffer
 	RLDI(P3,CMDMAX)	; and the length of the same
+#ifdef VIDEO
+	CALL(VIDWAK)	; turn the display on (if SET VIDEO FAST)
+#endif
+#ifdef UARTIRQ
+	CALL(TTYINP)	; read a command line
+#else
 	CALL(F_INPUTL)	; read a command line
+#endif
+#ifdef VIDEO
+	CALL(VIDSLP)	; and off again (this doesn't change DF)
+#endif
 	LBDF	MAIN2	; branch if the line was terminated by ^C
 	CALL(TCRLF)	; F_INPUT doesn't echo a <LF> at the end
 
@@ -1585,22 +1760,23 @@ SCANP2:	CALL(SCANP1)	; scan the first parameter
 	LBDF	CMDERR	; error if not
 			; and fall into SCANP1 to get the other parameter
 
-; Scan a single parameter and return its value in register P4...
+; Scan a single parameter and return its value in register P2...
 SCANP1:	CALL(F_LTRIM)	; ignore any leading spaces
 	LDN	P1	; get the next character
 	CALL(ISHEX)	; is it a hex digit?
 	LBNF	CMDERR	; no - print error message and restart
-	LBR	F_HEXIN	; scan a number and return in P2
+	LBR	HEXSCN	; scan a number and return in P2
 
 	.EJECT
 ;	.SBTTL	SHOW, SET and TEST Commands
 
 ;   These three little routines parse the SHOW, SET and TEST commands, each of
 ; which takes a secondary argument - e.g. "SHOW RTC", "SET BOOT", or "TEST RAM"!
-SHOW:	CALL(F_LTRIM)	; skip any spaces
+; The secondary argument is looked up in the table pointed to by P2...
+SHOW:	RLDI(P2,SHOCMD)	; point to the table of SHOW commands
+SUBCMD:	CALL(F_LTRIM)	; skip any spaces
 	CALL(ISEOL)	; there has to be an argument there
 	LBDF	CMDERR	; error if not
-	RLDI(P2,SHOCMD)	; point to the table of SHOW commands
 	LBR	COMND	; parse it (and call CMDERR if we can't!)
 
 SHOCMD:	CMD(4, "TERMINAL", SHOTERM)	; show terminal settings
@@ -1614,36 +1790,53 @@ SHOCMD:	CMD(4, "TERMINAL", SHOTERM)	; show terminal settings
 	CMD(2, "DATE",     SHOWTIME)	; show the real time clock
 	CMD(2, "EF",	   SHOWEF)	; print status of EF inputs
 	CMD(3, "CPU",      SHOCPU)	; print CPU type and speed
+#ifdef DCSLOTS
+	CMD(2, "DISK",     SHODSK)	; show disk cache statistics
+#endif
+#ifdef TRACE
+	CMD(2, "TRACE",    SHOTRC)	; show the last TRACE
+#endif
 	.DB	0
 
 
 ; Set command...
-SET:	CALL(F_LTRIM)	; ...
-	CALL(ISEOL)	; ...
-	LBDF	CMDERR	; ...
-	RLDI(P2,SETCMD)	; ...
-	LBR	COMND	; ...
+SET:	RLDI(P2,SETCMD)	; ...
+	LBR	SUBCMD	; ...
 
 SETCMD:	CMD(1, "Q",	  SETQ)		; set Q (for testing)
 	CMD(2, "DATE",    SETTIME)	; set the real time clock
 	CMD(3, "RESTART", SETRESTA)	; set the boot options
 	CMD(3, "NVR",     SETNVR)	; set the NVR contents
+#ifdef UARTIRQ
+	CMD(4, "TERMINAL",SETTRM)	; select the console driver
+#endif
+#ifdef VIDEO
+	CMD(3, "VIDEO",   SETVID)	; VT1802 display fast or slow
+#endif
+#ifdef MONEXT
+	CMD(4, "FASTBOOT",SETFBT)	; skip POST on a warm start
+#endif
 	.DB	0
 
 
 ; Test command...
-TEST:	CALL(F_LTRIM)	; ...
-	CALL(ISEOL)	; ...
-	LBDF	CMDERR	; ...
-	RLDI(P2,TSTCMD)	; ...
-	LBR	COMND
+TEST:	RLDI(P2,TSTCMD)	; ...
+	LBR	SUBCMD	; ...
 
-TSTCMD:	CMD(3, "RAM",   RAMTEST)	; exhaustive RAM test
+TSTCMD:
+#ifdef MONEXT2
+	CMD(3, "RAM",   RTTEST)		; RAM test engine
+#else
+	CMD(3, "RAM",   RAMTEST)	; exhaustive RAM test
+#endif
 #ifdef PIXIE
 	CMD(3, "PIXIE", PIXTEST)	; test CDP1861 video
 #endif
 #ifdef VIDEO
 	CMD(2, "VT1802",VTTEST)		; test VT1802 video terminal
+#endif
+#ifdef MONEXT3
+	CMD(2, "DISK",  TSTDSK)		; IDE disk transfer rate
 #endif
 	.DB	0
 
@@ -1752,6 +1945,11 @@ EXAM1:	RCOPY(P1,P3)	; copy the address
 ; memory between P3 and P4.  It's used by the EXAMINE command, but it
 ; can also be called from other random places, which is especially handy
 ; for chasing down bugs...
+;
+;   Each line is built in DMPBUF and then typed all at once by TMSG, which
+; is a lot faster than calling THEX2, TSPACE and F_TTY for every byte.
+; The spaces, the ">" and the CRLF never change, so they're stored only once
+; and after that each row just fills in the address, hex and ASCII parts.
 MEMDMP:	GLO	P3	; round P3 off to $xxx0
 	ANI	$F0	; ...
 	PLO	P3	; ...
@@ -1761,60 +1959,72 @@ MEMDMP:	GLO	P3	; round P3 off to $xxx0
 	CALL(F_INMSG)
 	.TEXT	"        0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F\r\n\000"
 
-; Print the address of this line (the first of a row of 16 bytes)...
-MEMDM2:	RCOPY(P1,P3)	; copy the address of this byte
-	CALL(THEX4)	; and then type it in hex
-	INLMES("> ")	; type a > character after the address
-	SKP		; skip the INC P3 the first time around
-
-; Now print a row of 16 bytes in hexadecimal...
-MEMDM3:	INC	P3	; on to the next byte...
-	CALL(TSPACE)	; leave some room between bytes
-	LDN	P3	; get the next byte from memory
-	CALL(THEX2)	; and type the data in two hex digits
-
-; Here to advance to the next data byte...
-MEMDM4:	GLO	P3	; get the current address
-	ANI	$0F	; have we done sixteen bytes??
-	XRI	$0F	; ???
-	LBNZ	MEMDM3	; no - on to the next address
-
-; Print all sixteen bytes again, put this time in ASCII...
-MEMDM5:	CALL(TSPACE)	; leave a few blanks
-	CALL(TSPACE)	; ...
-	GLO	P3	; restore the address back to the
-	ANI	$F0	;  ... beginning of the line
-	PLO	P3	; ...
-	SKP		; skip the INC P3 the first time around
-
-; If the next byte is a printing ASCII character, $20..$7E, then print it.
-MEMDM6:	INC	P3	; on to the next byte
-	LDN	P3	; get the byte
-	ANI	$60	; is it a control character??
-	LBZ	MEMDM7	; yep - print a dot
-	LDN	P3	; no - get the byte again
-	ANI	$7F	; ignore the 8th bit
-	XRI	$7F	; and is it a delete (rubout) ??
-	LBZ	MEMDM7	; yep - print a dot
-	XRI	$7F	; no - restore the original byte
-	CALL(F_TTY)	; and type it
-	LBR	MEMDM8	; on to the next byte
-
-; Here if the character isn't printing - print a "." instead...
-MEMDM7:	OUTCHR('.')	; do just that
-MEMDM8:	GLO	P3	; get the current address
-	ANI	$0F	; have we done sixteen bytes?
-	XRI	$0F	; ???
-	LBNZ	MEMDM6	; nope - keep printing
-
-; We're done with this line of sixteen bytes....
-	CALL(TCRLF)	; finish the line
-	CALL(F_BRKTEST)	; does the user want to stop early?
-	LBDF	MEMDM9	; branch if yes
-	INC	P3	; on to the next byte
-	CALL(P3LEP4)	; have we done all of them?
-	LBDF	MEMDM2	; nope, keep going
-MEMDM9:	RETURN		; yep - all done
+;   Initialize the line buffer - "xxxx>  hh hh ... hh  cccc...cccc\r\n".  It's
+; filled backwards starting from the null at the end, and the address and the
+; data bytes are left for MEMDM2 to fill in...
+	RLDI(P1,DMPBUF+DMPLEN-1); point to the end of the buffer
+	SEX	P1		; ...
+	LDI	0		; store the terminating null
+	STXD			; ...
+	LDI	CHLFD		; and the CRLF
+	STXD			; ...
+	LDI	CHCRT		; ...
+	STXD			; ...
+	LDI	DMPLEN-3-5	; then fill everything after the ">" with blanks
+	PLO	T1		; ...
+MEMDM1:	LDI	' '		; ...
+	STXD			; ...
+	DEC	T1		; ...
+	GLO	T1		; ...
+	BNZ	MEMDM1		; ...
+	LDI	'>'		; and finally the ">" after the address
+	STXD			; ...
+	SEX	SP		; ...
+
+; Build the address of this line (the first of a row of 16 bytes)...
+MEMDM2:	RLDI(P1,DMPBUF)		; P1 points to the hex part of the line
+	RLDI(P2,DMPBUF+DMPASC)	; and P2 points to the ASCII part
+	RLDI(T2,MHEX)		; set up the PC for MHEX
+	LDI	HIGH(HEXTAB)	; and T1.1 for the hex table
+	PHI	T1		; ...
+	GHI	P3		; convert the address to hex
+	SEP	T2		; ...
+	GLO	P3		; ...
+	SEP	T2		; ...
+	INC	P1		; skip over the ">"
+	INC	P1		;  ... and the two blanks
+	INC	P1		;  ... before the first byte
+
+; Now convert a row of 16 bytes to both hexadecimal and ASCII...
+MEMDM3:	LDN	P3		; get the next byte from memory
+	SEP	T2		; and convert it to two hex digits
+	INC	P1		; skip the blank between bytes
+	LDN	P3		; is it a control character??
+	ANI	$60		; ...
+	BZ	MEMDM4		; yep - use a dot instead
+	LDN	P3		; no - get the byte again
+	ANI	$7F		; ignore the 8th bit
+	XRI	$7F		; and is it a delete (rubout) ??
+	BZ	MEMDM4		; yep - use a dot
+	XRI	$7F		; no - restore the (7 bit) byte
+	LSKP			; ...
+MEMDM4:	LDI	'.'		; not printing - substitute a dot
+	STR	P2		; store the ASCII character
+	INC	P2		; ...
+	INC	P3		; on to the next byte
+	GLO	P3		; have we done sixteen bytes?
+	ANI	$0F		; ???
+	BNZ	MEMDM3		; nope - keep going
+
+;   We're done with this line of sixteen bytes - type it.  Note that P3 has
+; already been advanced to the next line...
+	RLDI(P1,DMPBUF)		; type the whole line at once
+	CALL(TMSG)		; ...
+	CALL(F_BRKTEST)		; does the user want to stop early?
+	LBDF	MEMDM9		; branch if yes
+	CALL(P3LEP4)		; have we done all of them?
+	LBDF	MEMDM2		; nope, keep going
+MEMDM9:	RETURN			; yep - all done
 
 	.EJECT
 ;	.SBTTL	Deposit Memory Command
@@ -1902,7 +2112,10 @@ RUN2:	RLDI(1,TRAP)	; register 1 still points to the TRAP function
 CALUSR:	CALL(SCANP1)	; in this case a parameter is required...
 	CALL(ISEOL)	; and then no more
 	LBNF	CMDERR	; ...
-	RLDI(T1,CALUS1)	; execute the rest of the code with P=T1
+#ifdef VIDEO
+	CALL(VIDWAK)	; the user's program may want the display
+#endif
+CALUS0:	RLDI(T1,CALUS1)	; execute the rest of the code with P=T1
 	SEP	T1	; ...
 
 ; Here to branch to the user's function...
@@ -2025,6 +2238,9 @@ SETBO1:	STR	DP		; first update BOOTF
 ; arguments and there's not much more to it than that!
 BOOTCMD:CALL(ISEOL)		; make sure there are no arguments
 	LBNF	CMDERR		; fail if there is
+#ifdef VIDEO
+	CALL(VIDWAK)		; ElfOS will want the display
+#endif
 
 ; The SYSINI routine calls here if the boot flag is set to BOOT...
 BOOTIDE:OUTSTR(BOOMSG)		; tell the user what we're doing
@@ -2042,7 +2258,9 @@ BOOMSG:	.TEXT	"Booting primary IDE ...\r\n\000"
 BFAMSG:	.TEXT	"?NOT BOOTABLE\r\n\000"
 
 ;   The SHOW IDE command prints a list of the IDE devices (there are at most
-; two!) attached.  It's the same information printed at startup by SYSINI.
+; two!) attached.  It's the same information printed at startup by SYSINI,
+; but it always resets and identifies the drives (even with IDECACHE) so it
+; also updates the data saved in NVR.
 SHOWIDE:CALL(ISEOL)		; arguments are neither required nor allowed
 	LBNF	CMDERR		; error if there's more
 	LDI	$00		; first probe for drive 0 (the master)
@@ -2058,7 +2276,8 @@ SHOWIDE:CALL(ISEOL)		; arguments are neither required nor allowed
 ; Once the drive is initialized the BIOS identify device function is used
 ; to determine the drive size and manufacturer.  When called, D should
 ; contain zero to test the primary (master) drive or 1 to test the secondary
-; (slave) drive...
+; (slave) drive.  If IDECACHE is defined, adding $80 to the unit lets it use
+; the size and model saved in NVR instead (see IDPRB)...
 PROBE:	STXD			; save the unit number on the stack
 	SHL\ SHL\ SHL\ SHL	; turn unit 1 to 0x10; unit zero stays zero
 	ORI	$E0		; the rest of these bits should be 1
@@ -2094,12 +2313,18 @@ NODRIVE:IRX			; remove the unit select from the stack
 
 ; Identify the unit we've found...
 PROBE1:	IRX\ LDX\ DEC SP	; get the unit number back from the stack
-	BZ	PROB1A		; jump if unit 0 selected
+#ifdef IDECACHE
+	ANI	$01		; (ignore the NVR flag)
+#endif
+	LBZ	PROB1A		; jump if unit 0 selected
 	INLMES("IDE Slave:  ")
-	BR	PROB1B
+	LBR	PROB1B
 PROB1A:	INLMES("IDE Master: ")
 
 ; Call the BIOS to reset the drive and then get its size in Mb...
+#ifdef IDECACHE
+PROB1B:	LBR	IDPRB		; it's all done at MONEXT5
+#else
 PROB1B:	IRX\ LDX\ DEC SP	; get the unit number back again
 	PLO	P2		; store it for the BIOS
 	CALL(F_IDERESET)	; and reset the drive
@@ -2129,6 +2354,7 @@ PROB1C:	CALL(TDEC16)		; type the size in megabytes
 	IRX			; fix the stack
 	CDF			; set DF=0
 	RETURN			; and we're done
+#endif
 
 ; Here if the drive has some hard error ...
 BADDRV:	OUTSTR(BADDR1)		; ?DRIVE ERROR
@@ -2327,7 +2553,11 @@ SHOTERM:CALL(ISEOL)		; no arguments
 	INLMES(" BAUD0=0x")
 	LDA	DP		; and now BAUD0
 	CALL(THEX2)		; ...
+#ifdef UARTIRQ
+	LBR	SHOIRQ		; show the console driver and return
+#else
 	LBR	TCRLF		; type CRLF and return
+#endif
 
 #ifdef VIDEO
 ;   Here if the video card and PS2 keyboard are in use.  Note that the name
@@ -2403,26 +2633,36 @@ RESBOO:	INLMES("BOOT")
 ; the 1804 had on chip mask programmed ROM and I really doubt that anybody
 ; is using one of these.  AFAIK, there's no software way to distinguish any
 ; of the 1804, 1805, or 1806 processors.
-SHOCPU:
-
-;  The first thing is to figure out whether the CPU is an 1802 or the newer
-; 1805/6.  This is pretty easy because the 1805/6 have additional two byte
-; opcodes which use 0x68 as the prefix, and on the original 1802 opcode 0x68
-; is a no-op.  So the two byte sequence 0x68, 0x68 is just two no-ops on the
-; 1802, and on the 1805/6 it's the "RLXA 8" (register load via X and advance)
-; instruction.
-	PUSHR(8)		; save register 8 just in case it's important
-	RCLEAR(P1)		; make P1 be zero
+;
+;   SYSI2B jumps to CPUINI, still with P=0, to figure out whether the CPU is an
+; 1802 or the newer 1805/6 before it initializes SCRT.  This is pretty easy
+; because the 1805/6 have additional two byte opcodes which use 0x68 as the
+; prefix, and on the original 1802 opcode 0x68 is a no-op.  So the two byte
+; sequence 0x68, 0x68 is just two no-ops on the 1802, and on the 1805/6 it's
+; the "RLXA 8" (register load via X and advance) instruction.  That advances X
+; by two, so P1 is left zero on an 1802 and two on an 1805/6 ...
+CPUINI:	RCLEAR(P1)		; make P1 be zero
 	SEX	P1		; and then use that for X
 	.DB	68H, 68H	; then do "RLXA 8"
-	SEX	SP		; back to the real stack
-	IRX			; and restore R8
-	POPRL(8)		; ...
-
-;   If P1 is still zero, then the CPU is an 1802.  If P1 has been incremented,
-; then the CPU is a 1805/6...
-	GLO	P1		; let's see
-	BZ	CPU02		; branch if it's a 1802
+	INC	SP		; CPUTYP is just above the stack
+	GLO	P1		; remember the answer there
+	STR	SP		; ...
+	DEC	SP		; ...
+#ifdef CDP1805
+	LBR	INITSC		; and initialize the SCRT routines
+#else
+	LBR	F_INITCALL	; and initialize the SCRT routines
+#endif
+
+; Here for the SHOW CPU command ...
+SHOCPU:
+
+;  The first thing is to say whether the CPU is an 1802 or the newer 1805/6,
+; and CPUINI has already figured that out ...
+	LDI	LOW(CPUTYP)	; zero for an 1802
+	PLO	DP		; ...
+	LDN	DP		; let's see
+	LBZ	CPU02		; branch if it's a 1802
 	INLMES("CDP1804/5/6")	; nope - it's a 1805/6 - lucky you!
 	BR	SHOCP0		; then continue with the speed measurement
 CPU02:	INLMES("CDP1802")	; a more traditional type
@@ -2448,7 +2688,7 @@ SHOCP0:
 SHOCP1:	SEX	PC		; RNVR does an inline OUT
 	RNVR(NVRC)		; read register C
 	ANI	PF		; is the PF bit set?
-	BZ	SHOCP1		; nope - keep waiting
+	LBZ	SHOCP1		; nope - keep waiting
 
 ;   Now that we have a known real time interval, measuring the CPU clock is
 ; pretty simple.  We simply execute a loop that uses a known number of CPU
@@ -2559,6 +2799,7 @@ VTTEST:	CALL(ISEOL)		; no more arguments allowed
 ; done by video.asm.  After the screen is displayed, we wait for any character,
 ; clear the screen, and then continue...
 VTTES0:	OUTSTR(VTTMSG)		; display the test screen
+	CALL(VIDWAK)		; make sure it can be seen
 	CALL(F_READ)		; wait for any character
 	OUTSTR(CLSMSG)		; clear the screen
 	RETURN			; and we're done
@@ -2767,6 +3008,10 @@ CONT1:	RLDI(0,REGS+4)		; point R0 at the saved registers
 	LDXA			; and finally load SAVEDF
 	SHRC			; restore DF
 	SEX	2		; switch to the user's stack
+#ifdef TRACE
+	LDA	0		; is this a TRACE step (R0 points to REGS)?
+	LBNZ	TRTRX		; yes - TRACE finishes up itself
+#endif
 	LDXA			; and restore D
 
 ;  The last instruction is a minor trick - we have to restore (X,P) from the
@@ -2805,7 +3050,7 @@ TRAP:	SEX	2	; and assume there's a stack pointer in R(2)
 	STR	2	; and then save that too
 
 ; Save registers R(F) thru R(2) in memory at REGS:...
-	RLDI(R0,REGS+32-1)
+TRAP1:	RLDI(R0,REGS+32-1)
 	SEX	0
 	PUSHR($F)
 	PUSHR($E)
@@ -2847,14 +3092,25 @@ TRAP:	SEX	2	; and assume there's a stack pointer in R(2)
 ; context so that things will work (e.g. OUTCHR, THEX4, etc)...
 	RLDI(SP,STACK)		; initialize the stack
 	RLDI(A,TRAP2)		; continue processing from TRAP2:
+#ifdef CDP1805
+	LBR	INITSC		; and initialize the SCRT routines
+#else
 	LBR	F_INITCALL	; and initialize the SCRT routines
+#endif
 
 ;   We get here once all the context has been saved after a breakpoint.
 ; At this time the normal BOOTS context has been re-established and things
 ; should work pretty much as we expect.  Nwo we type out the user's registers
 ; (the same as the "SHOW REGISTERS" command) and then rejoin the main monitor
 ; loop...
-TRAP2:	CALL(TTYINI)		; reset the terminal baud rate
+TRAP2:
+#ifdef TRACE
+	RLDI(DP,SAVEXP)		; is this TRACE's breakpoint?
+	LDN	DP		; (see TRTRP)
+	XRI	$01		; ...
+	LBZ	TRSTEP		; yes
+#endif
+	CALL(TTYINI)		; reset the terminal baud rate
 	CALL(SHORE1)		; print the registers 
 	LBR	MAIN		; and go print a monitor prompt
 	.EJECT
@@ -2872,6 +3128,7 @@ SHOREG:	CALL(ISEOL)		; should be the end of the line
 ; Here to display the registers after a break point....
 SHORE1:	RLDI(DP,SAVEXP)		; point DP at the user's context info
 	OUTSTR(BPTMSG)		; print "BREAKPOINT ..."
+SHORE2:
 
 ; Print a couple of CRLFs and then display X, D and DF...
 	INLMES(" @ XP=")	; ...
@@ -3059,20 +3316,39 @@ DSP1PG:	SEX	SP		; two cycle delay (NOP is 3 cycles!)
 ; you can see it!
 PHELP:	CALL(ISEOL)		; HELP has no arguments
 	LBNF	CMDERR		; error if it does
+#ifdef HELPLZ
+	RLDI(P4,HELP)		; the help text is compressed - see HLPBLK
+#endif
 #ifdef VIDEO
 	CALL(ISCRTC)		; is the VT1802 in use ??
 	LBDF	PHELP0		; branch if so
 #endif
+#ifdef HELPLZ
+PHELPS:	CALL(HLPBLK)		; type it a block at a time
+	BDF	PHELPT		; quit at the end
+	CALL(TMSG)		; ...
+	BR	PHELPS		; ...
+PHELPT:	RETURN			; ...
+#else
 	RLDI(P1,HELP)		; nope - just print the whole text
 	LBR	F_MSG		; ... print it and return
+#endif
 
 #ifdef VIDEO
 ;  We get here if the VT1802 video terminal is in use as the console.
+#ifdef HELPLZ
+PHELP0:	CALL(HLPBLK)		; expand the first block into DSKBUF
+#else
 PHELP0:	RLDI(P2,HELP)		; point to the help text
+#endif
 PHELP1:	LDI	0		; keep count of the number of lines
 	PLO	P3		;  ... here ...
 PHELP2:	LDA	P2		; get a byte from the message
+#ifdef HELPLZ
+	LBZ	PHELP5		; expand the next block at the end of this one
+#else
 	LBZ	PHELP9		; quit at the end of the string
+#endif
 	CALL(F_TTY)		; type it out
 	XRI	CHLFD		; was it a line feed?
 	BNZ	PHELP2		; nope - nothing special
@@ -3085,12 +3361,19 @@ PHELP2:	LDA	P2		; get a byte from the message
 
 ; We've done a full screen - say MORE and wait for input...
 	OUTSTR(MORMSG)		; "--More--"
+	CALL(VIDWAK)		; be sure the display is on
 	CALL(F_READ)		; wait for input
 	XRI	CHCTC		; is it a Control-C ??
 	LBZ	PHELP9		; yes - just quit now
 	OUTSTR(EELMSG)		; nope - erase the More message
 	LBR	PHELP1		; and keep typing
 
+#ifdef HELPLZ
+; Here at the end of a block - expand the next one, if there is one ...
+PHELP5:	CALL(HLPBLK)		; ...
+	LBNF	PHELP2		; and keep typing
+#endif
+
 ; Here when we're done...
 PHELP9:	OUTSTR(EELMSG)
 	RETURN
@@ -3147,7 +3430,8 @@ CLSCMD:	CALL(ISEOL)		; no arguments allowed
 RTSMSG:	.TEXT	"Testing RAM \000"
 REAMSG:	.TEXT	"\r\n?RAM ERROR AT \000"
 
-; Start the memory test ...
+; Start the memory test (TEST RAM uses RTTEST instead if MONEXT2 is defined) ...
+#ifndef MONEXT2
 RAMTEST:CALL(ISEOL)		; there should be no more text
 	LBNF	CMDERR		; ... after the command		
 	CALL(CLRPEK)		; clear PASSK and ERRORK
@@ -3267,6 +3551,7 @@ RAMT5:	CALL(INPASK)		; increment PASSK
 	CALL(PRTPEK)		; print the pass/error count
 	CALL(TCRLF)		; finish the line
 	LBR	RAMT0		; and go start another pass
+#endif
 
 	.EJECT
 ;	.SBTTL	Diagnostic Support Routines
@@ -3494,27 +3779,23 @@ GHEX4:	CALL(GHEX2)	; get the first two digits
 GHEX40:	RETURN		; all done
 
 ;   This routine will scan a two hex number pointed to by P1 and return its
-; value in D.  Unlike F_HEXIN, which will scan an arbitrary number of digits,
+; value in D.  Unlike HEXSCN, which will scan an arbitrary number of digits,
 ; in this case the number must contain exactly two digits - no more, and no
 ; less.  If we don't find two hex digits in the string addressed by P1, the
 ; DF bit will be cleared on return and P1 left pointing to the non-hex char.
-GHEX2:	LDN	P1	; get the first character
-	CALL(ISHEX)	; is it a hex digit???
-	BNF	GHEX40	; nope - quit now
+; The digits are converted by HEXDL, so T2 is changed too.
+GHEX2:	RLDI(T2,HEXDL)	; set up the PC for HEXDL
+	SEP	T2	; convert the first digit
+	BNF	GHEX20	; nope - quit now
 	SHL\ SHL	; shift the first nibble left 4 bits
 	SHL\ SHL	; ...
 	PLO	T1	; and save it temporarily in T1
-	INC	P1	; ...
-	LDN	P1	; then get the next character
-	CALL(ISHEX)	; is it a hex digit?
+	SEP	T2	; then convert the next digit
 	BNF	GHEX20	; not there - quit now
-	STXD		; stack the second digit
-	IRX		; and then address it
+	STR	SP	; stack the second digit
 	GLO	T1	; get the first four bits
 	OR		; and put them together
-	INC	P1	; on to the next digit
-	SDF		; return with DF set
-GHEX20:	RETURN		; and we're all done
+GHEX20:	RETURN		; and we're all done (HEXDL left DF set)
 
 	.EJECT
 ;	.SBTTL	Arithmetic Comparisons
@@ -3614,9 +3895,9 @@ TDEC16:	RLDI(P2,10)		; set the divisor
 	GLO	P1		; get the remainder
 	PUSHD			; and stack that for a minute
 	RCOPY(P1,P4)		; transfer the quotient back to P1
-	BNZ	TDEC1A		; if the quotient isn't zero ...
+	LBNZ	TDEC1A		; if the quotient isn't zero ...
 	GHI	P1		;  ... then keep dividing
-	BZ	TDEC1B		;  ...
+	LBZ	TDEC1B		;  ...
 TDEC1A:	CALL(TDEC16)		; keep typing P1 recursively
 TDEC1B:	POPD			; then get back the remainder
 	LBR	THEX1		; type it in ASCII and return
@@ -3638,12 +3919,20 @@ RBASIC:	RLDI(T2,BASIC)
 
 ;   Here's the common code for all cases...  When we get here, the main entry
 ; point for the language should be in T2...
-RBAS1:	CALL(ISEOL)	; is there more on the command line
+RBAS1:
+#ifdef VIDEO
+	CALL(VIDWAK)	; the languages do their own console I/O
+#endif
+	CALL(ISEOL)	; is there more on the command line
 	LBNF	RBAS2	; if there is more, check for NEW or OLD argument
 	OUTSTR(NEWOLD)	; ask "New or Old ?"
 	RLDI(P1,CMDBUF)	; read another command line
 	RLDI(P3,CMDMAX)	; ...
+#ifdef UARTIRQ
+	CALL(TTYINP)	; ...
+#else
 	CALL(F_INPUTL)	; ...
+#endif
 	CALL(TCRLF)	; ...
 	RLDI(P1,CMDBUF)	; setup P1 to point to the new "command"
 RBAS2:	CALL(F_LTRIM)	; skip any leading spaces
@@ -3686,6 +3975,9 @@ RFORTH:	RLDI(T2,FORTH)
 #ifdef SEDIT
 RSEDIT:	CALL(ISEOL)	; should be no arguments
 	LBNF	CMDERR	; error if there are
+#ifdef VIDEO
+	CALL(VIDWAK)	; turn the display on
+#endif
 	LBR	SEDIT	; start SEDIT ...
 #endif
 
@@ -3693,6 +3985,9 @@ RSEDIT:	CALL(ISEOL)	; should be no arguments
 #ifdef VISUAL
 RVISUAL:CALL(ISEOL)	; there are no arguments
 	LBNF	CMDERR	; error if there are
+#ifdef VIDEO
+	CALL(VIDWAK)	; turn the display on
+#endif
 	LBR	VISUAL	; start Visual/02 ...
 #endif
 
@@ -3728,8 +4023,37 @@ CMDTBL:	CMD(4, "CONTINUE", CONTINUE)	; continue after a breakpoint
 	CMD(2, "OUTPUT",   OUTPUT)	;  "   output  "
 	CMD(2, "INPUT",    INPUT)	; test input port
 	CMD(2, "CALL",     CALUSR)	; "call" a user's program
+#ifdef REMOTE
+	CMD(3, "REMOTE",   RMTCMD)	; binary packets for programs on the host
+#endif
 	CMD(2, "RUN",      RUNUSR)	; "run"  "   "     "   "
+#ifdef PROFILE
+	CMD(4, "PROFILE",  PRFCMD)	; call a program and sample its PC
+#ifdef MONEXT6
+	CMD(2, "TIME",     TIMCMD)	; call a program and time it
+#endif
+#endif
+#ifdef TRACE
+	CMD(2, "TRACE",    TRCCMD)	; call a program and trace it
+#endif
 	CMD(2, "HELP",	   PHELP)	; print help text
+#ifdef MEMCMDS
+;   SEARCH has to come before SET, or "SE" would match SET and then complain
+; about "ARCH"...
+	CMD(2, "FILL",     FILCMD)	; fill memory with a byte
+	CMD(2, "MOVE",     MOVCMD)	; copy a block of memory
+	CMD(3, "COMPARE",  CMPCMD)	; compare two blocks of memory
+	CMD(3, "SEARCH",   SRCCMD)	; search memory for a string
+#endif
+#ifdef MEMCRC
+	CMD(2, "CHECKSUM", CRCCMD)	; CRC-16 of a block of memory
+#endif
+#ifdef PPIXFER
+	CMD(3, "PARALLEL", PARCMD)	; memory transfers thru the GPIO PPI
+#endif
+#ifdef SAVEHEX
+	CMD(2, "SAVE",     SAVCMD)	; type memory as an Intel .HEX file
+#endif
 	CMD(2, "SET",      SET)
 	CMD(2, "SHOW",     SHOW)
 	CMD(2, "TEST",	   TEST)
@@ -3739,6 +4063,9 @@ CMDTBL:	CMD(4, "CONTINUE", CONTINUE)	; continue after a breakpoint
 	CMD(1, "BOOT",     BOOTCMD)	; boot from the primary IDE disk
 	CMD(1, "EXAMINE",  EXAM)	; examine/dump memory bytes
 	CMD(1, "DEPOSIT",  DEPOSIT)	; deposit data in memory
+#ifdef MONEXT
+	CMD(2, "LOAD",     HLOAD)	; fast load of a whole .HEX file
+#endif
 	CMD(1, ":",        IHEX)	; load Intel .HEX format files
 	CMD(1, ";",	   MAIN)	; a comment
 #ifdef VIDEO
@@ -3748,6 +4075,278 @@ CMDTBL:	CMD(4, "CONTINUE", CONTINUE)	; continue after a breakpoint
 ; The table always ends with a zero byte...
 	.DB	0
 
+	.EJECT
+;	.SBTTL	Fast Hex Conversion and String Output for MEMDMP
+
+;   This subroutine converts the byte in D to two hex digits and stores them
+; at P1, which is incremented twice.  Like HLDHEX it runs with T2 as the
+; program counter (call it with "SEP T2"), and T1.1 must point to HEXTAB's
+; page.  It's used only by MEMDMP, and it lives out here only because there's
+; room for it.  T1.0 and the top of the stack are used as temporaries...
+;
+;   MHEX, HEXTAB and TMSG together are at most 72 bytes, and MHEX and TMSG
+; use short branches, so skip to the next page if they won't all fit here...
+#if (($ & $FF00) != (($+71) & $FF00))
+	PAGE
+#endif
+MHEXR:	SEP	PC		; return to the caller
+MHEX:	STR	SP		; save the byte for a moment
+	SHR\ SHR\ SHR\ SHR	; get the high nibble first
+	ADI	LOW(HEXTAB)	; and look it up in the table
+	PLO	T1		; ...
+	LDN	T1		; ...
+	STR	P1		; store the first digit
+	INC	P1		; ...
+	LDN	SP		; now get the low nibble
+	ANI	$0F		; ...
+	ADI	LOW(HEXTAB)	; ...
+	PLO	T1		; ...
+	LDN	T1		; ...
+	STR	P1		; and store the second digit
+	INC	P1		; ...
+	BR	MHEXR		; ...
+HEXTAB:	.TEXT	"0123456789ABCDEF"
+
+;   This routine types the null terminated string at P1, just like F_MSG.
+; But if the UART is the console then it sends the characters to the UART
+; itself, and if the VT1802 is the console it hands the whole string to
+; VTPUTS.  Either way that saves a trip thru SCRT and the BIOS console code
+; for every character, which is most of the time it takes to type a string.
+; Interrupts are always off here, so nobody else can change the UART's
+; register select while we're using it.  Anything else goes to F_MSG...
+TMSG:	GHI	BAUD		; is the hardware UART the console?
+	ANI	$FE		; ignore the local echo bit
+	BNZ	TMSG3		; no
+TMSG1:	LDN	P1		; any more characters to type?
+	BZ	TMSG9		; no - quit
+	OUTI(UART_SELECT,LSR)	; wait for the transmitter to be ready
+TMSG2:	INP	UART_DATA	; ...
+	ANI	THRE		; ...
+	BZ	TMSG2		; ...
+	OUTI(UART_SELECT,THR)	; and then send the next character
+	SEX	P1		; ...
+	OUT	UART_DATA	; ...
+	SEX	SP		; ...
+	BR	TMSG1		; ...
+TMSG9:	RETURN			; ...
+#ifdef VTPUTS
+TMSG3:	XRI	$FE		; is the VT1802 the console?
+	LBZ	VTPUTS		; yes - let it do the work
+	LBR	F_MSG		; no - use the BIOS
+#else
+TMSG3:	LBR	F_MSG		; use the BIOS
+#endif
+#if ((MHEXR & $FF00) != ($ & $FF00))
+	.ECHO	"**** ERROR **** MHEX, HEXTAB and TMSG must be on the same page!"
+#endif
+
+	.EJECT
+;	.SBTTL	PROFILE Command
+
+;   The PROFILE command calls a program, just like CALL, but while it runs the
+; DS12887 periodic interrupt samples its program counter 256 times a second -
+;
+;	>>>PROF[ILE] addr
+;
+; The samples are counted by page, in 256 sixteen bit counts (low byte first)
+; in DSKBUF, and when the program returns (or the console receives a BREAK)
+; PRFRPT types the count for every page that was sampled.  Only R3 is sampled,
+; since that's the program counter for SCRT programs almost all of the time,
+; and any sample taken with some other P (the SCRT routines themselves,
+; mostly) is counted as "other" in the slot for RAMPAGE - no program ever runs
+; there.  The interrupt uses the program's stack, just like a breakpoint, so
+; R2 has to be valid the whole time and R1 isn't available to the program.
+; A tick that comes while the program is inside the BIOS waits until the BIOS
+; returns (see PRFISD), so BIOS time is counted in the caller's page.  The
+; counts wrap around after 65536 samples, or about four minutes in the same
+; page.
+;
+;   TIME uses the same sampler, but PRFTIM tells PRFRPT to type just the total
+; as an elapsed time (see TIMRPT).
+#ifdef PROFILE
+#ifdef MONEXT6
+TIMCMD:	LDI	1		; TIME - type just the elapsed time
+	LSKP			; ...
+PRFCMD:	LDI	0		; PROFILE - type all the samples
+	PLO	T1		; ...
+	LDI	LOW(PRFTIM)	; ...
+	PLO	DP		; ...
+	GLO	T1		; ...
+	STR	DP		; ...
+#else
+PRFCMD:
+#endif
+	CALL(SCANP1)		; get the address
+	CALL(ISEOL)		; and that had better be all
+	LBNF	CMDERR		; ...
+#ifdef VIDEO
+	CALL(NOCRTC)		; the VT1802 needs the interrupts
+	BDF	TMSG9		; ...
+#endif
+	RLDI(T1,DSKBUF)		; clear all the counts
+PRFCM1:	LDI	0		; ...
+	STR	T1		; ...
+	INC	T1		; ...
+	GHI	T1		; ...
+	XRI	HIGH(DSKBUF+512); ...
+	BNZ	PRFCM1		; ...
+	LBR	PRFGO		; check for the RTC and call the program
+
+;   While the program runs, RETPC points here instead of to the usual SCRT
+; return.  It's the same as the BIOS RETURN except that it always turns the
+; interrupts back on, and that lets in any tick that PRFISR put off because
+; the program was inside the BIOS (see PRFISD) ...
+PRFRX:	SEX	RETPC		; back to the caller with interrupts on
+	RET			; ...
+	.DB	(SP<<4) | PC	; ...
+PRFRET:	PLO	BAUD		; save D
+	GHI	A		; copy the linkage register to the PC
+	PHI	PC		; ...
+	GLO	A		; ...
+	PLO	PC		; ...
+	SEX	SP		; and pop the old linkage register
+	IRX			; ...
+	LDXA			; ...
+	PLO	A		; ...
+	LDX			; ...
+	PHI	A		; ...
+	GLO	BAUD		; restore D
+	BR	PRFRX		; ...
+
+;   Here's the sampler's interrupt service routine.  It saves D, DF and T1
+; (and X and P, of course) and nothing else is changed.  Like UISR, the exit
+; code comes first so that R1 is left pointing to PRFISR ...
+PRFISX:	IRX			; restore T1
+	POPR(T1)		; ...
+	LDXA			; then DF
+	SHL			; ...
+	LDXA			; then D
+	RET			; and finally X, P and IE
+PRFISR:	DEC	SP		; make a space on the stack
+	SAV			; and push T (the saved X,P)
+	DEC	SP		; ...
+	STXD			; save D
+	SHRC			; and DF
+	STXD			; ...
+	GHI	PC		; is the program inside the BIOS?
+	SMI	HIGH(MONXTOP)	;  (the BIOS starts right after MONEXT)
+	BDF	PRFISD		; yes - leave the select port alone
+	PUSHR(T1)		; no - save T1
+	SEX	INTPC		; read register C to clear the interrupt
+	RNVR(NVRC)		; ...
+	SEX	INTPC		; has the console received a BREAK?
+	RUART(LSR)		; ...
+	ANI	BI		; ...
+	LBNZ	PRFBRK		; yes - give up now
+	SAV			; no - get T again
+	LDX			; ...
+	ANI	$0F		; was P three?
+	XRI	PC		; ...
+	BNZ	PRFIS1		; no - count it as "other"
+	GHI	PC		; yes - count R3's page
+	LSKP			; ...
+PRFIS1:	LDI	HIGH(RAMPAGE)	; ...
+	SHL			; the count is at DSKBUF+2*page
+	PLO	T1		; ...
+	LDI	HIGH(DSKBUF)	; ...
+	ADCI	0		; ...
+	PHI	T1		; ...
+	LDN	T1		; increment the low byte
+	ADI	1		; ...
+	STR	T1		; ...
+	INC	T1		; and carry into the high byte
+	LDN	T1		; ...
+	ADCI	0		; ...
+	STR	T1		; ...
+	BR	PRFISX		; ...
+
+;   The RTC, the UART and the IDE disk all share the same write only register
+; select port, and if the tick comes while the BIOS is between selecting a
+; register and using it then reading C (or the LSR) would change the register
+; under it.  So if R3 is in the BIOS the sampler just leaves, with interrupts
+; off and the tick still pending, and the next RETURN (PRFRET) lets it in
+; again - the sample goes to whoever called the BIOS.  R1 has to be left
+; pointing to PRFISR this way too ...
+PRFISD:	IRX			; restore DF
+	LDXA			; ...
+	SHL			; ...
+	LDXA			; and D
+	DIS			; and X and P, but leave interrupts off
+	BR	PRFISR		; ...
+#endif
+
+	.EJECT
+;	.SBTTL	Fast Hex Scanning
+
+;   HEXDL converts the hex digit pointed to by P1 to its binary value and
+; returns that in D with DF=1, and P1 is advanced past it.  If the character
+; isn't a hex digit then DF=0 and P1 is left alone.  Upper and lower case both
+; work.  Like MHEX and HLDHEX it runs with T2 as the program counter (call it
+; with "SEP T2"), so a call costs one instruction instead of a trip thru SCRT
+; and back, and T2 points to HEXDL again afterwards so the caller can go on
+; calling it.  It doesn't use X, the stack or any other register, and that's
+; why GHEX2 and HEXSCN use it instead of calling ISHEX (and FOLD) for every
+; digit.  ISHEX is still there for everybody else.
+;
+;   HEXDL and HEXSCN use short branches, so they have to be on one page.  On
+; the Elf 2000 there's no room for them in the monitor, and they go to
+; MONEXT10 instead...
+#ifdef MONEXT10
+HEXSAV	.EQU	$		; remember where we were
+	.ORG	MONEXT10	; ...
+#endif
+#if (($ & $FF00) != (($+66) & $FF00))
+	PAGE
+#endif
+HEXDR:	SEP	PC		; return to the caller
+HEXDL:	LDN	P1		; get the character
+	SMI	'0'		; is it a decimal digit?
+	BL	HEXDR		; no - it's less than '0'
+	SMI	10		; ...
+	BL	HEXDL1		; yes
+	ANI	$DF		; no - fold 'a'..'f' onto 'A'..'F'
+	SMI	'A'-'9'-1	; and see if it's one of those
+	BL	HEXDR		; no
+	SDI	5		; ...
+	BNF	HEXDR		; no
+	SDI	5		; yes - 0..5 for 'A'..'F'
+HEXDL1:	ADI	10		; D = 0..15
+	INC	P1		; skip over the digit
+	SDF			; and return DF=1
+	BR	HEXDR		; ...
+
+;   HEXSCN scans a hex number with any number of digits, pointed to by P1, and
+; returns its value in P2.  P1 is left pointing to the first character after
+; the number.  It's the same as the BIOS F_HEXIN, which SCANP1 used to call,
+; but it's about twice as fast with HEXDL.  T2 and BAUD.0 are changed ...
+HEXSCN:	RLDI(T2,HEXDL)		; set up the PC for HEXDL
+	RCLEAR(P2)		; start with zero
+HEXSC1:	SEP	T2		; convert the next digit
+	BNF	HEXSC2		; that's the end of the number
+	PLO	BAUD		; save the digit for a moment
+	GLO	P2		; shift P2 left four bits
+	SHR\ SHR\ SHR\ SHR	;  ... the top of P2.0
+	STR	SP		;  ... goes to the bottom of P2.1
+	GHI	P2		; ...
+	SHL\ SHL\ SHL\ SHL	; ...
+	OR			; ...
+	PHI	P2		; ...
+	GLO	BAUD		; and the new digit goes to
+	STR	SP		;  the bottom of P2.0
+	GLO	P2		; ...
+	SHL\ SHL\ SHL\ SHL	; ...
+	OR			; ...
+	PLO	P2		; ...
+	BR	HEXSC1		; and keep going
+HEXSC2:	RETURN			; ...
+
+#ifdef MONEXT10
+#if ($ > MONX10TOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow at MONEXT10!"
+#endif
+	.ORG	HEXSAV		; and back to where we were
+#endif
+
 	.EJECT
 ;	.SBTTL	Sample Bitmaps for CDP1861 Display
 
@@ -3796,6 +4395,4532 @@ NCC1701:
 	.DB	$00,$00,$07,$F0,$00,$00,$00,$00
 #endif
 
+#ifdef MONEXT3
+	.EJECT
+;	.SBTTL	TEST DISK Command
+
+;   The TEST DISK command measures how fast DKREAD and DKWRIT can move data
+; to and from the master IDE drive -
+;
+;	TE[ST] DI[SK] [WR[ITE]]
+;
+;   It transfers 16 sectors (8K) at a time to or from memory at $0000 for four
+; seconds, as timed by the RTC, and then prints the rate in Kb per second.
+; The read test reads sequentially from sector zero, and the write test reads
+; sectors 0..15 first and then writes them back over and over again, so the
+; contents of the drive don't change.  Either one wipes out the first 8K of
+; RAM, though.  TIMBUF+0 is the last RTC seconds value, TIMBUF+1 counts the
+; seconds and TIMBUF+2 is zero for the read test.  There's no room for this
+; at MONEXT3 (it's full of help text!) so it lives here, after everything
+; else in the monitor ...
+TSTDSK:	CALL(F_LTRIM)		; ignore any spaces
+	CALL(ISEOL)		; no arguments?
+	BDF	DKTRD		; yes - test reads
+	RLDI(P2,DKTOPT)		; no - look up the option
+	LBR	COMND		; ...
+
+; Table of TEST DISK options ...
+DKTOPT:	CMD(2, "WRITE", DKTWR)	; write test
+	.DB	0
+
+; Here for TEST DISK WRITE ...
+DKTWR:	CALL(F_LTRIM)		; that had better be all
+	CALL(ISEOL)		; ...
+	LBNF	CMDERR		; ...
+	LDI	1		; write test
+	LSKP			; ...
+DKTRD:	LDI	0		; read test
+	PHI	T2		; save it for a moment
+	LDI	LOW(TIMBUF+2)	; and then save it in TIMBUF
+	PLO	DP		; ...
+	GHI	T2		; ...
+	STR	DP		; ...
+
+; Reset the drive and select 16 sector blocks ...
+	CALL(F_RTCTEST)		; we need the RTC for timing
+	LBNF	NORTC		; ...
+	SEX	PC		; PROBE leaves the slave selected if there
+	WIDE(IDELBA3,$E0)	;  isn't one, so select the master first
+	SEX	SP		;  (the BIOS waits for the old drive!)
+	LDI	0		; reset the master drive
+	PLO	P2		; ...
+	CALL(F_IDERESET)	; ...
+	BDF	DKTERR		; ...
+	CALL(DKINIT)		; (it doesn't matter if that fails)
+	RCLEAR(P2)		; start at sector zero
+	LDI	0		; ...
+	PLO	P4		; ...
+	LDI	LOW(TIMBUF+2)	; read or write?
+	PLO	DP		; ...
+	LDN	DP		; ...
+	PHI	P4		; ...
+	BZ	DKTST1		; read - just go
+	RCLEAR(P1)		; write - read the data to write back
+	LDI	16		; ...
+	PLO	P3		; ...
+	CALL(DKREAD)		; ...
+	BDF	DKTERR		; ...
+
+; Wait for the next second to start exactly, then start counting ...
+DKTST1:	CALL(DKTICK)		; remember the seconds now
+DKTST2:	CALL(DKTICK)		; and wait for them to change
+	BNF	DKTST2		; ...
+	LDI	LOW(TIMBUF+1)	; count four seconds
+	PLO	DP		; ...
+	LDI	4		; ...
+	STR	DP		; ...
+	CALL(CLRPEK)		; PASSK counts the blocks
+
+; Transfer another 16 sectors ...
+DKTST3:	RCLEAR(P1)		; always at $0000
+	LDI	16		; ...
+	PLO	P3		; ...
+	GHI	P4		; read or write?
+	BNZ	DKTST4		; ...
+	CALL(DKREAD)		; read the next 16 sectors
+	BDF	DKTERR		; ...
+	GLO	P2		; and advance the LBA
+	ADI	16		; ...
+	PLO	P2		; ...
+	GHI	P2		; ...
+	ADCI	0		; ...
+	PHI	P2		; ...
+	BR	DKTST5		; ...
+DKTST4:	CALL(DKWRIT)		; write the same 16 sectors again
+	BDF	DKTERR		; ...
+
+;   Count the block unless the time is up.  A block that finishes after the
+; last second ends isn't counted, so the result is rounded down ...
+DKTST5:	CALL(DKTICK)		; has another second gone by?
+	BNF	DKTST6		; no
+	LDI	LOW(TIMBUF+1)	; yes - count it
+	PLO	DP		; ...
+	LDN	DP		; ...
+	SMI	1		; ...
+	STR	DP		; ...
+	BZ	DKTST7		; quit after four
+DKTST6:	CALL(INPASK)		; count this block
+	BR	DKTST3		; and do another
+
+; Print the results.  8K every four seconds is 2K per second ...
+DKTST7:	GHI	P4		; read or write?
+	BNZ	DKTST8		; ...
+	INLMES("Read ")		; ...
+	BR	DKTST9		; ...
+DKTST8:	INLMES("Write ")	; ...
+DKTST9:	LDI	LOW(PASSK)	; get the block count
+	PLO	DP		; ...
+	LDA	DP		; ...
+	PHI	P1		; ...
+	LDN	DP		; ...
+	SHL			; times two
+	PLO	P1		; ...
+	GHI	P1		; ...
+	SHLC			; ...
+	PHI	P1		; ...
+	CALL(TDEC16)		; type it
+	INLMES(" Kb/sec\r\n")	; ...
+	RETURN			; and we're done
+
+; Here for any drive error ...
+DKTERR:	RLDI(P1,BADDR1)		; ?DRIVE ERROR
+	LBR	F_MSG		; ...
+
+;   TEST DISK uses this to time itself.  Return DF=1 if the RTC seconds have
+; changed since the last call, and remember the new value in TIMBUF+0.  If an
+; update is in progress then the seconds might not be valid and we just say
+; nothing happened ...
+DKTICK:	SEX	PC		; is an update in progress?
+	RNVR(NVRA)		; ...
+	ANI	UIP		; ...
+	BNZ	DKTIC9		; yes - try again later
+	SEX	PC		; no - read the seconds
+	RNVR(NVRSEC)		; ...
+	STR	SP		; ...
+	LDI	LOW(TIMBUF)	; compare them with the last time
+	PLO	DP		; ...
+	LDN	DP		; ...
+	XOR			; ...
+	BZ	DKTIC9		; no change
+	LDX			; changed - remember the new value
+	STR	DP		; ...
+	SDF			; and return DF=1
+	RETURN			; ...
+DKTIC9:	CDF			; no change - return DF=0
+	RETURN			; ...
+
+; This had better not run into the VT52 emulator ...
+#ifdef VIDEO
+#if ($ > VIDEO)
+	.ECHO	"**** ERROR **** TEST DISK overflows the monitor!"
+#endif
+#endif
+#endif
+
+#ifdef TRACE
+	.EJECT
+;	.SBTTL	TRACE Command
+
+;   The TRACE command runs a program one instruction at a time and keeps a
+; record of where it went -
+;
+;	TR[ACE] addr [count [stop]]
+;	TR[ACE]
+;
+;   The first form CALLs the program at addr, just like the CALL command, and
+; stops after count instructions (the default is 65535), when it gets to the
+; stop address, when it returns, or when BREAK is pressed.  The second form
+; continues from wherever the last TRACE (or breakpoint!) stopped, for the
+; same count as last time.  Either way, the registers are typed when it stops
+; and SHOW TRACE types the last few instructions executed and the number of
+; times each address was executed.
+;
+;   There's no interpreter here - each instruction is copied to a little
+; "thunk" in RAM, followed by a row of SEP R1 breakpoints, and then we resume
+; the program at the thunk the same way CONTINUE does.  The instruction
+; executes for real, the breakpoint after it lands in TRTRP (our own version
+; of TRAP - see there for why), and TRAP2 notices that and comes to TRSTEP
+; instead of typing the registers.  How far the PC got tells us whether the instruction
+; skipped, and the target of a branch is replaced by the address of the last
+; breakpoint so we can tell whether it was taken.  SEP, RET and DIS would
+; take the program somewhere else, so those are simulated instead, and IDL
+; just stops the trace.
+;
+;   This has all the restrictions of CONTINUE (R0 and R1 are ours, interrupts
+; are off and R2 must be a valid stack), plus one more - an instruction that
+; uses R(P) as data (e.g. GHI or LDA of the PC) sees the thunk's address.
+;
+;   The last TRRLEN instructions, along with D, DF and X, are kept in a ring
+; buffer and the number of times each address was executed is counted in a
+; table of the first TRCMAX different addresses.  All of this lives in DSKBUF,
+; so anything that uses the disk buffer (HELP, BOOT, SHOW IDE, ...) wipes it
+; out.  The thunk has to be at the start of a page, for short branches ...
+TRCNTS	.EQU	DSKBUF		; execution counts - address, count
+TRCMAX	.EQU	64		;  ... that's 256/4 of them
+TRTHK	.EQU	DSKBUF+256	; the thunk (seven bytes)
+TRXP	.EQU	TRTHK+7		; (X,P) before the instruction in the thunk
+TRSTP	.EQU	TRTHK+8		; address to stop at
+TRCNT	.EQU	TRTHK+10	; instructions left to trace
+TRCNT0	.EQU	TRTHK+12	;  ... and the count the user asked for
+TRNCNT	.EQU	TRTHK+14	; number of entries used in TRCNTS
+TRNUM	.EQU	TRTHK+15	;   "     "    "      "    " TRRING
+TRPTR	.EQU	TRTHK+16	; offset of the next entry in TRRING
+TRLEN	.EQU	TRTHK+17	; length of the instruction in the thunk
+TRPC	.EQU	TRTHK+18	;  ... its original address
+TRTGT	.EQU	TRTHK+20	;  ... and its target, if it's a branch
+TRRING	.EQU	TRTHK+32	; PC, D and X/DF of the last TRRLEN instructions
+TRRLEN	.EQU	32		;  ... four bytes each
+
+;   The program gets a stack of its own in the monitor's data page, well
+; below the stack that the monitor uses while it's tracing ...
+TRUSTK	.EQU	STACK-48
+
+; Here for the TRACE command ...
+TRCCMD:
+#ifdef VIDEO
+	CALL(NOCRTC)		; not allowed when the video card is active
+	LBDF	TMSG9		; ...
+#endif
+	CALL(ISEOL)		; are there any arguments at all?
+	LBDF	TRCON		; no - continue the last trace
+	CALL(SCANP1)		; get the program's address
+	RCOPY(P4,P2)		; and save it for later
+	RLDI(P2,$FFFF)		; the count defaults to 65535
+	RCOPY(P3,P2)		; ...
+	CALL(ISEOL)		; is there a count?
+	LBDF	TRACE1		; no
+	CALL(SCANP1)		; yes - read it
+	RCOPY(P3,P2)		; ...
+	RLDI(P2,$FFFF)		; and the default stop address is nowhere
+	CALL(ISEOL)		; is there a stop address too?
+	LBDF	TRACE1		; no
+	CALL(SCANP1)		; yes - read that
+	CALL(ISEOL)		; and that had better be all
+	LBNF	CMDERR		; ...
+TRACE1:	RLDI(T1,TRXP)		; the program starts with X=2 and P=3
+	LDI	$23		; ...
+	STR	T1		; ...
+	INC	T1		; then save the stop address
+	GHI	P2		; ...
+	STR	T1		; ...
+	INC	T1		; ...
+	GLO	P2		; ...
+	STR	T1		; ...
+	INC	T1		; then the count, in both TRCNT and TRCNT0
+	GHI	P3		; ...
+	STR	T1		; ...
+	INC	T1		; ...
+	GLO	P3		; ...
+	STR	T1		; ...
+	INC	T1		; ...
+	GHI	P3		; ...
+	STR	T1		; ...
+	INC	T1		; ...
+	GLO	P3		; ...
+	STR	T1		; ...
+	INC	T1		; empty TRCNTS and TRRING
+	LDI	0		; ...
+	STR	T1		; ...
+	INC	T1		; ...
+	STR	T1		; ...
+	INC	T1		; ...
+	STR	T1		; ...
+	INC	T1		; and a zero length instruction (see TRGO)
+	STR	T1		; ...
+	INC	T1		; at the program's address
+	GHI	P4		; ...
+	STR	T1		; ...
+	INC	T1		; ...
+	GLO	P4		; ...
+	STR	T1		; ...
+
+;   Start the program with its PC in a thunk that's nothing but breakpoints.
+; The first one goes off right away, TRAP saves all our registers as the
+; program's, and TRSTEP adds the length of the "instruction" (zero) to TRPC.
+; The program gets its own stack, and A points to an IDL at TRRET so that we
+; can tell when it returns.  R1 has to point to TRTRP, of course ...
+	RLDI(T2,TRTHK)		; fill the thunk with breakpoints
+	CALL(TRFILL)		; ...
+	RLDI(T1,TRGO)		; switch to T1 for a moment
+	SEP	T1		; ...
+TRGO:	RLDI(SP,TRUSTK)		; give the program a stack
+	RLDI(A,TRRET)		; and a return address
+	RLDI(INTPC,TRTRP)	; ...
+	RLDI(PC,TRTHK)		; and away we go
+	SEX	SP		; ...
+	SEP	PC		; ...
+
+; Here to continue the last trace ...
+TRCON:	RLDI(T1,TRCNT0+1)	; reload the count
+	LDN	T1		; ...
+	DEC	T1		; ...
+	DEC	T1		; ...
+	STR	T1		; ...
+	INC	T1		; ...
+	LDN	T1		; ...
+	DEC	T1		; ...
+	DEC	T1		; ...
+	STR	T1		; ...
+	CALL(TRGPC)		; and don't stop at the stop address right away
+	LBR	TRNEX1		; ...
+
+;   TRAP2 comes here when one of the breakpoints in the thunk goes off.  The
+; PC is one byte past the breakpoint that caught it, so the distance from the
+; start of the thunk to that breakpoint is how far the PC moved ...
+TRSTEP:	CALL(TRFXP)		; first fix (X,P) and R2
+	CALL(TRGPC)		; then get the PC
+	GLO	P1		; and figure the distance
+	SMI	LOW(TRTHK+1)	; ...
+	PLO	P3		; ...
+	RLDI(T1,TRLEN)		; was it a branch that was taken?
+	LDA	T1		; ...
+	ADI	3		; ...
+	STR	SP		; ...
+	GLO	P3		; ...
+	XOR			; ...
+	BNZ	TRSTE3		; no
+	INC	T1		; yes - the new PC is the target
+	INC	T1		; ...
+	LDA	T1		; ...
+	PHI	P1		; ...
+	LDN	T1		; ...
+	PLO	P1		; ...
+	BR	TRSTE4		; ...
+TRSTE3:	LDA	T1		; no - it's the old PC plus the distance
+	PHI	P1		; ...
+	LDN	T1		; ...
+	STR	SP		; ...
+	GLO	P3		; ...
+	ADD			; ...
+	PLO	P1		; ...
+	GHI	P1		; ...
+	ADCI	0		; ...
+	PHI	P1		; ...
+TRSTE4:	GLO	P1		; update the user's PC
+	STR	DP		; ...
+	DEC	DP		; ...
+	GHI	P1		; ...
+	STR	DP		; ...
+	LDI	LOW(BAUD1)	; and make sure that we can still type
+	PLO	DP		; ...
+	LDN	DP		; ...
+	PHI	BAUD		; ...
+
+;   Here to trace the next instruction.  First check for BREAK, the stop
+; address, an IDL and the count ...
+TRNEXT:	CALL(F_BRKTEST)		; does the user want to stop?
+	LBDF	TRSBRK		; ...
+	CALL(TRGPC)		; get the PC
+	RLDI(T1,TRSTP)		; is this the stop address?
+	LDA	T1		; ...
+	STR	SP		; ...
+	GHI	P1		; ...
+	XOR			; ...
+	BNZ	TRNEX1		; ...
+	LDN	T1		; ...
+	STR	SP		; ...
+	GLO	P1		; ...
+	XOR			; ...
+	LBZ	TRSSTP		; ...
+TRNEX1:	LDN	P1		; IDL?
+	LBZ	TRIDL		; ...
+	RLDI(T1,TRCNT)		; have we done enough?
+	LDA	T1		; ...
+	STR	SP		; ...
+	LDN	T1		; ...
+	OR			; ...
+	LBZ	TRSCNT		; ...
+	LDN	T1		; no - count this one
+	SMI	1		; ...
+	STR	T1		; ...
+	DEC	T1		; ...
+	LDN	T1		; ...
+	SMBI	0		; ...
+	STR	T1		; ...
+
+; Add the PC, D, DF and X to the ring buffer ...
+	RLDI(T1,TRNUM)		; count the entries in the ring
+	LDN	T1		; ...
+	XRI	TRRLEN		; until it's full
+	BZ	TRNEX2		; ...
+	XRI	TRRLEN		; ...
+	ADI	1		; ...
+	STR	T1		; ...
+TRNEX2:	INC	T1		; get the offset of the next entry
+	LDN	T1		; ...
+	PLO	T2		; ...
+	ADI	4		; and advance it
+	ANI	TRRLEN*4-1	; ...
+	STR	T1		; ...
+	GLO	T2		; ...
+	ADI	LOW(TRRING)	; ...
+	PLO	T2		; ...
+	LDI	HIGH(TRRING)	; ...
+	PHI	T2		; ...
+	GHI	P1		; store the PC
+	STR	T2		; ...
+	INC	T2		; ...
+	GLO	P1		; ...
+	STR	T2		; ...
+	INC	T2		; ...
+	LDI	LOW(SAVED)	; then D
+	PLO	DP		; ...
+	LDA	DP		; ...
+	STR	T2		; ...
+	INC	T2		; ...
+	LDN	DP		; and then X and DF in one byte
+	STR	SP		; ...
+	DEC	DP		; ...
+	DEC	DP		; ...
+	LDN	DP		; ...
+	ANI	$F0		; ...
+	OR			; ...
+	STR	T2		; ...
+
+;   And count it in TRCNTS.  If this address isn't there yet, then add it if
+; there's room ...
+	RLDI(T2,TRCNTS)		; search the table
+	RLDI(T1,TRNCNT)		; ...
+	LDN	T1		; ...
+	PLO	P3		; ...
+TRNEX3:	GLO	P3		; any more to look at?
+	BZ	TRNEX5		; no - add a new one
+	LDA	T2		; does the address match?
+	STR	SP		; ...
+	GHI	P1		; ...
+	XOR			; ...
+	BNZ	TRNEX4		; ...
+	LDN	T2		; ...
+	STR	SP		; ...
+	GLO	P1		; ...
+	XOR			; ...
+	BZ	TRNEX6		; yes - count it
+TRNEX4:	INC	T2		; no - on to the next one
+	INC	T2		; ...
+	INC	T2		; ...
+	DEC	P3		; ...
+	BR	TRNEX3		; ...
+TRNEX5:	LDN	T1		; is the table full?
+	XRI	TRCMAX		; ...
+	BZ	TRNEX7		; yes - just forget it
+	XRI	TRCMAX		; no - add one more
+	ADI	1		; ...
+	STR	T1		; ...
+	GHI	P1		; ...
+	STR	T2		; ...
+	INC	T2		; ...
+	GLO	P1		; ...
+	STR	T2		; ...
+	INC	T2		; with a zero count
+	LDI	0		; ...
+	STR	T2		; ...
+	INC	T2		; ...
+	STR	T2		; ...
+	DEC	T2		; ...
+	DEC	T2		; ...
+TRNEX6:	INC	T2		; increment the count
+	INC	T2		; ...
+	LDN	T2		; ...
+	ADI	1		; ...
+	STR	T2		; ...
+	DEC	T2		; ...
+	LDN	T2		; ...
+	ADCI	0		; ...
+	STR	T2		; ...
+
+;   Now figure out what the instruction is.  SEP, RET and DIS are simulated
+; and everything else goes to the thunk.  P3.0 gets the length and, for a
+; branch, P3.1 gets it too ...
+TRNEX7:	LDN	P1		; get the opcode
+	PLO	P3		; ...
+	ANI	$F0		; SEP?
+	XRI	$D0		; ...
+	LBZ	TRSEP		; ...
+	GLO	P3		; RET or DIS?
+	ANI	$FE		; ...
+	XRI	$70		; ...
+	LBZ	TRRDIS		; ...
+	GLO	P3		; short branch (or SKP)?
+	ANI	$F0		; ...
+	XRI	$30		; ...
+	BZ	TRNX12		; ...
+	GLO	P3		; long branch (or LSKP)?
+	ANI	$F4		; ...
+	XRI	$C0		; ...
+	BZ	TRNX13		; ...
+	LDI	0		; it's not a branch
+	PHI	P3		; ...
+	GLO	P3		; LDI, ORI, ANI, XRI, ADI, SDI or SMI?
+	SMI	$F8		; ...
+	BNF	TRNEX8		; not if it's less than $F8
+	XRI	$06		; SHL is the only one byte instruction up there
+	BNZ	TRNX10		; ...
+	BR	TRNX11		; ...
+TRNEX8:	GLO	P3		; ADCI, SDBI or SMBI?
+	SMI	$7C		; ...
+	BNF	TRNX11		; not if it's less than $7C
+	SMI	4		; or more than $7F
+	BDF	TRNX11		; ...
+	XRI	$FE		; and SHLC is one byte too
+	BZ	TRNX11		; ...
+TRNX10:	LDI	2		; a two byte instruction
+	LSKP			; ...
+TRNX11:	LDI	1		; a one byte instruction
+	PLO	P3		; ...
+	LBR	TRNX14		; ...
+TRNX12:	LDI	2		; a two byte branch
+	LSKP			; ...
+TRNX13:	LDI	3		; a three byte branch
+	PLO	P3		; ...
+	PHI	P3		; ...
+	LBR	TRNX14		; the rest is at MONEXT7
+
+; This had better not run into the help text ...
+#if ($ > HELP)
+	.ECHO	"**** ERROR **** TRACE overflows the monitor!"
+#endif
+#endif
+
+	.EJECT
+;	.SBTTL	Monitor Extensions
+
+;   The monitor long ago outgrew the EPROM space at BOOTS, so the newer
+; commands live in a second chunk of EPROM at MONEXT.  If MONEXT isn't defined
+; by the configuration, then none of these commands are included.  All of the
+; code here is called from the command table in the usual way and uses all the
+; usual monitor subroutines, so the only thing special about it is its address.
+#ifdef MONEXT
+	.ORG	MONEXT
+
+	.EJECT
+;	.SBTTL	Fast Intel HEX Loader
+
+;   The ":" command loads one HEX record at a time, and that's painfully slow
+; for a big file - every record is echoed as it's typed, then parsed, then we
+; print "OK" and the host has to wait for the next prompt before it can send
+; another line.  The LOAD command instead reads the whole file directly from
+; the UART and decodes it on the fly, as fast as the characters arrive.
+; Nothing is echoed and nothing is printed until the EOF record, and then we
+; print a one line summary and one message for each kind of error that we
+; found.  A record with an error is counted, but otherwise ignored (although,
+; like ":", some or all of it may have been stored in memory by then).  A ^C
+; between records aborts the load.
+;
+;   To keep up with the UART the hex digits aren't checked one at a time -
+; they're just looked up in a table, and anything that isn't a hex digit
+; decodes as zero.  That's OK because the record checksum will catch it.  If
+; characters are lost then we'll get out of step with the records and the
+; next record will be read as part of this one, but that always leaves some-
+; thing that's neither ":" nor CR/LF after the end of the record, and that
+; gets counted as another bad record.
+;
+;   This only works with the hardware UART for the console - the bit banged
+; serial port can't receive anything while we're busy decoding, and the PS/2
+; keyboard isn't much use for downloading.  With those use ":" instead.
+;
+;	P1   - count of records loaded
+;	P2   - load address
+;	P3.0 - record length (bytes remaining)
+;	P3.1 - record type, and then error flags for this record
+;	P4.0 - running checksum for this record
+;	P4.1 - error flags for the whole file
+;	T1   - pointer to the hex digit tables
+;	T2   - PC for HLDHEX
+;	DP.0 - count of bad records
+
+; Error flag bits in P3.1 and P4.1 (in the same order as HLDMSG!) ...
+HLDCKE	.EQU	$01	; checksum error
+HLDMEM	.EQU	$02	; memory didn't change
+HLDOVM	.EQU	$04	; would overwrite the monitor's data page
+HLDURC	.EQU	$08	; unknown record type
+HLDFMT	.EQU	$10	; something other than CR/LF between records
+
+;   These two tables convert an ASCII hex digit to its binary value, and they
+; share a page with HLDHEX.  The first one is indexed by the character AND
+; $3F and gives the low nibble; the second is indexed by the character OR $C0
+; and gives the high nibble.  Either way, both upper and lower case work.
+#if (($ & $FF) != 0)
+	.ECHO	"**** ERROR **** MONEXT must be page aligned!"
+#endif
+HLDLO:	.DB	$00, $0A, $0B, $0C, $0D, $0E, $0F, $00	; @ A B C D E F G
+	.DB	$00, $00, $00, $00, $00, $00, $00, $00	; H .. O
+	.DB	$00, $00, $00, $00, $00, $00, $00, $00	; P .. W
+	.DB	$00, $00, $00, $00, $00, $00, $00, $00	; X .. _
+	.DB	$00, $0A, $0B, $0C, $0D, $0E, $0F, $00	; ` a b c d e f g
+	.DB	$00, $00, $00, $00, $00, $00, $00, $00	; h .. o
+	.DB	$00, $01, $02, $03, $04, $05, $06, $07	; 0 .. 7
+	.DB	$08, $09, $00, $00, $00, $00, $00, $00	; 8 9 : ; < = > ?
+
+;   This subroutine reads two hex digits from the UART and returns the byte
+; in D, and also leaves it on the top of the stack.  The byte is added to the
+; checksum in P4.0 too.  It runs with T2 as the program counter (call it with
+; "SEP T2") so that calling it costs only one instruction.  It must be on the
+; same page as the tables, and T1.1 must point to that page!  DF says which
+; digit we're reading - zero for the first and one for the second.
+HLDHXR:	SEP	PC		; return to the caller
+HLDHEX:	CDF			; start with the first digit
+HLDHX1:	SEX	T2		; let the host send (see HLD1)
+	WUART(MCR,DTR+RTS)	; ...
+	OUT	UART_SELECT	; and select the line status register
+	.DB	LSR		; ...
+	SEX	SP		; ...
+HLDHX2:	INP	UART_DATA	; read the line status
+	ANI	DR		; is there a character waiting?
+	BZ	HLDHX2		; no - keep waiting
+	SEX	T2		; yes - hold the host off again
+	WUART(MCR,DTR)		; ...
+	OUT	UART_SELECT	; select the receiver buffer
+	.DB	RBR		; ...
+	SEX	SP		; ...
+	INP	UART_DATA	; and read the digit
+	BDF	HLDHX3		; branch if it's the second one
+	ORI	$C0		; look it up in the high nibble table
+	PLO	T1		; ...
+	LDN	T1		; ...
+	PLO	BAUD		; and save that for a moment
+	SDF			; now do the same for the second digit
+	BR	HLDHX1		; ...
+HLDHX3:	ANI	$3F		; but use the low nibble table this time
+	PLO	T1		; ...
+	LDN	T1		; ...
+	STR	SP		; and put the two nibbles together
+	GLO	BAUD		; ...
+	OR			; ...
+	STR	SP		; add the byte to the checksum
+	GLO	P4		; ...
+	ADD			; ...
+	PLO	P4		; ...
+	LDX			; and return the byte
+	BR	HLDHXR		; ...
+
+HLDGAP	.EQU	$		; (see SET VIDEO FAST)
+#if ($ > (HLDLO+$C0))
+	.ECHO	"**** ERROR **** HLDHEX overlaps HLDHI!"
+#endif
+	.ORG	HLDLO+$C0
+HLDHI:	.DB	$00, $A0, $B0, $C0, $D0, $E0, $F0, $00	; @ A B C D E F G
+	.DB	$00, $00, $00, $00, $00, $00, $00, $00	; H .. O
+	.DB	$00, $00, $00, $00, $00, $00, $00, $00	; P .. W
+	.DB	$00, $00, $00, $00, $00, $00, $00, $00	; X .. _
+	.DB	$00, $A0, $B0, $C0, $D0, $E0, $F0, $00	; ` a b c d e f g
+	.DB	$00, $00, $00, $00, $00, $00, $00, $00	; h .. o
+	.DB	$00, $10, $20, $30, $40, $50, $60, $70	; 0 .. 7
+	.DB	$80, $90, $00, $00, $00, $00, $00, $00	; 8 9 : ; < = > ?
+
+; Here's the LOAD command itself ...
+HLOAD:	CALL(ISEOL)		; no arguments allowed
+	LBNF	CMDERR		; ...
+	GHI	BAUD		; is the hardware UART the console?
+	ANI	$FE		; ignore the local echo bit
+	LBNZ	NOSETQ		; "?CAN'T - CONSOLE" if it isn't
+	LDI	0		; no records loaded yet
+	PHI	P1		; ...
+	PLO	P1		; ...
+	PHI	P3		; ...
+	PLO	P3		; ...
+	PHI	P4		; and no errors either
+	PLO	P4		; ...
+	PLO	DP		; ...
+	PLO	T1		; point to the hex digit tables
+	LDI	HIGH(HLDLO)	;  ... (HLDLO is page aligned)
+	PHI	T1		; ...
+	PHI	T2		; and set up the PC for HLDHEX
+	LDI	LOW(HLDHEX)	;  ... (which is on the same page)
+	PLO	T2		; ...
+	SEX	PC		; turn on the UART's FIFOs while we're here
+	WUART(FCR,FIFOEN)	;  ... (but don't reset them - see TXIDLE)
+
+;   Wait for the start of the next record.  CR and LF are ignored, and ^C
+; aborts the load.  Anything else means that something went wrong with the
+; last record, and if it hasn't been counted as bad already, then it is now.
+;
+;   There's no time to spare at the higher baud rates, so RTS is asserted
+; only while we're waiting for the next character and is dropped again as soon
+; as it arrives (HLDHEX does the same).  A host that uses hardware flow control
+; then can't get more than a character or two ahead of us, whatever the baud
+; rate, and the UART's FIFOs (which are turned on above) take care of those.
+HLD1:	SEX	PC		; let the host send
+	WUART(MCR,DTR+RTS)	; ...
+	OUT	UART_SELECT	; and select the UART line status register
+	.DB	LSR		; ...
+	SEX	SP		; ...
+HLD2:	INP	UART_DATA	; ...
+	ANI	DR		; wait for a character
+	BZ	HLD2		; ...
+	SEX	PC		; hold the host off again
+	WUART(MCR,DTR)		; ...
+	OUT	UART_SELECT	; select the receiver buffer
+	.DB	RBR		; ...
+	SEX	SP		; ...
+	INP	UART_DATA	; and read the character
+	XRI	':'		; is it the start of a record?
+	BZ	HLD3		; yes - go read it
+	XRI	':'^CHCTC	; is it a ^C?
+	BZ	HLD10		; yes - quit now
+	XRI	CHCTC^CHCRT	; is it a carriage return?
+	BZ	HLD1		; yes - ignore it
+	XRI	CHCRT^CHLFD	; or a line feed?
+	BZ	HLD1		; yes - ignore that too
+	GHI	P3		; was the last record already bad?
+	BNZ	HLD1		; yes - just ignore it
+	LDI	HLDFMT		; no - it's bad now
+	BR	HLD8		; ...
+
+; Read the record length, load address and record type ...
+HLD3:	LDI	0		; clear the checksum
+	PLO	P4		; ...
+	SEP	T2		; read the record length
+	PLO	P3		; ...
+	SEP	T2		; then the high byte of the address
+	PHI	P2		; ...
+	SEP	T2		; and the low byte
+	PLO	P2		; ...
+	SEP	T2		; and finally the record type
+	PHI	P3		; ...
+	BZ	HLD4		; branch if it's a data record
+	XRI	1		; is it an EOF record?
+	BZ	HLD7		; yes - we're done
+	LDI	HLDURC		; no - unknown record type
+	BR	HLD8		; ...
+
+;   For a data record, be sure that it doesn't load the monitor's data page.
+; That would trash the stack and all sorts of other things ...
+HLD4:	GHI	P2		; get the high byte of the address
+	XRI	HIGH(RAMPAGE)	; is it the monitor's data page?
+	BNZ	HLD5		; no - go load it
+	LDI	HLDOVM		; yes - refuse to load it
+	BR	HLD8		; ...
+
+;   Load the data bytes.  P3.1 is zero at this point (it's the record type!)
+; and it's used for this record's error flags from now on ...
+HLD5:	GLO	P3		; any more bytes to load?
+	BZ	HLD6		; no - check the checksum
+	SEP	T2		; yes - read the next data byte
+	STR	P2		; store it in memory
+	LDA	P2		; and be sure that memory really changed
+	XOR			;  ... (HLDHEX left the byte on the stack)
+	DEC	P3		; ...
+	BZ	HLD5		; and on to the next byte
+	GHI	P3		; memory error (e.g. trying to load EPROM)
+	ORI	HLDMEM		; ...
+	PHI	P3		; ...
+	BR	HLD5		; ...
+
+;   Here at the end of a data record.  Adding in the checksum byte should
+; make the total zero ...
+HLD6:	SEP	T2		; read the checksum byte
+	GLO	P4		; is the checksum zero?
+	BZ	HLD6A		; yes - good
+	GHI	P3		; no - flag a checksum error
+	ORI	HLDCKE		; ...
+	PHI	P3		; ...
+HLD6A:	GHI	P3		; were there any errors in this record?
+	BNZ	HLD6B		; yes - count a bad record
+	INC	P1		; no - count another good record
+	BR	HLD1		; and go wait for the next one
+HLD6B:	CALL(HLDBAD)		; count the bad record
+	LDI	0		; but it's over now, so anything but CR/LF
+	PHI	P3		;  ... before the next record is another error
+	BR	HLD1		; ...
+
+;   Here for a bad record - add the error flags for this record, in P3.1, to
+; the flags for the whole file and count another bad record (up to 255).  The
+; rest of the record, if any, will be ignored by HLD1 ...
+HLD8:	PHI	P3		; save the error flag
+	CALL(HLDBAD)		; count the bad record
+	BR	HLD1		; and wait for the next one
+HLDBAD:	GHI	P3		; get the flags for this record
+	STR	SP		; ...
+	GHI	P4		; and add them to the total
+	OR			; ...
+	PHI	P4		; ...
+	GLO	DP		; count the bad record
+	ADI	1		; ...
+	BZ	HLDBA1		; but don't let it wrap around
+	PLO	DP		; ...
+HLDBA1:	RETURN			; ...
+
+;   Here for an EOF record.  Check its checksum too, and then print the
+; summary...
+HLD7:	SEP	T2		; read the checksum byte
+	GLO	P4		; is it right?
+	BZ	HLD10		; yes - all done
+	LDI	HLDCKE		; no - flag it
+	PHI	P3		; ...
+	CALL(HLDBAD)		; ...
+
+;   The host is still sending the end of the EOF record's line, and if we
+; left that in the UART then the CR would give an extra prompt and the LF
+; would make F_BRKTEST stop the next command after one line.  So throw away
+; everything up to and including the LF, or until nothing more has arrived
+; for a while (about 1/10th of a second at 1.79MHz) in case the host only
+; sends a CR.  After a ^C this just waits for the host to stop.  Either way
+; RTS is asserted again, and it's left that way ...
+HLD10:	SEX	PC		; let the host send the rest
+	WUART(MCR,DTR+RTS)	; ...
+HLD10A:	LDI	6		; reset the timeout
+	PHI	P2		; ...
+HLD11:	OUTI(UART_SELECT,LSR)	; is there a character waiting?
+	INP	UART_DATA	; ...
+	ANI	DR		; ...
+	BNZ	HLD12		; yes - go read it
+	DEC	P2		; no - count down the timeout
+	GHI	P2		; ...
+	BNZ	HLD11		; ...
+	BR	HLD9		; it's been long enough - we're done
+HLD12:	OUTI(UART_SELECT,RBR)	; select the receiver buffer
+	INP	UART_DATA	; and read the character
+	XRI	CHLFD		; is it the LF?
+	BNZ	HLD10A		; no - keep going
+
+;   Here when we're done - print the number of records loaded, the number of
+; bad records (if any), and then one message for each kind of error ...
+HLD9:	GHI	P4		; save the error flags
+	STXD			; ...
+	GLO	DP		; and the bad record count
+	STXD			; ...
+#ifdef UARTIRQ
+	LDI	LOW(TTYIRQ)	; put the FIFOs back the way they were -
+	PLO	DP		;  on for the interrupt driver and off for
+	LDN	DP		;  polled mode
+	ANI	RXFCR		; ...
+	STR	SP		; ...
+	SEX	PC		; ...
+	OUT	UART_SELECT	; ...
+	.DB	FCR		; ...
+	SEX	SP		; ...
+	OUT	UART_DATA	; ...
+	DEC	SP		; ...
+#else
+	SEX	PC		; turn the FIFOs off again
+	WUART(FCR,FIFORST)	; ...
+	SEX	SP		; ...
+#endif
+	CALL(TDEC16)		; type the count of good records
+	INLMES(" RECORDS")	; ...
+	IRX\ LDX		; get the bad record count back
+	LBZ	HLD9A		; skip this if there weren't any
+	PLO	P1		; ...
+	LDI	0		; ...
+	PHI	P1		; ...
+	INLMES(", ")		; ...
+	CALL(TDEC16)		; type the count of bad records
+	INLMES(" BAD")		; ...
+HLD9A:	CALL(TCRLF)		; finish the line
+	RLDI(P3,HLDMSG)		; point to the list of error messages
+HLD9B:	IRX\ LDX		; get the remaining error flags
+	BZ	HLD9C		; quit when there aren't any more
+	SHR			; test the next flag bit
+	STXD			; and save the rest
+	LDA	P3		; get the address of the matching message
+	PHI	P1		; ...
+	LDA	P3		; ...
+	PLO	P1		; ...
+	BNF	HLD9B		; skip it if that error didn't happen
+	CALL(F_MSG)		; otherwise print the message
+	BR	HLD9B		; and on to the next one
+HLD9C:	RETURN			; all done!
+
+; Error messages for each flag bit in P4.1, in order ...
+HLDMSG:	.DW	HCKMSG		; HLDCKE - ?CHECKSUM MISMATCH
+	.DW	MERMSG		; HLDMEM - ?MEMORY ERROR
+	.DW	OVMMSG		; HLDOVM - ?WOULD OVERWRITE MONITOR
+	.DW	URCMSG		; HLDURC - ?UNKNOWN HEX RECORD TYPE
+	.DW	BHXMSG		; HLDFMT - ?BAD HEX RECORD
+BHXMSG:	.TEXT	"?BAD HEX RECORD\r\n\000"
+
+	.EJECT
+;	.SBTTL	Interrupt Driven Console Input
+
+#ifdef UARTIRQ
+;   Normally the monitor reads command lines with the BIOS F_INPUTL routine,
+; which polls the UART with its FIFOs turned off.  That's fine for typing,
+; but if a host pastes several lines at once then anything that arrives while
+; we're busy with the previous line is lost.  SET TERMINAL INTERRUPT turns on
+; the 16550 FIFOs and switches to an interrupt driven driver which reads the
+; command line from a small ring buffer, RXBUF, that's filled by an interrupt
+; service routine.  It also drives RTS, so a host that uses hardware flow
+; control will stop sending when the buffer fills up.  SET TERMINAL POLLED
+; goes back to the old way.  This needs the hardware UART for the console, and
+; the UART interrupt must be jumpered to the CPU (JP3 on the Elf 2000 disk
+; board), so it's only included if the configuration defines UARTIRQ.  A
+; hardware reset always returns to polled mode.
+;
+;   There's one big catch - the UART register select port is write only, and
+; on the Elf 2000 it's shared with the IDE disk and NVR too.  If an interrupt
+; happened after somebody (usually the BIOS) selected a register but before
+; they used it, the interrupt routine would change the selection out from
+; under them, and there's no way to put it back.  So interrupts are only ever
+; enabled while TTYINP is reading a command line, and even then they're turned
+; off around anything that uses the select port - echoing a character, or
+; changing RTS.  While a command runs the UART's interrupts are off too and the
+; 16 byte FIFO holds onto anything that arrives, and if we have part of the
+; next line already when we finish this one (i.e. the host is pasting) then
+; RTS is dropped until we're ready for it.
+;
+;   At 115200 baud a character arrives every 20 machine cycles or so, which
+; is less than one trip thru UISR, and a host may send several more after RTS
+; drops.  So the FIFO interrupts at 4 characters, not 8, and RTS is dropped
+; with only RXSTOP characters in RXBUF.  That leaves room for a whole FIFO
+; full plus whatever else the host sends before it stops.
+
+; UART settings for interrupt mode ...
+RXFCR	.EQU	FIFOEN+FIFORST+RXTRG4	; FIFOs on, interrupt at 4 characters
+RXIER	.EQU	ERBFI+ELSI		; receiver and line status interrupts
+RXSTOP	.EQU	2			; drop RTS with this many characters waiting
+
+; Here for SET TERMINAL (INTERRUPT or POLLED) ...
+SETTRM:	RLDI(P2,TRMCMD)		; look up the option
+	LBR	SUBCMD		; ...
+
+; Table of SET TERMINAL options ...
+TRMCMD:	CMD(3, "INTERRUPT", SETTRI)	; SET TERMINAL INTERRUPT
+	CMD(3, "POLLED",    SETTRP)	; SET TERMINAL POLLED
+	.DB	0
+
+;   Here for SET TERMINAL INTERRUPT.  Turn on the FIFOs and then make sure
+; that UART interrupts actually get to the CPU - enabling the transmitter
+; interrupt while the transmitter is idle requests an interrupt right away,
+; and reading the IIR in UISR clears it again.  If it's still pending after
+; interrupts have been enabled for a while, then they aren't connected ...
+SETTRI:	CALL(SETTRC)		; check the syntax and the console
+	LBDF	SETTR9		; return now if we can't
+	CALL(TXIDLE)		; so the transmitter can't interrupt later
+	SEX	PC		; turn on the FIFOs
+	WUART(FCR,RXFCR)	; ...
+	WUART(IER,ETBEI)	; and request a transmitter interrupt
+	RLDI(INTPC,UISR)	; point R1 at the interrupt service routine
+	LDI	16		; and give it a little while to happen
+	PLO	T1		; ...
+	INT_ON			; ...
+SETTR1:	DEC	T1		; ...
+	GLO	T1		; ...
+	LBNZ	SETTR1		; ...
+	INT_OFF			; ...
+	RLDI(INTPC,TRAP)	; let breakpoints work again
+	SEX	PC		; see if that interrupt is still pending
+	RUART(IIR)		; ...
+	SEX	PC		; then turn the UART interrupts off
+	WUART(IER,0)		;  (OUT doesn't change D!)
+	SEX	SP		; ...
+	XRI	$C1		; $C1 means "FIFOs on and no interrupt"
+	ANI	$CF		; ...
+	LBNZ	SETTR2		; branch if nobody took it
+	LDI	LOW(RXPUT)	; empty the ring buffer
+	PLO	DP		;  (DP.1 is always RAMPAGE)
+	LDI	0		; ...
+	STR	DP		; ...
+	INC	DP		; ...
+	STR	DP		; ...
+	INC	DP		; and clear the overrun count
+	STR	DP		; ...
+	INC	DP		; ...
+	STR	DP		; ...
+	LDI	LOW(TTYIRQ)	; and switch to interrupt mode
+	PLO	DP		; ...
+	LDI	$FF		; ...
+	STR	DP		; ...
+	RETURN			; ...
+
+; Here if UART interrupts don't work ...
+SETTR2:	OUTSTR(NOIMSG)		; say what's wrong
+	LBR	SETTP1		; and go back to polled mode
+
+; Here for SET TERMINAL POLLED ...
+SETTRP:	CALL(SETTRC)		; check the syntax and the console
+	LBDF	SETTR9		; ...
+SETTP1:	CALL(TXIDLE)		; don't lose the end of the last message
+	SEX	PC		; put the UART back the way UINI left it
+	WUART(FCR,$06)		; FIFOs off
+	WUART(IER,$00)		; no interrupts
+	WUART(MCR,DTR+RTS)	; and DTR and RTS on
+	SEX	SP		; ...
+	LDI	LOW(TTYIRQ)	; and select polled mode
+	PLO	DP		;  (DP.1 is always RAMPAGE)
+	LDI	0		; ...
+	STR	DP		; ...
+SETTR9:	RETURN			; and we're done
+
+;   Make sure there's nothing else on the command line, and that the UART is
+; the console.  Returns DF=1 (after printing a message) if we can't do it ...
+SETTRC:	CALL(ISEOL)		; there shouldn't be anything more
+	LBNF	CMDERR		; ...
+	GHI	BAUD		; is the hardware UART the console?
+	ANI	$FE		; ignore the local echo bit
+	LBZ	SETTC1		; yes - so far, so good
+	CALL(NOSETQ)		; "?CAN'T - CONSOLE"
+	SDF			; and return DF=1
+	RETURN			; ...
+#ifdef VIDEO
+SETTC1:	LBR	NOCRTC		; the VT1802 uses interrupts too
+#else
+SETTC1:	CDF			; it's OK
+	RETURN			; ...
+#endif
+
+NOIMSG:	.TEXT	"?NO UART INTERRUPT\r\n\000"
+
+;   Wait for the UART transmitter to send everything it has.  Resetting the
+; FIFOs would throw away anything that's still in the transmitter FIFO ...
+TXIDLE:	SEX	PC		; read the line status
+	RUART(LSR)		; ...
+	ANI	TEMT		; is the transmitter empty?
+	LBZ	TXIDLE		; no - wait for it
+	RETURN			; ...
+
+;   SHOW TERMINAL ends up here to show the console driver mode and, for the
+; interrupt driver, the number of receiver overruns.  That count includes
+; both the UART's overruns and characters that didn't fit in RXBUF ...
+SHOIRQ:	GHI	BAUD		; is the hardware UART the console?
+	ANI	$FE		; ...
+	LBNZ	TCRLF		; no - there's nothing to say
+	LDI	LOW(TTYIRQ)	; which driver are we using?
+	PLO	DP		;  (DP.1 is always RAMPAGE)
+	LDN	DP		; ...
+	LBNZ	SHOIR1		; branch if it's interrupt mode
+	INLMES(" POLLED")	; ...
+	LBR	TCRLF		; ...
+SHOIR1:	INLMES(" INTERRUPT, ")	; ...
+	LDI	LOW(OVRUNK)	; get the overrun count
+	PLO	DP		; ...
+	LDA	DP		; ...
+	PHI	P1		; ...
+	LDN	DP		; ...
+	PLO	P1		; ...
+	CALL(TDEC16)		; type it in decimal
+	INLMES(" OVERRUNS")	; ...
+	LBR	TCRLF		; and we're done
+
+;   This routine reads a command line for the monitor.  It's called just like
+; F_INPUTL, with P1 pointing to the buffer and P3 containing the maximum
+; length, and the line is terminated by a null.  It returns DF=1 if the line
+; was ended with a ^C.  In polled mode it simply jumps to F_INPUTL, and in
+; interrupt mode it gets the characters from RXBUF instead.  Backspace and
+; rubout erase the last character, and other control characters are ignored.
+; Uses T2 ...
+TTYINP:	LDI	LOW(TTYIRQ)	; which console driver are we using?
+	PLO	DP		;  (DP.1 is always RAMPAGE)
+	LDN	DP		; ...
+	LBZ	F_INPUTL	; polled - let the BIOS do the work
+	GHI	BAUD		; and make sure the UART is still the console
+	ANI	$FE		; ...
+	LBNZ	F_INPUTL	; ...
+	RLDI(INTPC,UISR)	; point R1 at the interrupt service routine
+	SEX	PC		; and enable the UART interrupts
+	WUART(IER,RXIER)	; ...
+	SEX	SP		; ...
+	LDI	0		; count the characters in the buffer
+	PLO	T2		;  ... in T2.0
+	INT_ON			; and let UISR run
+
+; Read and process the next character ...
+TINP1:	CALL(UGETC)		; get a character from RXBUF
+	ANI	$7F		; ignore the parity bit
+	PHI	T2		; save it for a minute
+	XRI	CHCRT		; carriage return?
+	BZ	TINP5		; yes - that's the end of the line
+	GHI	T2		; ...
+	XRI	CHCTC		; control-C?
+	BZ	TINP4		; yes - quit now
+	GHI	T2		; ...
+	XRI	CHBSP		; backspace?
+	BZ	TINP3		; ...
+	GHI	T2		; ...
+	XRI	CHRUB		; or rubout?
+	BZ	TINP3		; both erase the last character
+	GHI	T2		; ...
+	SMI	' '		; is it any other control character?
+	BNF	TINP1		; yes - just ignore it
+	GLO	P3		; is there room in the buffer?
+	BNZ	TINP2		; ...
+	GHI	P3		; ...
+	BZ	TINP1		; no - ignore it
+TINP2:	GHI	T2		; store the character
+	STR	P1		; ...
+	INC	P1		; ...
+	DEC	P3		; ...
+	INC	T2		; and count it
+	CALL(UECHO)		; echo it
+	BR	TINP1		; and on to the next one
+
+; Here for backspace or rubout ...
+TINP3:	GLO	T2		; is there anything to erase?
+	BZ	TINP1		; no - ignore it
+	DEC	T2		; yes - back up
+	DEC	P1		; ...
+	INC	P3		; ...
+	LDI	CHBSP		; and erase it on the screen
+	CALL(UECHO)		; ...
+	LDI	' '		; ...
+	CALL(UECHO)		; ...
+	LDI	CHBSP		; ...
+	CALL(UECHO)		; ...
+	BR	TINP1		; ...
+
+;   Here at the end of the line.  T2.1 is set to $FF for ^C, which becomes
+; DF when we return ...
+TINP4:	LDI	CHCTC		; echo the ^C, like F_INPUTL does
+	CALL(UECHO)		; ...
+	LDI	$FF		; ^C
+	LSKP			; ...
+TINP5:	LDI	0		; carriage return
+	PHI	T2		; ...
+	LDI	0		; terminate the string
+	STR	P1		; ...
+	INT_OFF			; no more interrupts
+	SEX	PC		; and turn off the UART interrupts
+	WUART(IER,0)		; ...
+	SEX	SP		; ...
+	CALL(RXEMTY)		; is there more input waiting already?
+	BNF	TINP5A		; yes
+	SEX	PC		; or is it still in the UART's FIFO?
+	RUART(LSR)		; ...
+	ANI	DR		; ...
+	BZ	TINP6		; no - the host has stopped sending
+TINP5A:	SEX	PC		; yes - drop RTS until we're ready for it
+	WUART(MCR,DTR)		; ...
+	SEX	SP		; ...
+TINP6:	RLDI(INTPC,TRAP)	; let breakpoints work again
+	GHI	T2		; DF=1 for ^C
+	SHL			; ...
+	RETURN			; and we're done
+
+;   Echo a character from D, but only if local echo is enabled (which is
+; bit 0 of BAUD.1, the same as the BIOS).  F_TTY uses the select port, so
+; interrupts are off while it runs ...
+UECHO:	PLO	BAUD		; save the character
+	GHI	BAUD		; get the echo flag
+	SHR			; ...
+	BNF	UECHO1		; do nothing if echo is off
+	INT_OFF			; ...
+	GLO	BAUD		; get the character back
+	CALL(F_TTY)		; and type it
+	INT_ON			; ...
+UECHO1:	RETURN			; ...
+
+;   Return DF=1 if RXBUF is empty, and in any case leave DP pointing to RXGET.
+; This doesn't need interrupts to be disabled, since UISR only ever changes
+; RXPUT with one instruction ...
+RXEMTY:	LDI	LOW(RXPUT)	; compare the fill and empty pointers
+	PLO	DP		; ...
+	SEX	DP		; ...
+	LDA	DP		; ...
+	XOR			; ...
+	SEX	SP		; ...
+	CDF			; assume they're different
+	LBNZ	RXEMT1		; and they are
+	SDF			; no - the buffer is empty
+RXEMT1:	RETURN			; ...
+
+;   Get the next character from RXBUF and return it in D.  This is called
+; with interrupts enabled, and UISR only ever changes RXPUT, so there's no
+; need to turn them off to look at RXBUF.  If the buffer is empty then we turn
+; on RTS (if it was off, it's OK for the host to start sending again) and wait
+; for an interrupt to put something there ...
+UGETC:	CALL(RXEMTY)		; is there anything there?
+	LBNF	UGETC2		; yes - go get it
+	INT_OFF			; no - assert RTS (UISR uses the select
+	SEX	PC		;  port too!)
+	WUART(MCR,DTR+RTS)	; ...
+	INT_ON			; ...
+UGETC1:	CALL(RXEMTY)		; and wait
+	LBDF	UGETC1		; ...
+UGETC2:	LDN	DP		; get the empty pointer (RXEMTY left DP there)
+	PLO	DP		; and point to the next character
+	LDN	DP		; get that
+	PLO	BAUD		; and save it for a moment
+	GLO	DP		; advance the empty pointer
+	ADI	1		; ...
+	ANI	RXBSIZ-1	; and wrap around at the end
+	STR	SP		; ...
+	LDI	LOW(RXGET)	; ...
+	PLO	DP		; ...
+	LDN	SP		; ...
+	STR	DP		; ...
+	GLO	BAUD		; return the character in D
+	RETURN			; ...
+
+;   Here's the UART interrupt service routine.  Interrupts can only happen
+; while TTYINP is reading a line, and that's monitor code so DP.1 is always
+; RAMPAGE.  We save D, DF and DP.0 (and X and P, of course) and nothing
+; else is changed.  Every character in the FIFO is moved to RXBUF and, once
+; RXSTOP characters are waiting, RTS is dropped.  That's early, but the FIFO
+; can fill up again while we're busy echoing and there has to be room in RXBUF
+; for all of that plus whatever the host sends before it stops.  Overruns in
+; the UART and characters that don't fit in RXBUF are both counted in OVRUNK.
+; Like the video ISR, the exit code comes first so that R1 is left pointing
+; to UISR ...
+UISRX:	IRX			; point to the saved DP.0
+	LDXA			; and restore it
+	PLO	DP		; ...
+	LDXA			; then DF
+	SHL			; ...
+	LDXA			; then D
+	RET			; and finally X, P and IE
+UISR:	DEC	SP		; make a space on the stack
+	SAV			; and push T (the saved X,P)
+	DEC	SP		; ...
+	STXD			; save D
+	SHRC			; and DF
+	STXD			; ...
+	GLO	DP		; and DP.0
+	STXD			; ...
+	SEX	INTPC		; read the IIR, which clears a transmitter
+	RUART(IIR)		;  ... interrupt (and nothing else does!)
+UISR1:	SEX	INTPC		; read the line status register
+	RUART(LSR)		; ...
+	ANI	OE		; was there an overrun?
+	LBNZ	UISR3		; yes - count it
+	LDN	SP		; get the LSR back (RUART left it there)
+	ANI	DR		; is there a character waiting?
+	LBZ	UISRX		; no - we're done
+	LDI	LOW(RXPUT)	; point DP at the next free slot in RXBUF
+	PLO	DP		; ...
+	LDN	DP		; ...
+	PLO	DP		; ...
+	SEX	INTPC		; and read the character straight into it
+	OUT	UART_SELECT	; ...
+	.DB	RBR		; ...
+	SEX	DP		; ...
+	INP	UART_DATA	; ...
+	SEX	SP		; ...
+	GLO	DP		; advance the fill pointer
+	ADI	1		; ...
+	ANI	RXBSIZ-1	; ...
+	STR	SP		; and save it for a moment
+	LDI	LOW(RXGET)	; compute RXPUT-RXGET
+	PLO	DP		; ...
+	LDN	DP		; ...
+	SD			; ...
+	ANI	RXBSIZ-1	; ...
+	LBZ	UISR3		; zero means RXBUF is full - it's an overrun
+	SMI	RXSTOP		; is it getting full?
+	LBNF	UISR2		; no
+	SEX	INTPC		; yes - drop RTS
+	WUART(MCR,DTR)		; ...
+	SEX	SP		; ...
+UISR2:	DEC	DP		; update RXPUT
+	LDN	SP		; ...
+	STR	DP		; ...
+	LBR	UISR1		; and look for more
+
+; Here to count an overrun ...
+UISR3:	LDI	LOW(OVRUNK+1)	; increment the low byte
+	PLO	DP		; ...
+	LDN	DP		; ...
+	ADI	1		; ...
+	STR	DP		; ...
+	DEC	DP		; and then the high byte
+	LDN	DP		; ...
+	ADCI	0		; ...
+	STR	DP		; ...
+	LBR	UISR1		; and keep going
+#endif
+
+	.EJECT
+;	.SBTTL	SET VIDEO FAST and SLOW
+
+#ifdef VIDEO
+;   The VT1802 display DMA and interrupts take more than half of the CPU time.
+; SET VIDEO FAST turns the display off (see VTFAST in video.asm) while every
+; monitor command runs, and back on whenever the monitor waits for console
+; input, rather like the ZX81's FAST mode.  That makes things like TEST RAM
+; run more than twice as fast.  Programs that the monitor starts (CALL, BOOT
+; and the languages) do their own console I/O, so the display is always turned
+; back on before they start - they can CALL VTFAST themselves if they like.
+; SET VIDEO SLOW goes back to normal, and so does a reset.  The frame buffer is
+; always kept up to date, so nothing printed while the display is off is lost.
+;
+;   This code doesn't care where it lives, so it's assembled into the otherwise
+; wasted space between HLDHEX and HLDHI ...
+SETVIE	.EQU	$		; remember where we were
+	.ORG	HLDGAP		; ...
+
+; Here for SET VIDEO (FAST or SLOW) ...
+SETVID:	RLDI(P2,VIDCMD)		; look up the option
+	LBR	SUBCMD		; ...
+
+; Table of SET VIDEO options ...
+VIDCMD:	CMD(4, "FAST", SETVFA)	; SET VIDEO FAST
+	CMD(4, "SLOW", SETVSL)	; SET VIDEO SLOW
+	.DB	0
+
+;   Here for SET VIDEO FAST or SLOW.  All we do is to remember which - if the
+; display needs to be turned on, the prompt will do that ...
+SETVFA:	LDI	$FF		; FAST
+	LSKP			; ...
+SETVSL:	LDI	0		; SLOW
+	PLO	P3		; save that for a minute
+	CALL(ISEOL)		; there shouldn't be anything more
+	LBNF	CMDERR		; ...
+	CALL(ISCRTC)		; and the VT1802 has to be in use
+	LBNF	CMDERR		; ...
+	LDI	LOW(VIDFST)	; update the mode
+	PLO	DP		;  (DP.1 is always RAMPAGE)
+	GLO	P3		; ...
+	STR	DP		; ...
+	RETURN			; and we're done
+
+;   Turn the display on, if there is one, before the monitor waits for console
+; input or starts a program.  Uses T1, T2 and DF ...
+VIDWAK:	CALL(ISCRTC)		; is the video card in use?
+	BNF	VIDSL9		; no - just return
+	LDI	0		; yes - turn the display on
+	LBR	VTFAST		; and return from there
+
+;   And turn it off again after reading a command line, but only for SET VIDEO
+; FAST.  This must not change DF (that's the ^C flag from reading the line!),
+; and neither does VTFAST when it turns the display off ...
+VIDSLP:	LDI	LOW(VIDFST)	; is it SET VIDEO FAST?
+	PLO	DP		; ...
+	LDN	DP		; ...
+	LBNZ	VTFAST		; yes - turn the display off
+VIDSL9:	RETURN			; no - nothing to do
+#if ($ > HLDHI)
+	.ECHO	"**** ERROR **** SET VIDEO doesn't fit before HLDHI!"
+#endif
+	.ORG	SETVIE		; and back to where we were
+#endif
+
+	.EJECT
+;	.SBTTL	Fast Boot
+
+;   Most of the time after a reset goes to POST - summing the whole EPROM
+; (about 2.8 seconds at 1.79MHz), sizing SRAM one byte at a time (3.8 more),
+; waiting for the RTC to tick (up to one second) and beeping the speaker (half
+; a second).  None of that tells us anything new when the SRAM key is valid
+; and the NVR is OK, so with SET FASTBOOT ON those tests are skipped on a warm
+; start.  The hardware probes themselves (UART, PPI, PS/2 keyboard and video)
+; cost almost nothing and still run every time, so UARTOK, PS2VER and VIDVER
+; are always right even if a card was pulled.  A cold start (the SRAM key is
+; wrong), a dead NVR battery, NVR contents from some other monitor version or
+; switches set to 0x42 or 0x43 (Elf2K only) always get the full POST.  The
+; SRAM key check also stands in for SIZMEM, since the key lives in RAMPAGE and
+; the monitor can't use any other memory size anyway.
+;
+;   FBTEST is entered from SYSINI with X=P=0 and no stack.  It goes to ROMCHK
+; with T2.0 zero for a full POST, or to DPDONE with T2.0 non-zero (and BATTOK
+; set to 1) for a fast one, and RTCINI and the speaker test look at T2.0...
+FBTEST:	LDI	0		; assume a full POST
+	PLO	T2		; ...
+	RLDI(SP,STACK-1)	; INP needs a RAM pointer
+
+;   The NVR battery has to be OK, the NVR contents have to belong to this
+; monitor, and fast boot has to be on.  If there's no NVR at all then these
+; just read whatever is floating on the bus, and all three won't match...
+	SEX	PC0		; ...
+	RNVR(NVRD)		; read register D
+	XRI	VRT		; VRT should be set and nothing else
+	LBNZ	ROMCHK		; battery failure - full POST
+	SEX	PC0		; ...
+	RNVR(NVRFREE+NVRVERS)	; then the NVR version
+	XRI	MONVER		; ...
+	LBNZ	ROMCHK		; ...
+	SEX	PC0		; ...
+	RNVR(NVRFREE+NVRFAST)	; and finally the fast boot flag
+	XRI	FBON		; ...
+	LBNZ	ROMCHK		; ...
+
+;   And the SRAM key has to match the EPROM (and the switches can't be 0x42
+; or 0x43) - RAMTS1 checks both.  With T2.0 = 2 it goes to DPDONE with BATTOK
+; set to 1 if they're OK, or to KEYBAD if they're not...
+	LDI	2		; ask for a fast boot
+	PLO	T2		; ...
+	LBR	RAMTS1		; and check the key
+
+;   Here from RAMTS1 when the SRAM key doesn't match.  That's the end of the
+; fast boot, if we were trying one, and we go back to do the full POST.  If
+; not, then it's a cold start...
+KEYBAD:	GLO	T2		; were we trying for a fast boot?
+	LBZ	DPTEST		; no - initialize SRAM
+	LDI	0		; yes - do the full POST instead
+	PLO	T2		; ...
+	LBR	ROMCHK		; ...
+
+;   The startup message says "FAST BOOT" rather than "CONTENTS OK" when the
+; slow tests were skipped.  D is BATTOK...
+FBMSG:	XRI	1		; BATTOK is 1 after a fast boot
+	LBNZ	FBMSG1		; ...
+	INLMES("FAST BOOT")	; SRAM contents were used and POST was skipped
+	RETURN			; ...
+FBMSG1:	INLMES("CONTENTS OK")	; current SRAM contents were used
+	RETURN			; ...
+
+;   SET FASTBOOT ON or OFF just changes the flag in NVR, so it's an error if
+; there's no NVR.  It takes effect on the next reset...
+SETFBT:	RLDI(P2,FBTCMD)		; look up the option
+	LBR	SUBCMD		; ...
+
+; Table of SET FASTBOOT options ...
+FBTCMD:	CMD(2, "ON",  SETFON)	; SET FASTBOOT ON
+	CMD(2, "OFF", SETFOF)	; SET FASTBOOT OFF
+	.DB	0
+
+; Here for SET FASTBOOT ON or OFF ...
+SETFON:	LDI	FBON		; ON
+	LSKP			; ...
+SETFOF:	LDI	FBOFF		; OFF
+	PLO	P3		; save that for a minute
+	CALL(ISEOL)		; there shouldn't be anything more
+	LBNF	CMDERR		; ...
+	CALL(F_RTCTEST)		; and there has to be an NVR
+	LBNF	CMDERR		; ...
+	GLO	P3		; put the flag on the stack
+	STXD			;  ... so F_WRNVR can write it
+	RCOPY(P2,SP)		; P2 points to the flag
+	INC	P2		; ...
+	RLDI(P1,NVRFAST)	; offset of the flag in NVR
+	RLDI(P3,1)		; and just one byte
+	CALL(F_WRNVR)		; ...
+	IRX			; pop the flag
+	RETURN			; and we're done
+
+	.EJECT
+;	.SBTTL	RAM Test Engine
+
+#ifdef MONEXT2
+;   The original RAMTEST runs the Knaizuk and Hartmann test a byte at a time,
+; with a modulo 3 counter to update for every byte, and it takes about a
+; minute for each pass over 32K.  That's too slow to run every time a board
+; is powered up, and it still misses a lot of coupling faults.  This is the
+; replacement for it, and it's the TEST RAM command when MONEXT2 is defined -
+;
+;	TE[ST] RAM [MA[RCH]|PA[TTERN]|BU[S]|QU[ICK] [start [end]]]
+;
+;   MARCH is the default and runs the March C- algorithm -
+;
+;	{ (w0); up(r0,w1); up(r1,w0); down(r0,w1); down(r1,w0); (r0) }
+;
+; where "0" is a data background byte and "1" is its complement.  Each pass
+; uses the next background from RTBGND, so four passes also find coupling
+; faults between the bits of the same byte.  PATTERN is the old Knaizuk and
+; Hartmann test, and BUS is a walking ones test of the data bus followed by a
+; test of the address lines - each address that's a power of two away from
+; the start is written in turn and all the others are checked.  All of these
+; repeat until BREAK is pressed.  QUICK is a single pass of BUS and then one
+; pass of MARCH, and it returns to the prompt after that.  It's the one to use
+; at every power on.
+;
+;   The range defaults to all of RAM below the monitor's data page (or below
+; the VT1802 frame buffer, if it's in use) and is always rounded out to whole
+; pages.  The elapsed time is printed at the end of every pass if there's an
+; RTC and the VT1802 isn't running - it's counted by the same 256Hz periodic
+; interrupt that PROFILE and TIME use, so it's good to about 4ms rather than
+; to a whole second, and it wraps around after 256 seconds.  The interrupt
+; costs the test about 3% of the CPU.  All the inner loops are unrolled and
+; run a page at a time with no per byte bookkeeping other than the address.  At 1.79MHz a pass over 32K
+; takes about 10 seconds for MARCH, 17 seconds for PATTERN (the old RAMTEST
+; took over a minute for the same thing) and a third of a second for BUS.
+;
+; Register usage:
+;	P2   = memory address
+;	P3.1 = first page to test
+;	P3.0 = last page to test
+;	P4.1 = byte expected
+;	P4.0 = byte to write
+;	T1.0 = count of pages left
+;	T2   = data background and pass counter (used differently by each test)
+
+; Here for TEST RAM ...
+RTTEST:	CALL(F_LTRIM)		; ignore any spaces
+	CALL(ISEOL)		; no arguments at all?
+	BDF	RTMARC		; yes - the default is MARCH
+	RLDI(P2,RTOPTS)		; otherwise look up the algorithm
+	LBR	COMND		; ...
+
+; Table of TEST RAM algorithms ...
+RTOPTS:	CMD(2, "MARCH",   RTMARC)	; March C-
+	CMD(2, "PATTERN", RTPATT)	; Knaizuk and Hartmann
+	CMD(2, "BUS",     RTBUS)	; data and address bus
+	CMD(2, "QUICK",   RTQUIK)	; bus test and one March pass
+	.DB	0
+
+; Data backgrounds for MARCH, one for each pass ...
+RTBGND:	.DB	$00, $55, $33, $0F
+#if ((RTBGND & $FF00) != ((RTBGND+3) & $FF00))
+	.ECHO	"**** ERROR **** RTBGND must not cross a page!"
+#endif
+
+;   Parse the optional start and end address, leave the first and last pages
+; in P3, clear the pass and error counts and print the "Testing" message...
+RTARGS:	CALL(RTTOP)		; the default is all of RAM
+	SMI	1		; ... up to the top page
+	PLO	P3		; ...
+	LDI	0		; ... from page zero
+	PHI	P3		; ...
+	CALL(F_LTRIM)		; is there a start address?
+	CALL(ISEOL)		; ...
+	BDF	RTARG1		; no - use the defaults
+	CALL(SCANP1)		; yes - read it
+	GHI	P2		; and round it down to a page
+	PHI	P3		; ...
+	CALL(F_LTRIM)		; is there an end address too?
+	CALL(ISEOL)		; ...
+	BDF	RTARG1		; no
+	CALL(SCANP1)		; yes - read that
+	GHI	P2		; and round it up to the end of its page
+	PLO	P3		; ...
+	CALL(F_LTRIM)		; and that had better be all
+	CALL(ISEOL)		; ...
+	LBNF	CMDERR		; ...
+RTARG1:	CALL(RTTOP)		; the last page has to be below the top
+	STR	SP		; ...
+	GLO	P3		; ...
+	SM			; ...
+	LBDF	CMDERR		; ...
+	GHI	P3		; and the first page can't be after the last
+	STR	SP		; ...
+	GLO	P3		; ...
+	SM			; ...
+	LBNF	CMDERR		; ...
+	PUSHR(P3)		; save the range
+	CALL(CLRPEK)		; clear PASSK and ERRORK
+	IRX			; get the first page back
+	LDXA			; ...
+	SD			; and figure the number of pages
+	ADI	1		; ...
+	DEC SP\ DEC SP		; (protect the range)
+	CALL(PRTSBM)		; "Testing nnnnn bytes - press BREAK to abort"
+	IRX			; restore the range
+	POPRL(P3)		; ...
+	RETURN			; ...
+
+;   Return the page number of the top of RAM in D, which is RAMPAGE or SCREEN
+; if the VT1802 is in use.  Uses T1 ...
+RTTOP:
+#ifdef VIDEO
+	CALL(ISCRTC)		; is the video card active?
+	LDI	HIGH(SCREEN)	; (doesn't change DF!)
+	BDF	RTTOP1		; yes - stop at the frame buffer
+#endif
+	LDI	HIGH(RAMPAGE)	; no - test all the way up to RAMPAGE
+RTTOP1:	RETURN			; ...
+
+; Here for TEST RAM MARCH ...
+RTMARC:	CALL(RTARGS)		; parse the range
+	LDI	0		; start with the first data background
+	PLO	T2		; ...
+RTMAR1:	CALL(RTSTRT)		; start a pass
+	CALL(RTMRCH)		; do one March C- pass
+	CALL(RTEND)		; print the pass count
+	INC	T2		; use the next background
+	BR	RTMAR1		; and go again
+
+; Here for TEST RAM PATTERN ...
+RTPATT:	CALL(RTARGS)		; parse the range
+RTPAT1:	CALL(RTSTRT)		; start a pass
+	CALL(RTKH)		; do all six iterations
+	CALL(RTEND)		; ...
+	BR	RTPAT1		; and again
+
+; Here for TEST RAM BUS ...
+RTBUS:	CALL(RTARGS)		; parse the range
+RTBUS1:	CALL(RTSTRT)		; ...
+	CALL(RTBUSC)		; test the data and address buses
+	CALL(RTEND)		; ...
+	BR	RTBUS1		; ...
+
+; And TEST RAM QUICK is just one pass of BUS and MARCH ...
+RTQUIK:	CALL(RTARGS)		; parse the range
+	CALL(RTSTRT)		; start the one and only pass
+	CALL(RTBUSC)		; test the buses first
+	LDI	0		; then March C- with a background of $00
+	PLO	T2		; ...
+	CALL(RTMRCH)		; ...
+	BR	RTEND		; print the results and return to the prompt
+
+;   Start a pass - print "Testing RAM " and start the clock.  Preserves P3
+; and T2 ...
+RTSTRT:	PUSHR(P3)		; save the range
+	PUSHR(T2)		; and the pass data
+	OUTSTR(RTSMSG)		; "Testing RAM "
+#ifdef MONEXT6
+	CALL(RTTIME)		; (after the message - see RTIOFF)
+#endif
+	BR	RTEND9		; restore the registers and return
+
+;   Finish a pass - count it, print the pass and error counts and, if it was
+; timed, the time this pass took.  Preserves P3 and T2 ...
+RTEND:	PUSHR(P3)		; save the range
+	PUSHR(T2)		; and the pass data
+#ifdef MONEXT6
+	CALL(RTSTOP)		; stop the clock first
+#endif
+	CALL(INPASK)		; count this pass
+	CALL(PRTPEK)		; " Pass n Errors m"
+#ifdef MONEXT6
+	LDI	LOW(TIMBUF)	; was this pass timed?
+	PLO	DP		; ...
+	LDN	DP		; ...
+	BZ	RTEND8		; no
+	INLMES(" Time ")	; ...
+	RCOPY(T2,0)		; R0 has the ticks
+	CALL(TIMSEC)		; type "s.sss sec" and a CRLF
+	BR	RTEND9		; ...
+#endif
+RTEND8:	CALL(TCRLF)		; finish the line
+RTEND9:	IRX			; restore T2
+	POPR(T2)		; ...
+	POPRL(P3)		; and P3
+	RETURN			; ...
+
+#ifdef MONEXT6
+;   Start timing a pass, if we can.  The DS12887 periodic interrupt counts
+; 256 ticks a second in R0, and TIMBUF+0 is non-zero while it's running.
+; That needs the RTC, of course, and it can't be done while the VT1802 is
+; running because the VT1802 owns both R0 (for DMA) and R1 ...
+RTTIME:	LDI	LOW(TIMBUF)	; assume we can't
+	PLO	DP		; ...
+	LDI	0		; ...
+	STR	DP		; ...
+#ifdef VIDEO
+	CALL(ISCRTC)		; is the video card active?
+	BDF	RTTIM9		; yes - no time, then
+#endif
+	CALL(F_RTCTEST)		; is there an RTC?
+	BNF	RTTIM9		; no
+	LDI	LOW(TIMBUF)	; yes - remember that the clock is running
+	PLO	DP		; ...
+	LDI	$FF		; ...
+	STR	DP		; ...
+	RCLEAR(0)		; start from zero
+	RLDI(INTPC,RTTICK)	; point R1 at the ISR
+	LBR	PRFON		; and start the periodic interrupt
+RTTIM9:	RETURN			; ...
+
+;   Stop the clock, if it's running.  TIMBUF+0 is left alone, so RTEND still
+; knows if this pass was timed, and MAIN points R1 at TRAP again later ...
+RTSTOP:	LDI	LOW(TIMBUF)	; is the clock running?
+	PLO	DP		; ...
+	LDN	DP		; ...
+	BZ	RTTIM9		; no - nothing to do
+	LBR	PRFOFF		; yes - no more ticks
+
+;   While a pass is being timed, the console I/O (the dots and the error
+; messages) has to be done with interrupts off.  The RTC, the UART and the
+; IDE disk all share the same write only register select port, so the tick
+; interrupt can't be allowed to happen in the middle of one of the BIOS's
+; UART accesses.  RTIOFF turns them off and RTION turns them back on, but
+; only if the clock is running - if the VT1802 is active then it needs its
+; interrupts and they're left alone.  Both change DP ...
+RTIOFF:	LDI	LOW(TIMBUF)	; is the clock running?
+	PLO	DP		; ...
+	LDN	DP		; ...
+	BZ	RTTIM9		; no - leave the interrupts alone
+	INT_OFF			; yes - stop the ticks for now
+	RETURN			; ...
+RTION:	LDI	LOW(TIMBUF)	; is the clock running?
+	PLO	DP		; ...
+	LDN	DP		; ...
+	BZ	RTTIM9		; no
+	INT_ON			; yes - let the ticks in again
+	RETURN			; ...
+
+;   The tick interrupt service routine.  All it does is clear the interrupt
+; and count R0, and it saves D (INP changes it) and nothing else.  Like
+; PRFISR, the exit comes first so that R1 is left pointing to RTTICK ...
+RTTICX:	IRX			; restore D
+	LDXA			; ...
+	RET			; and finally X, P and IE
+RTTICK:	DEC	SP		; make a space on the stack
+	SAV			; and push T (the saved X,P)
+	DEC	SP		; ...
+	STXD			; save D
+	SEX	INTPC		; read register C to clear the interrupt
+	RNVR(NVRC)		; ...
+	INC	0		; count the tick
+	BR	RTTICX		; ...
+
+; Here if BREAK is pressed during a pass - stop the clock and quit ...
+RTBRK:	CALL(RTSTOP)		; ...
+	LBR	MAIN		; ...
+#endif
+
+;   Print a dot to show some progress, and quit if the user wants to stop.
+; Preserves everything except DP ...
+#ifdef MONEXT6
+RTDOT:	CALL(RTIOFF)		; no ticks while we use the console
+	OUTCHR('.')		; ...
+	CALL(F_BRKTEST)		; BREAK?
+	BDF	RTBRK		; yes - quit now
+	BR	RTION		; no - carry on
+#else
+RTDOT:	OUTCHR('.')		; ...
+	CALL(F_BRKTEST)		; BREAK?
+	LBDF	MAIN		; yes - quit now
+	RETURN			; no - carry on
+#endif
+
+;   Report a RAM error at the address in P2.  The byte expected is in D, and
+; the byte actually there is read again.  Preserves everything but P1 and DP ...
+RTERR:	PUSHD			; save the expected byte
+#ifdef MONEXT6
+	CALL(RTIOFF)		; no ticks while we use the console
+#endif
+	OUTSTR(REAMSG)		; "?RAM ERROR AT "
+	RCOPY(P1,P2)		; ...
+	CALL(THEX4)		; ...
+	INLMES(" EXPECTED ")	; ...
+	POPD			; ...
+	CALL(THEX2)		; ...
+	INLMES(" READ ")	; ...
+	LDN	P2		; ...
+	CALL(THEX2)		; ...
+	CALL(TCRLF)		; ...
+#ifdef MONEXT6
+	CALL(RTION)		; start the clock again
+#endif
+	LBR	INERRK		; count the error and return
+
+;   Check that the byte at P2 is D, and report an error if it isn't.  Leaves
+; the byte expected in P4.1 ...
+RTCHK:	PHI	P4		; save the expected byte
+	SEX	P2		; compare it with memory
+	XOR			; ...
+	SEX	SP		; ...
+	BZ	RTCHK1		; return if it's OK
+	GHI	P4		; no - get the expected byte again
+	LBR	RTERR		; report an error and return
+RTCHK1:	RETURN			; ...
+
+;   Point P2 at the first byte in the range, or the last, and set T1.0 to the
+; number of pages in the range.  These are used to start all the page loops.
+RTFRST:	GHI	P3		; the first page
+	PHI	P2		; ...
+	LDI	0		; ...
+	PLO	P2		; ...
+	BR	RTPGS		; ...
+RTLAST:	GLO	P3		; the last page
+	PHI	P2		; ...
+	LDI	$FF		; ...
+	PLO	P2		; ...
+RTPGS:	GHI	P3		; count the pages
+	STR	SP		; ...
+	GLO	P3		; ...
+	SM			; ...
+	ADI	1		; ...
+	PLO	T1		; ...
+	RETURN			; ...
+
+;   Do one pass of March C-, using the data background from RTBGND selected by
+; T2.0.  T2.1 holds the background byte ...
+RTMRCH:	GLO	T2		; select the background
+	ANI	3		; ...
+	ADI	LOW(RTBGND)	; ...
+	PLO	P4		; ...
+	LDI	HIGH(RTBGND)	; ...
+	PHI	P4		; ...
+	LDN	P4		; ...
+	PHI	T2		; ...
+	PLO	P4		; (w0)
+	CALL(RTFILL)		; ...
+	GHI	T2		; up(r0,w1)
+	PHI	P4		; ...
+	XRI	$FF		; ...
+	PLO	P4		; ...
+	CALL(MUP)		; ...
+	GHI	T2		; up(r1,w0)
+	PLO	P4		; ...
+	XRI	$FF		; ...
+	PHI	P4		; ...
+	CALL(MUP)		; ...
+	GHI	T2		; down(r0,w1)
+	PHI	P4		; ...
+	XRI	$FF		; ...
+	PLO	P4		; ...
+	CALL(MDN)		; ...
+	GHI	T2		; down(r1,w0)
+	PLO	P4		; ...
+	XRI	$FF		; ...
+	PHI	P4		; ...
+	CALL(MDN)		; ...
+	GHI	T2		; (r0)
+	PHI	P4		; ...
+	PLO	P4		; ...
+	LBR	MUP		; ...
+
+
+#endif
+
+	.EJECT
+;	.SBTTL	PROFILE Results
+
+#ifdef PROFILE
+;   PRFRPT turns off the PROFILE sampler and types the results - the total
+; number of samples, and then the page and count for every page that was
+; sampled at all.  It's called by PRFCMD when the program returns, or after a
+; BREAK.  There's no room for this in the monitor proper, so it lives here ...
+PRFRPT:	CALL(PRFOFF)		; no more samples
+	RCLEAR(P1)		; add up all the samples
+	PLO	P3		;  (DSKBUF is page aligned)
+	LDI	HIGH(DSKBUF)	; ...
+	PHI	P3		; ...
+PRFRP1:	LDA	P3		; ...
+	STR	SP		; ...
+	GLO	P1		; ...
+	ADD			; ...
+	PLO	P1		; ...
+	LDA	P3		; ...
+	STR	SP		; ...
+	GHI	P1		; ...
+	ADC			; ...
+	PHI	P1		; ...
+	GHI	P3		; ...
+	XRI	HIGH(DSKBUF+512); ...
+	BNZ	PRFRP1		; ...
+#ifdef MONEXT6
+	LDI	LOW(PRFTIM)	; is this really the TIME command?
+	PLO	DP		;  (DP.1 is always RAMPAGE)
+	LDN	DP		; ...
+	LBNZ	TIMRPT		; yes - type the time instead
+#endif
+	CALL(TDEC16)		; and type that
+	INLMES(" samples\r\n")	; ...
+	LDI	0		; T2.0 is the page number
+	PLO	T2		; ...
+	PLO	P3		; now type every page that was sampled
+	LDI	HIGH(DSKBUF)	; ...
+	PHI	P3		; ...
+PRFRP2:	LDA	P3		; get the count for this page
+	PLO	P1		; ...
+	LDA	P3		; ...
+	PHI	P1		; ...
+	STR	SP		; is it zero?
+	GLO	P1		; ...
+	OR			; ...
+	BZ	PRFRP5		; yes - skip it
+	GLO	T2		; is this the "other" count?
+	XRI	HIGH(RAMPAGE)	; ...
+	BZ	PRFRP3		; yes
+	GLO	T2		; no - type the page as "xxxx"
+	CALL(THEX2)		; ...
+	INLMES("xx")		; ...
+	BR	PRFRP4		; ...
+PRFRP3:	INLMES("other")		; ...
+PRFRP4:	CALL(TTABC)		; then the count
+	CALL(TDEC16)		; ...
+	CALL(TCRLF)		; ...
+PRFRP5:	INC	T2		; on to the next page
+	GLO	T2		; ...
+	BNZ	PRFRP2		; ...
+	RETURN			; all done
+
+;   PRFON starts the DS12887 periodic interrupt at 256Hz, with R1 already
+; pointing to the interrupt service routine, and turns the interrupts on.
+; PRFOFF turns them both off again.  The RAM test's clock uses these too ...
+PRFON:	SEX	PC		; start the periodic interrupt
+	WNVR(NVRA,DV1+$08)	; ...
+	WNVR(NVRB,PIE+DM+HR24+DSE); ...
+	RNVR(NVRC)		; (reading C clears any old interrupt)
+	INT_ON			; ...
+	RETURN			; ...
+PRFOFF:	INT_OFF			; no more ticks
+	SEX	PC		; and turn the periodic interrupt off
+	WNVR(NVRB,DM+HR24+DSE)	; ...
+	WNVR(NVRA,DV1)		; ...
+	SEX	SP		; ...
+	RETURN			; ...
+
+;   PRFCMD jumps here to start the sampler and call the program, with RETPC
+; pointing to PRFRET while it runs.  When it returns SCRT has to be put back,
+; and that's just what happens after a BREAK, so it falls into PRFBRK ...
+PRFGO:	CALL(F_RTCTEST)		; we need the RTC
+	LBNF	NORTC		; ...
+	RLDI(INTPC,PRFISR)	; point R1 at the sampler
+	RLDI(RETPC,PRFRET)	; and RETPC at its RETURN
+	CALL(PRFON)		; start the clock
+	CALL(CALUS0)		; and call the program
+
+;   The sampler jumps here if the console receives a BREAK.  The program's
+; context is lost, just like it is after a breakpoint, but the results are
+; typed anyway ...
+PRFBRK:	RLDI(SP,STACK)		; reset the stack
+	RLDI(A,PRFBK1)		; continue from PRFBK1
+#ifdef CDP1805
+	LBR	INITSC		; and reinitialize SCRT
+#else
+	LBR	F_INITCALL	; and reinitialize SCRT
+#endif
+PRFBK1:	CALL(PRFRPT)		; type the results
+	LBR	MAIN		; and start over
+#endif
+
+#ifdef MEMCMDS
+MEMEXT	.EQU	$		; FILL, COMPARE and SEARCH go here
+#endif
+
+; If the extensions have outgrown their space, then cause an assembly error...
+#if ($ > MONXTOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow!"
+#endif
+
+	.EJECT
+;	.SBTTL	RAM Test Algorithms
+
+;   There isn't room at MONEXT for all of the RAM test engine, so the tests
+; themselves live in the second chunk of extension space at MONEXT2.  The
+; inner loops for MARCH and PATTERN have to be on one page, and MONEXT2 is
+; page aligned so they go first ...
+#ifdef MONEXT2
+	.ORG	MONEXT2
+
+;   These are the March elements.  MUP goes up and MDN goes down, and for
+; every byte in the range they check that it's P4.1 and then write P4.0.
+; The inner loops do four bytes at a time and they must be on one page.
+; After an error the rest of the group is done one byte at a time, and then
+; we go back to the unrolled loop ...
+MUP:	CALL(RTFRST)		; start at the beginning
+	SEX	P2		; ...
+MUP1:	GHI	P4\ XOR\ BNZ MUPE\ GLO P4\ STR P2\ INC P2
+	GHI	P4\ XOR\ BNZ MUPE\ GLO P4\ STR P2\ INC P2
+	GHI	P4\ XOR\ BNZ MUPE\ GLO P4\ STR P2\ INC P2
+	GHI	P4\ XOR\ BNZ MUPE\ GLO P4\ STR P2\ INC P2
+MUP2:	GLO	P2		; end of this page?
+	BNZ	MUP1		; no
+	DEC	T1		; yes - any more pages?
+	GLO	T1		; ...
+	BNZ	MUP1		; ...
+	SEX	SP		; ...
+	LBR	RTDOT		; all done
+MUPE:	GHI	P4		; report the error
+	CALL(RTERR)		; ...
+MUPE1:	GLO	P4		; and then do the write anyway
+	STR	P2		; ...
+	INC	P2		; ...
+	SEX	P2		; (SCRT changes X!)
+	GLO	P2		; back at the start of a group?
+	ANI	3		; ...
+	BZ	MUP2		; yes - back to the fast loop
+	GHI	P4		; no - check the next byte
+	XOR			; ...
+	BZ	MUPE1		; ...
+	BR	MUPE		; ...
+
+MDN:	CALL(RTLAST)		; start at the end
+	SEX	P2		; ...
+MDN1:	GHI	P4\ XOR\ BNZ MDNE\ GLO P4\ STR P2\ DEC P2
+	GHI	P4\ XOR\ BNZ MDNE\ GLO P4\ STR P2\ DEC P2
+	GHI	P4\ XOR\ BNZ MDNE\ GLO P4\ STR P2\ DEC P2
+	GHI	P4\ XOR\ BNZ MDNE\ GLO P4\ STR P2\ DEC P2
+MDN2:	GLO	P2		; end of this page?
+	XRI	$FF		; ...
+	BNZ	MDN1		; no
+	DEC	T1		; yes - any more pages?
+	GLO	T1		; ...
+	BNZ	MDN1		; ...
+	SEX	SP		; ...
+	LBR	RTDOT		; all done
+MDNE:	GHI	P4		; report the error
+	CALL(RTERR)		; ...
+MDNE1:	GLO	P4		; and then do the write anyway
+	STR	P2		; ...
+	DEC	P2		; ...
+	SEX	P2		; ...
+	GLO	P2		; back at the end of a group?
+	ANI	3		; ...
+	XRI	3		; ...
+	BZ	MDN2		; yes
+	GHI	P4		; no - check the next byte
+	XOR			; ...
+	BZ	MDNE1		; ...
+	BR	MDNE		; ...
+
+;   And this is the Knaizuk and Hartmann verify loop.  It must be on one page
+; too, and after an error it just carries on with the next byte ...
+RTKV:	SEX	P2		; ...
+RTKV1:	GHI	P4\ XOR\ BNZ RTKE1
+RTKV2:	INC	P2\ GLO P4\ XOR\ BNZ RTKE2
+RTKV3:	INC	P2\ GHI T2\ XOR\ BNZ RTKE3
+RTKV4:	INC	P2		; end of the page?
+	GLO	P2		; ...
+	XRI	$FF		; ...
+	BNZ	RTKV1		; no
+	GHI	P4		; yes - check the last byte
+	XOR			; ...
+	BNZ	RTKE4		; ...
+RTKV5:	INC	P2		; ...
+	GHI	P4		; rotate the three bytes expected
+	STR	SP		; ...
+	GLO	P4		; ...
+	PHI	P4		; ...
+	GHI	T2		; ...
+	PLO	P4		; ...
+	LDN	SP		; ...
+	PHI	T2		; ...
+	DEC	T1		; any more pages?
+	GLO	T1		; ...
+	BNZ	RTKV1		; ...
+	SEX	SP		; no - this iteration is done
+	CALL(RTDOT)		; ...
+	INC	T2		; on to the next iteration
+	GLO	T2		; ...
+	XRI	6		; have we done all six?
+	LBNZ	RTKH1		; no - keep going
+	RETURN			; yes - this pass is done
+RTKE1:	GHI	P4\ CALL(RTERR)\ SEX P2\ BR RTKV2
+RTKE2:	GLO	P4\ CALL(RTERR)\ SEX P2\ BR RTKV3
+RTKE3:	GHI	T2\ CALL(RTERR)\ SEX P2\ BR RTKV4
+RTKE4:	GHI	P4\ CALL(RTERR)\ SEX P2\ BR RTKV5
+#if ((MUP & $FF00) != ($ & $FF00))
+	.ECHO	"**** ERROR **** MUP, MDN and RTKV must be on the same page!"
+#endif
+
+;   Fill the range with P4.0, eight bytes at a time.  It has to go backwards,
+; because that's the way STXD goes ...
+RTFILL:	CALL(RTLAST)		; start at the end
+	SEX	P2		; ...
+RTFIL1:	GLO	P4		; ...
+	STXD\ STXD\ STXD\ STXD	; ...
+	STXD\ STXD\ STXD\ STXD	; ...
+	GLO	P2		; end of this page?
+	XRI	$FF		; ...
+	BNZ	RTFIL1		; no
+	DEC	T1		; yes - any more pages?
+	GLO	T1		; ...
+	BNZ	RTFIL1		; ...
+	SEX	SP		; ...
+	RETURN			; ...
+
+;   Point P2 at the first address plus the offset in T1, and return DF=1 if
+; that's still in the range ...
+RTADR:	GLO	T1		; ...
+	PLO	P2		; ...
+	GHI	P3		; ...
+	STR	SP		; ...
+	GHI	T1		; ...
+	ADD			; ...
+	PHI	P2		; ...
+	STR	SP		; ...
+	GLO	P3		; ...
+	SM			; ...
+	RETURN			; ...
+
+; Go to the next address bus offset - 0, 1, 2, 4, 8, ...
+RTNXT:	GLO	T1		; is it zero now?
+	STR	SP		; ...
+	GHI	T1		; ...
+	OR			; ...
+	BNZ	RTNXT1		; ...
+	INC	T1		; yes - go to 1
+	RETURN			; ...
+RTNXT1:	RSHL(T1)		; otherwise just shift it left
+	RETURN			; ...
+
+;   Test the data bus with walking ones at the first address, and then the
+; address bus.  Every address that's a power of two bytes from the start of
+; the range, and the start itself, gets $AA.  Then each one in turn is
+; changed to $55 and all the others are checked - a stuck or shorted address
+; line will change one of them.  T1 is the offset being checked and T2 is the
+; offset being tested ...
+RTBUSC:	CALL(RTFRST)		; the data bus first
+	LDI	$01		; walking ones
+RTBUS2:	STR	P2		; write it
+	CALL(RTCHK)		; and read it back
+	GHI	P4		; get the pattern back
+	SHL			; move the one over
+	BNZ	RTBUS2		; and do all eight bits
+	CALL(RTDOT)		; ...
+	RCLEAR(T1)		; write $AA to all the offsets
+RTBUS3:	CALL(RTADR)		; ...
+	BNF	RTBUS4		; ...
+	LDI	$AA		; ...
+	STR	P2		; ...
+	CALL(RTNXT)		; ...
+	BR	RTBUS3		; ...
+RTBUS4:	RCLEAR(T2)		; now test each offset in turn
+RTBUS5:	RCOPY(T1,T2)		; ...
+	CALL(RTADR)		; ...
+	LBNF	RTDOT		; all done when we've run out of range
+	LDI	$55		; write $55 to this one
+	STR	P2		; ...
+	RCLEAR(T1)		; and check them all
+RTBUS6:	CALL(RTADR)		; ...
+	BNF	RTBUS8		; ...
+	GLO	T1		; the one being tested should be $55
+	STR	SP		; ...
+	GLO	T2		; ...
+	XOR			; ...
+	BNZ	RTBUS7		; ...
+	GHI	T1		; ...
+	STR	SP		; ...
+	GHI	T2		; ...
+	XOR			; ...
+	BNZ	RTBUS7		; ...
+	LDI	$55		; ...
+	LSKP			; ...
+RTBUS7:	LDI	$AA		; and all the rest $AA
+	CALL(RTCHK)		; ...
+	CALL(RTNXT)		; ...
+	BR	RTBUS6		; ...
+RTBUS8:	RCOPY(T1,T2)		; put $AA back in this one
+	CALL(RTADR)		; ...
+	LDI	$AA		; ...
+	STR	P2		; ...
+	CALL(RTNXT)		; and on to the next
+	RCOPY(T2,T1)		; ...
+	BR	RTBUS5		; ...
+
+;   Do all six iterations of the Knaizuk and Hartmann test.  This is the same
+; test as RAMTEST, but the fill and verify loops are unrolled.  The verify
+; loop checks three bytes at a time, with the three bytes expected in P4.1,
+; P4.0 and T2.1.  There are 85 groups of three in a page plus one more byte,
+; so at the end of each page the three are rotated by one.  T2.0 counts the
+; iterations ...
+RTKH:	LDI	0		; ...
+	PLO	T2		; ...
+RTKH1:	GLO	T2		; the fill is $FF for the first three
+	SMI	3		;  ... and $00 for the last three
+	LDI	0		; ...
+	SHLC			; ...
+	SMI	1		; ...
+	PLO	P4		; ...
+	CALL(RTFILL)		; fill memory
+	GLO	P4		; the test byte is the complement
+	XRI	$FF		; ...
+	PHI	P4		; ...
+	GLO	T2		; compute the iteration MOD 3
+	SMI	3		; ...
+	BDF	RTKH2		; ...
+	ADI	3		; ...
+RTKH2:	PLO	T1		; ...
+	PLO	P2		; start at that offset
+	GHI	P3		; ...
+	PHI	P2		; ...
+RTKH3:	GHI	P4		; write every third byte
+	STR	P2		; ...
+	INC	P2		; ...
+	INC	P2		; ...
+	INC	P2		; ...
+	GHI	P2		; until we pass the last page
+	STR	SP		; ...
+	GLO	P3		; ...
+	SM			; ...
+	BDF	RTKH3		; ...
+	GLO	P4		; the three bytes expected are all the fill
+	PHI	T2		; ...
+	GLO	T1		; except for one of them
+	BZ	RTKH5		; the first - P4 is already right
+	SMI	1		; ...
+	BNZ	RTKH4		; ...
+	GHI	P4		; the second
+	PLO	P4		; ...
+	GHI	T2		; ...
+	PHI	P4		; ...
+	BR	RTKH5		; ...
+RTKH4:	GHI	P4		; the third
+	PHI	T2		; ...
+	GLO	P4		; ...
+	PHI	P4		; ...
+RTKH5:	CALL(RTFRST)		; and check them all
+	LBR	RTKV		; ...
+#endif
+#endif
+
+	.EJECT
+;	.SBTTL	Help Text Decompression
+
+;   If HELPLZ is defined then the help text is stored compressed (by the ROMLZ
+; tool) and we expand it again one block at a time, into the top half of
+; DSKBUF, as it's typed.  Each block is at most 255 characters (half of
+; DSKBUF less room for a null).  Before each block the previous one is slid
+; down into the bottom half of DSKBUF, so a block can refer back to the text
+; of the block before it as well as to itself, but there's still no need for
+; a ring buffer or any wrap around checks here.  A block is a series of
+; tokens, and each token starts with a control byte -
+;
+;	00		end of the block
+;	01..7F		that many literal bytes follow
+;	1LLLLLLD dddddddd
+;			copy LLLLLL+3 (3..66) bytes that start Dddddddd+1
+;			(1..512) bytes back in the output
+;
+; An empty block (just a 00) marks the end of the text.  The format is byte
+; oriented, so there's no shifting bits in and out, and both inner loops are
+; six instructions (12 machine cycles) per byte.
+;
+;   All this normally goes at the end of MONEXT2, but a ROM without MONEXT2
+; (the PicoElf and the alternate Elf2K EPROM) puts it at HLPEXT instead, and
+; the alternate EPROM has no MONEXT either.
+#ifdef HELPLZ
+#ifndef MONEXT2
+	.ORG	HLPEXT
+#endif
+
+;   HLPBLK expands the next block of the help text.  P4 points to the
+; compressed text and it's advanced past the block.  If there's no more text
+; it returns with DF=1, and otherwise it returns with DF=0 and with P1 and P2
+; both pointing to the expanded, null terminated, text in DSKBUF+256.  It uses T1
+; and T2, and it preserves P3 ...
+HLPBLK:	LDN	P4		; is this the end of the text?
+	BNZ	LZDEC		; no - expand another block
+	SDF			; yes - return DF=1
+	RETURN			; ...
+
+; Here to expand a block...
+LZDEC:	LDI	HIGH(DSKBUF)	; T1 points to the bottom half of DSKBUF
+	PHI	T1		; ...
+	LDI	HIGH(DSKBUF)+1	; P1 is the output pointer
+	PHI	P1		; ... and P2 remembers where it started
+	PHI	P2		; ...
+	LDI	0		; (DSKBUF is always page aligned)
+	PLO	T1		; ...
+	PLO	P1		; ...
+	PLO	P2		; ...
+LZDEC0:	LDA	P1		; slide the last block down into the
+	STR	T1		;  bottom half, where we can still
+	INC	T1		;  refer back to it
+	GLO	T1		; ...
+	BNZ	LZDEC0		; ...
+	GHI	P2		; and point P1 at the top half again
+	PHI	P1		; ...
+LZDEC1:	LDA	P4		; get the next control byte
+	BZ	LZDEC9		; zero is the end of the block
+	PLO	T2		; save it for a moment
+	ANI	$80		; is it a literal or a match?
+	BNZ	LZDEC3		; branch if it's a match
+
+; Copy a run of literal bytes ...
+LZDEC2:	LDA	P4		; copy another byte
+	STR	P1		; ...
+	INC	P1		; ...
+	DEC	T2		; and count them
+	GLO	T2		; ...
+	BNZ	LZDEC2		; ...
+	BR	LZDEC1		; then on to the next token
+
+; Copy a match from the text we've already expanded...
+LZDEC3:	GLO	T2		; the high bit of the distance
+	ANI	$01		; ...
+	PHI	T1		; ...
+	LDA	P4		; and then the low byte
+	PLO	T1		; ...
+	INC	T1		; the distance is always 1..512
+	GLO	T1		; T1 = P1 - distance
+	STR	SP		; ...
+	GLO	P1		; ...
+	SM			; ...
+	PLO	T1		; ...
+	GHI	T1		; ...
+	STR	SP		; ...
+	GHI	P1		; ...
+	SMB			; ...
+	PHI	T1		; ...
+	GLO	T2		; and the length is 3..66
+	ANI	$7E		; ...
+	SHR			; ...
+	ADI	3		; ...
+	PLO	T2		; ...
+LZDEC4:	LDA	T1		; copy another byte
+	STR	P1		; ...
+	INC	P1		; ...
+	DEC	T2		; ...
+	GLO	T2		; ...
+	BNZ	LZDEC4		; ...
+	BR	LZDEC1		; on to the next token
+
+; Here at the end of the block ...
+LZDEC9:	STR	P1		; null terminate the text
+	GLO	P2		; and point P1 back at the start
+	PLO	P1		; ...
+	GHI	P2		; ...
+	PHI	P1		; ...
+	CDF			; return DF=0
+	RETURN			; ...
+#ifndef MONEXT2
+#if ($ > HLPXTOP)
+	.ECHO	"**** ERROR **** Help decompression overflow at HLPEXT!"
+#endif
+#endif
+#endif
+
+; And check for overflow here too ...
+#ifdef MONEXT2
+#if ($ > MONX2TOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow at MONEXT2!"
+#endif
+#endif
+
+	.EJECT
+;	.SBTTL	Disk Block I/O
+
+;   The BIOS F_IDEREAD and F_IDEWRITE functions move one sector per call -
+; each call selects the drive, loads all the task file registers, waits for
+; the drive and then moves the data with a loop that takes 10 machine cycles
+; a byte.  DKREAD and DKWRIT move any number of sectors, up to 255, with one
+; READ MULTIPLE or WRITE MULTIPLE command straight to or from the caller's
+; buffer.  The data loops are unrolled 16 times, so a read takes about 4.4
+; machine cycles a byte and a write about 2.4.  They're called thru the jump
+; table at MONEXT3 -
+;
+;	MONEXT3+0  DKINIT - select 16 sector blocks for READ/WRITE MULTIPLE
+;	MONEXT3+3  DKREAD - read sectors
+;	MONEXT3+6  DKWRIT - write sectors
+;
+; and they take the same arguments -
+;
+;	P1   = buffer address (advanced past the data)
+;	P2   = LBA, bits 0..15 (preserved)
+;	P4.0 = LBA, bits 16..23 (preserved)
+;	P3.0 = sector count, 1..255 (zero on return)
+;
+; They return DF=0 if all's well, or DF=1 and the ATA error register in D if
+; the drive reports an error (D=0 means the drive timed out).  Only the master
+; drive is used, it has to be reset by F_IDERESET first, and DKINIT ought to
+; be called once after that.  If the drive doesn't do READ/WRITE MULTIPLE
+; (or if DKINIT wasn't called) the command is aborted and we quietly fall back
+; to READ/WRITE SECTORS, which is still much faster than the BIOS.  They use
+; T1 and T2 ...
+#ifdef MONEXT3
+	.ORG	MONEXT3
+
+; Jump table ...
+	LBR	DKINIT		; MONEXT3+0
+	LBR	DKREAD		; MONEXT3+3
+	LBR	DKWRIT		; MONEXT3+6
+#ifdef DCSLOTS
+	LBR	DCREAD		; MONEXT3+9
+	LBR	DCWRIT		; MONEXT3+12
+	LBR	DCFLSH		; MONEXT3+15
+#endif
+
+;   Send SET MULTIPLE MODE for 16 sector blocks.  The caller can ignore any
+; error - the drive just doesn't do READ/WRITE MULTIPLE.  If there's a disk
+; cache then empty that too (without writing anything back - call DCFLSH
+; first if that matters).  Changes P3.0 ...
+DKINIT:
+#ifdef DCSLOTS
+	CALL(DCINIT)		; empty the cache
+#endif
+	LDI	16		; sectors per block
+	PLO	P3		; ...
+	LDI	IDESMM		; SET MULTIPLE MODE
+	PLO	T2		; ...
+	CALL(DKCMD)		; send it
+	LBDF	DKXFR9		; quit now if the drive isn't ready
+	LDI	DRDY+ERR	; and wait for it to finish
+	LBR	DKWAIT		; ...
+
+;   Select the master drive, wait for it to be ready, and then load the task
+; file from P2, P3.0 and P4.0 and send the command in T2.0.  The registers
+; are pushed on the stack, address and then data, and sent from there ...
+DKCMD:	SEX	PC		; select the master drive, LBA mode
+	WIDE(IDELBA3,$E0)	; ...
+	SEX	SP		; ...
+	LDI	DRDY		; wait for it to be ready
+	CALL(DKWAIT)		; ...
+	BDF	DKCMD9		; quit if it isn't
+	GLO T2\ STXD\ LDI IDECMD\  STXD	; command goes last
+	GLO P4\ STXD\ LDI IDELBA2\ STXD	; LBA bits 16..23
+	GHI P2\ STXD\ LDI IDELBA1\ STXD	; LBA bits 8..15
+	GLO P2\ STXD\ LDI IDELBA0\ STXD	; LBA bits 0..7
+	GLO P3\ STXD\ LDI IDESCT\  STXD	; and the sector count first
+	LDI	5		; five registers to send
+	PLO	T1		; ...
+	IRX			; point to the first one
+DKCMD1:	OUT	IDE_SELECT	; select the register
+	OUT	IDE_DATA	; and write it
+	DEC	T1		; ...
+	GLO	T1		; ...
+	BNZ	DKCMD1		; ...
+	DEC	SP		; fix the stack
+	CDF			; return DF=0
+DKCMD9:	RETURN			; ...
+
+;   Wait for the drive to be not busy and for one of the status bits in D
+; to be set.  D is DRDY or DRQ, plus ERR if an error should end the wait too
+; (before a new command ERR is left over from the last one, and we don't care
+; about it).  Return DF=0 if all's well, DF=1 and the error register in D if
+; ERR is set, and DF=1 and D=0 if the drive is still busy after 65536 tries
+; (about four seconds).  Uses T1 and T2.1 ...
+DKWAIT:	PHI	T2		; save the bits we want
+	RCLEAR(T1)		; and count the tries
+	OUTI(IDE_SELECT,IDESTS)	; select the status register
+DKWAI1:	INP	IDE_DATA	; read the status (into M(SP) too)
+	ANI	BSY		; still busy?
+	BNZ	DKWAI3		; yes - keep waiting
+	GHI	T2		; no - are any of the bits we want set?
+	AND			; ...
+	BZ	DKWAI3		; no - keep waiting
+	ANI	ERR		; yes - is it an error?
+	BNZ	DKERR		; ...
+	CDF			; no - return DF=0
+	RETURN			; ...
+DKWAI3:	DEC	T1		; count the tries
+	GLO	T1		; ...
+	BNZ	DKWAI1		; ...
+	GHI	T1		; ...
+	BNZ	DKWAI1		; ...
+	SDF			; timed out - return DF=1 and D=0
+	RETURN			; ...
+
+; Here to return the error register ...
+DKERR:	SEX	PC		; read the error register
+	RIDE(IDEERR)		; ...
+	SDF			; and return DF=1
+	RETURN			; ...
+
+; Here to read or write sectors ...
+DKREAD:	LDI	IDERDM		; READ MULTIPLE
+	LSKP			; ...
+DKWRIT:	LDI	IDEWRM		; WRITE MULTIPLE
+	PLO	T2		; save the command
+DKXFR:	CALL(DKCMD)		; send the command
+	LBDF	DKXFR9		; quit if the drive isn't ready
+
+; Wait for the drive to ask for the next sector ...
+DKXFR1:	LDI	DRQ+ERR		; wait for DRQ
+	CALL(DKWAIT)		; ...
+	BDF	DKXFR7		; branch if the drive has some problem
+	OUTI(IDE_SELECT,IDEDATA); select the data register
+	LDI	512/16		; 16 bytes per loop
+	PLO	T1		; ...
+	SEX	P1		; point X at the buffer
+	GLO	T2		; read or write?
+	ANI	$11		; ($C4 and $20 read, $C5 and $30 write)
+	BNZ	DKXFR3		; ...
+
+; Read a sector ...
+DKXFR2:	INP IDE_DATA\ INC P1\ INP IDE_DATA\ INC P1
+	INP IDE_DATA\ INC P1\ INP IDE_DATA\ INC P1
+	INP IDE_DATA\ INC P1\ INP IDE_DATA\ INC P1
+	INP IDE_DATA\ INC P1\ INP IDE_DATA\ INC P1
+	INP IDE_DATA\ INC P1\ INP IDE_DATA\ INC P1
+	INP IDE_DATA\ INC P1\ INP IDE_DATA\ INC P1
+	INP IDE_DATA\ INC P1\ INP IDE_DATA\ INC P1
+	INP IDE_DATA\ INC P1\ INP IDE_DATA\ INC P1
+	DEC	T1		; count the loops
+	GLO	T1		; ...
+	BNZ	DKXFR2		; ...
+	BR	DKXFR4		; ...
+
+; Write a sector (OUT increments P1 for us) ...
+DKXFR3:	OUT IDE_DATA\ OUT IDE_DATA\ OUT IDE_DATA\ OUT IDE_DATA
+	OUT IDE_DATA\ OUT IDE_DATA\ OUT IDE_DATA\ OUT IDE_DATA
+	OUT IDE_DATA\ OUT IDE_DATA\ OUT IDE_DATA\ OUT IDE_DATA
+	OUT IDE_DATA\ OUT IDE_DATA\ OUT IDE_DATA\ OUT IDE_DATA
+	DEC	T1		; count the loops
+	GLO	T1		; ...
+	BNZ	DKXFR3		; ...
+
+; Count the sectors and wait for the drive to finish at the end ...
+DKXFR4:	SEX	SP		; back to normal
+	DEC	P3		; any more sectors?
+	GLO	P3		; ...
+	BNZ	DKXFR1		; yes
+	LDI	DRDY+ERR	; no - wait for the drive to finish
+	LBR	DKWAIT		; and return its status
+
+;   Here if the drive doesn't ask for the data.  If the command was READ or
+; WRITE MULTIPLE and the drive aborted it then try again with READ or WRITE
+; SECTORS.  Anything else is a real error ...
+DKXFR7:	PHI	T1		; save the error code
+	ANI	ABRT		; was the command aborted?
+	BZ	DKXFR8		; no - give up
+	GLO	T2		; yes - was it READ/WRITE MULTIPLE?
+	ANI	$80		; ...
+	BZ	DKXFR8		; no - give up
+	GLO	T2		; $C4 -> $20 and $C5 -> $30
+	ANI	$01		; ...
+	SHL\ SHL\ SHL\ SHL	; ...
+	ORI	IDERDS		; ...
+	PLO	T2		; ...
+	LBR	DKXFR		; and try again
+DKXFR8:	GHI	T1		; return the error code
+	SDF			; and DF=1
+DKXFR9:	RETURN			; ...
+
+#ifdef DCSLOTS
+;   SHOW DISK CACHE prints the size of the cache and the number of hits and
+; misses since the last DKINIT ...
+SHODSK:	CALL(F_LTRIM)		; ...
+	RLDI(P2,SDKCMD)		; ...
+	LBR	COMND		; ...
+
+; Table of SHOW DISK options ...
+SDKCMD:	CMD(2, "CACHE", SHODC)	; SHOW DISK CACHE
+	.DB	0
+
+SHODC:	CALL(ISEOL)		; that had better be all
+	LBNF	CMDERR		; ...
+	INLMES("Disk cache ")	; ...
+	RLDI(P1,DCSLOTS)	; ...
+	CALL(TDEC16)		; ...
+	INLMES(" sectors, ")	; ...
+	RLDI(P3,DCHITS)		; ...
+	CALL(SHODC1)		; ...
+	INLMES(" hits, ")	; ...
+	RLDI(P3,DCMISS)		; ...
+	CALL(SHODC1)		; ...
+	INLMES(" misses\r\n")	; ...
+	RETURN			; ...
+
+; Type the count at P3 ...
+SHODC1:	LDA	P3		; ...
+	PHI	P1		; ...
+	LDN	P3		; ...
+	PLO	P1		; ...
+	LBR	TDEC16		; ...
+
+#endif
+
+; And check for overflow here too ...
+#if ($ > MONX3TOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow at MONEXT3!"
+#endif
+#endif
+
+	.EJECT
+;	.SBTTL	Disk Cache
+
+;   DCREAD, DCWRIT and DCFLSH put a write back cache of DCSLOTS sectors in
+; front of DKREAD and DKWRIT, for programs that read the same few sectors
+; over and over (ElfOS directories and allocation tables, for example).  The
+; sectors live in RAM at DCBUF, just below DSKBUF, and their tags are below
+; that.  The cache is emptied by DKINIT, and there's a jump table entry for
+; each of these at MONEXT3 -
+;
+;	MONEXT3+9  DCREAD - return P1 pointing to the sector in the cache.  It's
+;			    only good until the next DCREAD or DCWRIT, and the
+;			    caller mustn't change it.
+;	MONEXT3+12 DCWRIT - copy the sector at P1 (P1 is advanced) into the
+;			    cache and mark it dirty.  It isn't written to the
+;			    drive until the slot is needed for another sector
+;			    or until DCFLSH is called.
+;	MONEXT3+15 DCFLSH - write all the dirty sectors back to the drive.
+;
+;   The LBA is in P2 and P4.0, just like DKREAD, but it's always exactly one
+; sector.  All of them return DF=1 if the drive has a problem (but the ATA
+; error code is lost) and they use P3, T1 and T2.
+;
+;   Each tag is four bytes - the flags and then the LBA (bits 16..23, 8..15
+; and 0..7).  The flags are the slot number (which sector of DCBUF it is) plus
+; DCDIRT if the sector has been changed and DCEMPT if the slot isn't in use.
+; The tags are kept in the order they were used, most recent first, and the
+; tag for every sector that's read or written moves to the front.  That way
+; the least recently used slot, the one to replace, is always the last, and
+; the sectors used most often are found first.  A hit on the first slot
+; costs about 500 machine cycles, against 2500 or so for DKREAD.
+#ifdef DCSLOTS
+#if (DCSLOTS > 31)
+	.ECHO	"**** ERROR **** DCSLOTS can't be more than 31!"
+#endif
+DCSLOT	.EQU	$1F		; the slot number
+DCDIRT	.EQU	$40		; sector has been changed
+DCEMPT	.EQU	$80		; slot isn't in use
+
+	.ORG	MONEXT4
+
+; Here to read a sector thru the cache ...
+DCREAD:	LDI	0		; read it if it isn't cached
+	CALL(DCGET)		; ...
+	RCOPY(P1,T1)		; and return a pointer to it
+	RETURN			; (DF is still DCGET's status)
+
+; Here to write a sector thru the cache ...
+DCWRIT:	LDI	1		; no need to read it first
+	CALL(DCGET)		; find a slot for it
+	BDF	DCWRI9		; ...
+	LDN	P3		; mark it dirty (DCGET left P3 at the tag)
+	ORI	DCDIRT		; ...
+	STR	P3		; ...
+	LDI	512/4		; and copy the data
+	PLO	T2		; ...
+DCWRI1:	LDA P1\ STR T1\ INC T1\ LDA P1\ STR T1\ INC T1
+	LDA P1\ STR T1\ INC T1\ LDA P1\ STR T1\ INC T1
+	DEC	T2		; ...
+	GLO	T2		; ...
+	BNZ	DCWRI1		; ...
+DCWRI9:	RETURN			; (DCGET left DF=0)
+
+; Here to write back all the dirty sectors ...
+DCFLSH:	RLDI(P3,DCTAGS)		; start with the first tag
+DCFLS1:	CALL(DCSPIL)		; write it back if it's dirty
+	BDF	DCWRI9		; quit on errors
+	GLO	P3		; on to the next one
+	ADI	4		; ...
+	PLO	P3		; ...
+	XRI	LOW(DCHITS)	; is that all of them?
+	BNZ	DCFLS1		; ...
+	RETURN			; yes (the ADI left DF=0)
+
+;   Empty the cache and clear the hit and miss counts.  This is called by
+; DKINIT ...
+DCINIT:	RLDI(T1,DCMISS+1)	; start at the end
+	SEX	T1		; ...
+	LDI	DCEMPT+DCSLOTS	; the last slot number, plus one
+	PLO	T2		; ...
+	LDI	0		; clear the counts
+	STXD\ STXD\ STXD\ STXD	; ...
+DCINI1:	DEC T1\ DEC T1\ DEC T1	; back to the flags for the previous tag
+	DEC	T2		; set this slot number, and empty
+	GLO	T2		; ...
+	STXD			; ...
+	XRI	DCEMPT		; was that slot zero?
+	BNZ	DCINI1		; no - keep going
+	SEX	SP		; ...
+	RETURN			; ...
+
+;   Find the sector P2/P4.0 in the cache, replacing the least recently used
+; slot if it isn't there, and move its tag to the front.  D is zero to read
+; the sector from the drive if it isn't cached (DCREAD) or non-zero if it's
+; going to be overwritten anyway (DCWRIT).  Returns DF=0, P3 pointing to the
+; tag and T1 to the sector, or DF=1 if the drive has a problem ...
+DCGET:	PUSHD			; save the flag
+	CALL(DCFIND)		; look for the sector
+	RLDI(P3,DCTAGS)		; it's at the front now, either way
+	LDI	LOW(DCHITS+1)	; count a hit
+	BDF	DCGET3		; ...
+	CALL(DCSPIL)		; a miss - write back what's there now
+	BDF	DCGET9		; quit if that fails
+	LDN	P3		; it isn't valid until it's read
+	ANI	DCSLOT		; ...
+	ORI	DCEMPT		; ...
+	STR	P3		; ...
+	INC P3\ GLO P4\ STR P3	; and put this sector in its place
+	INC P3\ GHI P2\ STR P3	; ...
+	INC P3\ GLO P2\ STR P3	; ...
+	DEC P3\ DEC P3\ DEC P3	; ...
+	IRX\ LDX\ DEC SP	; does it need to be read?
+	BNZ	DCGET2		; no
+	CALL(DCSBUF)		; yes - read it into the slot
+	RCOPY(P1,T1)		; ...
+	LDI	1		; ...
+	PLO	P3		; ...
+	CALL(DKREAD)		; ...
+	LDI	LOW(DCTAGS)	; (DKREAD left P3.0 zero)
+	PLO	P3		; ...
+	BDF	DCGET9		; quit if the read failed
+DCGET2:	LDN	P3		; the slot is valid (and clean) now
+	ANI	DCSLOT		; ...
+	STR	P3		; ...
+	LDI	LOW(DCMISS+1)	; and count a miss
+DCGET3:	CALL(DCCNT)		; ...
+	CALL(DCSBUF)		; point T1 at the sector
+	CDF			; and return DF=0
+DCGET9:	IRX			; drop the flag
+	RETURN			; ...
+
+;   Look for the sector P2/P4.0 in the cache and move its tag to the front.
+; If it isn't there then the last tag, the least recently used, moves to
+; the front instead.  Returns DF=1 if the sector was found.  Uses T1 and T2 ...
+DCFIND:	RLDI(T1,DCTAGS)		; start with the first tag
+	LDI	DCSLOTS		; count the slots
+	PLO	T2		; ...
+	SEX	T1		; ...
+DCFND1:	LDN T1\ ANI DCEMPT\ BNZ DCFND2 ; is it in use?
+	INC T1\ GLO P4\ XOR\ BNZ DCFND2 ; and does the LBA match?
+	INC T1\ GHI P2\ XOR\ BNZ DCFND2
+	INC T1\ GLO P2\ XOR\ BZ DCFND3
+DCFND2:	GLO	T1		; no - on to the next tag
+	ORI	3		; ...
+	PLO	T1		; ...
+	INC	T1		; ...
+	DEC	T2		; any more?
+	GLO	T2		; ...
+	BNZ	DCFND1		; ...
+	DEC	T1		; no - use the last tag (and T2.0 is zero)
+DCFND3:	SEX	SP		; T1 points to the end of the tag here
+	GLO	T2		; save T2.0 - zero for a miss
+	STXD			; ...
+	LDN T1\ STXD\ DEC T1	; and save the tag, backwards
+	LDN T1\ STXD\ DEC T1	; ...
+	LDN T1\ STXD\ DEC T1	; ...
+	LDN T1\ STXD\ DEC T1	; ...
+	GLO	T1		; move all the tags before it back one
+	ADI	4		;  with T1 as the source and T2 as the
+	PLO	T2		;  destination
+	GHI	T1		; ...
+	PHI	T2		; ...
+DCFND4:	GLO	T1		; ...
+	XRI	LOW(DCTAGS-1)	; ...
+	BZ	DCFND5		; ...
+	LDN T1\ DEC T1\ STR T2\ DEC T2
+	BR	DCFND4		; ...
+DCFND5:	INC	T1		; and then put this one at the front
+	IRX			; ...
+	LDXA\ STR T1\ INC T1	; ...
+	LDXA\ STR T1\ INC T1	; ...
+	LDXA\ STR T1\ INC T1	; ...
+	LDXA\ STR T1		; ...
+	LDX			; DF=1 if it was a hit
+	ADI	$FF		; ...
+	RETURN			; ...
+
+;   If the slot for the tag at P3 is dirty then write it back to the drive and
+; mark it clean.  Returns DF=1 if that fails.  Preserves P1, P2, P3 and P4 and
+; uses T1 and T2 ...
+DCSPIL:	LDN	P3		; is it in use and dirty?
+	ANI	DCEMPT+DCDIRT	; ...
+	XRI	DCDIRT		; ...
+	BNZ	DCSPL9		; no - there's nothing to do
+	PUSHR(P1)		; save the caller's registers
+	PUSHR(P2)		; ...
+	PUSHR(P4)		; ...
+	CALL(DCSBUF)		; point P1 at the sector
+	RCOPY(P1,T1)		; ...
+	INC	P3		; and get its LBA from the tag
+	LDA	P3		; ...
+	PLO	P4		; ...
+	LDA	P3		; ...
+	PHI	P2		; ...
+	LDN	P3		; ...
+	PLO	P2		; ...
+	GLO	P3		; the tags are all on one page, so
+	PHI	P3		;  just save the low byte
+	LDI	1		; write one sector
+	PLO	P3		; ...
+	CALL(DKWRIT)		; ...
+	GHI	P3		; point P3 to the tag again
+	PLO	P3		; ...
+	LDI	HIGH(DCTAGS)	; ...
+	PHI	P3		; ...
+	DEC P3\ DEC P3\ DEC P3	; ...
+	BDF	DCSPL8		; branch if the write failed
+	LDN	P3		; it's clean now
+	ANI	$FF-DCDIRT	; ...
+	STR	P3		; ...
+DCSPL8:	IRX			; restore the registers
+	POPR(P4)		; ...
+	POPR(P2)		; ...
+	POPRL(P1)		; ...
+	RETURN			; ...
+DCSPL9:	CDF			; clean or empty - return DF=0
+	RETURN			; ...
+
+; Return the address of the sector for the tag at P3 in T1 ...
+DCSBUF:	LDN	P3		; the slot number times two pages
+	ANI	DCSLOT		; ...
+	SHL			; ...
+	ADI	HIGH(DCBUF)	; ...
+	PHI	T1		; ...
+	LDI	LOW(DCBUF)	; (that's always zero)
+	PLO	T1		; ...
+	RETURN			; ...
+
+; Increment the hit or miss count - D is the LSB of the count ...
+DCCNT:	PLO	T1		; ...
+	LDI	HIGH(DCHITS)	; ...
+	PHI	T1		; ...
+	SEX	T1		; ...
+	LDX\ ADI 1\ STXD	; ...
+	LDX\ ADCI 0\ STR T1	; ...
+	SEX	SP		; ...
+	RETURN			; ...
+
+; And check for overflow here too ...
+#if ($ > MONX4TOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow at MONEXT4!"
+#endif
+#endif
+
+	.EJECT
+;	.SBTTL	IDE Identify Cache
+
+;   Resetting and identifying an IDE drive can take a while - a CompactFlash
+; card is pretty quick, but a real disk has to spin up before it'll answer
+; IDENTIFY DEVICE, and the BIOS waits as long as it takes.  If IDECACHE is
+; defined then PROBE saves the size and model number of every drive it finds
+; in NVR, and when SYSINI probes the master at startup it skips the reset and
+; just asks the drive for its size with F_IDESIZE.  If that matches the size
+; saved in NVR then it types the saved data, and if it doesn't (the drive has
+; been changed, or it isn't ready, or nothing is saved in NVR) it falls back to
+; the full reset and identify, which saves the new drive in NVR.  A different
+; drive of exactly the same size would get the old model number, but that's
+; all - SHOW IDE always does it the hard way, and that fixes it.
+;
+;   Each unit gets IDCSIZ bytes in NVR, starting at NVRIDE - the size in Mb
+; (zero if there's nothing saved) and then the 40 byte model number.  The
+; same data lives at IDCBUF in DSKBUF, where the size replaces the last word
+; of the firmware revision just in front of the model number in the IDENTIFY
+; DEVICE data, so both ways end up typing the same thing ...
+#ifdef IDECACHE
+IDCBUF	.EQU	DSKBUF+$34	; size and model, in the IDENTIFY data
+IDCSIZ	.EQU	42		; bytes per unit
+
+	.ORG	MONEXT5
+
+; PROBE jumps here with the unit number (plus $80 to use NVR) on the stack ...
+IDPRB:	IRX\ LDX\ DEC SP	; can we use the data in NVR?
+	ANI	$80		; ...
+	BZ	IDPRB2		; no - do it the hard way
+	CALL(IDNVR)		; read the saved data into IDCBUF
+	CALL(F_RDNVR)		; ...
+	BDF	IDPRB2		; the NVR isn't valid
+	IRX\ LDX\ DEC SP	; ask the drive how big it is
+	ANI	$01		; ...
+	PLO	P2		; ...
+	CALL(F_IDESIZE)		; ...
+	GHI	P1		; zero means it isn't ready or it's bad
+	STR	SP		; ...
+	GLO	P1		; ...
+	OR			; ...
+	BZ	IDPRB2		; ...
+	RLDI(P2,IDCBUF)		; is that the same size as we saved?
+	SEX	P2		; ...
+	GHI	P1		; ...
+	XOR			; ...
+	BNZ	IDPRB1		; ...
+	INC	P2		; ...
+	GLO	P1		; ...
+	XOR			; ...
+IDPRB1:	SEX	SP		; ...
+	BZ	IDPRB5		; yes - just type the rest
+
+; Here to reset and identify the drive ...
+IDPRB2:	IRX\ LDX\ DEC SP	; get the unit number
+	ANI	$01		; ...
+	PLO	P2		; ...
+	CALL(F_IDERESET)	; and reset the drive
+	LBDF	BADDRV		; branch if hard drive error
+	IRX\ LDX\ DEC SP	; then send IDENTIFY DEVICE
+	ANI	$01		; ...
+	PLO	P2		; ...
+	RLDI(P1,DSKBUF)		; ...
+	CALL(F_IDEID)		; ...
+	LBDF	BADDRV		; this shouldn't fail, but...
+	IRX\ LDX\ DEC SP	; and get the size of the drive
+	ANI	$01		; ...
+	PLO	P2		; ...
+	CALL(F_IDESIZE)		; ...
+	GHI	P1		; check for zero drive size
+	BNZ	IDPRB4		; ...
+	GLO	P1		; ...
+	LBZ	BADDRV		; zero means an unusable drive
+IDPRB4:	RLDI(P2,IDCBUF)		; put the size in front of the model
+	GHI	P1		; ...
+	STR	P2		; ...
+	INC	P2		; ...
+	GLO	P1		; ...
+	STR	P2		; ...
+	RLDI(P1,IDCBUF+IDCSIZ-1); make sure the model number is
+	LDI	0		;  null terminated
+	STR	P1		; ...
+	CALL(IDNVR)		; and save it all in NVR
+	CALL(F_WRNVR)		; ...
+
+; Type the size and model number ...
+IDPRB5:	RLDI(P2,IDCBUF)		; type the size in megabytes
+	LDA	P2		; ...
+	PHI	P1		; ...
+	LDN	P2		; ...
+	PLO	P1		; ...
+	CALL(TDEC16)		; ...
+	INLMES("Mb ")		; ...
+	OUTSTR(IDCBUF+2)	; then the model number
+	CALL(TCRLF)		; and finish the line
+	IRX			; fix the stack
+	CDF			; set DF=0
+	RETURN			; and we're done
+
+;   Set up P1, P2 and P3 for F_RDNVR or F_WRNVR to move the saved data for
+; this unit between NVR and IDCBUF.  The unit number is still on the stack,
+; just above our return address ...
+IDNVR:	IRX\ IRX\ IRX\ LDX	; get the unit number
+	DEC SP\ DEC SP\ DEC SP	; ...
+	ANI	$01		; unit 1 follows unit 0
+	BZ	IDNVR1		; ...
+	LDI	IDCSIZ		; ...
+IDNVR1:	ADI	NVRIDE		; ...
+	PLO	P1		; ...
+	LDI	0		; ...
+	PHI	P1		; ...
+	RLDI(P2,IDCBUF)		; ...
+	RLDI(P3,IDCSIZ)		; ...
+	RETURN			; ...
+
+; And check for overflow here too ...
+#if ($ > MONX5TOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow at MONEXT5!"
+#endif
+#endif
+
+	.EJECT
+;	.SBTTL	TIME Command
+
+;   The TIME command calls a program, just like CALL, and types how long it
+; took when it returns -
+;
+;	>>>TI[ME] addr
+;	280K cycles, 1.425 sec
+;
+; It's really just PROFILE with a different report - the sampler counts the
+; RTC's 256Hz interrupts either way, and the total is the elapsed time in
+; 1/256ths of a second.  BREAK works the same way, too.  The cycle count is
+; an estimate, in thousands of 1802 machine cycles, for a 1.79MHz CPU, and
+; TIMCYC leaves out the cycles that went to the sampler itself (about 12% of
+; them).  Either number is only good to one tick, about 4ms or 870 cycles.
+; The VT1802 also counts frames, but its interrupt owns R1 and its counter is
+; only eight bits, so the RTC is the only clock that TIME uses.
+;
+;   Since the sampler leaves the select port alone while the program is in
+; the BIOS (see PRFISD), a tick that comes then waits for the BIOS to return,
+; and only one can wait.  Any BIOS call that lasts longer than a tick (waiting
+; for a key, a disk transfer, or just typing at 1200bps) loses the rest, so
+; TIME reads low for programs that do much I/O.  Counting the time exactly
+; would mean polling the RTC instead of using its interrupt, and there isn't
+; room for that.
+#ifdef MONEXT6
+TIMCYC	.EQU	197		; program's machine cycles per tick, times 256/1000
+
+	.ORG	MONEXT6
+
+;   PRFRPT jumps here for TIME, with the number of samples (ticks, really)
+; in P1.  It types the estimated cycles first, since that leaves the ticks in
+; T2 for the elapsed time.  TIMSEC types just the elapsed time, from the ticks
+; in T2, and the RAM test uses that too.  It uses P1, P3.0 and P4.0 ...
+TIMRPT:	RCOPY(T2,P1)		; save the ticks
+	LDI	TIMCYC		; and estimate the machine cycles
+	CALL(PRFMUL)		; ...
+	CALL(TDEC16)		; ...
+	INLMES("K cycles, ")	; ...
+TIMSEC:	GHI	T2		; the high byte is whole seconds
+	PLO	P1		; ...
+	LDI	0		; ...
+	PHI	P1		; ...
+	PHI	T2		; and the low byte is the fraction
+	CALL(TDEC16)		; type the seconds
+	OUTCHR('.')		; ...
+	LDI	3		; then three decimal places
+TIMRP1:	PUSHD			; ...
+	LDI	10		; multiply the fraction by ten
+	CALL(PRFMUL)		; ...
+	GLO	P4		; what's left is the new fraction
+	PLO	T2		; ...
+	GLO	P1		; and the rest is the next digit
+	CALL(THEX1)		; ...
+	POPD			; ...
+	SMI	1		; ...
+	BNZ	TIMRP1		; ...
+	INLMES(" sec\r\n")	; ...
+	RETURN			; ...
+
+;   PRFMUL multiplies T2 by D, by adding it up D times, and returns the 24 bit
+; product in P1 (the top 16 bits) and P4.0 (the low byte).  It's used by TIME,
+; which only ever wants a fixed point fraction out of it.  It uses P3.0 ...
+PRFMUL:	PLO	P3		; count the additions
+	RCLEAR(P1)		; clear the product
+	PLO	P4		; ...
+PRFMU1:	GLO	T2		; add the low byte
+	STR	SP		; ...
+	GLO	P4		; ...
+	ADD			; ...
+	PLO	P4		; ...
+	GHI	T2		; then the high byte
+	STR	SP		; ...
+	GLO	P1		; ...
+	ADC			; ...
+	PLO	P1		; ...
+	GHI	P1		; and the carry
+	ADCI	0		; ...
+	PHI	P1		; ...
+	DEC	P3		; ...
+	GLO	P3		; ...
+	BNZ	PRFMU1		; ...
+	RETURN			; ...
+
+; And check for overflow here too ...
+#if ($ > MONX6TOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow at MONEXT6!"
+#endif
+#endif
+
+#ifdef TRACE
+	.EJECT
+;	.SBTTL	TRACE Extensions
+
+;   There's no room for all of TRACE in the alternate EPROM's monitor, so the
+; rest of it lives in the unused ends of Forth (MONEXT7) and Visual/02
+; (MONEXT8) ...
+	.ORG	MONEXT7
+
+
+; Copy the instruction to the thunk, followed by the breakpoints ...
+TRNX14:	RLDI(T1,TRLEN)		; save the length
+	GLO	P3		; ...
+	STR	T1		; ...
+	INC	T1		; and the address
+	GHI	P1		; ...
+	STR	T1		; ...
+	INC	T1		; ...
+	GLO	P1		; ...
+	STR	T1		; ...
+	INC	T1		; ...
+	RLDI(T2,TRTHK)		; ...
+TRNX15:	LDA	P1		; ...
+	STR	T2		; ...
+	INC	T2		; ...
+	DEC	P3		; ...
+	GLO	P3		; ...
+	BNZ	TRNX15		; ...
+	CALL(TRFILL)		; ...
+
+;   If it's a branch, then save the target in TRTGT and point the branch at
+; the last breakpoint instead.  A short branch gets the high byte of its
+; target from the address of its second byte ...
+	GHI	P3		; is it a branch?
+	BZ	TRNX17		; no
+	RLDI(T2,TRTHK+1)	; yes - the high byte is always the same
+	LDI	HIGH(TRTHK)	; ...
+	STR	T2		; ...
+	DEC	P1		; P1 points to the last byte
+	GHI	P1		; assume it's a short branch
+	STR	T1		; ...
+	GHI	P3		; is it?
+	XRI	2		; ...
+	BZ	TRNX16		; yes
+	DEC	P1		; no - the high byte comes first
+	LDA	P1		; ...
+	STR	T1		; ...
+	INC	T2		; and the low byte is next
+TRNX16:	INC	T1		; now the low byte
+	LDN	P1		; ...
+	STR	T1		; ...
+	GHI	P3		; and the last breakpoint is at length+3
+	ADI	LOW(TRTHK)+3	; ...
+	STR	T2		; ...
+
+;   Set the user's PC to the thunk, remember (X,P) for TRSTEP, and do a
+; CONTINUE.  The non-zero byte at REGS+0 (R0 is never restored and TRAP
+; always saves it as zero) tells CONT1 to finish up at TRTRX ...
+TRNX17:	CALL(TRGPC)		; point DP at the PC
+	LDI	LOW(TRTHK)	; ...
+	STR	DP		; ...
+	DEC	DP		; ...
+	LDI	HIGH(TRTHK)	; ...
+	STR	DP		; ...
+	RLDI(T1,TRXP)		; save (X,P)
+	LDI	LOW(SAVEXP)	; ...
+	PLO	DP		; ...
+	LDN	DP		; ...
+	STR	T1		; ...
+	LDI	LOW(REGS)	; this is a TRACE step
+	PLO	DP		; ...
+	STR	DP		; ...
+	RLDI(INTPC,CONT1)	; and do a CONTINUE
+	SEP	INTPC		; ...
+
+;   CONT1 comes here instead of TRAPX for a TRACE step.  DIS restores (X,P)
+; the same way, but leaves R1 pointing to TRTRP rather than TRAP ...
+TRTRX:	LDXA			; restore D
+	DIS			; and (X,P)
+
+;   The SEP R1 breakpoints in the thunk come here.  This is TRAP without the
+; MARK - the instruction might have been the IRX of an IRX/LDXA pair, and
+; then M(R2) is still part of the program's stack.  That's where MARK would
+; put (X,P), so we leave it alone and push D and DF below it instead.  TRSTEP
+; works out (X,P) for itself, and $01 (P=1 - impossible for a real
+; breakpoint) goes in its place so that TRAP2 can tell the difference ...
+TRTRP:	DEC	2		; skip over M(R2)
+	DEC	2		; ...
+	STR	2		; save D
+	INC	2		; ...
+	LDI	$01		; and our fake (X,P)
+	STR	2		; ...
+	DEC	2		; ...
+	DEC	2		; ...
+	LDI	0		; and then DF
+	SHLC			; ...
+	STR	2		; ...
+	LBR	TRAP1		; let TRAP do the rest
+
+;   Here for SEP - advance the old R(P) past the SEP and then change P.  Don't
+; go anywhere near R0 or R1, though ...
+TRSEP:	GLO	P3		; SEP R0 or SEP R1?
+	ANI	$0E		; ...
+	LBZ	TRSSEP		; yes - stop here
+	CALL(TRGPC)		; no - step over the SEP
+	INC	P1		; ...
+	GLO	P1		; ...
+	STR	DP		; ...
+	DEC	DP		; ...
+	GHI	P1		; ...
+	STR	DP		; ...
+	GLO	P3		; and then set P
+	ANI	$0F		; ...
+	STR	SP		; ...
+	LDI	LOW(SAVEXP)	; ...
+	PLO	DP		; ...
+	LDN	DP		; ...
+	ANI	$F0		; ...
+	OR			; ...
+	STR	DP		; ...
+	LBR	TRNEXT		; ...
+
+;   Here for RET and DIS - (X,P) comes from M(R(X)) and R(X) is incremented.
+; IE doesn't matter since interrupts are always off ...
+TRRDIS:	CALL(TRGPC)		; step over the RET or DIS first
+	INC	P1		; ...
+	GLO	P1		; ...
+	STR	DP		; ...
+	DEC	DP		; ...
+	GHI	P1		; ...
+	STR	DP		; ...
+	LDI	LOW(SAVEXP)	; then point DP at R(X)
+	PLO	DP		; ...
+	LDN	DP		; ...
+	SHR			; ...
+	SHR			; ...
+	SHR			; ...
+	ANI	$1E		; ...
+	ADI	LOW(REGS)	; ...
+	PLO	DP		; ...
+	LDA	DP		; ...
+	PHI	P1		; ...
+	LDN	DP		; ...
+	PLO	P1		; ...
+	LDA	P1		; get the new (X,P)
+	PLO	P3		; ...
+	ANI	$0E		; don't go to R0 or R1
+	LBZ	TRSSEP		; ...
+	GLO	P1		; and increment R(X)
+	STR	DP		; ...
+	DEC	DP		; ...
+	GHI	P1		; ...
+	STR	DP		; ...
+	LDI	LOW(SAVEXP)	; and set X and P
+	PLO	DP		; ...
+	GLO	P3		; ...
+	STR	DP		; ...
+	LBR	TRNEXT		; ...
+
+;   Here for IDL, which would hang up forever with interrupts off, so we
+; stop here.  If it's the IDL at TRRET, then the program has returned ...
+TRIDL:	GHI	P1		; is it TRRET?
+	XRI	HIGH(TRRET)	; ...
+	BNZ	TRIDL1		; ...
+	GLO	P1		; ...
+	XRI	LOW(TRRET)	; ...
+	BNZ	TRIDL1		; ...
+	RLDI(P1,TRMRET)		; yes
+	BR	TRSTOP		; ...
+TRIDL1:	RLDI(P1,TRMIDL)		; no
+	BR	TRSTOP		; ...
+
+; The various other reasons for stopping ...
+TRSBRK:	RLDI(P1,TRMBRK)		; BREAK
+	BR	TRSTOP		; ...
+TRSSTP:	RLDI(P1,TRMSTP)		; the stop address
+	BR	TRSTOP		; ...
+TRSCNT:	RLDI(P1,TRMCNT)		; the count ran out
+	BR	TRSTOP		; ...
+TRSSEP:	RLDI(P1,TRMSEP)		; SEP R0, SEP R1 (a breakpoint!) or RET
+				; and fall into TRSTOP ...
+
+;   Type "TRACE <reason>" and the registers, the same as a breakpoint does,
+; and go back to the command loop.  The user's PC is left pointing to the
+; next instruction, so CONTINUE works too ...
+TRSTOP:	PUSHR(P1)		; save the reason
+	INLMES("\r\nTRACE ")	; ...
+	IRX			; ...
+	POPRL(P1)		; ...
+	CALL(F_MSG)		; ...
+	RLDI(DP,SAVEXP)		; ...
+	CALL(SHORE2)		; ...
+	LBR	MAIN		; ...
+
+;   Point DP at the user's PC in REGS (R(P), of course), load it into P1 and
+; leave DP pointing to the low byte ...
+TRGPC:	RLDI(DP,SAVEXP)		; get the user's P
+	LDN	DP		; ...
+	ANI	$0F		; ...
+	SHL			; ...
+	ADI	LOW(REGS)	; ...
+	PLO	DP		; ...
+	LDA	DP		; ...
+	PHI	P1		; ...
+	LDN	DP		; ...
+	PLO	P1		; ...
+	RETURN			; ...
+
+;   Fill the rest of the thunk, starting at T2, with SEP R1 breakpoints.
+; The thunk is seven bytes long, so there are always at least four of them
+; after the instruction ...
+TRFILL:	LDI	$D1		; SEP R1
+	STR	T2		; ...
+	INC	T2		; ...
+	GLO	T2		; all done?
+	XRI	LOW(TRTHK+7)	; ...
+	BNZ	TRFILL		; no
+	RETURN			; yes
+
+; The program "returns" to this IDL ...
+TRRET:	IDL
+
+; TRACE messages ...
+TRMRET:	.TEXT	"RETURN\000"
+TRMIDL:	.TEXT	"IDL\000"
+TRMBRK:	.TEXT	"BREAK\000"
+TRMSTP:	.TEXT	"STOP\000"
+TRMCNT:	.TEXT	"COUNT\000"
+TRMSEP:	.TEXT	"SEP\000"
+
+#if ($ > MONX7TOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow at MONEXT7!"
+#endif
+
+	.ORG	MONEXT8
+
+;   SHOW TRACE types the last few instructions executed by TRACE (all of them
+; by default) with D, DF and X before each one, and then the number of times
+; each address was executed -
+;
+;	SH[OW] TR[ACE] [n]
+;
+SHOTRC:	RLDI(P2,TRRLEN)		; the default is all of them
+	CALL(ISEOL)		; ...
+	LBDF	SHOTR1		; ...
+	CALL(SCANP1)		; ...
+	CALL(ISEOL)		; ...
+	LBNF	CMDERR		; ...
+SHOTR1:	RLDI(T1,TRNUM)		; but no more than we have
+	LDA	T1		; ...
+	STR	SP		; ...
+	GHI	P2		; ...
+	BNZ	SHOTR2		; ...
+	GLO	P2		; ...
+	SD			; ...
+	GLO	P2		; ...
+	BDF	SHOTR3		; ...
+SHOTR2:	LDX			; ...
+SHOTR3:	PLO	P3		; P3.0 counts the lines
+	SHL			; and P3.1 is the offset of the first one
+	SHL			; ...
+	STR	SP		; ...
+	LDN	T1		; ...
+	SM			; ...
+	ANI	TRRLEN*4-1	; ...
+	PHI	P3		; ...
+SHOTR4:	GLO	P3		; any more?
+	BZ	SHOTR5		; ...
+	GHI	P3		; point P4 at the entry
+	ADI	LOW(TRRING)	; ...
+	PLO	P4		; ...
+	LDI	HIGH(TRRING)	; ...
+	PHI	P4		; ...
+	GHI	P3		; and advance the offset
+	ADI	4		; ...
+	ANI	TRRLEN*4-1	; ...
+	PHI	P3		; ...
+	LDA	P4		; type the address
+	PHI	P1		; ...
+	LDA	P4		; ...
+	PLO	P1		; ...
+	CALL(THEX4)		; ...
+	CALL(TSPACE)		; and the opcode
+	LDN	P1		; ...
+	CALL(THEX2)		; ...
+	INLMES(" D=")		; ...
+	LDA	P4		; ...
+	CALL(THEX2)		; ...
+	INLMES(" DF=")		; ...
+	LDN	P4		; ...
+	CALL(THEX1)		; ...
+	INLMES(" X=")		; ...
+	LDN	P4		; ...
+	SHR\ SHR\ SHR\ SHR	; ...
+	CALL(THEX1)		; ...
+	CALL(TCRLF)		; ...
+	DEC	P3		; ...
+	BR	SHOTR4		; ...
+
+; Now type the counts, "addr=count", four to a line ...
+SHOTR5:	CALL(TCRLF)		; leave a blank line
+	RLDI(P4,TRCNTS)		; ...
+	RLDI(T1,TRNCNT)		; ...
+	LDN	T1		; ...
+	PLO	P3		; ...
+	LDI	0		; ...
+	PHI	P3		; ...
+SHOTR6:	GLO	P3		; any more?
+	BZ	SHOTR8		; ...
+	LDA	P4		; type the address
+	PHI	P1		; ...
+	LDA	P4		; ...
+	PLO	P1		; ...
+	CALL(THEX4)		; ...
+	OUTCHR('=')		; ...
+	LDA	P4		; and the count
+	PHI	P1		; ...
+	LDA	P4		; ...
+	PLO	P1		; ...
+	CALL(THEX4)		; ...
+	CALL(TTABC)		; ...
+	GHI	P3		; end of the line?
+	ADI	1		; ...
+	PHI	P3		; ...
+	ANI	3		; ...
+	BNZ	SHOTR7		; ...
+	CALL(TCRLF)		; ...
+SHOTR7:	DEC	P3		; ...
+	BR	SHOTR6		; ...
+SHOTR8:	GHI	P3		; finish the last line
+	ANI	3		; ...
+	LBNZ	TCRLF		; ...
+	RETURN			; ...
+
+;   TRTRP couldn't save (X,P), but it's the same as it was before the
+; instruction unless that was a SEX or MARK.  And TRTRP saved R2 one byte
+; low, too.  DP points to SAVEXP ...
+TRFXP:	RLDI(T1,TRTHK)		; get the opcode
+	LDN	T1		; ...
+	PHI	P3		; ...
+	RLDI(T1,TRXP)		; and the old (X,P)
+	LDN	T1		; ...
+	PLO	P3		; ...
+	GHI	P3		; SEX?
+	ANI	$F0		; ...
+	XRI	$E0		; ...
+	BZ	TRSTE0		; yes - X is its register
+	GHI	P3		; MARK?
+	XRI	$79		; ...
+	BNZ	TRSTE1		; no - (X,P) didn't change
+	GLO	P3		; yes - X gets P
+	SKP			; ...
+TRSTE0:	GHI	P3		; ...
+	SHL\ SHL\ SHL\ SHL	; ...
+	STR	SP		; ...
+	GLO	P3		; ...
+	ANI	$0F		; ...
+	OR			; ...
+	PLO	P3		; ...
+TRSTE1:	GLO	P3		; ...
+	STR	DP		; DP still points to SAVEXP
+	LDI	LOW(REGS+5)	; now fix R2
+	PLO	DP		; ...
+	LDN	DP		; ...
+	ADI	1		; ...
+	STR	DP		; ...
+	DEC	DP		; ...
+	LDN	DP		; ...
+	ADCI	0		; ...
+	STR	DP		; ...
+	RETURN			; ...
+
+#if ($ > MONX8TOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow at MONEXT8!"
+#endif
+#endif
+
+#ifdef CDP1805
+	.EJECT
+;	.SBTTL	CDP1805 SCRT
+
+;   INITSC is a replacement for F_INITCALL - it's called (well, jumped to) the
+; same way, with the continuation address in A, and it uses the BIOS SCRT if
+; the CPU is an 1802.  On an 1804/5/6 it uses CAL05 and RET05 instead, which
+; do the same thing with RNX and RLXA.  They're only a little faster, but it's
+; every CALL and every RETURN.
+;
+;   Why not SCAL and SRET?  Because they would have to be in the caller's code
+; and the monitor has to run on an 1802 too.  And the stack frames have to be
+; exactly the same as the BIOS makes (the high byte of the old linkage register
+; pushed first), because programs CALLed from the monitor may well switch to
+; the BIOS SCRT with F_INITCALL and then RETURN to us.  RSXD and RLXA store
+; and load a register the other way around, so they can't be used for the
+; stack, and that limits what the 1805 can save us.
+	.ORG	MONEXT9
+INITSC:	RLDI(CALLPC,CPUTYP)	; is this an 1804/5/6?
+	LDN	CALLPC		; ...
+	LBZ	F_INITCALL	; no - use the BIOS SCRT
+	DEC	2		; RET05 will pop two bytes - make room for
+	DEC	2		;  them, just like F_INITCALL does
+	RLDI(CALLPC,CAL05)	; ...
+	RLDI(RETPC,RET05)	; ...
+	SEP	RETPC		; "return" to the address in A
+
+; Call a subroutine - the address follows the SEP 4 ...
+CAL05X:	SEP	PC		; go to the subroutine
+CAL05:	PLO	BAUD		; save D (in BAUD.0, like the BIOS)
+	GHI	A		; push the old linkage register
+	SEX	SP		; ...
+	STXD			; ...
+	GLO	A		; ...
+	STXD			; ...
+	SEX	A		; and copy the PC to it
+	.DB	68H, 0B3H	; RNX 3
+	.DB	68H, 63H	; then load the PC from it - RLXA 3
+	SEX	SP		; ...
+	GLO	BAUD		; restore D
+	BR	CAL05X		; ...
+
+; Return from a subroutine ...
+RET05X:	SEP	PC		; back to the caller
+RET05:	PLO	BAUD		; save D
+	SEX	PC		; copy the linkage register to the PC
+	.DB	68H, 0B6H	; RNX 6
+	SEX	SP		; and pop the old linkage register
+	IRX			; ...
+	LDXA			; ...
+	PLO	A		; ...
+	LDX			; ...
+	PHI	A		; ...
+	GLO	BAUD		; restore D
+	BR	RET05X		; ...
+
+#if ($ > MONX9TOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow at MONEXT9!"
+#endif
+#endif
+
+	.EJECT
+;	.SBTTL	FILL, MOVE, COMPARE and SEARCH Commands
+
+;   These four commands work on a block of memory, addr1 thru addr2 -
+;
+;	>>>FILL addr1 addr2 byte		- store byte in every location
+;	>>>MOVE addr1 addr2 addr3		- copy the block to addr3
+;	>>>COMPARE addr1 addr2 addr3		- compare the block with addr3
+;	>>>SEARCH addr1 addr2 byte [byte ...]	- find a string of bytes
+;
+; MOVE gets it right even if the old and new blocks overlap, COMPARE types
+; the address and contents of both bytes whenever they're different, and
+; SEARCH types the address of every place the string starts.  FILL and MOVE
+; refuse to store anything on the monitor's data page, just like IHEX.
+;
+;   They all go thru the block a page at a time, and the inner loops count
+; only the bytes on that page (MEMCNK works out how many) with an eight bit
+; counter.  The console is checked for a BREAK only between pages, by MEMNXT.
+; FILL and MOVE also have a special loop for a whole page, unrolled sixteen
+; or eight times, that just watches the low byte of the address - FILL's
+; stores a byte every two machine cycles and a half, which is pretty close
+; to as fast as an 1802 can write memory.
+#ifdef MEMCMDS
+	.ORG	MONEXT11
+
+;   Scan "addr1 addr2 x" for all four commands - addr1 goes in P3, addr2 in
+; P4 and x in P2, and addr1 must not be more than addr2 ...
+MEMARG:	CALL(SCANP2)		; P3 = addr1 and P2 = addr2
+	RCOPY(P4,P2)		; ...
+	CALL(P3LEP4)		; they'd better be in the right order
+	LBNF	CMDERR		; ...
+	CALL(ISEOL)		; and there has to be another argument
+	LBDF	CMDERR		; ...
+	LBR	SCANP1		; scan that and return
+
+;   Make sure that a block of memory, from the page in D thru the address in
+; T1, doesn't include the monitor's data page.  If it does, then say so and
+; go back to MAIN ...
+MEMOVM:	SDI	HIGH(RAMPAGE)	; does the block start above RAMPAGE?
+	LBNF	MEMOV1		; yes - that's fine
+	GHI	T1		; no - does it end below RAMPAGE?
+	SMI	HIGH(RAMPAGE)	; ...
+	LBNF	MEMOV1		; that's fine too
+	OUTSTR(OVMMSG)		; ?WOULD OVERWRITE MONITOR
+	LBR	MAIN		; ...
+MEMOV1:	RETURN			; ...
+
+;   Figure out how many bytes there are on this page, from P3 to the end of
+; the page or to P4, whichever comes first, and return that in T1.0 and D.
+; Zero means 256 - a whole page.  T1.1 is zero if this is the last page ...
+MEMCNK:	GHI	P3		; are P3 and P4 on the same page?
+	STR	SP		; ...
+	GHI	P4		; ...
+	XOR			; ...
+	PHI	T1		; T1.1 = 0 if they are
+	BZ	MEMCN1		; ...
+	GLO	P3		; no - count to the end of the page
+	SDI	0		; ...
+	BR	MEMCN2		; ...
+MEMCN1:	GLO	P3		; yes - count up to P4
+	STR	SP		; ...
+	GLO	P4		; ...
+	SM			; ...
+	ADI	1		; ...
+MEMCN2:	PLO	T1		; ...
+	RETURN			; ...
+
+;   Call this after each page.  It returns DF=1 if that was the last page
+; (T1.1 is zero) or if there's a BREAK on the console ...
+MEMNXT:	GHI	T1		; DF=1 if that was the last page
+	SDI	0		; ...
+	LBNF	F_BRKTEST	; if it wasn't, DF=1 only for a BREAK
+	RETURN			; ...
+
+;   MOVE copies the block up, starting from the beginning, when the new block
+; is lower in memory than the old one, and down, starting from the end, when
+; it's higher.  Either way it never stores on top of a byte it still needs to
+; copy.  T1 is the last address of the new block, and it can't wrap around
+; past $FFFF ...
+MOVCMD:	CALL(MEMARG)		; P3 = addr1, P4 = addr2 and P2 = addr3
+	CALL(ISEOL)		; that should be all
+	LBNF	CMDERR		; ...
+	GLO	P3		; T1 = addr2 - addr1 + addr3
+	STR	SP		; ...
+	GLO	P4		; ...
+	SM			; ...
+	PLO	T1		; ...
+	GHI	P3		; ...
+	STR	SP		; ...
+	GHI	P4		; ...
+	SMB			; ...
+	PHI	T1		; ...
+	GLO	P2		; ...
+	STR	SP		; ...
+	GLO	T1		; ...
+	ADD			; ...
+	PLO	T1		; ...
+	GHI	P2		; ...
+	STR	SP		; ...
+	GHI	T1		; ...
+	ADC			; ...
+	PHI	T1		; ...
+	LBDF	CMDERR		; the new block wraps around - no way
+	GHI	P2		; and it can't include the data page
+	CALL(MEMOVM)		; ...
+	GLO	P2		; is addr3 above addr1?
+	STR	SP		; ...
+	GLO	P3		; ...
+	SM			; ...
+	GHI	P2		; ...
+	STR	SP		; ...
+	GHI	P3		; ...
+	SMB			; ...
+	LBDF	MOVUP		; no - copy up from the beginning
+	RCOPY(P2,T1)		; yes - copy down from the end
+
+;   Copy down from P4 to P2 and stop after P3.  This is MEMCNK upside down -
+; the count on each page is from P4 to the start of the page, or to P3 ...
+MOVDN:	GHI	P3		; are P3 and P4 on the same page?
+	STR	SP		; ...
+	GHI	P4		; ...
+	XOR			; ...
+	PHI	T1		; T1.1 = 0 if they are
+	BZ	MOVDN1		; ...
+	GLO	P4		; no - count to the start of the page
+	ADI	1		; ...
+	BR	MOVDN2		; ...
+MOVDN1:	GLO	P3		; yes - count down to P3
+	STR	SP		; ...
+	GLO	P4		; ...
+	SM			; ...
+	ADI	1		; ...
+MOVDN2:	PLO	T1		; ...
+	SEX	P2		; STXD stores at P2
+	BNZ	MOVDN4		; only part of a page - one byte at a time
+MOVDN3:	LDN P4\ DEC P4\ STXD	; a whole page - eight bytes at a time
+	LDN P4\ DEC P4\ STXD	; ...
+	LDN P4\ DEC P4\ STXD	; ...
+	LDN P4\ DEC P4\ STXD	; ...
+	LDN P4\ DEC P4\ STXD	; ...
+	LDN P4\ DEC P4\ STXD	; ...
+	LDN P4\ DEC P4\ STXD	; ...
+	LDN P4\ DEC P4\ STXD	; ...
+	GLO	P4		; have we wrapped around to $xxFF?
+	XRI	$FF		; ...
+	BNZ	MOVDN3		; no - keep going
+	BR	MOVDN5		; ...
+MOVDN4:	LDN	P4		; part of a page
+	DEC	P4		; ...
+	STXD			; ...
+	DEC	T1		; ...
+	GLO	T1		; ...
+	BNZ	MOVDN4		; ...
+MOVDN5:	SEX	SP		; ...
+	CALL(MEMNXT)		; on to the next page
+	LBNF	MOVDN		; ...
+	LBR	MAIN		; all done
+
+; Copy up from P3 to P2 and stop after P4 ...
+MOVUP:	CALL(MEMCNK)		; how much is there on this page?
+	BNZ	MOVUP2		; only part of a page
+MOVUP1:	LDA P3\ STR P2\ INC P2	; a whole page - eight bytes at a time
+	LDA P3\ STR P2\ INC P2	; ...
+	LDA P3\ STR P2\ INC P2	; ...
+	LDA P3\ STR P2\ INC P2	; ...
+	LDA P3\ STR P2\ INC P2	; ...
+	LDA P3\ STR P2\ INC P2	; ...
+	LDA P3\ STR P2\ INC P2	; ...
+	LDA P3\ STR P2\ INC P2	; ...
+	GLO	P3		; have we reached the next page?
+	BNZ	MOVUP1		; no - keep going
+	BR	MOVUP3		; ...
+MOVUP2:	LDA	P3		; part of a page
+	STR	P2		; ...
+	INC	P2		; ...
+	DEC	T1		; ...
+	GLO	T1		; ...
+	BNZ	MOVUP2		; ...
+MOVUP3:	CALL(MEMNXT)		; on to the next page
+	LBNF	MOVUP		; ...
+	LBR	MAIN		; all done
+
+#if ($ > MONX11TOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow at MONEXT11!"
+#endif
+
+; SEARCH, FILL and COMPARE fit in what's left at the end of MONEXT.  COMPARE
+; goes first so that the page boundary falls in SEARCH's argument scanning and
+; not in the middle of somebody's loop ...
+	.ORG	MEMEXT
+
+;   COMPARE types "aaaa xx bbbb yy" for every byte that's different.  There's
+; no whole page loop here, since it has to stop in the middle anyway for
+; every difference, but the loop still takes only seven instructions a byte.
+CMPCMD:	CALL(MEMARG)		; P3 = addr1, P4 = addr2 and P2 = addr3
+	CALL(ISEOL)		; that should be all
+	LBNF	CMDERR		; ...
+CMP1:	CALL(MEMCNK)		; how much is there on this page?
+	SEX	P2		; compare with the second block
+CMP2:	LDA	P3		; get a byte from the first block
+	XOR			; is it the same as the second?
+	INC	P2		; ...
+	BNZ	CMP4		; no - type them
+CMP3:	DEC	T1		; yes - on to the next
+	GLO	T1		; ...
+	BNZ	CMP2		; ...
+	SEX	SP		; ...
+	CALL(MEMNXT)		; on to the next page
+	LBNF	CMP1		; ...
+	LBR	MAIN		; all done
+
+; Here when the bytes are different ...
+CMP4:	SEX	SP		; ...
+	DEC	P3		; back up to them
+	DEC	P2		; ...
+	RCOPY(P1,P3)		; type "aaaa xx"
+	CALL(CMPTYP)		; ...
+	CALL(TSPACE)		; a space
+	RCOPY(P1,P2)		; and then "bbbb yy"
+	CALL(CMPTYP)		; ...
+	CALL(TCRLF)		; ...
+	INC	P3		; and go on from where we were
+	INC	P2		; ...
+	CALL(F_BRKTEST)		; there might be a lot of these
+	LBDF	MAIN		; ...
+	SEX	P2		; ...
+	LBR	CMP3		; (this may not be on CMP3's page)
+
+; Type the address in P1, a space and the byte there ...
+CMPTYP:	CALL(THEX4)		; type the address
+	CALL(TSPACE)		; ...
+	LDN	P1		; and the byte
+	LBR	THEX2		; ...
+
+;   SEARCH keeps the string in DMPBUF, and it pushes the length of all but
+; the first byte on the stack.  The first byte goes in T2.1 (SCANP1 changes
+; T2, so not until the scanning is done) and at the top of the stack, where
+; the loop can look for it with XOR.  When it matches, SRCHM compares the
+; rest ...
+SRCCMD:	CALL(MEMARG)		; P3 = addr1, P4 = addr2 and P2.0 = byte
+	RLDI(T1,DMPBUF)		; the string goes in DMPBUF
+SRC1:	GLO	P2		; store the next byte
+	STR	T1		; ...
+	INC	T1		; ...
+	CALL(ISEOL)		; any more?
+	LBDF	SRC2		; no
+	CALL(SCANP1)		; yes - scan the next one
+	BR	SRC1		; ...
+SRC2:	GLO	T1		; push the length of the rest of it
+	SMI	LOW(DMPBUF+1)	; ...
+	STXD			; ...
+	RLDI(T1,DMPBUF)		; and keep the first byte in T2.1
+	LDN	T1		; ...
+	PHI	T2		; ...
+SRC3:	CALL(MEMCNK)		; how much is there on this page?
+	GHI	T2		; put the first byte on the stack
+	STR	SP		; ...
+SRC4:	LDA	P3		; get a byte from memory
+	XOR			; is it the first one?
+	BZ	SRCHM		; yes - check the rest
+SRC5:	DEC	T1		; no - on to the next
+	GLO	T1		; ...
+	BNZ	SRC4		; ...
+	CALL(MEMNXT)		; on to the next page
+	LBNF	SRC3		; ...
+	LBR	MAIN		; all done
+
+; Here when the first byte matches - compare the rest with DMPBUF ...
+SRCHM:	IRX			; get the length of the rest
+	LDX			; ...
+	DEC	SP		; ...
+	PLO	T2		; ...
+	RLDI(P1,DMPBUF+1)	; ...
+	RCOPY(P2,P3)		; and the rest of memory
+SRCHM1:	GLO	T2		; have we done all of it?
+	BZ	SRCHM2		; yes - it's a match
+	DEC	T2		; no - compare the next byte
+	LDA	P2		; ...
+	STR	SP		; ...
+	LDA	P1		; ...
+	XOR			; ...
+	BZ	SRCHM1		; keep going while they're the same
+	BR	SRCHM3		; it's not a match after all
+SRCHM2:	DEC	P3		; type the address of the match
+	RCOPY(P1,P3)		; ...
+	INC	P3		; ...
+	CALL(THEX4)		; ...
+	CALL(TCRLF)		; ...
+	CALL(F_BRKTEST)		; there might be a lot of these
+	LBDF	MAIN		; ...
+SRCHM3:	GHI	T2		; put the first byte back on the stack
+	STR	SP		; ...
+	BR	SRC5		; and keep looking
+
+;   FILL goes thru the block a page at a time.  For a whole page it starts at
+; the top and works down with STXD, which stores the byte and decrements the
+; address all in one instruction, sixteen at a time ...
+FILCMD:	CALL(MEMARG)		; P3 = addr1, P4 = addr2 and P2.0 = byte
+	CALL(ISEOL)		; that should be all
+	LBNF	CMDERR		; ...
+	RCOPY(T1,P4)		; FILL can't touch the monitor's data page
+	GHI	P3		; ...
+	CALL(MEMOVM)		; ...
+FILL1:	CALL(MEMCNK)		; how much is there on this page?
+	BNZ	FILL3		; only part of a page - one byte at a time
+	LDI	$FF		; a whole page - start at the top
+	PLO	P3		; ...
+	SEX	P3		; ...
+FILL2:	GLO	P2		; get the byte
+	STXD\ STXD\ STXD\ STXD	; and store sixteen of them
+	STXD\ STXD\ STXD\ STXD	; ...
+	STXD\ STXD\ STXD\ STXD	; ...
+	STXD\ STXD\ STXD\ STXD	; ...
+	GLO	P3		; have we wrapped around to $xxFF?
+	XRI	$FF		; ...
+	BNZ	FILL2		; no - keep going
+	SEX	SP		; yes - P3 = $xx00 again
+	INC	P3		; ...
+	GHI	P3		; and then on to the next page
+	ADI	1		; ...
+	PHI	P3		; ...
+	BR	FILL4		; ...
+FILL3:	GLO	P2		; here for part of a page
+	STR	P3		; ...
+	INC	P3		; ...
+	DEC	T1		; ...
+	GLO	T1		; ...
+	BNZ	FILL3		; ...
+FILL4:	CALL(MEMNXT)		; on to the next page
+	LBNF	FILL1		; ...
+	LBR	MAIN		; all done
+
+#if ($ > MONXTOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow!"
+#endif
+#endif
+
+	.EJECT
+;	.SBTTL	CHECKSUM Command
+
+;   CHECKSUM types the CRC-16 of a block of memory -
+;
+;	>>>CHECKSUM addr1 addr2
+;
+; and HEXCRC, in the tools directory, works out the same CRC from a .HEX
+; file, so checking that a program in RAM is still intact takes one command
+; instead of another download.  It's the CRC that XMODEM uses - polynomial
+; $1021, starting from zero, most significant bit first and nothing inverted
+; or reflected - so anything else that does "CRC-16/XMODEM" will agree too.
+;
+;   It's table driven, a byte at a time.  There's no room in EPROM for the
+; 512 byte table, so CRCTAB builds it in DSKBUF first, with the high bytes on
+; one page and the low bytes on the next.  That only takes about 6,000
+; machine cycles.  The usual table driven loop is
+;
+;	idx = (crc >> 8) ^ byte
+;	crc = (crc << 8) ^ table[idx]
+;
+; but the low byte of the CRC is always just the low table byte for the last
+; index, and so the next index is really
+;
+;	idx(n+1) = byte ^ tablehi[idx(n)] ^ tablelo[idx(n-1)]
+;
+; If the last two indices are kept in the low bytes of four registers, with
+; the table pages in the high bytes, then each byte takes seven instructions
+; and the CRC itself is never kept anywhere at all.  The loop does two bytes
+; at a time, with the two pairs of registers swapping places, and then
+; counts with a sixteen bit counter, so all told it takes about 17 machine
+; cycles a byte - 32K takes about two and a half seconds at 1.79MHz.  The
+; console is checked for a BREAK every 512 bytes.
+;
+;   This needs about 150 bytes of EPROM, which the Elf2K EPROM doesn't have,
+; so it's only in the others.  CRCCMD goes in the end of XMODEM (MONEXT12)
+; and CRCTAB in the end of SEDIT (MONEXT13).
+#ifdef MEMCRC
+CRCPOL	.EQU	$1021		; the CRC-16 polynomial
+	.ORG	MONEXT12
+
+;   T1 and P1 point to the high and low table bytes for the last index, and
+; P2 and T2 to the ones for the index before that.  They all start out at
+; entry zero, which is zero, just as if the CRC started out as zero ...
+CRCCMD:	CALL(SCANP2)		; P3 = addr1 and P2 = addr2
+	CALL(ISEOL)		; that should be all
+	LBNF	CMDERR		; ...
+	RCOPY(P4,P2)		; ...
+	CALL(P3LEP4)		; they'd better be in the right order
+	LBNF	CMDERR		; ...
+	CALL(CRCTAB)		; build the table
+	GLO	P3		; P4 = (addr2 - addr1) / 2 + 1
+	STR	SP		; ...
+	GLO	P4		; ...
+	SM			; ...
+	PLO	P4		; ...
+	GHI	P3		; ...
+	STR	SP		; ...
+	GHI	P4		; ...
+	SMB			; ...
+	SHR			; ...
+	PHI	P4		; ...
+	GLO	P4		; ...
+	SHRC			; ...
+	PLO	P4		; ...
+	INC	P4		; ...
+	BNF	CRC2		; an odd number of bytes - start halfway thru
+CRC1:	LDA	P3		; idx = byte
+	SEX	T1		;  ^ tablehi[idx(n)]
+	XOR			; ...
+	SEX	T2		;  ^ tablelo[idx(n-1)]
+	XOR			; ...
+	PLO	P2		; and that's the new index
+	PLO	T2		; ...
+CRC2:	LDA	P3		; and the same again, with the
+	SEX	P2		;  registers the other way around
+	XOR			; ...
+	SEX	P1		; ...
+	XOR			; ...
+	PLO	T1		; ...
+	PLO	P1		; ...
+	DEC	P4		; count them
+	GLO	P4		; ...
+	BNZ	CRC1		; ...
+	SEX	SP		; check for a BREAK every 512 bytes
+	CALL(F_BRKTEST)		; ...
+	LBDF	MAIN		; ...
+	GHI	P4		; ...
+	BNZ	CRC1		; ...
+	SEX	T2		; the high byte of the CRC is
+	LDN	T1		;  tablehi[idx(n)] ^ tablelo[idx(n-1)]
+	XOR			; ...
+	SEX	SP		; ...
+	PHI	T1		; ...
+	LDN	P1		; and the low byte is tablelo[idx(n)]
+	PLO	P1		; ...
+	GHI	T1		; ...
+	PHI	P1		; ...
+	CALL(THEX4)		; type it
+	CALL(TCRLF)		; ...
+	LBR	MAIN		; and we're done
+
+#if ($ > MONX12TOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow at MONEXT12!"
+#endif
+	.ORG	MONEXT13
+
+;   Build the CRC table in DSKBUF and return with T1 and P2 pointing to entry
+; zero of the high bytes, and P1 and T2 to entry zero of the low bytes.  Entry
+; 2j is entry j shifted left one bit, XORed with the polynomial if a one fell
+; out, and entry 2j+1 is that XORed with the polynomial again.  So the table
+; can be built from itself, in order, starting from entry zero = zero ...
+CRCTAB:	LDI	HIGH(DSKBUF)	; T1 and P2 point to the high bytes
+	PHI	T1		; ...
+	PHI	P2		; ...
+	LDI	HIGH(DSKBUF)+1	; and P1 and T2 to the low bytes
+	PHI	P1		; ...
+	PHI	T2		; ...
+	LDI	0		; ...
+	PLO	T1		; ...
+	PLO	P1		; ...
+	PLO	P2		; ...
+	PLO	T2		; ...
+	STR	T1		; entry zero is zero
+	STR	P1		; ...
+CRCT1:	LDA	T2		; entry 2j = entry j shifted left
+	SHL			; ...
+	STR	P1		; ...
+	LDA	P2		; ...
+	SHLC			; ...
+	STR	T1		; ...
+	BNF	CRCT2		; did a one fall out?
+	XRI	HIGH(CRCPOL)	; yes - XOR in the polynomial
+	STR	T1		; ...
+	LDN	P1		; ...
+	XRI	LOW(CRCPOL)	; ...
+	STR	P1		; ...
+CRCT2:	LDA	T1		; entry 2j+1 = entry 2j ^ polynomial
+	XRI	HIGH(CRCPOL)	; ...
+	STR	T1		; ...
+	LDA	P1		; ...
+	XRI	LOW(CRCPOL)	; ...
+	STR	P1		; ...
+	INC	T1		; ...
+	INC	P1		; ...
+	GLO	T1		; until entry 2j wraps around to zero
+	BNZ	CRCT1		; ...
+	PLO	P2		; then point everything back at entry zero
+	PLO	T2		; ...
+	GHI	P2		; ...
+	PHI	T1		; ...
+	GHI	T2		; ...
+	PHI	P1		; ...
+	RETURN			; ...
+
+#if ($ > MONX13TOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow at MONEXT13!"
+#endif
+#endif
+
+	.EJECT
+;	.SBTTL	SAVE Command
+
+;   SAVE types a block of memory as an Intel .HEX file -
+;
+;	>>>SAVE addr1 addr2
+;
+; sixteen bytes to a record and then an end of file record, so that LOAD (or
+; ":", or HEXSEND) can put it back later.  Just have your terminal program
+; capture the output.  The console is checked for a BREAK after each record.
+;
+;   The point of all this is to keep up with the UART.  The hex digits go out
+; one at a time, as they're converted, by a little routine that runs with P1
+; as the program counter, so there's no trip thru SCRT for any byte.  The UART
+; has a holding register as well as the shift register, so the next digit is
+; figured out while the last one is still being sent, and that takes less
+; than one character time even at 38400bps.  If the UART isn't the console,
+; then each record is saved in CMDBUF instead and typed by TMSG.
+#ifdef SAVEHEX
+	.ORG	MONEXT14
+
+SAVCMD:	CALL(SCANP2)		; P3 = addr1 and P2 = addr2
+	CALL(ISEOL)		; that should be all
+	LBNF	CMDERR		; ...
+	RCOPY(P4,P2)		; ...
+	CALL(P3LEP4)		; they'd better be in the right order
+	LBNF	CMDERR		; ...
+	RLDI(P1,SAVUAR)		; assume the UART is the console
+	GHI	BAUD		; is it?
+	ANI	$FE		; ...
+	BZ	SAV1		; yes
+	RLDI(P1,SAVBUF)		; no - save the records in CMDBUF
+
+; Figure out how much goes in the next record - 16 bytes, or what's left ...
+SAV1:	GLO	P3		; P2.0 = addr2 - P3
+	STR	SP		; ...
+	GLO	P4		; ...
+	SM			; ...
+	PLO	P2		; ...
+	GHI	P3		; ...
+	STR	SP		; ...
+	GHI	P4		; ...
+	SMB			; ...
+	BNZ	SAV2		; 256 or more left
+	GLO	P2		; 16 or more?
+	SMI	16		; ...
+	BDF	SAV2		; yes
+	GLO	P2		; no - this is the last record
+	ADI	1		; ...
+	PHI	P2		; ...
+	CALL(SAVDAT)		; ...
+	LDI	0		; and then the end of file record -
+	PHI	P3		;  no data (P2.1 is zero already),
+	PLO	P3		;  address 0000 and type 01
+	LDI	1		; ...
+	PLO	P2		; ...
+	CALL(SAVREC)		; ...
+	LBR	MAIN		; all done
+SAV2:	LDI	16		; a whole record
+	PHI	P2		; ...
+	CALL(SAVDAT)		; ...
+	CALL(F_BRKTEST)		; does the user want to stop early?
+	LBNF	SAV1		; no - keep going
+	LBR	MAIN		; ...
+
+;   Type one record, with P2.1 data bytes from P3 (which is advanced past
+; them) and record type P2.0.  SAVDAT is for type 00.  First the whole record,
+; less the colon and the checksum, is copied so that it ends just before
+; SAVEND, and then all of it is typed in one loop.  The checksum is added up
+; in P2.0 as we go, and it's stored in the last byte when we get there ...
+SAVEND	.EQU	DMPBUF+DMPLEN-1	; end of the copy (on the same page!)
+SAVDAT:	LDI	0		; a data record
+	PLO	P2		; ...
+SAVREC:	LDI	HIGH(SAVEND)	; point T2 at the start of the copy
+	PHI	T2		; ...
+	GHI	P2		; which is LOW(SAVEND-5) - count
+	SDI	LOW(SAVEND-5)	; ...
+	PLO	T2		; ...
+	PLO	T1		; remember that for later
+	GHI	P2		; the byte count
+	STR	T2		; ...
+	INC	T2		; ...
+	GHI	P3		; the address
+	STR	T2		; ...
+	INC	T2		; ...
+	GLO	P3		; ...
+	STR	T2		; ...
+	INC	T2		; ...
+	GLO	P2		; the record type
+	STR	T2		; ...
+	INC	T2		; ...
+SAVRE1:	GHI	P2		; and then the data
+	BZ	SAVRE2		; ...
+	SMI	1		; ...
+	PHI	P2		; ...
+	LDA	P3		; ...
+	STR	T2		; ...
+	INC	T2		; ...
+	BR	SAVRE1		; ...
+SAVRE2:	PLO	P2		; D is zero here - clear the checksum
+	GLO	T1		; back to the start of the copy
+	PLO	T2		; ...
+	LDI	HIGH(HEXTAB)	; and T1 to the hex digits
+	PHI	T1		; ...
+	LDI	LOW(CMDBUF)	; (for SAVBUF)
+	PLO	DP		; ...
+	LDI	':'		; every record starts with a colon
+	SEP	P1		; ...
+SAVRE3:	GLO	T2		; is the next byte the checksum?
+	XRI	LOW(SAVEND-1)	; ...
+	BNZ	SAVRE4		; no
+	GLO	P2		; yes - it's minus the sum of the rest
+	SDI	0		; ...
+	STR	T2		; ...
+SAVRE4:	LDA	T2		; add this byte to the checksum
+	STR	SP		; ...
+	GLO	P2		; ...
+	ADD			; ...
+	PLO	P2		; ...
+	LDN	SP		; type the high nibble
+	SHR\ SHR\ SHR\ SHR	; ...
+	ADI	LOW(HEXTAB)	; ...
+	PLO	T1		; ...
+	LDN	T1		; ...
+	SEP	P1		; ...
+	LDN	SP		; and then the low nibble
+	ANI	$0F		; ...
+	ADI	LOW(HEXTAB)	; ...
+	PLO	T1		; ...
+	LDN	T1		; ...
+	SEP	P1		; ...
+	GLO	T2		; was that the checksum?
+	XRI	LOW(SAVEND)	; ...
+	BNZ	SAVRE3		; no - keep going
+	LDI	CHCRT		; finish with a CRLF
+	SEP	P1		; ...
+	LDI	CHLFD		; ...
+	SEP	P1		; ...
+	GHI	BAUD		; is the UART the console?
+	ANI	$FE		; ...
+	BZ	SAVRE5		; yes - that's all
+	STR	DP		; no - terminate the record in CMDBUF
+	RLDI(P1,CMDBUF)		; and type it
+	CALL(TMSG)		; ...
+	RLDI(P1,SAVBUF)		; ...
+SAVRE5:	RETURN			; ...
+
+;   SAVUAR sends the character in D to the UART, and SAVBUF stores it at DP
+; instead.  Both run with P1 as the program counter, "SEP P1" to call them.
+; SAVUAR uses T1.0 and the byte below the top of the stack, and it leaves
+; the UART's register select pointing to THR ...
+SAVUAX:	SEP	PC		; return to SAVREC
+SAVUAR:	PLO	T1		; save the character
+	SEX	P1		; select the line status register
+	OUT	UART_SELECT	; ...
+	.DB	LSR		; ...
+	DEC	SP		; don't let INP step on the top of the stack
+	SEX	SP		; ...
+SAVUA1:	INP	UART_DATA	; wait for the transmitter to be ready
+	ANI	THRE		; ...
+	BZ	SAVUA1		; ...
+	SEX	P1		; and then select the holding register
+	OUT	UART_SELECT	; ...
+	.DB	THR		; ...
+	GLO	T1		; send the character
+	STR	SP		; ...
+	SEX	SP		; ...
+	OUT	UART_DATA	; (which increments SP back again)
+	BR	SAVUAX		; ...
+SAVBFX:	SEP	PC		; return to SAVREC
+SAVBUF:	STR	DP		; just store the character
+	INC	DP		; ...
+	BR	SAVBFX		; ...
+
+#if ($ > MONX14TOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow at MONEXT14!"
+#endif
+#endif
+
+	.EJECT
+;	.SBTTL	REMOTE Command
+
+;   REMOTE lets a program on the host read and write memory and run programs
+; without going thru the command line at all.  The host types
+;
+;	>>>REMOTE
+;
+; and the monitor answers with an ACK packet, and from then on it's nothing
+; but binary packets, one reply for every command.  A command is
+;
+;	cmd addrhi addrlo len [data ...] crchi crclo
+;
+; where there's data only for W, and a reply is
+;
+;	status [data ...] crchi crclo
+;
+; where the status is ACK ($06) or NAK ($15), and there's data only for R
+; and I.  The CRC is CRC-16/XMODEM, the same one that CHECKSUM uses, of all
+; the bytes before it.  The commands are
+;
+;	R	send len bytes (1..255) starting at addr
+;	W	write len bytes (1..RMTMAX) starting at addr
+;	I	send RMTTAB - MONVER, RMTMAX and the address of SAVEXP
+;	G	CALL the program at addr, and send another ACK when it returns
+;	C	CONTINUE after a breakpoint
+;	Q	quit back to the command prompt
+;
+; and anything else, or a bad length or CRC, gets a NAK.  The user registers
+; after a breakpoint start at SAVEXP, in the order that TRAP saves them, so R
+; and W work for them too, and a breakpoint is just a W of $79 $D1 (MARK and
+; SEP R1) into the program.  When a breakpoint is hit the monitor types the
+; registers and the prompt, the same as always, and the host has to type
+; REMOTE again.  A BREAK from the host gets back to the prompt from anywhere,
+; and that's how the host gets back in step if a packet is lost.
+;
+;   The packets go straight to and from the UART, with the CRC worked out a
+; byte at a time as they go (using the table that CRCTAB builds in DSKBUF),
+; and the 16550 FIFOs are turned on while we're here so that the receiver
+; can keep up at 38400bps.  A W has to be kept in CMDBUF until its CRC has
+; been checked, which is why it's limited to RMTMAX bytes.  All this needs
+; the UART to be the console.
+#ifdef REMOTE
+RMTACK	.EQU	$06		; the command worked
+RMTNAK	.EQU	$15		; bad command, length or CRC
+RMTMAX	.EQU	CMDMAX-8	; longest W (it has to fit in CMDBUF)
+	.ORG	MONEXT15
+
+RMTCMD:	CALL(ISEOL)		; there are no arguments
+	LBNF	CMDERR		; ...
+	GHI	BAUD		; and the UART has to be the console
+	ANI	$FE		; ...
+	LBNZ	CMDERR		; ...
+RMTGO1:	SEX	PC		; turn on the FIFOs, if there are any
+	WUART(FCR,FIFOEN+FIFORST); ...
+	SEX	SP		; ...
+	CALL(CRCTAB)		; build the CRC table
+RMTOK:	LDI	0		; send an ACK with no data
+	PLO	P1		; ...
+RMTRD:	LDI	RMTACK		; send an ACK with P1.0 bytes from P3
+RMTLP:	PHI	P1		; send the reply
+	CALL(RMTSND)		; ...
+
+; Read the next command into CMDBUF and check its CRC ...
+	RLDI(P2,CMDBUF)		; ...
+	LDI	0		; start the CRC
+	PHI	P4		; ...
+	PLO	P4		; ...
+	LDI	4		; the command, address and length first
+	CALL(RMTRCV)		; ...
+	LDI	LOW(CMDBUF+1)	; P3 = addr
+	PLO	DP		; ...
+	LDA	DP		; ...
+	PHI	P3		; ...
+	LDA	DP		; ...
+	PLO	P3		; ...
+	LDN	DP		; and P1.0 = len
+	PLO	P1		; ...
+	LDI	LOW(CMDBUF)	; is it a W?
+	PLO	DP		; ...
+	LDN	DP		; ...
+	XRI	'W'		; ...
+	BNZ	RMTLP1		; no - just the CRC is left
+	GLO	P1		; yes - 1 <= len <= RMTMAX?
+	SMI	1		; ...
+	SMI	RMTMAX		; ...
+	BDF	RMTBAD		; no
+	GLO	P1		; yes - read the data too
+	CALL(RMTRCV)		; ...
+RMTLP1:	LDI	2		; and then the CRC
+	CALL(RMTRCV)		; ...
+	GHI	P4		; the CRC of all that should be zero
+	BNZ	RMTBAD		; ...
+	GLO	P4		; ...
+	BNZ	RMTBAD		; ...
+
+; The packet's OK - see what it wants ...
+	LDN	DP		; get the command back
+	XRI	'R'		; R?
+	BZ	RMTRD		; ...
+	XRI	'R'^'W'		; W?
+	BZ	RMTWR		; ...
+	XRI	'W'^'I'		; I?
+	BZ	RMTINF		; ...
+	XRI	'I'^'G'		; G?
+	BZ	RMTGO		; ...
+	XRI	'G'^'C'		; C?
+	BZ	RMTCON		; ...
+	XRI	'C'^'Q'		; Q?
+	BZ	RMTQ		; ...
+RMTBAD:	LDI	0		; send a NAK
+	PLO	P1		; ...
+	LDI	RMTNAK		; ...
+	BR	RMTLP		; ...
+
+; I - send RMTTAB ...
+RMTINF:	RLDI(P3,RMTTAB)		; ...
+	LDI	RMTTBL		; ...
+	PLO	P1		; ...
+	BR	RMTRD		; ...
+
+; W - copy the data from CMDBUF to memory ...
+RMTWR:	LDI	LOW(CMDBUF+4)	; ...
+	PLO	DP		; ...
+RMTWR1:	LDA	DP		; ...
+	STR	P3		; ...
+	INC	P3		; ...
+	DEC	P1		; ...
+	GLO	P1		; ...
+	BNZ	RMTWR1		; ...
+	BR	RMTOK		; ...
+
+; G - ACK first, and then call the program ...
+RMTGO:	CALL(RMTAK0)		; ...
+	RCOPY(P2,P3)		; ...
+	CALL(CALUS0)		; ...
+	BR	RMTGO1		; it may have changed DSKBUF
+
+; C - ACK, and then CONTINUE ...
+RMTCON:	CALL(RMTAK0)		; ...
+	CALL(RMTEND)		; ...
+	RLDI(1,CONT1)		; ...
+	SEP	1		; ...
+
+; Q - ACK, and back to the prompt ...
+RMTQ:	CALL(RMTAK0)		; ...
+RMTBRK:	CALL(RMTEND)		; ...
+	LBR	MAIN		; ...
+
+; Here's what I sends ...
+RMTTAB:	.DB	MONVER, RMTMAX	; ...
+	.DB	HIGH(SAVEXP), LOW(SAVEXP)
+RMTTBL	.EQU	$-RMTTAB	; ...
+
+;   Send a reply with status P1.1 and P1.0 bytes from P3.  RMTPUT does all
+; the work, with P2 as its PC.  RMTAK0 sends an ACK with no data, and that
+; leaves P3 alone (G needs it afterwards) ...
+RMTAK0:	LDI	RMTACK		; ...
+	PHI	P1		; ...
+	LDI	0		; ...
+	PLO	P1		; ...
+RMTSND:	RLDI(P2,RMTPUT)		; ...
+	LDI	0		; start the CRC
+	PHI	P4		; ...
+	PLO	P4		; ...
+	GHI	P1		; send the status
+	SEP	P2		; ...
+	GLO	P1		; any data?
+	BZ	RMTSN2		; no
+RMTSN1:	LDA	P3		; yes - send it
+	SEP	P2		; ...
+	DEC	P1		; ...
+	GLO	P1		; ...
+	BNZ	RMTSN1		; ...
+RMTSN2:	GLO	P4		; then the CRC, high byte first
+	PLO	P1		; ...
+	GHI	P4		; ...
+	SEP	P2		; ...
+	GLO	P1		; ...
+	SEP	P2		; ...
+	RETURN			; ...
+
+;   Add the byte in D to the CRC in P4 and send it to the UART.  T1 and T2
+; point to the CRC table pages, and BAUD.0 and the top of the stack are
+; used ...
+RMTPUX:	SEP	PC		; return to RMTSND
+RMTPUT:	PLO	BAUD		; save the byte
+	STR	SP		; ...
+	GHI	P4		; idx = (crc >> 8) ^ byte
+	XOR			; ...
+	PLO	T1		; ...
+	PLO	T2		; ...
+	GLO	P4		; crc = (crc << 8) ^ table[idx]
+	SEX	T1		; ...
+	XOR			; ...
+	PHI	P4		; ...
+	LDN	T2		; ...
+	PLO	P4		; ...
+	SEX	P2		; wait for the transmitter
+	OUT	UART_SELECT	; ...
+	.DB	LSR		; ...
+	SEX	SP		; ...
+RMTPU1:	INP	UART_DATA	; ...
+	ANI	THRE		; ...
+	BZ	RMTPU1		; ...
+	SEX	P2		; and send the byte
+	OUT	UART_SELECT	; ...
+	.DB	THR		; ...
+	GLO	BAUD		; ...
+	STR	SP		; ...
+	SEX	SP		; ...
+	OUT	UART_DATA	; ...
+	DEC	SP		; ...
+	BR	RMTPUX		; ...
+
+;   Read D bytes from the UART into P2, adding them to the CRC in P4 as they
+; come, and give up if there's a BREAK.  The count is kept in BAUD.0, since
+; P1.0 holds the length of the packet we're reading ...
+RMTRCV:	PLO	BAUD		; count them in BAUD.0
+RMTRC1:	OUTI(UART_SELECT,LSR)	; wait for a byte
+RMTRC2:	INP	UART_DATA	; ...
+	ANI	DR+BI		; ...
+	BZ	RMTRC2		; ...
+	ANI	BI		; is it a BREAK?
+	LBNZ	RMTBRK		; yes - give up
+	SEX	PC		; no - read it
+	OUT	UART_SELECT	; ...
+	.DB	RBR		; ...
+	SEX	P2		; into the buffer
+	INP	UART_DATA	; ...
+	GHI	P4		; and add it to the CRC
+	XOR			; ...
+	PLO	T1		; ...
+	PLO	T2		; ...
+	GLO	P4		; ...
+	SEX	T1		; ...
+	XOR			; ...
+	PHI	P4		; ...
+	LDN	T2		; ...
+	PLO	P4		; ...
+	SEX	SP		; ...
+	INC	P2		; ...
+	DEC	BAUD		; ...
+	GLO	BAUD		; ...
+	BNZ	RMTRC1		; ...
+	RETURN			; ...
+
+;   Wait for the last reply to be sent, and turn the FIFOs off again ...
+RMTEND:	OUTI(UART_SELECT,LSR)	; ...
+RMTEN1:	INP	UART_DATA	; ...
+	ANI	TEMT		; ...
+	BZ	RMTEN1		; ...
+	SEX	PC		; ...
+	WUART(FCR,FIFORST)	; ...
+	SEX	SP		; ...
+	RETURN			; ...
+
+#if ($ > MONX15TOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow at MONEXT15!"
+#endif
+#endif
+
+	.EJECT
+;	.SBTTL	PARALLEL Command
+
+;   PARALLEL loads and saves memory thru the GPIO card's 8255 PPI instead of
+; the console, for a program on the host (see tools/ppilink.cpp) that talks to
+; port A thru a USB to parallel bridge.  Port A runs in mode 2, strobed and
+; bidirectional - the host strobes a byte in with STB, which sets IBF until
+; we read it, and when we write a byte OBF goes low until the host takes it
+; with ACK.  The 8255 does all the handshaking, so every byte needs just one
+; look at port C and one INP or OUT of port A.  The user types
+;
+;	>>>PARALLEL
+;
+; at the console, and from then on the host sends commands to port A.  Each
+; one is five bytes -
+;
+;	cmd addrhi addrlo counthi countlo
+;
+; and the commands are
+;
+;	W	the host sends count bytes, which are stored at addr, and then
+;		  we send an ACK
+;	R	we send count bytes starting at addr
+;	I	we send an ACK and MONVER
+;	Q	we send an ACK and go back to the command prompt
+;
+; and anything else gets a NAK.  A count of zero means no data at all.  The
+; parallel bus doesn't drop or mangle bytes the way a serial line can, so
+; there are no checksums, and the host can just read back anything it cares
+; about.  Every wait for the host checks for a BREAK on the console too, and
+; that gets back to the prompt from anywhere.  The PPI is left in the same
+; mode 0 input state that the POST leaves it in.
+#ifdef PPIXFER
+PARACK	.EQU	$06		; the command worked
+PARNAK	.EQU	$15		; unknown command
+	.ORG	MONEXT16
+
+PARCMD:	CALL(ISEOL)		; there are no arguments
+	LBNF	CMDERR		; ...
+	SEX	PC		; is there a PPI?  Use the same test as the
+	WPPI(PPICTL,PPIIN)	;  POST - see if the control word reads back
+	RPPI(PPICTL)		; ...
+	XRI	PPIIN		; ...
+	BZ	PARGO		; yes
+	OUTSTR(NOPMSG)		; no - say so
+	RETURN			; ...
+PARGO:	SEX	PC		; put port A in mode 2
+	WPPI(PPICTL,PPIMD2)	; ...
+	SEX	SP		; ...
+
+; Read the next command, address and count ...
+PARLP:	RLDI(P1,CMDBUF)		; ...
+	RLDI(P2,5)		; ...
+	CALL(PARRCV)		; ...
+	LDI	LOW(CMDBUF)	; P1 = addr and P2 = count
+	PLO	DP		; ...
+	LDA	DP		; and T1.0 = cmd
+	PLO	T1		; ...
+	LDA	DP		; ...
+	PHI	P1		; ...
+	LDA	DP		; ...
+	PLO	P1		; ...
+	LDA	DP		; ...
+	PHI	P2		; ...
+	LDN	DP		; ...
+	PLO	P2		; ...
+
+; See what it wants ...
+	GLO	T1		; W?
+	XRI	'W'		; ...
+	BZ	PARWR		; ...
+	XRI	'W'^'R'		; R?
+	BZ	PARRD		; ...
+	XRI	'R'^'I'		; I?
+	BZ	PARINF		; ...
+	XRI	'I'^'Q'		; Q?
+	BZ	PARQ		; ...
+	RLDI(P1,PARTAB+2)	; anything else gets a NAK
+	BR	PARRP1		; ...
+
+; W - read the data, and then ACK ...
+PARWR:	CALL(PARRCV)		; ...
+	BR	PAROK		; ...
+
+; R - send the data ...
+PARRD:	CALL(PARSND)		; ...
+	BR	PARLP		; ...
+
+; I - send an ACK and MONVER ...
+PARINF:	RLDI(P1,PARTAB)		; ...
+	RLDI(P2,2)		; ...
+	BR	PARRP2		; ...
+
+; Q - send an ACK, and back to the prompt.  PARSND waits for the host to
+; take the ACK, so it's safe to change the mode right away ...
+PARQ:	RLDI(P1,PARTAB)		; ...
+	RLDI(P2,1)		; ...
+	CALL(PARSND)		; ...
+PARBRK:	SEX	PC		; leave the PPI the way the POST did
+	WPPI(PPICTL,PPIIN)	; ...
+	SEX	SP		; ...
+	LBR	MAIN		; ...
+
+; Send an ACK (or the NAK at P1) ...
+PAROK:	RLDI(P1,PARTAB)		; ...
+PARRP1:	RLDI(P2,1)		; ...
+PARRP2:	CALL(PARSND)		; ...
+	BR	PARLP		; ...
+
+; Here's what the replies come from ...
+PARTAB:	.DB	PARACK, MONVER, PARNAK
+
+;   Read P2 bytes from port A into memory at P1.  Port C is selected while we
+; wait for IBF, and port A while we read the byte, and the INP stores it right
+; into memory.  That's 28 machine cycles a byte, and a BREAK on the console
+; is only checked when we have to wait ...
+PARRCV:	GLO	P2		; is there anything to read?
+	BNZ	PARRC1		; ...
+	GHI	P2		; ...
+	BZ	PARRC9		; no
+PARRC1:	SEX	PC		; select port C
+	OUT	GPIO		; ...
+	.DB	PPIPC		; ...
+	SEX	SP		; ...
+PARRC2:	INP	PPI		; has the host sent a byte?
+	ANI	PPIIBF		; ...
+	BZ	PARRC3		; not yet
+	SEX	PC		; yes - select port A
+	OUT	GPIO		; ...
+	.DB	PPIPA		; ...
+	SEX	P1		; and read it into memory
+	INP	PPI		; ...
+	INC	P1		; ...
+	DEC	P2		; count the bytes
+	GLO	P2		; ...
+	BNZ	PARRC1		; ...
+	GHI	P2		; ...
+	BNZ	PARRC1		; ...
+PARRC9:	SEX	SP		; ...
+	RETURN			; ...
+PARRC3:	CALL(F_BRKTEST)		; BREAK?
+	LBDF	PARBRK		; yes - give up
+	BR	PARRC2		; no - keep waiting
+
+;   Send P2 bytes from memory at P1 to port A.  OUT increments P1 for us, and
+; after each byte we wait for the host to take it (OBF to go high), so OBF
+; is always high when we get here and the host has everything when we
+; return.  That's 26 machine cycles a byte ...
+PARSND:	GLO	P2		; is there anything to send?
+	BNZ	PARSN1		; ...
+	GHI	P2		; ...
+	BZ	PARSN9		; no
+PARSN1:	SEX	PC		; select port A
+	OUT	GPIO		; ...
+	.DB	PPIPA		; ...
+	SEX	P1		; and send the next byte
+	OUT	PPI		; ...
+	SEX	PC		; then select port C
+	OUT	GPIO		; ...
+	.DB	PPIPC		; ...
+	SEX	SP		; ...
+PARSN2:	INP	PPI		; and wait for OBF
+	SHL			; ...
+	BNF	PARSN3		; ...
+	DEC	P2		; count the bytes
+	GLO	P2		; ...
+	BNZ	PARSN1		; ...
+	GHI	P2		; ...
+	BNZ	PARSN1		; ...
+PARSN9:	RETURN			; ...
+PARSN3:	CALL(F_BRKTEST)		; BREAK?
+	LBDF	PARBRK		; yes - give up
+	BR	PARSN2		; no - keep waiting
+
+NOPMSG:	.TEXT	"?NO PPI\r\n\000"
+
+#if ($ > MONX16TOP)
+	.ECHO	"**** ERROR **** Monitor extensions overflow at MONEXT16!"
+#endif
+#endif
+
 	.EJECT
 	.END
 
@@ -0,0 +1,520 @@
+//++
+//cosmac.cpp - RCA CDP1802 COSMAC microprocessor emulation
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   This module implements the CCOSMAC class, which emulates the CDP1802 CPU.
+// See cosmac.hpp for the gory details.  The interesting part is the Run()
+// method, which is a threaded interpreter that dispatches each opcode thru a
+// table of GCC "labels as values".  If you're using a compiler that doesn't
+// support that extension, define NO_THREADED and Run() will fall back to a
+// plain old switch statement.  It's slower, but it gives the same answers.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+// 17-Oct-26    RLA     Add InterruptAcknowledge() and GetInterruptCycles().
+// 17-Oct-26    RLA     Add the CDP1805 register instructions.
+//--
+#include <stdio.h>		// sprintf(), et al ...
+#include <string.h>		// memset() ...
+#include <string>		// C++ std::string class
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "cosmac.hpp"		// declarations for this module
+
+#if !defined(__GNUC__) && !defined(NO_THREADED)
+#define NO_THREADED
+#endif
+
+// Non-existent memory reads as all ones, and writes to it go nowhere ...
+BYTE CCOSMAC::m_abNXM[CCOSMAC::PAGE_SIZE];
+BYTE CCOSMAC::m_abSink[CCOSMAC::PAGE_SIZE];
+
+
+CCOSMAC::CCOSMAC (CBus *pBus)
+{
+  //++
+  //   The constructor initializes the memory map so that everything is
+  // non-existent memory.  The system should call MapPage() to install real
+  // memory and then Reset() before calling Run().
+  //--
+  m_pBus = pBus;  m_pafBreak = NULL;  m_fCDP1805 = false;
+  memset(m_abNXM, 0xFF, sizeof(m_abNXM));
+  for (unsigned i = 0;  i < NPAGES;  ++i)  MapPage(i, m_abNXM, m_abSink);
+  m_qCycles = m_qInstructions = 0;
+  m_qInterruptStart = m_qInterruptCycles = 0;
+  memset(m_awR, 0, sizeof(m_awR));
+  m_bD = m_bT = 0;  m_fDF = false;
+  Reset();
+}
+
+
+void CCOSMAC::Reset()
+{
+  //++
+  //   A hardware reset on the 1802 clears I, N (which we don't care about),
+  // Q, X, P and R0 and sets IE.  D, DF, T and all the other registers are
+  // unchanged.  Note that the reset doesn't clear our cycle counter ...
+  //--
+  m_bX = m_bP = 0;  m_awR[0] = 0;
+  m_fQ = false;  m_fIE = true;  m_fIRQ = false;
+  m_fIdle = m_fStop = m_fBreak = m_fInterrupt = false;
+  m_pBus->SetQ(false);
+}
+
+
+BYTE CCOSMAC::DMAOut()
+{
+  //++
+  // Do one DMA output cycle (M(R0) -> bus, R0 += 1) and return the data ...
+  //--
+  BYTE bData = ReadMemory(m_awR[0]++);
+  m_fIdle = false;  ++m_qCycles;
+  // (cycles stolen by DMA don't count as interrupt time!)
+  if (m_fInterrupt) ++m_qInterruptStart;
+  return bData;
+}
+
+
+void CCOSMAC::DMAIn (BYTE bData)
+{
+  //++
+  // Do one DMA input cycle (bus -> M(R0), R0 += 1) ...
+  //--
+  WriteMemory(m_awR[0]++, bData);
+  m_fIdle = false;  ++m_qCycles;
+  if (m_fInterrupt) ++m_qInterruptStart;
+}
+
+
+void CCOSMAC::Run (QUAD qLimit)
+{
+  //++
+  //   Execute instructions until the cycle counter reaches qLimit, until some
+  // I/O routine calls Stop(), or until we hit a breakpoint.  Note that the
+  // cycle limit is checked only at the end of an instruction, so we may over
+  // shoot by up to three cycles.  The system's event scheduling allows for
+  // that.
+  //
+  //   The registers that are used by every instruction are kept in local
+  // variables while we're in here, and the threaded dispatch is done by the
+  // NEXT() macro at the end of each handler...
+  //--
+  WORD *R = m_awR;
+  BYTE  P = m_bP, X = m_bX, D = m_bD, N, bOp;
+  unsigned DF = m_fDF ? 1 : 0;
+  QUAD  qCycles = m_qCycles, qInstructions = m_qInstructions;
+  unsigned nTemp;  WORD wTemp;
+  m_fStop = m_fBreak = false;
+
+  // Memory access, always thru the page map ...
+#define RD(a)		(m_apbRead[HIBYTE(a)][LOBYTE(a)])
+#define WR(a,d)		(m_apbWrite[HIBYTE(a)][LOBYTE(a)] = (d))
+#define FETCH()		(wTemp = R[P]++, RD(wTemp))
+  //   Short branch - replace the low byte of the PC with the next byte; long
+  // branch - replace the whole PC with the next two bytes ...
+#define SBRANCH(c)	{if (c) {R[P] = (R[P] & 0xFF00) | RD(R[P]);} else ++R[P];}
+#define LBRANCH(c)	{if (c) {wTemp = MKWORD(RD(R[P]), RD((WORD) (R[P]+1)));  R[P] = wTemp;} \
+			 else R[P] += 2;}
+#define LSKIP(c)	{if (c) R[P] += 2;}
+  // Arithmetic - all of these set D and DF ...
+#define ADDC(a,b,c)	{nTemp = (a) + (b) + (c);  D = LOBYTE(nTemp);  DF = nTemp >> 8;}
+#define SUBB(a,b,c)	{nTemp = (a) + ((b) ^ 0xFF) + (c);  D = LOBYTE(nTemp);  DF = nTemp >> 8;}
+
+  //   Interrupts are checked at the end of every instruction (as long as IE is
+  // set), and the cycle limit is checked every time as well.  If there's a
+  // breakpoint table then we need to check the new PC against that too, and
+  // that comes first so that a breakpoint is never missed just because the
+  // cycle limit happened to expire on the same instruction...
+#define CHECK()		{ if (m_pafBreak != NULL && m_pafBreak[R[P]]) goto brkpt; \
+			  if (qCycles >= qLimit || m_fStop) goto done;		\
+			  if (m_fIRQ && m_fIE) goto interrupt; }
+#ifndef NO_THREADED
+#define OP(x)		x
+#define NEXT(n)		{ qCycles += (n);  ++qInstructions;  CHECK();		\
+			  bOp = FETCH();  N = bOp & 0xF;  goto *apDispatch[bOp]; }
+#else
+#define OP(x)		case_##x
+#define NEXT(n)		{ qCycles += (n);  ++qInstructions;  goto next; }
+#endif
+
+#ifndef NO_THREADED
+  //   This is the dispatch table, and it's the reason why the threaded code
+  // is fast - it maps each opcode directly to the code that executes it...
+  static const void *const apDispatch[256] = {
+    // 0x (IDL and LDN) ...
+    &&IDL, &&LDN, &&LDN, &&LDN, &&LDN, &&LDN, &&LDN, &&LDN,
+    &&LDN, &&LDN, &&LDN, &&LDN, &&LDN, &&LDN, &&LDN, &&LDN,
+    // 1x INC, 2x DEC ...
+    &&INC, &&INC, &&INC, &&INC, &&INC, &&INC, &&INC, &&INC,
+    &&INC, &&INC, &&INC, &&INC, &&INC, &&INC, &&INC, &&INC,
+    &&DEC, &&DEC, &&DEC, &&DEC, &&DEC, &&DEC, &&DEC, &&DEC,
+    &&DEC, &&DEC, &&DEC, &&DEC, &&DEC, &&DEC, &&DEC, &&DEC,
+    // 3x short branches ...
+    &&BR,  &&BQ,  &&BZ,  &&BDF, &&BEF, &&BEF, &&BEF, &&BEF,
+    &&SKP, &&BNQ, &&BNZ, &&BNF, &&BNEF,&&BNEF,&&BNEF,&&BNEF,
+    // 4x LDA, 5x STR ...
+    &&LDA, &&LDA, &&LDA, &&LDA, &&LDA, &&LDA, &&LDA, &&LDA,
+    &&LDA, &&LDA, &&LDA, &&LDA, &&LDA, &&LDA, &&LDA, &&LDA,
+    &&STR, &&STR, &&STR, &&STR, &&STR, &&STR, &&STR, &&STR,
+    &&STR, &&STR, &&STR, &&STR, &&STR, &&STR, &&STR, &&STR,
+    // 6x IRX, OUT, (68) and INP ...
+    &&IRX, &&OUT, &&OUT, &&OUT, &&OUT, &&OUT, &&OUT, &&OUT,
+    &&X68, &&INP, &&INP, &&INP, &&INP, &&INP, &&INP, &&INP,
+    // 7x miscellaneous ...
+    &&RET, &&DIS, &&LDXA,&&STXD,&&ADC, &&SDB, &&SHRC,&&SMB,
+    &&SAV, &&MARK,&&REQ, &&SEQ, &&ADCI,&&SDBI,&&SHLC,&&SMBI,
+    // 8x GLO, 9x GHI, Ax PLO, Bx PHI ...
+    &&GLO, &&GLO, &&GLO, &&GLO, &&GLO, &&GLO, &&GLO, &&GLO,
+    &&GLO, &&GLO, &&GLO, &&GLO, &&GLO, &&GLO, &&GLO, &&GLO,
+    &&GHI, &&GHI, &&GHI, &&GHI, &&GHI, &&GHI, &&GHI, &&GHI,
+    &&GHI, &&GHI, &&GHI, &&GHI, &&GHI, &&GHI, &&GHI, &&GHI,
+    &&PLO, &&PLO, &&PLO, &&PLO, &&PLO, &&PLO, &&PLO, &&PLO,
+    &&PLO, &&PLO, &&PLO, &&PLO, &&PLO, &&PLO, &&PLO, &&PLO,
+    &&PHI, &&PHI, &&PHI, &&PHI, &&PHI, &&PHI, &&PHI, &&PHI,
+    &&PHI, &&PHI, &&PHI, &&PHI, &&PHI, &&PHI, &&PHI, &&PHI,
+    // Cx long branches and skips ...
+    &&LBR, &&LBQ, &&LBZ, &&LBDF,&&NOP, &&LSNQ,&&LSNZ,&&LSNF,
+    &&LSKP,&&LBNQ,&&LBNZ,&&LBNF,&&LSIE,&&LSQ, &&LSZ, &&LSDF,
+    // Dx SEP, Ex SEX ...
+    &&SEP, &&SEP, &&SEP, &&SEP, &&SEP, &&SEP, &&SEP, &&SEP,
+    &&SEP, &&SEP, &&SEP, &&SEP, &&SEP, &&SEP, &&SEP, &&SEP,
+    &&SEX, &&SEX, &&SEX, &&SEX, &&SEX, &&SEX, &&SEX, &&SEX,
+    &&SEX, &&SEX, &&SEX, &&SEX, &&SEX, &&SEX, &&SEX, &&SEX,
+    // Fx memory reference and ALU ...
+    &&LDX, &&OR,  &&AND, &&XOR, &&ADD, &&SD,  &&SHR, &&SM,
+    &&LDI, &&ORI, &&ANI, &&XRI, &&ADI, &&SDI, &&SHL, &&SMI
+  };
+#endif
+
+  // If we're idle, then just burn cycles until an interrupt comes along ...
+  if (m_fIdle) {
+    if (m_fIRQ && m_fIE) goto interrupt;
+    if (qCycles < qLimit) qCycles = qLimit;
+    goto done;
+  }
+
+  //   Start the ball rolling.  Note that we don't check for a breakpoint on
+  // the first instruction - otherwise we could never continue from one!
+  if (qCycles >= qLimit) goto done;
+  if (m_fIRQ && m_fIE) goto interrupt;
+#ifndef NO_THREADED
+  bOp = FETCH();  N = bOp & 0xF;  goto *apDispatch[bOp];
+#else
+  goto first;
+next:
+  CHECK();
+first:
+  bOp = FETCH();  N = bOp & 0xF;
+  switch (bOp >> 4) {
+    case 0x0: if (N == 0) goto case_IDL;  goto case_LDN;
+    case 0x1: goto case_INC;
+    case 0x2: goto case_DEC;
+    case 0x3:
+      switch (N) {
+	case 0x0: goto case_BR;    case 0x1: goto case_BQ;
+	case 0x2: goto case_BZ;    case 0x3: goto case_BDF;
+	case 0x8: goto case_SKP;   case 0x9: goto case_BNQ;
+	case 0xA: goto case_BNZ;   case 0xB: goto case_BNF;
+	default:  if (N < 8) goto case_BEF;  goto case_BNEF;
+      }
+    case 0x4: goto case_LDA;
+    case 0x5: goto case_STR;
+    case 0x6: if (N == 0) goto case_IRX;  if (N == 8) goto case_X68;
+	      if (N < 8) goto case_OUT;  goto case_INP;
+    case 0x7:
+      switch (N) {
+	case 0x0: goto case_RET;   case 0x1: goto case_DIS;
+	case 0x2: goto case_LDXA;  case 0x3: goto case_STXD;
+	case 0x4: goto case_ADC;   case 0x5: goto case_SDB;
+	case 0x6: goto case_SHRC;  case 0x7: goto case_SMB;
+	case 0x8: goto case_SAV;   case 0x9: goto case_MARK;
+	case 0xA: goto case_REQ;   case 0xB: goto case_SEQ;
+	case 0xC: goto case_ADCI;  case 0xD: goto case_SDBI;
+	case 0xE: goto case_SHLC;  default:  goto case_SMBI;
+      }
+    case 0x8: goto case_GLO;
+    case 0x9: goto case_GHI;
+    case 0xA: goto case_PLO;
+    case 0xB: goto case_PHI;
+    case 0xC:
+      switch (N) {
+	case 0x0: goto case_LBR;   case 0x1: goto case_LBQ;
+	case 0x2: goto case_LBZ;   case 0x3: goto case_LBDF;
+	case 0x4: goto case_NOP;   case 0x5: goto case_LSNQ;
+	case 0x6: goto case_LSNZ;  case 0x7: goto case_LSNF;
+	case 0x8: goto case_LSKP;  case 0x9: goto case_LBNQ;
+	case 0xA: goto case_LBNZ;  case 0xB: goto case_LBNF;
+	case 0xC: goto case_LSIE;  case 0xD: goto case_LSQ;
+	case 0xE: goto case_LSZ;   default:  goto case_LSDF;
+      }
+    case 0xD: goto case_SEP;
+    case 0xE: goto case_SEX;
+    default:
+      switch (N) {
+	case 0x0: goto case_LDX;   case 0x1: goto case_OR;
+	case 0x2: goto case_AND;   case 0x3: goto case_XOR;
+	case 0x4: goto case_ADD;   case 0x5: goto case_SD;
+	case 0x6: goto case_SHR;   case 0x7: goto case_SM;
+	case 0x8: goto case_LDI;   case 0x9: goto case_ORI;
+	case 0xA: goto case_ANI;   case 0xB: goto case_XRI;
+	case 0xC: goto case_ADI;   case 0xD: goto case_SDI;
+	case 0xE: goto case_SHL;   default:  goto case_SMI;
+      }
+  }
+#endif
+
+  // 0x - IDL and LDN ...
+OP(IDL):
+  //   IDL stops the CPU until a DMA or interrupt request comes along.  Since
+  // nothing can happen until the next event, skip right ahead to that ...
+  m_fIdle = true;  qCycles += 2;  ++qInstructions;
+  if (m_fIRQ && m_fIE) goto interrupt;
+  if (qCycles < qLimit) qCycles = qLimit;
+  goto done;
+OP(LDN):  D = RD(R[N]);				NEXT(2);
+
+  // 1x, 2x - INC and DEC ...
+OP(INC):  ++R[N];				NEXT(2);
+OP(DEC):  --R[N];				NEXT(2);
+
+  // 3x - short branches ...
+OP(BR):   SBRANCH(true);			NEXT(2);
+OP(BQ):   SBRANCH(m_fQ);			NEXT(2);
+OP(BZ):   SBRANCH(D == 0);			NEXT(2);
+OP(BDF):  SBRANCH(DF != 0);			NEXT(2);
+OP(BEF):  SBRANCH(m_pBus->GetEF((N & 3) + 1));	NEXT(2);
+OP(SKP):  ++R[P];				NEXT(2);
+OP(BNQ):  SBRANCH(!m_fQ);			NEXT(2);
+OP(BNZ):  SBRANCH(D != 0);			NEXT(2);
+OP(BNF):  SBRANCH(DF == 0);			NEXT(2);
+OP(BNEF): SBRANCH(!m_pBus->GetEF((N & 3) + 1)); NEXT(2);
+
+  // 4x, 5x - LDA and STR ...
+OP(LDA):  D = RD(R[N]);  ++R[N];		NEXT(2);
+OP(STR):  WR(R[N], D);				NEXT(2);
+
+  //   6x - IRX and I/O instructions.  Note that the I/O routines might call
+  // Stop(), schedule an event, or change the interrupt request, so we have
+  // to save our state before calling them ...
+OP(IRX):  ++R[X];				NEXT(2);
+OP(OUT):
+  m_bP = P;  m_bX = X;  m_bD = D;  m_fDF = DF;  m_qCycles = qCycles;
+  m_pBus->Output(N, RD(R[X]));  ++R[X];
+  NEXT(2);
+OP(X68):
+  //   On the 1802, 0x68 is an unused opcode and it's a no-op.  The 1804/5/6
+  // use it as the prefix for their extended instructions, and the second byte
+  // is decoded here.  Only the register instructions are implemented - the
+  // counter branches (BCI, BXI) are never taken and everything else in this
+  // page is a no-op.  The cycle counts include the fetch of the prefix ...
+  if (!m_fCDP1805) NEXT(2);
+  bOp = FETCH();  N = bOp & 0xF;
+  switch (bOp >> 4) {
+    case 0x2:				// DBNZ - decrement and long branch
+      --R[N];  LBRANCH(R[N] != 0);	NEXT(5);
+    case 0x3:				// BCI, BXI - counter branches
+      if (N >= 0xE) {++R[P];}		NEXT(3);
+    case 0x6:				// RLXA - load register via X and advance
+      wTemp = MKWORD(RD(R[X]), RD((WORD) (R[X]+1)));
+      R[X] += 2;  R[N] = wTemp;		NEXT(5);
+    case 0x8:				// SCAL - standard call
+      WR(R[X], LOBYTE(R[N]));  --R[X];
+      WR(R[X], HIBYTE(R[N]));  --R[X];
+      R[N] = R[P];  wTemp = MKWORD(RD(R[N]), RD((WORD) (R[N]+1)));
+      R[N] += 2;  R[P] = wTemp;		NEXT(10);
+    case 0x9:				// SRET - standard return
+      R[P] = R[N];  ++R[X];  nTemp = RD(R[X]);
+      ++R[X];  R[N] = MKWORD(nTemp, RD(R[X]));	NEXT(8);
+    case 0xA:				// RSXD - store register via X and decrement
+      WR(R[X], LOBYTE(R[N]));  --R[X];
+      WR(R[X], HIBYTE(R[N]));  --R[X];	NEXT(5);
+    case 0xB:				// RNX - copy register N to register X
+      R[X] = R[N];			NEXT(4);
+    case 0xC:				// RLDI - register load immediate
+      wTemp = MKWORD(RD(R[P]), RD((WORD) (R[P]+1)));
+      R[P] += 2;  R[N] = wTemp;		NEXT(5);
+    default:				NEXT(3);
+  }
+OP(INP):
+  m_bP = P;  m_bX = X;  m_bD = D;  m_fDF = DF;  m_qCycles = qCycles;
+  D = m_pBus->Input(N & 7);  WR(R[X], D);
+  NEXT(2);
+
+  // 7x - miscellaneous ...
+  //   RET and DIS with P=1 are the end of an interrupt service routine, so
+  // that's when we add up the time spent there ...
+OP(RET):  if (m_fInterrupt && (P == 1)) {
+	    m_qInterruptCycles += qCycles + 2 - m_qInterruptStart;  m_fInterrupt = false;
+	  }
+	  nTemp = RD(R[X]);  ++R[X];  X = nTemp >> 4;  P = nTemp & 0xF;
+	  m_fIE = true;				NEXT(2);
+OP(DIS):  if (m_fInterrupt && (P == 1)) {
+	    m_qInterruptCycles += qCycles + 2 - m_qInterruptStart;  m_fInterrupt = false;
+	  }
+	  nTemp = RD(R[X]);  ++R[X];  X = nTemp >> 4;  P = nTemp & 0xF;
+	  m_fIE = false;			NEXT(2);
+OP(LDXA): D = RD(R[X]);  ++R[X];		NEXT(2);
+OP(STXD): WR(R[X], D);  --R[X];			NEXT(2);
+OP(ADC):  ADDC(D, RD(R[X]), DF);		NEXT(2);
+OP(SDB):  SUBB(RD(R[X]), D, DF);		NEXT(2);
+OP(SHRC): nTemp = D & 1;  D = (D >> 1) | (DF << 7);  DF = nTemp;  NEXT(2);
+OP(SMB):  SUBB(D, RD(R[X]), DF);		NEXT(2);
+OP(SAV):  WR(R[X], m_bT);			NEXT(2);
+OP(MARK): m_bT = (X << 4) | P;  WR(R[2], m_bT);  X = P;  --R[2];  NEXT(2);
+OP(REQ):  m_fQ = false;  m_pBus->SetQ(false);	NEXT(2);
+OP(SEQ):  m_fQ = true;   m_pBus->SetQ(true);	NEXT(2);
+OP(ADCI): ADDC(D, RD(R[P]), DF);  ++R[P];	NEXT(2);
+OP(SDBI): SUBB(RD(R[P]), D, DF);  ++R[P];	NEXT(2);
+OP(SHLC): nTemp = D >> 7;  D = (D << 1) | DF;  DF = nTemp;  NEXT(2);
+OP(SMBI): SUBB(D, RD(R[P]), DF);  ++R[P];	NEXT(2);
+
+  // 8x .. Bx - register transfers ...
+OP(GLO):  D = LOBYTE(R[N]);			NEXT(2);
+OP(GHI):  D = HIBYTE(R[N]);			NEXT(2);
+OP(PLO):  R[N] = (R[N] & 0xFF00) | D;		NEXT(2);
+OP(PHI):  R[N] = (R[N] & 0x00FF) | (D << 8);	NEXT(2);
+
+  // Cx - long branches and skips (all three cycles, even NOP) ...
+OP(LBR):  LBRANCH(true);			NEXT(3);
+OP(LBQ):  LBRANCH(m_fQ);			NEXT(3);
+OP(LBZ):  LBRANCH(D == 0);			NEXT(3);
+OP(LBDF): LBRANCH(DF != 0);			NEXT(3);
+OP(NOP):					NEXT(3);
+OP(LSNQ): LSKIP(!m_fQ);				NEXT(3);
+OP(LSNZ): LSKIP(D != 0);			NEXT(3);
+OP(LSNF): LSKIP(DF == 0);			NEXT(3);
+OP(LSKP): R[P] += 2;				NEXT(3);
+OP(LBNQ): LBRANCH(!m_fQ);			NEXT(3);
+OP(LBNZ): LBRANCH(D != 0);			NEXT(3);
+OP(LBNF): LBRANCH(DF == 0);			NEXT(3);
+OP(LSIE): LSKIP(m_fIE);				NEXT(3);
+OP(LSQ):  LSKIP(m_fQ);				NEXT(3);
+OP(LSZ):  LSKIP(D == 0);			NEXT(3);
+OP(LSDF): LSKIP(DF != 0);			NEXT(3);
+
+  // Dx, Ex - SEP and SEX ...
+OP(SEP):  P = N;				NEXT(2);
+OP(SEX):  X = N;				NEXT(2);
+
+  // Fx - memory reference and ALU ...
+OP(LDX):  D = RD(R[X]);				NEXT(2);
+OP(OR):   D |= RD(R[X]);			NEXT(2);
+OP(AND):  D &= RD(R[X]);			NEXT(2);
+OP(XOR):  D ^= RD(R[X]);			NEXT(2);
+OP(ADD):  ADDC(D, RD(R[X]), 0);			NEXT(2);
+OP(SD):   SUBB(RD(R[X]), D, 1);			NEXT(2);
+OP(SHR):  DF = D & 1;  D >>= 1;			NEXT(2);
+OP(SM):   SUBB(D, RD(R[X]), 1);			NEXT(2);
+OP(LDI):  D = RD(R[P]);  ++R[P];		NEXT(2);
+OP(ORI):  D |= RD(R[P]);  ++R[P];		NEXT(2);
+OP(ANI):  D &= RD(R[P]);  ++R[P];		NEXT(2);
+OP(XRI):  D ^= RD(R[P]);  ++R[P];		NEXT(2);
+OP(ADI):  ADDC(D, RD(R[P]), 0);  ++R[P];	NEXT(2);
+OP(SDI):  SUBB(RD(R[P]), D, 1);  ++R[P];	NEXT(2);
+OP(SHL):  DF = D >> 7;  D <<= 1;		NEXT(2);
+OP(SMI):  SUBB(D, RD(R[P]), 1);  ++R[P];	NEXT(2);
+
+  // Here to take an interrupt, and then keep going ...
+interrupt:
+  m_bT = (X << 4) | P;  P = 1;  X = 2;
+  m_fIE = m_fIdle = false;
+  m_fInterrupt = true;  m_qInterruptStart = qCycles++;
+  m_pBus->InterruptAcknowledge();
+  if (qCycles >= qLimit || m_fStop) goto done;
+#ifndef NO_THREADED
+  bOp = FETCH();  N = bOp & 0xF;  goto *apDispatch[bOp];
+#else
+  goto next;
+#endif
+
+  // Here for a breakpoint - the PC points to the instruction NOT executed ...
+brkpt:
+  m_fBreak = true;
+
+  // Here when it's time to stop - save the state and return ...
+done:
+  m_bP = P;  m_bX = X;  m_bD = D;  m_fDF = (DF != 0);
+  m_qCycles = qCycles;  m_qInstructions = qInstructions;
+#undef RD
+#undef WR
+#undef FETCH
+}
+
+
+unsigned CCOSMAC::Disassemble (WORD wAddress, const BYTE abCode[3], std::string &sCode)
+{
+  //++
+  //   Disassemble one 1802 instruction and return its length in bytes.  The
+  // caller must pass three bytes of code (whether they're all needed or not).
+  // This is only used for tracing, so the output is simple and unadorned...
+  //--
+  static const char *const apszLow[16] = {	// 7x and Fx (ALU) opcodes
+    "RET", "DIS", "LDXA","STXD","ADC", "SDB", "SHRC","SMB",
+    "SAV", "MARK","REQ", "SEQ", "ADCI","SDBI","SHLC","SMBI"};
+  static const char *const apszF[16] = {
+    "LDX", "OR",  "AND", "XOR", "ADD", "SD",  "SHR", "SM",
+    "LDI", "ORI", "ANI", "XRI", "ADI", "SDI", "SHL", "SMI"};
+  static const char *const apszBr[16] = {	// 3x and Cx opcodes
+    "BR",  "BQ",  "BZ",  "BDF", "B1",  "B2",  "B3",  "B4",
+    "SKP", "BNQ", "BNZ", "BNF", "BN1", "BN2", "BN3", "BN4"};
+  static const char *const apszLB[16] = {
+    "LBR", "LBQ", "LBZ", "LBDF","NOP", "LSNQ","LSNZ","LSNF",
+    "LSKP","LBNQ","LBNZ","LBNF","LSIE","LSQ", "LSZ", "LSDF"};
+  static const char *const apszReg[16] = {	// register opcodes
+    "LDN", "INC", "DEC", NULL,  "LDA", "STR", NULL,  NULL,
+    "GLO", "GHI", "PLO", "PHI", NULL,  "SEP", "SEX", NULL};
+  char sz[32];  BYTE bOp = abCode[0];  unsigned n = bOp & 0xF, nLength = 1;
+
+  if (bOp == 0x00)
+    sprintf(sz, "IDL");
+  else if (apszReg[bOp >> 4] != NULL)
+    sprintf(sz, "%-5s%X", apszReg[bOp >> 4], n);
+  else if ((bOp >> 4) == 0x3) {
+    if (n == 0x8)
+      sprintf(sz, "SKP");
+    else {
+      sprintf(sz, "%-5s%04X", apszBr[n], ((wAddress+1) & 0xFF00) | abCode[1]);
+      nLength = 2;
+    }
+  } else if ((bOp >> 4) == 0x6) {
+    if (n == 0)       sprintf(sz, "IRX");
+    else if (n == 8)  sprintf(sz, ".DB  $68");	// 1805 opcodes aren't decoded
+    else if (n < 8)   sprintf(sz, "OUT  %d", n);
+    else              sprintf(sz, "INP  %d", n-8);
+  } else if ((bOp >> 4) == 0x7) {
+    if ((n == 0xC) || (n == 0xD) || (n == 0xF)) {
+      sprintf(sz, "%-5s$%02X", apszLow[n], abCode[1]);  nLength = 2;
+    } else
+      sprintf(sz, "%s", apszLow[n]);
+  } else if ((bOp >> 4) == 0xC) {
+    //   C0..C3 and C9..CB are three byte long branches; all the rest are one
+    // byte skips (and NOP) ...
+    if (((0x0E0F >> n) & 1) != 0) {
+      sprintf(sz, "%-5s%02X%02X", apszLB[n], abCode[1], abCode[2]);  nLength = 3;
+    } else
+      sprintf(sz, "%s", apszLB[n]);
+  } else {
+    if (n >= 8 && n != 0xE) {
+      sprintf(sz, "%-5s$%02X", apszF[n], abCode[1]);  nLength = 2;
+    } else
+      sprintf(sz, "%s", apszF[n]);
+  }
+  sCode = sz;
+  return nLength;
+}
@@ -0,0 +1,185 @@
+//++
+//cosmac.hpp - RCA CDP1802 COSMAC microprocessor emulation
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   The CCOSMAC class is an instruction level emulation of the CDP1802 CPU.
+// It knows nothing about the system it lives in - memory is accessed thru a
+// table of 256 page pointers (so that EPROM, RAM and unused address space
+// can be mapped any way the system likes), and I/O, EF inputs, Q and the
+// interrupt request are passed thru the CCOSMAC::CBus interface.
+//
+//   The emulator counts machine cycles exactly - every 1802 instruction takes
+// two machine cycles (16 clocks), except for the long branch and long skip
+// instructions which take three.  DMA and interrupt acknowledge cycles are
+// added when they occur.  Time is measured in machine cycles everywhere and
+// the system converts that to real time using the CPU clock frequency (a
+// machine cycle is eight clocks).
+//
+//   For speed, Run() is a "threaded" interpreter - each opcode handler ends by
+// fetching the next opcode and jumping directly to its handler thru a table of
+// label addresses (a GCC extension).  The only checks made between instructions
+// are for the cycle limit and for a pending interrupt.  Anything else that has
+// to happen at a particular time (e.g. the RTC ticking, or a UART character
+// arriving) is handled by the system scheduling an "event", which simply sets
+// the cycle limit passed to Run().
+//
+//   SetCDP1805() turns on the CDP1804/5/6 register instructions behind the 68
+// prefix - RLDI, RLXA, RSXD, RNX, SCAL, SRET and DBNZ - with their real cycle
+// counts.  The counter/timer, the decimal arithmetic and the extra interrupt
+// controls aren't implemented, so the rest of the 68 page are no-ops and the
+// counter branches are never taken.  Without it 68 is the 1802's unused
+// opcode, which is also a no-op.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+// 17-Oct-26    RLA     Add InterruptAcknowledge() and GetInterruptCycles().
+// 17-Oct-26    RLA     Add SetCDP1805() (the 1804/5/6 register instructions).
+//--
+#ifndef _cosmac_hpp_
+#define _cosmac_hpp_
+#include <stddef.h>		// NULL, size_t, ...
+#include <string>		// C++ std::string class
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+
+class CCOSMAC {
+  //++
+  // Public constants ...
+  //--
+public:
+  enum {
+    NREGS      = 16,		// number of 16 bit scratchpad registers
+    NEFS       = 4,		// number of EF inputs (EF1 .. EF4)
+    PAGE_SIZE  = 256,		// bytes per page in the memory map
+    NPAGES     = 65536/PAGE_SIZE,// number of pages in the address space
+    CLOCKS_PER_CYCLE = 8	// clock periods per machine cycle
+  };
+
+  //++
+  //   The CBus class is the interface between the CPU and the rest of the
+  // system.  The system implements these methods to do I/O, EF sensing, etc.
+  // Note that the memory is NOT accessed thru here (see MapPage() instead).
+  //--
+public:
+  class CBus {
+  public:
+    virtual ~CBus() {};
+    // Input (INP n) and output (OUT n) instructions, n = 1..7 ...
+    virtual BYTE Input (unsigned nPort) = 0;
+    virtual void Output (unsigned nPort, BYTE bData) = 0;
+    // Sense EF1 .. EF4 (true means the B1..B4 branch is taken) ...
+    virtual bool GetEF (unsigned nEF) = 0;
+    // Q output has changed ...
+    virtual void SetQ (bool fQ) {UNUSED(fQ);}
+    // Interrupt acknowledge (S3) cycle ...
+    virtual void InterruptAcknowledge() {}
+  };
+
+  // Constructor and destructor ...
+public:
+  CCOSMAC (CBus *pBus);
+  virtual ~CCOSMAC() {};
+private:
+  // Disallow copy and assignments!
+  CCOSMAC (const CCOSMAC &) = delete;
+  CCOSMAC& operator= (const CCOSMAC &) = delete;
+
+  // Public CPU methods ...
+public:
+  // Reset the CPU (X=P=Q=R0=0, IE=1) ...
+  void Reset();
+  //   Map a page of memory for reading and/or writing.  NULL means that the
+  // page reads as non-existent memory, or that writes are ignored ...
+  void MapPage (unsigned nPage, BYTE *pbRead, BYTE *pbWrite)
+    { m_apbRead[nPage]  = (pbRead  != NULL) ? pbRead  : m_abNXM;
+      m_apbWrite[nPage] = (pbWrite != NULL) ? pbWrite : m_abSink; }
+  // Read or write memory exactly as the CPU sees it ...
+  BYTE ReadMemory (WORD wAddress) const
+    {return m_apbRead[HIBYTE(wAddress)][LOBYTE(wAddress)];}
+  void WriteMemory (WORD wAddress, BYTE bData)
+    {m_apbWrite[HIBYTE(wAddress)][LOBYTE(wAddress)] = bData;}
+  // Run until the cycle counter reaches qLimit, a stop or a breakpoint ...
+  void Run (QUAD qLimit);
+  // Request Run() to return at the end of the current instruction ...
+  void Stop() {m_fStop = true;}
+  // Interrupt request input (level sensitive, just like the real thing) ...
+  void SetIRQ (bool fIRQ) {m_fIRQ = fIRQ;}
+  // Execute one DMA IN or DMA OUT cycle ...
+  BYTE DMAOut();
+  void DMAIn (BYTE bData);
+  // Enable or disable the per instruction breakpoint test ...
+  void SetBreakpoints (const bool *pafBreak) {m_pafBreak = pafBreak;}
+  bool IsBreak() const {return m_fBreak;}
+  // Emulate a CDP1805 instead of a CDP1802 ...
+  void SetCDP1805 (bool fCDP1805) {m_fCDP1805 = fCDP1805;}
+  bool IsCDP1805() const {return m_fCDP1805;}
+  // Disassemble one instruction (returns the instruction length) ...
+  static unsigned Disassemble (WORD wAddress, const BYTE abCode[3], std::string &sCode);
+
+  // CPU register access ...
+public:
+  WORD GetReg (unsigned n) const {return m_awR[n & 0xF];}
+  void SetReg (unsigned n, WORD w) {m_awR[n & 0xF] = w;}
+  BYTE GetP()  const {return m_bP;}
+  BYTE GetX()  const {return m_bX;}
+  BYTE GetD()  const {return m_bD;}
+  BYTE GetT()  const {return m_bT;}
+  bool GetDF() const {return m_fDF;}
+  bool GetQ()  const {return m_fQ;}
+  bool GetIE() const {return m_fIE;}
+  bool IsIdle() const {return m_fIdle;}
+  WORD GetPC() const {return m_awR[m_bP];}
+  void SetP (BYTE b) {m_bP = b & 0xF;}
+  void SetX (BYTE b) {m_bX = b & 0xF;}
+  void SetD (BYTE b) {m_bD = b;}
+  // Cycle and instruction counters ...
+  QUAD GetCycles() const {return m_qCycles;}
+  QUAD GetInstructions() const {return m_qInstructions;}
+  //   Total cycles spent in interrupt service routines (from the interrupt
+  // acknowledge up to and including the RET or DIS executed with P=1) ...
+  QUAD GetInterruptCycles() const {return m_qInterruptCycles;}
+
+  // Private member data ...
+private:
+  CBus     *m_pBus;			// system bus interface
+  WORD      m_awR[NREGS];		// scratchpad registers R0..RF
+  BYTE      m_bP, m_bX;			// P and X registers
+  BYTE      m_bD;			// accumulator
+  BYTE      m_bT;			// saved X,P after an interrupt
+  bool      m_fDF;			// data flag (carry)
+  bool      m_fQ;			// Q output
+  bool      m_fIE;			// interrupt enable
+  bool      m_fIRQ;			// interrupt request input
+  bool      m_fIdle;			// true after an IDL instruction
+  bool      m_fStop;			// true to stop Run() now
+  bool      m_fBreak;			// true if Run() hit a breakpoint
+  bool      m_fCDP1805;			// true to emulate the 1805 extensions
+  QUAD      m_qCycles;			// total machine cycles executed
+  QUAD      m_qInstructions;		// total instructions executed
+  bool      m_fInterrupt;		// true while in an interrupt routine
+  QUAD      m_qInterruptStart;		// cycle count when it started
+  QUAD      m_qInterruptCycles;		// total cycles spent in them
+  BYTE     *m_apbRead[NPAGES];		// memory map for reading
+  BYTE     *m_apbWrite[NPAGES];		//   "     "   "  writing
+  const bool *m_pafBreak;		// breakpoint table (or NULL)
+  static BYTE m_abNXM[PAGE_SIZE];	// what non-existent memory reads as
+  static BYTE m_abSink[PAGE_SIZE];	// where writes to ROM/NXM go
+};
+
+#endif	// _cosmac_hpp_
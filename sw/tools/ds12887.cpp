@@ -0,0 +1,325 @@
+//++
+//ds12887.cpp - Dallas DS12887 real time clock and NVR emulation
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   This module implements the CDS12887 class.  See ds12887.hpp for details.
+//
+//   Internally the current time always lives in the clock registers in the
+// format selected by register B, just like the real chip.  Each time an
+// emulated second passes we convert the registers to a time_t, add the
+// elapsed seconds, and convert back.  It's not especially fast, but it only
+// happens once a second and it gets all the calendar rules right for free.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#include <stdio.h>		// FILE, fopen(), etc ...
+#include <string.h>		// memset() ...
+#include <time.h>		// time_t, struct tm, etc ...
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "ds12887.hpp"		// declarations for this module
+
+// "Never" for the purposes of NextEvent() ...
+#define NEVER	((QUAD) -1)
+
+
+CDS12887::CDS12887 (QUAD qCyclesPerSecond)
+{
+  //++
+  //   Initialize the chip to the state of a brand new DS12887 with a fresh
+  // battery - the oscillator running, 24 hour binary mode, VRT set, and the
+  // time set to the host's local time...
+  //--
+  m_qCyclesPerSecond = qCyclesPerSecond;
+  memset(m_abRAM, 0, sizeof(m_abRAM));
+  m_abRAM[REGA] = REGA_DV_ON;
+  m_abRAM[REGB] = REGB_DM | REGB_24;
+  m_abRAM[REGD] = REGD_VRT;
+  m_qNextSecond = m_qCyclesPerSecond;  m_qNextPeriodic = NEVER;
+  SetTime(LocalTime());
+}
+
+
+void CDS12887::Reset()
+{
+  //++
+  //   The RESET input clears the PIE, AIE, UIE and SQWE bits in register B
+  // and all the flags in register C.  The time and NVR are unaffected...
+  //--
+  m_abRAM[REGB] &= ~(REGB_PIE|REGB_AIE|REGB_UIE|REGB_SQWE);
+  m_abRAM[REGC] = 0;
+}
+
+
+long CDS12887::LocalTime()
+{
+  //++
+  //   Return the host's current local time as a time_t, pretending that the
+  // local time zone is UTC (see SetTime() for why) ...
+  //--
+  time_t tNow = time(NULL);
+  struct tm *ptm = localtime(&tNow);
+  return (long) tNow + ptm->tm_gmtoff;
+}
+
+
+BYTE CDS12887::ToBCD (unsigned n) const
+{
+  //++
+  // Convert a number to the current data mode (BCD or binary) ...
+  //--
+  if ((m_abRAM[REGB] & REGB_DM) != 0) return (BYTE) n;
+  return (BYTE) (((n / 10) << 4) | (n % 10));
+}
+
+
+unsigned CDS12887::FromBCD (BYTE b) const
+{
+  //++
+  // Convert a register from the current data mode to a number ...
+  //--
+  if ((m_abRAM[REGB] & REGB_DM) != 0) return b;
+  return ((b >> 4) * 10) + (b & 0xF);
+}
+
+
+void CDS12887::SetTime (long lTime)
+{
+  //++
+  //   Set the clock registers to the time given.  We treat the time_t as if
+  // it were UTC so that gmtime() and timegm() are exact inverses, and the
+  // caller uses LocalTime() if it wants local time...
+  //--
+  time_t tTime = (time_t) lTime;
+  struct tm *ptm = gmtime(&tTime);
+  m_abRAM[SECONDS] = ToBCD(ptm->tm_sec);
+  m_abRAM[MINUTES] = ToBCD(ptm->tm_min);
+  if ((m_abRAM[REGB] & REGB_24) != 0)
+    m_abRAM[HOURS] = ToBCD(ptm->tm_hour);
+  else {
+    // 12 hour mode - 12, 1, 2, ... 11 with the PM flag in bit 7 ...
+    unsigned nHour = ptm->tm_hour % 12;
+    m_abRAM[HOURS] = ToBCD((nHour == 0) ? 12 : nHour);
+    if (ptm->tm_hour >= 12) m_abRAM[HOURS] |= 0x80;
+  }
+  m_abRAM[DAY_OF_WEEK]  = ToBCD(ptm->tm_wday + 1);
+  m_abRAM[DAY_OF_MONTH] = ToBCD(ptm->tm_mday);
+  m_abRAM[MONTH]        = ToBCD(ptm->tm_mon + 1);
+  m_abRAM[YEAR]         = ToBCD((ptm->tm_year + 1900 - YEAR_BASE) % 100);
+}
+
+
+long CDS12887::GetTime() const
+{
+  //++
+  // Convert the current clock registers to a time_t ...
+  //--
+  struct tm tm;
+  memset(&tm, 0, sizeof(tm));
+  tm.tm_sec  = FromBCD(m_abRAM[SECONDS]);
+  tm.tm_min  = FromBCD(m_abRAM[MINUTES]);
+  if ((m_abRAM[REGB] & REGB_24) != 0)
+    tm.tm_hour = FromBCD(m_abRAM[HOURS]);
+  else {
+    tm.tm_hour = FromBCD(m_abRAM[HOURS] & 0x7F) % 12;
+    if ((m_abRAM[HOURS] & 0x80) != 0) tm.tm_hour += 12;
+  }
+  tm.tm_mday = FromBCD(m_abRAM[DAY_OF_MONTH]);
+  tm.tm_mon  = FromBCD(m_abRAM[MONTH]) - 1;
+  tm.tm_year = FromBCD(m_abRAM[YEAR]) + YEAR_BASE - 1900;
+  return (long) timegm(&tm);
+}
+
+
+QUAD CDS12887::PeriodicCycles() const
+{
+  //++
+  //   Return the periodic interrupt rate, in CPU cycles, or zero if the
+  // periodic interrupt is off.  With a 32.768kHz time base rates 1 and 2 are
+  // the same as 8 and 9; the rest are 2^(RS-1) ticks of the time base...
+  //--
+  unsigned nRS = m_abRAM[REGA] & REGA_RS;
+  if ((nRS == 0) || !IsRunning()) return 0;
+  if (nRS < 3) nRS += 7;
+  QUAD qCycles = (m_qCyclesPerSecond << (nRS-1)) / TIME_BASE;
+  return (qCycles == 0) ? 1 : qCycles;
+}
+
+
+void CDS12887::UpdateIRQ()
+{
+  //++
+  // Recompute the IRQF bit in register C ...
+  //--
+  BYTE bC = m_abRAM[REGC] & ~REGC_IRQF;
+  BYTE bB = m_abRAM[REGB];
+  if ( (((bC & REGC_PF) != 0) && ((bB & REGB_PIE) != 0))
+    || (((bC & REGC_AF) != 0) && ((bB & REGB_AIE) != 0))
+    || (((bC & REGC_UF) != 0) && ((bB & REGB_UIE) != 0)) ) bC |= REGC_IRQF;
+  m_abRAM[REGC] = bC;
+}
+
+
+void CDS12887::Clock (QUAD qNow)
+{
+  //++
+  //   Advance the clock to the time given.  This updates the time registers
+  // once per emulated second (unless the SET bit is on or the oscillator is
+  // stopped) and sets the update ended, alarm and periodic flags...
+  //--
+  if (qNow >= m_qNextSecond) {
+    QUAD qSeconds = (qNow - m_qNextSecond) / m_qCyclesPerSecond + 1;
+    m_qNextSecond += qSeconds * m_qCyclesPerSecond;
+    if (IsRunning() && ((m_abRAM[REGB] & REGB_SET) == 0)) {
+      SetTime(GetTime() + (long) qSeconds);
+      m_abRAM[REGC] |= REGC_UF;
+      //   Check the alarm.  Any alarm register with the two MSBs set is a
+      // "don't care" and always matches ...
+      bool fAlarm = true;
+      for (unsigned i = SECONDS;  i <= HOURS;  i += 2) {
+	BYTE bAlarm = m_abRAM[i+1];
+	if (((bAlarm & 0xC0) != 0xC0) && (bAlarm != m_abRAM[i])) fAlarm = false;
+      }
+      if (fAlarm) m_abRAM[REGC] |= REGC_AF;
+    }
+  }
+  if ((m_qNextPeriodic != NEVER) && (qNow >= m_qNextPeriodic)) {
+    QUAD qPeriod = PeriodicCycles();
+    m_abRAM[REGC] |= REGC_PF;
+    m_qNextPeriodic = (qPeriod == 0) ? NEVER : (qNow / qPeriod + 1) * qPeriod;
+  }
+  UpdateIRQ();
+}
+
+
+QUAD CDS12887::NextEvent() const
+{
+  //++
+  //   Return the next time something happens.  The flags are updated lazily
+  // whenever the CPU reads register C, so we only need to be called at the
+  // right time if an interrupt is enabled...
+  //--
+  QUAD qNext = NEVER;
+  BYTE bB = m_abRAM[REGB];
+  if ((bB & (REGB_AIE|REGB_UIE)) != 0) qNext = m_qNextSecond;
+  if (((bB & REGB_PIE) != 0) && (m_qNextPeriodic < qNext)) qNext = m_qNextPeriodic;
+  return qNext;
+}
+
+
+BYTE CDS12887::Read (unsigned nAddress, QUAD qNow)
+{
+  //++
+  //   Read a clock register or NVR location.  The UIP bit in register A is
+  // computed on the fly from the time until the next update, and reading
+  // register C clears all the flags...
+  //--
+  nAddress &= NVR_SIZE-1;
+  Clock(qNow);
+  if (nAddress == REGA) {
+    BYTE bA = m_abRAM[REGA] & ~REGA_UIP;
+    QUAD qUIP = m_qCyclesPerSecond * UIP_USEC / 1000000UL;
+    if (IsRunning() && ((m_abRAM[REGB] & REGB_SET) == 0)
+     && (m_qNextSecond - qNow <= qUIP)) bA |= REGA_UIP;
+    return bA;
+  } else if (nAddress == REGC) {
+    BYTE bC = m_abRAM[REGC];
+    m_abRAM[REGC] = 0;
+    return bC;
+  }
+  return m_abRAM[nAddress];
+}
+
+
+void CDS12887::Write (unsigned nAddress, BYTE bData, QUAD qNow)
+{
+  //++
+  //   Write a clock register or NVR location.  Registers C and D are read
+  // only, and UIP is read only too.  Changing the periodic rate or the
+  // oscillator control bits restarts the periodic interrupt timer...
+  //--
+  nAddress &= NVR_SIZE-1;
+  Clock(qNow);
+  switch (nAddress) {
+    case REGA:
+      m_abRAM[REGA] = bData & ~REGA_UIP;
+      if (PeriodicCycles() == 0)
+	m_qNextPeriodic = NEVER;
+      else
+	m_qNextPeriodic = (qNow / PeriodicCycles() + 1) * PeriodicCycles();
+      //   Turning on the oscillator (or taking it out of reset) starts the
+      // first update one second later...
+      if (!IsRunning()) m_qNextSecond = qNow + m_qCyclesPerSecond;
+      break;
+
+    case REGB:
+      //   Setting the SET bit aborts any update in progress and clears UIE.
+      // Changing the data mode does NOT convert the existing registers!
+      if ((bData & REGB_SET) != 0) bData &= ~REGB_UIE;
+      if (((m_abRAM[REGB] & REGB_SET) != 0) && ((bData & REGB_SET) == 0))
+	m_qNextSecond = qNow + m_qCyclesPerSecond;
+      m_abRAM[REGB] = bData;
+      UpdateIRQ();
+      break;
+
+    case REGC:
+    case REGD:
+      break;
+
+    default:
+      m_abRAM[nAddress] = bData;
+      break;
+  }
+}
+
+
+bool CDS12887::LoadNVR (const char *pszFile)
+{
+  //++
+  //   Load the NVR contents from a file.  This includes registers A and B,
+  // but the time registers are always reset to the host's current time, and
+  // register C and D are always initialized as for a power up ...
+  //--
+  FILE *f = fopen(pszFile, "rb");
+  if (f == NULL) return false;
+  BYTE abRAM[NVR_SIZE];
+  size_t cb = fread(abRAM, 1, sizeof(abRAM), f);
+  fclose(f);
+  if (cb != sizeof(abRAM)) return false;
+  memcpy(m_abRAM, abRAM, sizeof(m_abRAM));
+  m_abRAM[REGA] &= ~REGA_UIP;
+  m_abRAM[REGB] &= ~REGB_SET;
+  m_abRAM[REGC] = 0;  m_abRAM[REGD] = REGD_VRT;
+  SetTime(LocalTime());
+  return true;
+}
+
+
+bool CDS12887::SaveNVR (const char *pszFile) const
+{
+  //++
+  // Save the NVR contents to a file ...
+  //--
+  FILE *f = fopen(pszFile, "wb");
+  if (f == NULL) return false;
+  size_t cb = fwrite(m_abRAM, 1, sizeof(m_abRAM), f);
+  fclose(f);
+  return cb == sizeof(m_abRAM);
+}
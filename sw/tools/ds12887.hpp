@@ -0,0 +1,109 @@
+//++
+//ds12887.hpp - Dallas DS12887 real time clock and NVR emulation
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   The CDS12887 class emulates the DS12887 (aka DS1287, MC146818) real time
+// clock and 114 bytes of battery backed RAM.  The clock keeps time in either
+// BCD or binary and 12 or 24 hour mode, exactly as selected by register B,
+// and it ticks in emulated time (i.e. CPU cycles) rather than real time.  The
+// update in progress bit, the update ended, alarm and periodic interrupt flags
+// are all implemented because the monitor's POST depends on UIP and PF.
+//
+//   The clock is set from the host's local time when the object is created.
+// The NVR contents (and the control registers) may optionally be loaded from
+// and saved to a file, so that settings like SET BAUD and SET RESTART survive
+// from one run to the next, just like the real thing.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#ifndef _ds12887_hpp_
+#define _ds12887_hpp_
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+
+class CDS12887 {
+  //++
+  // DS12887 register addresses and bits ...
+  //--
+public:
+  enum {
+    // Time, calendar and alarm registers ...
+    SECONDS = 0, SECONDS_ALARM = 1, MINUTES = 2, MINUTES_ALARM = 3,
+    HOURS = 4, HOURS_ALARM = 5, DAY_OF_WEEK = 6, DAY_OF_MONTH = 7,
+    MONTH = 8, YEAR = 9,
+    // Control registers ...
+    REGA = 10, REGB = 11, REGC = 12, REGD = 13,
+    // Register A bits ...
+    REGA_UIP = 0x80, REGA_DV = 0x70, REGA_RS = 0x0F, REGA_DV_ON = 0x20,
+    // Register B bits ...
+    REGB_SET = 0x80, REGB_PIE = 0x40, REGB_AIE = 0x20, REGB_UIE = 0x10,
+    REGB_SQWE = 0x08, REGB_DM = 0x04, REGB_24 = 0x02, REGB_DSE = 0x01,
+    // Register C and D bits ...
+    REGC_IRQF = 0x80, REGC_PF = 0x40, REGC_AF = 0x20, REGC_UF = 0x10,
+    REGD_VRT = 0x80,
+    // Other magic numbers ...
+    NVR_SIZE = 128,		// total size including clock registers
+    TIME_BASE = 32768,		// crystal frequency (for the periodic rate)
+    UIP_USEC = 2228,		// UIP is set 244us before and during update
+    YEAR_BASE = 1972		// the BIOS counts years from the ElfOS epoch
+  };
+
+  // Constructor and destructor ...
+public:
+  CDS12887 (QUAD qCyclesPerSecond);
+  virtual ~CDS12887() {};
+
+  // Public methods ...
+public:
+  // Reset (clears the interrupt enables and flags only) ...
+  void Reset();
+  // Read or write a register or NVR location ...
+  BYTE Read (unsigned nAddress, QUAD qNow);
+  void Write (unsigned nAddress, BYTE bData, QUAD qNow);
+  // Advance time and return the next time something will happen ...
+  void Clock (QUAD qNow);
+  QUAD NextEvent() const;
+  // Interrupt request output ...
+  bool IsIRQ() const {return (m_abRAM[REGC] & REGC_IRQF) != 0;}
+  // Load or save the NVR contents ...
+  bool LoadNVR (const char *pszFile);
+  bool SaveNVR (const char *pszFile) const;
+
+  // Private methods ...
+private:
+  BYTE ToBCD (unsigned n) const;
+  unsigned FromBCD (BYTE b) const;
+  static long LocalTime();
+  void SetTime (long lTime);
+  long GetTime() const;
+  QUAD PeriodicCycles() const;
+  bool IsRunning() const
+    {return (m_abRAM[REGA] & REGA_DV) == REGA_DV_ON;}
+  void UpdateIRQ();
+
+  // Private member data ...
+private:
+  BYTE     m_abRAM[NVR_SIZE];		// clock registers and NVR
+  QUAD     m_qCyclesPerSecond;		// CPU cycles per emulated second
+  QUAD     m_qNextSecond;		// time of the next clock update
+  QUAD     m_qNextPeriodic;		// time of the next periodic interrupt
+};
+
+#endif	// _ds12887_hpp_
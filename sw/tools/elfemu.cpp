@@ -0,0 +1,466 @@
+//++
+//elfemu.cpp - headless Elf 2000/PicoElf emulator for EPROM testing
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   ELFEMU loads an EPROM image (e.g. Elf2K.hex or PicoElf.hex, straight out
+// of the Makefile) into an emulated Elf 2000 or PicoElf, resets it, and runs
+// it until the monitor prints its ">>>" prompt.  Along the way the POST codes
+// can be traced, so if a change to BOOTS breaks SYSINI, ROMCHK, SIZMEM, RTCINI,
+// UINI or TTYINI you'll find out which one without burning an EPROM.
+//
+//   If a script file is given, then each time the prompt appears the next
+// line of the script is typed, and when the script runs out and the prompt
+// comes back we exit.  Everything the monitor prints goes to stdout.  That
+// makes it easy to run a monitor command or two and compare the output to
+// what you expect.  A script line of the form "<file" is special - the
+// contents of that file are sent immediately after the previous line, without
+// waiting for the prompt and without any flow control (see StreamInput()).
+// That's meant for things like "LOAD" followed by "<test.hex".  With -f the
+// file is sent with hardware flow control instead, and it can contain several
+// command lines to simulate pasting them into a terminal emulator.  A script
+// line of just "!" presses the RESET switch instead of typing anything.  SRAM
+// and the NVR are preserved, just like the real thing with battery backup, so
+// that's a warm start (and "-t SYSINI,MAIN", with their addresses from the
+// listing, times both kinds of boot).
+//
+//   The emulator counts 1802 machine cycles exactly, so with -c it reports
+// how many cycles (and how much real time, at the selected clock frequency)
+// the whole run took, and -t reports the exact time taken by the code between
+// two addresses (e.g. the entry and return of some routine).  With just one
+// address -t times a subroutine called with SCRT, from its entry until it
+// returns to the caller, and that works even when there are many callers
+// (e.g. -t 9803 times every call to VTPUTC).  By default the
+// UART is infinitely fast so that the emulator runs as fast as it can, but -b
+// sets a real baud rate so that serial I/O takes as long as it would on the
+// real thing.
+//
+//   With -5 the CPU is a CDP1805 (well, its register instructions, anyway -
+// see cosmac.hpp), so the monitor's 1805 code can be run and timed against
+// the 1802 code it replaces.
+//
+//   With -V the Elf 2000 also has a VT1802 video card.  The console is still
+// the UART (there's no PS/2 keyboard), but the monitor finds the card and
+// keeps the display running, so its DMA and interrupts steal CPU time just
+// like they do on the real thing.  -c then reports how many cycles per frame
+// go to DMA, to interrupt service and to everything else, and -d prints what
+// was on the screen at the end.
+//
+//   With -D there's also an IDE drive (really a CompactFlash card) attached
+// as the master, and the file given is its contents - the sectors in LBA
+// order, so "dd if=/dev/zero of=cf.img bs=512 count=8192" makes a blank 4Mb
+// drive.  Anything written to the drive is saved back to the file at the end.
+// The drive is infinitely fast, so timing a disk transfer times the CPU
+// alone, and -c reports the number of sectors read and written.
+//
+//   With -P the console is a pseudo terminal instead - its name is printed
+// when we start, and any program that talks to a serial port (e.g. HEXSEND
+// or RMTBENCH) can open it and talk to the monitor.  Whatever arrives from
+// the pseudo terminal is sent to the UART at the full line rate, just like
+// a "<file" script line, and the emulator is slowed down to real time so
+// that the other program sees the same timing it would with the real thing
+// (which only makes sense if -b sets the baud rate, too).  A BREAK can't be
+// sent thru a pseudo terminal, though.  We keep going until the other end
+// closes it or the cycle limit is reached.  This is a POSIX only option.
+//
+//   With -G the Elf 2000 also has the GPIO card's 8255 PPI, and the other
+// side of its port A is another pseudo terminal that stands in for the USB
+// to parallel bridge on the host.  Its name is printed when we start (after
+// the console's, with -P), and a program like PPILOAD can open it and talk
+// to the monitor's PARALLEL command.  The bridge itself is infinitely fast,
+// so the transfer rate is set by the monitor's loops alone.  This runs in
+// real time too, even with a script, and it's POSIX only as well.
+//
+// USAGE:
+//	elfemu [options] image.hex
+//
+//	-p elf2k|picoelf	select the hardware (default elf2k)
+//	-5			the CPU is a CDP1805 instead of a CDP1802
+//	-V			add a VT1802 video card (elf2k only)
+//	-d			print the VT1802 screen when done
+//	-k hz			CPU clock frequency (default 1789773)
+//	-b baud			console baud rate (default infinitely fast)
+//	-s xx			set the toggle switches to xx (hex)
+//	-n file			load/save the NVR contents from/to file
+//	-D file			attach an IDE drive with this image file
+//	-P			the console is a pseudo terminal
+//	-G			add a PPI with a pseudo terminal bridge (elf2k only)
+//	-i file			type the lines in file ("-" for stdin)
+//	-f			"<file" lines wait for RTS (flow control)
+//	-e string		expect string in the output (exit status 2 if not)
+//	-m cycles		give up after this many machine cycles
+//	-t start[,end]		time the code between two addresses (hex), or
+//				 a subroutine CALL if there's no end address
+//	-c			report cycle and instruction counts
+//	-v			trace POST codes to stderr
+//	-q			don't echo the console output
+//
+//   The exit status is 0 for success, 1 if the cycle limit was reached, 2 if
+// the expected string never appeared, and 3 for any other error.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+// 17-Oct-26    RLA     Add "<file" script lines.
+// 17-Oct-26    RLA     Add -f (hardware flow control for "<file").
+// 17-Oct-26    RLA     Add -V and -d (VT1802 video card).
+// 17-Oct-26    RLA     -t with one address times a subroutine call.
+// 17-Oct-26    RLA     Add "!" script lines (press RESET).
+// 17-Oct-26    RLA     Add -D (IDE drive).
+// 17-Oct-26    RLA     Add -5 (CDP1805 CPU).
+// 17-Oct-26    RLA     Add -P (pseudo terminal console).
+// 17-Oct-26    RLA     Add -G (GPIO PPI and bridge).
+//--
+#include <stdio.h>		// printf(), fprintf(), etc ...
+#include <stdlib.h>		// exit(), strtoul(), ...
+#include <string.h>		// strcmp(), strchr(), ...
+#include <time.h>		// clock() ...
+#include <unistd.h>		// getopt(), read(), usleep() ...
+#include <fcntl.h>		// O_RDWR, O_NOCTTY, ...
+#include <termios.h>		// tcgetattr(), cfmakeraw(), ...
+#include <sys/select.h>		// select() ...
+#include <sys/time.h>		// gettimeofday() ...
+#include <string>		// C++ std::string class
+#include <deque>		// C++ std::deque template
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "cosmac.hpp"		// CCOSMAC CPU emulation
+#include "uart.hpp"		// CUART 16450/16550 emulation
+#include "ds12887.hpp"		// CDS12887 RTC/NVR emulation
+#include "vt1802.hpp"		// CVT1802 video card emulation
+#include "ppi.hpp"		// CPPI 8255 emulation
+#include "elfsys.hpp"		// CElfSystem Elf 2000/PicoElf emulation
+
+// Exit status codes ...
+#define EXIT_OK		0	// everything worked
+#define EXIT_TIMEOUT	1	// cycle limit reached
+#define EXIT_EXPECT	2	// expected output never appeared
+#define EXIT_ERROR	3	// anything else
+
+// Defaults ...
+#define DEFAULT_CLOCK	1789773ULL	// Elf 2000 CPU clock (Hz)
+#define DEFAULT_LIMIT	100000000ULL	// about 7.5 minutes of 1802 time
+#define PROMPT		">>>"		// the monitor's prompt
+#define PTY_SLICE	1000		// -P and -G run in slices of a millisecond
+
+
+static void Usage()
+{
+  fprintf(stderr, "usage: elfemu [-p elf2k|picoelf] [-5] [-V] [-d] [-k hz] [-b baud] [-s switches] [-n nvrfile] [-D disk] [-P] [-G]\n");
+  fprintf(stderr, "              [-i script] [-f] [-e expect] [-m cycles] [-t start[,end]] [-c] [-v] [-q] image.hex\n");
+  exit(EXIT_ERROR);
+}
+
+
+static bool ReadScript (const char *pszFile, std::deque<std::string> &Lines)
+{
+  //++
+  //   Read the script file into a list of lines.  Each line is terminated by
+  // a carriage return, which is what the monitor expects ...
+  //--
+  FILE *f = (strcmp(pszFile, "-") == 0) ? stdin : fopen(pszFile, "rt");
+  if (f == NULL) return false;
+  char szLine[1024];
+  while (fgets(szLine, sizeof(szLine), f) != NULL) {
+    size_t n = strcspn(szLine, "\r\n");  szLine[n] = '\0';
+    Lines.push_back(std::string(szLine) + "\r");
+  }
+  if (f != stdin) fclose(f);
+  return true;
+}
+
+
+static bool ReadFile (const char *pszFile, std::string &sData)
+{
+  //++
+  // Read an entire file (for "<file" script lines) into a string ...
+  //--
+  FILE *f = fopen(pszFile, "rb");
+  if (f == NULL) return false;
+  char ab[4096];  size_t cb;
+  while ((cb = fread(ab, 1, sizeof(ab), f)) > 0) sData.append(ab, cb);
+  fclose(f);
+  return true;
+}
+
+
+static double Now()
+{
+  //++
+  // Return the current time, in seconds, for pacing -P ...
+  //--
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double) tv.tv_sec + (double) tv.tv_usec / 1000000.0;
+}
+
+
+static int OpenPty (std::string &sName)
+{
+  //++
+  //   Create a pseudo terminal, set it to raw mode, and return the master's
+  // file descriptor and the name of the slave, or -1 if it didn't work ...
+  //--
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0) return -1;
+  struct termios tio;
+  if ((grantpt(fd) != 0) || (unlockpt(fd) != 0) || (tcgetattr(fd, &tio) != 0)) {
+    close(fd);  return -1;
+  }
+  cfmakeraw(&tio);
+  if (tcsetattr(fd, TCSANOW, &tio) != 0) {close(fd);  return -1;}
+  sName = ptsname(fd);
+  return fd;
+}
+
+
+static int RunRealTime (CElfSystem *pSystem, int fdConsole, int fdPPI, QUAD qLimit, QUAD qClockHz)
+{
+  //++
+  //   Run the system in real time, with a pseudo terminal as its console (see
+  // -P above) or as the PPI bridge (-G), or both.  Each slice runs the CPU for
+  // 1/PTY_SLICE of a second and then waits for the real time to catch up, and
+  // meanwhile anything that arrives from the pseudo terminals is streamed to
+  // the UART or the PPI.  Once somebody has opened the other end of the
+  // console, reading it fails after they close it again and that's the end.
+  // Without a console pseudo terminal we stop at the prompt instead, just
+  // like CElfSystem::Run(), so this can run a script too.
+  //--
+  QUAD qSlice = qClockHz / CCOSMAC::CLOCKS_PER_CYCLE / PTY_SLICE;
+  QUAD qStart = pSystem->CPU().GetCycles();
+  double dStart = Now();  bool fOpened = false;
+  while (pSystem->CPU().GetCycles() < qLimit) {
+    pSystem->Run(pSystem->CPU().GetCycles() + qSlice);
+    if ((fdConsole < 0) && pSystem->IsPrompt()) return EXIT_OK;
+    for (;;) {
+      double dWait = pSystem->CyclesToSeconds(pSystem->CPU().GetCycles()-qStart) - (Now()-dStart);
+      if (dWait < 0.0) dWait = 0.0;
+      fd_set fds;  FD_ZERO(&fds);
+      if (fdConsole >= 0) FD_SET(fdConsole, &fds);
+      if (fdPPI >= 0) FD_SET(fdPPI, &fds);
+      struct timeval tv = {0, (long) (dWait * 1000000.0)};
+      if (select(((fdConsole > fdPPI) ? fdConsole : fdPPI)+1, &fds, NULL, NULL, &tv) <= 0) break;
+      //   Until somebody opens the other end of a pseudo terminal (and after
+      // they close it again) the master is always "readable" and reading it
+      // fails.  Just sleep for the rest of the slice instead ...
+      char ab[256];  ssize_t cb;
+      if ((fdConsole >= 0) && FD_ISSET(fdConsole, &fds)) {
+	if ((cb = read(fdConsole, ab, sizeof(ab))) > 0) {
+	  pSystem->StreamInput(std::string(ab, cb));  fOpened = true;
+	} else if (fOpened) {
+	  return EXIT_OK;
+	} else {
+	  usleep((useconds_t) (dWait * 1000000.0));  break;
+	}
+      }
+      if ((fdPPI >= 0) && FD_ISSET(fdPPI, &fds)) {
+	if ((cb = read(fdPPI, ab, sizeof(ab))) > 0) {
+	  pSystem->StreamPPI(std::string(ab, cb));
+	} else {
+	  usleep((useconds_t) (dWait * 1000000.0));  break;
+	}
+      }
+    }
+  }
+  return EXIT_TIMEOUT;
+}
+
+
+int main (int argc, char *argv[])
+{
+  bool fPicoElf = false, fCycles = false, fTrace = false, fQuiet = false, fFlow = false;
+  bool fVideo = false, fScreen = false, f1805 = false, fPty = false, fPPI = false;
+  QUAD qClockHz = DEFAULT_CLOCK, qLimit = DEFAULT_LIMIT;
+  unsigned nBaud = 0, nSwitches = 0;
+  const char *pszNVR = NULL, *pszScript = NULL, *pszExpect = NULL, *pszDisk = NULL;
+  bool fTimer = false, fTimerCall = false;  int nArgs;
+  unsigned nTimerStart = 0, nTimerEnd = 0;
+  int nOption;
+
+  // Parse the command line ...
+  while ((nOption = getopt(argc, argv, "p:5Vdk:b:s:n:D:PGi:fe:m:t:cvq")) != -1) {
+    switch (nOption) {
+      case 'p':
+	if (strcmp(optarg, "picoelf") == 0)
+	  fPicoElf = true;
+	else if (strcmp(optarg, "elf2k") == 0)
+	  fPicoElf = false;
+	else
+	  Usage();
+	break;
+      case '5': f1805 = true;  break;
+      case 'V': fVideo = true;  break;
+      case 'd': fScreen = true;  break;
+      case 'k': qClockHz = strtoull(optarg, NULL, 10);  break;
+      case 'b': nBaud = strtoul(optarg, NULL, 10);  break;
+      case 's': nSwitches = strtoul(optarg, NULL, 16) & 0xFF;  break;
+      case 'n': pszNVR = optarg;  break;
+      case 'D': pszDisk = optarg;  break;
+      case 'P': fPty = true;  break;
+      case 'G': fPPI = true;  break;
+      case 'i': pszScript = optarg;  break;
+      case 'f': fFlow = true;  break;
+      case 'e': pszExpect = optarg;  break;
+      case 'm': qLimit = strtoull(optarg, NULL, 10);  break;
+      case 't':
+	nArgs = sscanf(optarg, "%x,%x", &nTimerStart, &nTimerEnd);
+	if (nArgs < 1) Usage();
+	fTimer = true;  fTimerCall = (nArgs == 1);  break;
+      case 'c': fCycles = true;  break;
+      case 'v': fTrace = true;  break;
+      case 'q': fQuiet = true;  break;
+      default:  Usage();
+    }
+  }
+  if ((optind != argc-1) || (qClockHz < CCOSMAC::CLOCKS_PER_CYCLE)) Usage();
+  if ((fVideo && fPicoElf) || (fScreen && !fVideo) || (fPty && (pszScript != NULL))) Usage();
+  if (fPPI && fPicoElf) Usage();
+
+  // Create the system and load the EPROM and NVR ...
+  CElfSystem *pSystem = new CElfSystem(fPicoElf, qClockHz);
+  std::string sError;
+  if (!pSystem->LoadROM(argv[optind], sError)) {
+    fprintf(stderr, "elfemu: %s\n", sError.c_str());  return EXIT_ERROR;
+  }
+  if (pszNVR != NULL) pSystem->RTC().LoadNVR(pszNVR);
+  if ((pszDisk != NULL) && !pSystem->IDE().LoadImage(pszDisk)) {
+    fprintf(stderr, "elfemu: unable to attach %s\n", pszDisk);  return EXIT_ERROR;
+  }
+  std::deque<std::string> Script;
+  if ((pszScript != NULL) && !ReadScript(pszScript, Script)) {
+    fprintf(stderr, "elfemu: unable to read %s\n", pszScript);  return EXIT_ERROR;
+  }
+  pSystem->CPU().SetCDP1805(f1805);
+  pSystem->SetVideo(fVideo);
+  pSystem->SetPPI(fPPI);
+  pSystem->SetSwitches((BYTE) nSwitches);
+  pSystem->SetBaud(nBaud);
+  pSystem->SetFlowControl(fFlow);
+  pSystem->SetConsole(fQuiet ? NULL : stdout);
+  pSystem->SetPOSTTrace(fTrace ? stderr : NULL);
+  pSystem->SetPrompt(PROMPT);
+  if (fTimer) pSystem->SetTimer((WORD) nTimerStart, (WORD) nTimerEnd, fTimerCall);
+  int fdPty = -1;  FILE *pPty = NULL;
+  if (fPty) {
+    std::string sPty;
+    if (((fdPty = OpenPty(sPty)) < 0) || ((pPty = fdopen(fdPty, "w")) == NULL)) {
+      fprintf(stderr, "elfemu: unable to create a pseudo terminal\n");  return EXIT_ERROR;
+    }
+    printf("%s\n", sPty.c_str());  fflush(stdout);
+    pSystem->SetConsole(pPty);  pSystem->SetPrompt("");  fQuiet = true;
+  }
+  int fdPPI = -1;  FILE *pPPI = NULL;
+  if (fPPI) {
+    std::string sPty;
+    if (((fdPPI = OpenPty(sPty)) < 0) || ((pPPI = fdopen(fdPPI, "w")) == NULL)) {
+      fprintf(stderr, "elfemu: unable to create a pseudo terminal\n");  return EXIT_ERROR;
+    }
+    printf("%s\n", sPty.c_str());  fflush(stdout);
+    pSystem->SetPPIOutput(pPPI);
+  }
+
+  //   And run it.  Every time the prompt appears, type the next line of the
+  // script.  When the script is empty (and anything streamed has been sent),
+  // we're done...
+  int nStatus = EXIT_OK;
+  clock_t tStart = clock();
+  pSystem->Reset();
+  if (fPty) nStatus = RunRealTime(pSystem, fdPty, fdPPI, qLimit, qClockHz);
+  while (!fPty) {
+    if (fPPI)
+      RunRealTime(pSystem, -1, fdPPI, qLimit, qClockHz);
+    else
+      pSystem->Run(qLimit);
+    if (!pSystem->IsPrompt()) {
+      nStatus = EXIT_TIMEOUT;  break;
+    }
+    pSystem->ClearPrompt();
+    if (Script.empty()) {
+      if (pSystem->IsInputEmpty()) break;
+      continue;
+    }
+    if (Script.front() == "!\r") {
+      Script.pop_front();  pSystem->Reset();  continue;
+    }
+    pSystem->TypeAhead(Script.front());  Script.pop_front();
+    while (!Script.empty() && (Script.front()[0] == '<')) {
+      std::string sFile = Script.front().substr(1, Script.front().length()-2);
+      std::string sData;  Script.pop_front();
+      if (!ReadFile(sFile.c_str(), sData)) {
+	fprintf(stderr, "elfemu: unable to read %s\n", sFile.c_str());
+	delete pSystem;  return EXIT_ERROR;
+      }
+      pSystem->StreamInput(sData);
+    }
+  }
+  double dHostTime = (double) (clock() - tStart) / CLOCKS_PER_SEC;
+  if (!fQuiet) printf("\n");
+  if (fScreen) fputs(pSystem->VT1802().GetScreen().c_str(), stdout);
+
+  //   If an expected string was given, it overrides a timeout (for programs
+  // that never get back to the prompt) ...
+  if (pszExpect != NULL)
+    nStatus = (pSystem->GetOutput().find(pszExpect) != std::string::npos) ? EXIT_OK : EXIT_EXPECT;
+  if (nStatus == EXIT_TIMEOUT)
+    fprintf(stderr, "elfemu: cycle limit reached, POST code %02X, PC=%04X\n",
+      pSystem->GetLEDs(), pSystem->CPU().GetPC());
+  else if (nStatus == EXIT_EXPECT)
+    fprintf(stderr, "elfemu: \"%s\" not found in the output\n", pszExpect);
+
+  // Print the statistics and save the NVR ...
+  if (fCycles) {
+    QUAD qCycles = pSystem->CPU().GetCycles();
+    double dTime = pSystem->CyclesToSeconds(qCycles);
+    fprintf(stderr, "%llu machine cycles, %llu instructions, %.6f seconds at %llu Hz\n",
+      (unsigned long long) qCycles, (unsigned long long) pSystem->CPU().GetInstructions(),
+      dTime, (unsigned long long) qClockHz);
+    if (dHostTime > 0.0)
+      fprintf(stderr, "host time %.3f seconds, %.1f times real time\n", dHostTime, dTime/dHostTime);
+    //   The video statistics are averaged over every frame since the display
+    // was started, and the interrupt time includes the UART's too (if any) ...
+    CVT1802 &VT1802 = pSystem->VT1802();
+    if (fVideo && (VT1802.GetFrames() != 0)) {
+      QUAD qFrame = VT1802.GetFrameCycles();
+      double dDMA = (double) VT1802.GetDMACycles() / VT1802.GetFrames();
+      double dISR = (double) pSystem->CPU().GetInterruptCycles() / VT1802.GetFrames();
+      fprintf(stderr, "%u video frames of %llu cycles: %.1f DMA, %.1f interrupt and %.1f (%.1f%%) left per frame\n",
+	VT1802.GetFrames(), (unsigned long long) qFrame, dDMA, dISR,
+	qFrame-dDMA-dISR, 100.0*(qFrame-dDMA-dISR)/qFrame);
+    }
+    if (pSystem->IDE().IsAttached())
+      fprintf(stderr, "%llu IDE sectors read, %llu written\n",
+	(unsigned long long) pSystem->IDE().GetSectorsRead(),
+	(unsigned long long) pSystem->IDE().GetSectorsWritten());
+    if (fPPI)
+      fprintf(stderr, "%llu bytes thru the PPI from the host, %llu to it\n",
+	(unsigned long long) pSystem->GetPPIBytesIn(),
+	(unsigned long long) pSystem->GetPPIBytesOut());
+    if (pSystem->UART().GetOverruns() != 0)
+      fprintf(stderr, "%u UART receiver overruns\n", pSystem->UART().GetOverruns());
+  }
+  if (fTimer) pSystem->ReportTimer(stderr);
+  if ((pszNVR != NULL) && !pSystem->RTC().SaveNVR(pszNVR)) {
+    fprintf(stderr, "elfemu: unable to write %s\n", pszNVR);  nStatus = EXIT_ERROR;
+  }
+  if ((pszDisk != NULL) && pSystem->IDE().IsModified() && !pSystem->IDE().SaveImage(pszDisk)) {
+    fprintf(stderr, "elfemu: unable to write %s\n", pszDisk);  nStatus = EXIT_ERROR;
+  }
+  if (pPty != NULL) fclose(pPty);
+  if (pPPI != NULL) fclose(pPPI);
+  delete pSystem;
+  return nStatus;
+}
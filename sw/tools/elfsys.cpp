@@ -0,0 +1,492 @@
+//++
+//elfsys.cpp - Elf 2000 and PicoElf system emulation
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   This module implements the CElfSystem class.  See elfsys.hpp for the
+// details of the memory map and I/O decoding.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+// 17-Oct-26    RLA     Add StreamInput() for timing HEX file downloads.
+// 17-Oct-26    RLA     Add SetFlowControl() (RTS/CTS for streamed input).
+// 17-Oct-26    RLA     Add the VT1802 video card.
+// 17-Oct-26    RLA     SetTimer() can time an SCRT subroutine call.
+// 17-Oct-26    RLA     Add the GPIO PPI.
+//--
+#include <stdio.h>		// FILE, fprintf(), etc ...
+#include <string.h>		// memset() ...
+#include <string>		// C++ std::string class
+#include <deque>		// C++ std::deque template
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "cosmac.hpp"		// CCOSMAC CPU emulation
+#include "uart.hpp"		// CUART 16450/16550 emulation
+#include "ds12887.hpp"		// CDS12887 RTC/NVR emulation
+#include "vt1802.hpp"		// CVT1802 video card emulation
+#include "hexfile.hpp"		// LoadIntelHex(), etc ...
+#include "elfsys.hpp"		// declarations for this module
+
+
+CElfSystem::CElfSystem (bool fPicoElf, QUAD qClockHz)
+  : m_CPU(this), m_UART(this), m_RTC(qClockHz / CCOSMAC::CLOCKS_PER_CYCLE),
+    m_VT1802(this, qClockHz / CCOSMAC::CLOCKS_PER_CYCLE)
+{
+  //++
+  //   Note that the EPROM is initialized to all ones (like an erased EPROM)
+  // and the RAM to zeros.  The caller should load an EPROM image and then
+  // call Reset() ...
+  //--
+  m_fPicoElf = fPicoElf;  m_fVideo = m_fPPI = false;
+  m_qCyclesPerSecond = qClockHz / CCOSMAC::CLOCKS_PER_CYCLE;
+  memset(m_abRAM, 0, sizeof(m_abRAM));
+  memset(m_abROM, 0xFF, sizeof(m_abROM));
+  memset(m_afBreak, 0, sizeof(m_afBreak));
+  m_bLEDs = m_bSwitches = 0;  m_fInput = false;
+  m_qCharacterTime = m_qNextInput = m_qRTSDrop = 0;  m_fFlowControl = false;
+  m_pConsole = m_pPOSTTrace = m_pPPIOutput = NULL;
+  m_qPPIIn = m_qPPIOut = 0;
+  m_fPrompt = false;
+  m_wTimerStart = m_wTimerEnd = m_wTimerReturn = 0;
+  m_fTimerCall = m_fTiming = false;
+  m_qTimerStart = m_qTimerTotal = m_qTimerMax = 0;
+  m_qTimerMin = (QUAD) -1;  m_nTimerCount = 0;
+  Reset();
+}
+
+
+bool CElfSystem::LoadROM (const char *pszFile, std::string &sError)
+{
+  //++
+  //   Load an EPROM image.  The images built by the Makefile are addressed
+  // from zero rather than $8000, so that's the way we load them ...
+  //--
+  unsigned nLow, nHigh;
+  memset(m_abROM, 0xFF, sizeof(m_abROM));
+  return LoadIntelHex(pszFile, m_abROM, sizeof(m_abROM), nLow, nHigh, sError);
+}
+
+
+void CElfSystem::MapMemory()
+{
+  //++
+  //   Set up the CPU's memory map.  During the bootstrap the EPROM appears in
+  // both halves of the address space (for reading, anyway) ...
+  //--
+  for (unsigned i = 0;  i < RAM_SIZE/CCOSMAC::PAGE_SIZE;  ++i) {
+    BYTE *pbRAM = &m_abRAM[i*CCOSMAC::PAGE_SIZE];
+    BYTE *pbROM = &m_abROM[i*CCOSMAC::PAGE_SIZE];
+    m_CPU.MapPage(i, m_fBootstrap ? pbROM : pbRAM, pbRAM);
+  }
+  for (unsigned i = 0;  i < ROM_SIZE/CCOSMAC::PAGE_SIZE;  ++i)
+    m_CPU.MapPage(i + ROM_BASE/CCOSMAC::PAGE_SIZE, &m_abROM[i*CCOSMAC::PAGE_SIZE], NULL);
+}
+
+
+void CElfSystem::Reset()
+{
+  //++
+  // Reset the CPU, the UART and the RTC, and enable the bootstrap ...
+  //--
+  m_fBootstrap = true;  MapMemory();
+  m_CPU.Reset();  m_UART.Reset();  m_RTC.Reset();  m_VT1802.Reset();
+  m_IDE.Reset();  m_PPI.Reset();
+  m_bIDESelect = m_bNVRSelect = m_bPPISelect = 0;
+  m_qNextInput = m_CPU.GetCycles();
+}
+
+
+void CElfSystem::SetBaud (unsigned nBaud)
+{
+  //++
+  //   Set the console baud rate.  A character is ten bits (start, eight data
+  // and a stop), and zero means that the UART is infinitely fast ...
+  //--
+  m_qCharacterTime = (nBaud == 0) ? 0 : (m_qCyclesPerSecond * 10) / nBaud;
+  m_UART.SetCharacterTime(m_qCharacterTime);
+}
+
+
+void CElfSystem::UpdateIRQ()
+{
+  //++
+  //   The UART, RTC and video card interrupt requests are wire-OR'ed to the
+  // CPU ...
+  //--
+  m_CPU.SetIRQ(m_UART.IsIRQ() || m_RTC.IsIRQ() || (m_fVideo && m_VT1802.IsIRQ()));
+}
+
+
+void CElfSystem::InterruptAcknowledge()
+{
+  //++
+  //   The CPU has taken an interrupt.  The only thing that cares is the VT1802,
+  // whose end of row interrupt is cleared by the acknowledge cycle ...
+  //--
+  if (m_fVideo) {m_VT1802.InterruptAcknowledge();  UpdateIRQ();}
+}
+
+
+void CElfSystem::Transmit (BYTE bData)
+{
+  //++
+  //   The UART has transmitted a character.  Send it to the console and see
+  // if the monitor has just printed its prompt.  If it has, stop the CPU so
+  // that the caller can decide what to type next ...
+  //--
+  if (m_pConsole != NULL) {fputc(bData, m_pConsole);  fflush(m_pConsole);}
+  m_sOutput += (char) bData;
+  if (!m_sPrompt.empty() && (m_sOutput.size() >= m_sPrompt.size())
+   && (m_sOutput.compare(m_sOutput.size()-m_sPrompt.size(), m_sPrompt.size(), m_sPrompt) == 0)) {
+    m_fPrompt = true;  m_CPU.Stop();
+  }
+}
+
+
+void CElfSystem::ReceiveInput (QUAD qNow)
+{
+  //++
+  //   If there's a character waiting to be typed, and it's time for it, and
+  // the UART has room for it, then give it to the UART.  Streamed characters
+  // don't wait for the UART - they arrive once every character time, just
+  // like a real host sending a file, and if the firmware can't keep up then
+  // the UART overruns.  That only makes sense if the baud rate is set, though,
+  // so with an infinitely fast UART they're flow controlled too.  And with
+  // SetFlowControl() a stream also waits for the UART's RTS output, but like
+  // a real host it only looks at RTS when it starts to send a character, and
+  // a character that's already on the wire when RTS drops still arrives (see
+  // WriteSelected() and IsInputDue()) ...
+  //--
+  if (!IsInputDue(qNow)) return;
+  if (!m_Input.empty()) {
+    m_UART.Receive((BYTE) m_Input.front(), qNow);  m_Input.pop_front();
+    //   If a stream follows this line, then give the command a tenth of a
+    // second to get started before sending it (a host would do the same) ...
+    if (m_Input.empty() && !m_Stream.empty()) {
+      m_qNextInput = qNow + m_qCyclesPerSecond/10;  return;
+    }
+  } else {
+    m_UART.Receive((BYTE) m_Stream.front(), qNow);  m_Stream.pop_front();
+  }
+  //   Schedule the next character one character time after this one was due,
+  // rather than after now, so that a stream keeps up the exact wire speed...
+  if ((qNow - m_qNextInput) >= m_qCharacterTime) m_qNextInput = qNow;
+  m_qNextInput += m_qCharacterTime;
+}
+
+
+bool CElfSystem::IsInputDue (QUAD qNow) const
+{
+  //++
+  // Return true if it's time to receive another character (see above) ...
+  //--
+  if (qNow < m_qNextInput) return false;
+  if (!m_Input.empty()) return m_UART.IsReceiverReady();
+  if (m_Stream.empty()) return false;
+  if (m_fFlowControl && !m_UART.IsRTS()
+   && ((m_qNextInput - m_qCharacterTime) > m_qRTSDrop)) return false;
+  return (m_qCharacterTime != 0) || m_UART.IsReceiverReady();
+}
+
+
+BYTE CElfSystem::ReadSelected (BYTE bSelect)
+{
+  //++
+  //   Read from the device addressed by the select register.  If there are
+  // still characters to be typed after a UART read, then stop the CPU so
+  // that Run() can reschedule the next one...
+  //--
+  QUAD qNow = m_CPU.GetCycles();
+  BYTE bData = 0xFF;
+  if ((bSelect & SELECT_NVR) != 0) {
+    bData = m_RTC.Read(bSelect & ~SELECT_NVR, qNow);  UpdateIRQ();
+  } else if ((bSelect & 0xF8) == SELECT_UART) {
+    ReceiveInput(qNow);
+    bData = m_UART.Read(bSelect & 7, qNow);
+    if (!IsInputEmpty()) m_CPU.Stop();
+  } else if (!m_fPicoElf && ((bSelect & ~SELECT_IDE_MASK) == 0)) {
+    bData = m_IDE.Read(bSelect);
+  }
+  return bData;
+}
+
+
+void CElfSystem::WriteSelected (BYTE bSelect, BYTE bData)
+{
+  //++
+  //   Write to the device addressed by the select register.  Writing to the
+  // UART or the RTC may change the time of their next event, so stop the CPU
+  // and let Run() figure that out again.  When RTS goes up a flow controlled
+  // stream starts sending again, and the next character arrives one character
+  // time later; when it goes down, remember when so that a character that was
+  // already being sent isn't lost ...
+  //--
+  QUAD qNow = m_CPU.GetCycles();
+  if ((bSelect & SELECT_NVR) != 0) {
+    m_RTC.Write(bSelect & ~SELECT_NVR, bData, qNow);
+    UpdateIRQ();  m_CPU.Stop();
+  } else if ((bSelect & 0xF8) == SELECT_UART) {
+    bool fRTS = m_UART.IsRTS();
+    m_UART.Write(bSelect & 7, bData, qNow);  m_CPU.Stop();
+    if (fRTS && !m_UART.IsRTS()) m_qRTSDrop = qNow;
+    if (!fRTS && m_UART.IsRTS() && m_fFlowControl && m_Input.empty()
+     && (m_qNextInput < qNow+m_qCharacterTime))
+      m_qNextInput = qNow + m_qCharacterTime;
+  } else if (!m_fPicoElf && ((bSelect & ~SELECT_IDE_MASK) == 0)) {
+    m_IDE.Write(bSelect, bData);
+  }
+}
+
+
+void CElfSystem::UpdatePPI()
+{
+  //++
+  //   This is the host's side of PPI port A (see elfsys.hpp).  Take any byte
+  // the CPU has written, and strobe in the next one from the host if the CPU
+  // has read the last one.  It's called around every PPI access, and that's
+  // often enough since the CPU has to look at port C to see either one ...
+  //--
+  if (!m_PPI.IsMode2()) return;
+  if (m_PPI.IsOutputFull()) {
+    BYTE bData = m_PPI.Acknowledge();  ++m_qPPIOut;
+    if (m_pPPIOutput != NULL) {fputc(bData, m_pPPIOutput);  fflush(m_pPPIOutput);}
+  }
+  if (!m_PPI.IsInputFull() && !m_PPIInput.empty()) {
+    m_PPI.Strobe((BYTE) m_PPIInput.front());  m_PPIInput.pop_front();  ++m_qPPIIn;
+  }
+}
+
+
+BYTE CElfSystem::Input (unsigned nPort)
+{
+  //++
+  //   Handle an INP instruction.  Anything that isn't implemented reads as
+  // $FF, which is what the monitor expects from an empty bus ...
+  //--
+  switch (nPort) {
+    case PORT_SWITCHES:
+      return m_bSwitches;
+    case PORT_IDE_DATA:
+      // On the Elf2K the UART and NVR share the IDE ports, but not on the PicoElf ...
+      return m_fPicoElf ? m_IDE.Read(m_bIDESelect & SELECT_IDE_MASK)
+			: ReadSelected(m_bIDESelect);
+    case PICO_NVR_DATA:
+      return m_fPicoElf ? ReadSelected(m_bNVRSelect) : 0xFF;
+    case ELF2K_CRTC_STATUS:
+      return m_fVideo ? m_VT1802.ReadStatus() : 0xFF;
+    case ELF2K_PPI_DATA:
+      if (!m_fPPI) return 0xFF;
+      UpdatePPI();
+      return m_PPI.Read(m_bPPISelect);
+    default:
+      return 0xFF;
+  }
+}
+
+
+void CElfSystem::Output (unsigned nPort, BYTE bData)
+{
+  //++
+  //   Handle an OUT instruction.  Note that on the PicoElf writing the NVR
+  // select register with bit 7 cleared and bit 6 set resets both the UART
+  // and the RTC ...
+  //--
+  switch (nPort) {
+    case PORT_LEDS:
+      if ((bData != m_bLEDs) && (m_pPOSTTrace != NULL))
+	fprintf(m_pPOSTTrace, "[POST %02X at %llu cycles]\n", bData,
+	  (unsigned long long) m_CPU.GetCycles());
+      //   The autobaud routine flushes the UART before it starts looking for
+      // a carriage return, so wait a tenth of a second (about as fast as any
+      // human could type it) before sending one ...
+      if ((bData == POST_AUTOBAUD) && (bData != m_bLEDs)) {
+	m_Input.push_front('\r');
+	m_qNextInput = m_CPU.GetCycles() + m_qCyclesPerSecond/10;
+      }
+      m_bLEDs = bData;
+      break;
+    case PORT_IDE_SELECT:
+      m_bIDESelect = bData;
+      break;
+    case PORT_IDE_DATA:
+      if (!m_fPicoElf)
+	WriteSelected(m_bIDESelect, bData);
+      else
+	m_IDE.Write(m_bIDESelect & SELECT_IDE_MASK, bData);
+      break;
+    //   Ports 6 and 7 are the PPI data and the GPIO control register on the
+    // Elf 2000.  The control register loads the PPI register select bits only
+    // when the enable bit is set too ...
+    case PICO_NVR_SELECT:
+      if (!m_fPicoElf) {
+	if (m_fPPI) {m_PPI.Write(m_bPPISelect, bData);  UpdatePPI();}
+	break;
+      }
+      m_bNVRSelect = bData;
+      if ((bData & (SELECT_NVR|SELECT_RESET)) == SELECT_RESET) {
+	m_UART.Reset();  m_RTC.Reset();  UpdateIRQ();
+      }
+      break;
+    case PICO_NVR_DATA:
+      if (m_fPicoElf)
+	WriteSelected(m_bNVRSelect, bData);
+      else if (m_fPPI && ((bData & GPIO_PPI_ENABLE) != 0))
+	m_bPPISelect = bData & GPIO_PPI_SELECT;
+      break;
+    //   Starting the display (or resetting its counters) changes the time of
+    // the next video event, so stop the CPU to let Run() reschedule ...
+    case ELF2K_CRTC_COMMAND:
+      if (m_fVideo) {m_VT1802.WriteCommand(bData, m_CPU.GetCycles());  m_CPU.Stop();}
+      break;
+    case ELF2K_CRTC_PARAMETER:
+      if (m_fVideo) m_VT1802.WriteParameter(bData);
+      break;
+  }
+}
+
+
+bool CElfSystem::GetEF (unsigned nEF)
+{
+  //++
+  //   EF4 is the INPUT button on both systems.  EF3 is the bit banged serial
+  // input, which is always idle (a mark, which reads as EF3 asserted) since
+  // we use the UART.  The BIOS autobaud watches EF3 and the UART at the same
+  // time, so this matters!  EF2 is the PS/2 keyboard data ready flag and
+  // there's never a keyboard.  EF1 is the VT1802 interrupt request ...
+  //--
+  if (nEF == 1) return m_fVideo && m_VT1802.IsIRQ();
+  if (nEF == 3) return true;
+  return (nEF == 4) ? m_fInput : false;
+}
+
+
+void CElfSystem::SetTimer (WORD wStart, WORD wEnd, bool fCall)
+{
+  //++
+  //   Time the code that runs from wStart to wEnd.  Every time the CPU gets to
+  // wStart we note the cycle count, and every time it gets to wEnd after that
+  // we add the elapsed cycles to the statistics.  If fCall is true then wEnd
+  // is ignored and wStart is the entry point of a subroutine called with SCRT
+  // instead.  The SCRT CALL leaves the return address in the linkage register
+  // (A, R6), so that's where the window ends this time.  Calls nested inside
+  // the one being timed are just part of it ...
+  //--
+  memset(m_afBreak, 0, sizeof(m_afBreak));
+  m_wTimerStart = wStart;  m_wTimerEnd = fCall ? wStart : wEnd;
+  m_fTimerCall = fCall;
+  m_afBreak[m_wTimerStart] = m_afBreak[m_wTimerEnd] = true;
+  m_CPU.SetBreakpoints(m_afBreak);
+}
+
+
+void CElfSystem::Breakpoint()
+{
+  //++
+  // Called when the CPU stops on one of the SetTimer() addresses ...
+  //--
+  WORD wPC = m_CPU.GetPC();
+  QUAD qNow = m_CPU.GetCycles();
+  if ((wPC == m_wTimerEnd) && m_fTiming && !m_fTimerCall) {
+    AddTimer(qNow - m_qTimerStart);  m_fTiming = false;
+  }
+  if (m_fTimerCall && m_fTiming && (wPC == m_wTimerReturn)) {
+    AddTimer(qNow - m_qTimerStart);  m_fTiming = false;
+    if (m_wTimerReturn != m_wTimerStart) m_afBreak[m_wTimerReturn] = false;
+  }
+  if ((wPC == m_wTimerStart) && !(m_fTimerCall && m_fTiming)) {
+    m_qTimerStart = qNow;  m_fTiming = true;
+    if (m_fTimerCall) {
+      m_wTimerReturn = m_CPU.GetReg(LINKAGE);  m_afBreak[m_wTimerReturn] = true;
+    }
+  }
+}
+
+
+void CElfSystem::AddTimer (QUAD qElapsed)
+{
+  //++
+  // Add one pass thru the SetTimer() window to the statistics ...
+  //--
+  m_qTimerTotal += qElapsed;  ++m_nTimerCount;
+  if (qElapsed < m_qTimerMin) m_qTimerMin = qElapsed;
+  if (qElapsed > m_qTimerMax) m_qTimerMax = qElapsed;
+}
+
+
+void CElfSystem::ReportTimer (FILE *pFile) const
+{
+  //++
+  //   Print the statistics collected for the SetTimer() window.  The rate is
+  // how many passes per second the CPU could manage at the average time ...
+  //--
+  char szWindow[32];
+  if (m_fTimerCall)
+    sprintf(szWindow, "CALL %04X", m_wTimerStart);
+  else
+    sprintf(szWindow, "%04X..%04X", m_wTimerStart, m_wTimerEnd);
+  if (m_nTimerCount == 0) {
+    fprintf(pFile, "timer %s: never completed\n", szWindow);
+    return;
+  }
+  QUAD qAverage = m_qTimerTotal / m_nTimerCount;
+  fprintf(pFile, "timer %s: %u passes, %llu cycles total, min %llu, max %llu, avg %llu (%.1f us, %.1f/second)\n",
+    szWindow, m_nTimerCount, (unsigned long long) m_qTimerTotal,
+    (unsigned long long) m_qTimerMin, (unsigned long long) m_qTimerMax,
+    (unsigned long long) qAverage, CyclesToSeconds(qAverage) * 1.0E6,
+    (double) m_nTimerCount / CyclesToSeconds(m_qTimerTotal));
+}
+
+
+void CElfSystem::Run (QUAD qLimit)
+{
+  //++
+  //   Run the system until the cycle counter reaches qLimit or the monitor
+  // prints its prompt.  Each trip thru the loop clocks the devices, figures
+  // out when the next thing will happen, and lets the CPU run until then.
+  //--
+  while ((m_CPU.GetCycles() < qLimit) && !m_fPrompt) {
+    //   While the bootstrap is in effect, execute one instruction at a time
+    // and watch for the first fetch from the upper half of memory ...
+    if (m_fBootstrap) {
+      m_CPU.Run(m_CPU.GetCycles() + 1);
+      if ((m_CPU.GetPC() & ROM_BASE) != 0) {m_fBootstrap = false;  MapMemory();}
+      if (m_CPU.IsBreak()) Breakpoint();
+      continue;
+    }
+
+    // Bring all the devices up to date ...
+    QUAD qNow = m_CPU.GetCycles();
+    m_UART.Clock(qNow);  m_RTC.Clock(qNow);
+    if (m_fVideo) m_VT1802.Clock(qNow);
+    ReceiveInput(qNow);  UpdateIRQ();
+    // (the UART might have just finished transmitting the prompt!)
+    if (m_fPrompt) break;
+
+    // And figure out when we next need to do that ...
+    QUAD qNext = qLimit, q;
+    if ((q = m_UART.NextEvent()) < qNext) qNext = q;
+    if ((q = m_RTC.NextEvent()) < qNext) qNext = q;
+    if (m_fVideo && ((q = m_VT1802.NextEvent()) < qNext)) qNext = q;
+    if (IsInputDue(m_qNextInput) && (m_qNextInput < qNext))
+      qNext = (m_qNextInput > qNow) ? m_qNextInput : qNow+1;
+    if (qNext <= qNow) qNext = qNow+1;
+
+    m_CPU.Run(qNext);
+    if (m_CPU.IsBreak()) Breakpoint();
+  }
+}
@@ -0,0 +1,248 @@
+//++
+//elfsys.hpp - Elf 2000 and PicoElf system emulation
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   The CElfSystem class glues a CCOSMAC CPU, a CUART and a CDS12887 together
+// (plus, optionally, a CVT1802) into either an Elf 2000 or a PicoElf.  Both have 32K of RAM from $0000 to
+// $7FFF (the monitor's RAMPAGE is the top page) and 32K of EPROM from $8000
+// to $FFFF.  After a reset the EPROM is also mapped to every page of the
+// lower 32K until the CPU fetches an instruction from the upper half - that's
+// how the hardware gets from R0=0 to the cold start vector at $8000.
+//
+//   The two systems differ only in their I/O decoding -
+//
+//	Elf 2000			PicoElf
+//	--------			-------
+//	2 - IDE/UART/NVR select		2 - IDE select
+//	3 - IDE/UART/NVR data		3 - IDE data
+//	4 - LEDS/switches		4 - LEDS/switches
+//	1,5 - 8275 CRTC			6 - UART/NVR select
+//	6,7 - GPIO PPI/PS2 keyboard	7 - UART/NVR data
+//
+// On both, a select value with bit 7 set addresses the RTC/NVR and a value
+// of $10..$17 addresses the UART.  Anything else on the Elf 2000 goes to the
+// IDE bus, where $00..$07 are the ATA command block registers and $08..$0F
+// the control block.  An IDE drive (a CIDE) is attached only if it's given an
+// image file, and otherwise the bus is empty.  On the PicoElf writing a select value of $4x resets both the UART and RTC.  The
+// PS/2 keyboard isn't implemented, and the monitor correctly decides that
+// it's absent.  The GPIO card's 8255 PPI (a CPPI) is there only if SetPPI()
+// installs it.  Its register is selected by writing the GPIO control register
+// with the PPI enable bit set, the same as the real card.  The other side of
+// port A is a bridge to the host that's infinitely fast - bytes given to
+// StreamPPI() are strobed in as soon as the CPU has read the last one, and
+// every byte the CPU writes is acknowledged at once and goes to the PPI
+// output file.  The speaker bits are ignored.  The VT1802 video card is implemented but it
+// must be installed by SetVideo().  When it is, EF1 is its interrupt request
+// and the monitor keeps it running even though the console is still the UART
+// (there's no keyboard).
+//
+//   The console is the UART.  Characters to be "typed" are queued by the
+// caller with TypeAhead(), and we feed them to the UART only when its receiver
+// can accept another one (and no faster than one per character time, if the
+// baud rate is set).  Characters passed to StreamInput() are sent at the
+// full line rate without waiting for the UART, the way a host sends a file.
+// If flow control is enabled, then the stream also stops whenever the UART's
+// RTS output is off, the same as a host that uses hardware flow control.
+// Characters transmitted by the UART go to the console output file, and we
+// watch for the monitor's prompt so that the caller can decide what to type
+// next.  Since the BIOS autobaud routine (POST code 16)
+// needs to see a carriage return before it'll do anything, we type one
+// automatically when that POST code shows up.
+//
+//   Everything is timed in CPU machine cycles.  Run() executes instructions
+// until the next device "event" (e.g. the UART finishing a character or the
+// next input character being due) and then clocks the devices and continues.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+// 17-Oct-26    RLA     Add StreamInput() for timing HEX file downloads.
+// 17-Oct-26    RLA     Add SetFlowControl() (RTS/CTS for streamed input).
+// 17-Oct-26    RLA     Add the VT1802 video card.
+// 17-Oct-26    RLA     SetTimer() can time an SCRT subroutine call.
+// 17-Oct-26    RLA     Add the IDE drive.
+// 17-Oct-26    RLA     Add the GPIO PPI.
+//--
+#ifndef _elfsys_hpp_
+#define _elfsys_hpp_
+#include <stdio.h>		// FILE, ...
+#include <string>		// C++ std::string class
+#include <deque>		// C++ std::deque template
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "cosmac.hpp"		// CCOSMAC CPU emulation
+#include "uart.hpp"		// CUART 16450/16550 emulation
+#include "ds12887.hpp"		// CDS12887 RTC/NVR emulation
+#include "vt1802.hpp"		// CVT1802 video card emulation
+#include "ide.hpp"		// CIDE drive emulation
+#include "ppi.hpp"		// CPPI 8255 emulation
+
+class CElfSystem : public CCOSMAC::CBus, public CUART::CHost, public CVT1802::CHost {
+  //++
+  // Public constants ...
+  //--
+public:
+  enum {
+    RAM_SIZE    = 32768,	// SRAM from $0000 to $7FFF
+    ROM_SIZE    = 32768,	// EPROM from $8000 to $FFFF
+    ROM_BASE    = 0x8000,	// ...
+    // I/O ports used by both systems ...
+    PORT_IDE_SELECT = 2, PORT_IDE_DATA = 3, PORT_LEDS = 4, PORT_SWITCHES = 4,
+    // UART and NVR on the Elf 2000 (shared with the IDE!) ...
+    ELF2K_NVR_SELECT = 2, ELF2K_NVR_DATA = 3,
+    // UART and NVR on the PicoElf ...
+    PICO_NVR_SELECT = 6, PICO_NVR_DATA = 7,
+    // VT1802 8275 CRTC on the Elf 2000 ...
+    ELF2K_CRTC_PARAMETER = 1, ELF2K_CRTC_COMMAND = 5, ELF2K_CRTC_STATUS = 5,
+    // GPIO card on the Elf 2000 ...
+    ELF2K_PPI_DATA = 6, ELF2K_GPIO_CONTROL = 7,
+    GPIO_PPI_ENABLE = 0x04, GPIO_PPI_SELECT = 0x03,
+    // Select register decoding ...
+    SELECT_NVR = 0x80, SELECT_RESET = 0x40, SELECT_UART = 0x10,
+    SELECT_IDE_MASK = 0x0F,
+    // The POST code that means "waiting for autobaud" ...
+    POST_AUTOBAUD = 0x16,
+    // The SCRT linkage register (A) that holds a CALL's return address ...
+    LINKAGE = 6
+  };
+
+  // Constructor and destructor ...
+public:
+  CElfSystem (bool fPicoElf, QUAD qClockHz);
+  virtual ~CElfSystem() {};
+private:
+  // Disallow copy and assignments!
+  CElfSystem (const CElfSystem &) = delete;
+  CElfSystem& operator= (const CElfSystem &) = delete;
+
+  // Public methods ...
+public:
+  // Load the EPROM image from an Intel HEX file ...
+  bool LoadROM (const char *pszFile, std::string &sError);
+  // Hardware reset (CPU, UART and bootstrap) ...
+  void Reset();
+  // Run until the cycle limit, the prompt, or Stop() ...
+  void Run (QUAD qLimit);
+  // Access to the component parts ...
+  CCOSMAC &CPU() {return m_CPU;}
+  CUART &UART() {return m_UART;}
+  CDS12887 &RTC() {return m_RTC;}
+  CVT1802 &VT1802() {return m_VT1802;}
+  CIDE &IDE() {return m_IDE;}
+  CPPI &PPI() {return m_PPI;}
+  // Install the VT1802 video card (Elf 2000 only) ...
+  void SetVideo (bool fVideo) {m_fVideo = fVideo && !m_fPicoElf;}
+  bool IsVideo() const {return m_fVideo;}
+  // Install the GPIO card's PPI (Elf 2000 only) and talk to its port A ...
+  void SetPPI (bool fPPI) {m_fPPI = fPPI && !m_fPicoElf;}
+  bool IsPPI() const {return m_fPPI;}
+  void StreamPPI (const std::string &s) {m_PPIInput.insert(m_PPIInput.end(), s.begin(), s.end());}
+  void SetPPIOutput (FILE *pFile) {m_pPPIOutput = pFile;}
+  QUAD GetPPIBytesIn() const {return m_qPPIIn;}
+  QUAD GetPPIBytesOut() const {return m_qPPIOut;}
+  // Front panel ...
+  void SetSwitches (BYTE bSwitches) {m_bSwitches = bSwitches;}
+  void SetInputSwitch (bool fInput) {m_fInput = fInput;}
+  BYTE GetLEDs() const {return m_bLEDs;}
+  // Set the console baud rate (zero means infinitely fast) ...
+  void SetBaud (unsigned nBaud);
+  // Console input and output ...
+  void TypeAhead (const std::string &s) {m_Input.insert(m_Input.end(), s.begin(), s.end());}
+  void StreamInput (const std::string &s) {m_Stream.insert(m_Stream.end(), s.begin(), s.end());}
+  bool IsInputEmpty() const {return m_Input.empty() && m_Stream.empty();}
+  void SetFlowControl (bool fFlow) {m_fFlowControl = fFlow;}
+  void SetConsole (FILE *pFile) {m_pConsole = pFile;}
+  void SetPrompt (const std::string &s) {m_sPrompt = s;}
+  bool IsPrompt() const {return m_fPrompt;}
+  void ClearPrompt() {m_fPrompt = false;}
+  const std::string &GetOutput() const {return m_sOutput;}
+  // POST code tracing (each change of the LEDs is printed here) ...
+  void SetPOSTTrace (FILE *pFile) {m_pPOSTTrace = pFile;}
+  // Time the code between two addresses, or an SCRT subroutine call ...
+  void SetTimer (WORD wStart, WORD wEnd, bool fCall=false);
+  void ReportTimer (FILE *pFile) const;
+  // Convert machine cycles to seconds ...
+  double CyclesToSeconds (QUAD qCycles) const
+    {return (double) qCycles / (double) m_qCyclesPerSecond;}
+
+  // CCOSMAC::CBus, CUART::CHost and CVT1802::CHost interfaces ...
+public:
+  virtual BYTE Input (unsigned nPort);
+  virtual void Output (unsigned nPort, BYTE bData);
+  virtual bool GetEF (unsigned nEF);
+  virtual void InterruptAcknowledge();
+  virtual void Transmit (BYTE bData);
+  virtual void UpdateIRQ();
+  virtual BYTE DMAOut() {return m_CPU.DMAOut();}
+
+  // Private methods ...
+private:
+  void MapMemory();
+  BYTE ReadSelected (BYTE bSelect);
+  void WriteSelected (BYTE bSelect, BYTE bData);
+  void ReceiveInput (QUAD qNow);
+  bool IsInputDue (QUAD qNow) const;
+  void Breakpoint();
+  void AddTimer (QUAD qElapsed);
+  void UpdatePPI();
+
+  // Private member data ...
+private:
+  bool        m_fPicoElf;		// true for PicoElf, false for Elf 2000
+  QUAD        m_qCyclesPerSecond;	// machine cycles per second
+  CCOSMAC     m_CPU;			// the CPU
+  CUART       m_UART;			// console UART
+  CDS12887    m_RTC;			// real time clock and NVR
+  CVT1802     m_VT1802;			// VT1802 video card
+  bool        m_fVideo;			// true if the VT1802 is installed
+  CIDE        m_IDE;			// IDE master drive
+  CPPI        m_PPI;			// GPIO card 8255 PPI
+  bool        m_fPPI;			// true if the PPI is installed
+  BYTE        m_bPPISelect;		// PPI register selected by GPIO control
+  std::deque<char> m_PPIInput;		// bytes waiting to be strobed in
+  FILE       *m_pPPIOutput;		// bytes acknowledged go here
+  QUAD        m_qPPIIn, m_qPPIOut;	// bytes strobed in and taken out
+  BYTE        m_abRAM[RAM_SIZE];	// SRAM
+  BYTE        m_abROM[ROM_SIZE];	// EPROM
+  bool        m_fBootstrap;		// EPROM is mapped everywhere
+  BYTE        m_bIDESelect;		// IDE (and Elf2K UART/NVR) select
+  BYTE        m_bNVRSelect;		// PicoElf UART/NVR select
+  BYTE        m_bLEDs, m_bSwitches;	// POST display and toggle switches
+  bool        m_fInput;			// INPUT switch (EF4)
+  QUAD        m_qCharacterTime;		// console character time, in cycles
+  QUAD        m_qNextInput;		// time the next input character is due
+  std::deque<char> m_Input;		// characters waiting to be typed
+  std::deque<char> m_Stream;		// characters streamed after those
+  bool        m_fFlowControl;		// streams wait for RTS
+  QUAD        m_qRTSDrop;		// time RTS was last dropped
+  FILE       *m_pConsole;		// console output goes here
+  FILE       *m_pPOSTTrace;		// POST code trace goes here
+  std::string m_sPrompt;		// the monitor's prompt string
+  bool        m_fPrompt;		// true when the prompt was just printed
+  std::string m_sOutput;		// the last few console output characters
+  bool        m_afBreak[65536];		// breakpoint table for SetTimer()
+  WORD        m_wTimerStart, m_wTimerEnd;// timed code window
+  bool        m_fTimerCall;		// true to time a subroutine call
+  WORD        m_wTimerReturn;		// return address for that call
+  bool        m_fTiming;		// true while inside the window
+  QUAD        m_qTimerStart;		// cycle count at entry
+  QUAD        m_qTimerTotal, m_qTimerMin, m_qTimerMax;// statistics
+  unsigned    m_nTimerCount;		// ...
+};
+
+#endif	// _elfsys_hpp_
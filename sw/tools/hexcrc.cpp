@@ -0,0 +1,152 @@
+//++
+//hexcrc.cpp - compute the monitor's CHECKSUM for a HEX file
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   HEXCRC reads an Intel HEX file and types the same CRC-16 that the
+// monitor's CHECKSUM command would for the same range of memory, so checking
+// that a program in RAM still matches the file takes one command instead of
+// another download.  The output is the command to type, followed by the CRC,
+// for example
+//
+//	CHECKSUM 0100 01FF = 31C3
+//
+//   The CRC is CRC-16/XMODEM - polynomial $1021, starting from zero, most
+// significant bit first and nothing reflected or inverted.  It's table driven
+// here too, although the table is built the simple way, a bit at a time, and
+// not the way CRCTAB in boots.asm does it.
+//
+//   RAM that the file doesn't load could contain anything, so if any byte in
+// the range isn't in the file we say so and give up, unless -f says what to
+// use instead.  To find out which bytes are missing, the file is simply loaded
+// twice, over 00s and then over FFs, and compared - anything that changed
+// wasn't loaded.
+//
+// USAGE:
+//	hexcrc [-a address] [-e end] [-f fill] file.hex
+//
+//	-a address	first address (default the lowest address loaded)
+//	-e end		last address (default the highest address loaded)
+//	-f fill		value for bytes that aren't in the file
+//
+// and all three are in hex, the same as the monitor.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#include <stdio.h>		// printf(), fprintf(), etc ...
+#include <stdlib.h>		// exit(), strtoul(), ...
+#include <string.h>		// memset(), ...
+#include <unistd.h>		// getopt() ...
+#include <string>		// C++ std::string class
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "hexfile.hpp"		// LoadIntelHex() ...
+
+// Exit status codes ...
+#define EXIT_OK		0	// everything worked
+#define EXIT_ERROR	1	// anything else
+
+// CRC parameters (these have to agree with CRCCMD in boots.asm!) ...
+#define CRC_POLY	0x1021	// CRC-16/XMODEM polynomial
+#define CRC_INIT	0x0000	// and the initial value
+
+
+static void Usage()
+{
+  fprintf(stderr, "usage: hexcrc [-a address] [-e end] [-f fill] file.hex\n");
+  exit(EXIT_ERROR);
+}
+
+
+static WORD Crc16 (const BYTE *pbData, unsigned cbData)
+{
+  //++
+  //   Compute the CRC-16 of a block of data, a byte at a time with a 256
+  // entry table ...
+  //--
+  static WORD awTable[256];  static bool fTable = false;
+  if (!fTable) {
+    for (unsigned i = 0;  i < 256;  ++i) {
+      WORD w = (WORD) (i << 8);
+      for (unsigned j = 0;  j < 8;  ++j)
+	w = (WORD) ((w & 0x8000) ? ((w << 1) ^ CRC_POLY) : (w << 1));
+      awTable[i] = w;
+    }
+    fTable = true;
+  }
+  WORD wCRC = CRC_INIT;
+  for (unsigned i = 0;  i < cbData;  ++i)
+    wCRC = (WORD) ((wCRC << 8) ^ awTable[((wCRC >> 8) ^ pbData[i]) & 0xFF]);
+  return wCRC;
+}
+
+
+int main (int argc, char *argv[])
+{
+  //++
+  //--
+  unsigned nAddress = ~0U, nEnd = ~0U, nFill = ~0U;
+  int ch;
+  while ((ch = getopt(argc, argv, "a:e:f:")) != -1) {
+    switch (ch) {
+      case 'a': nAddress = strtoul(optarg, NULL, 16);  break;
+      case 'e': nEnd = strtoul(optarg, NULL, 16);  break;
+      case 'f': nFill = strtoul(optarg, NULL, 16);  break;
+      default:  Usage();
+    }
+  }
+  if (optind != argc-1) Usage();
+  if (((nAddress != ~0U) && (nAddress > 0xFFFF)) || ((nEnd != ~0U) && (nEnd > 0xFFFF))
+   || ((nFill != ~0U) && (nFill > 0xFF))) Usage();
+
+  // Load the file twice, once over 00s and once over FFs ...
+  static BYTE abData[65536], abCheck[65536];
+  memset(abData, 0x00, sizeof(abData));
+  memset(abCheck, 0xFF, sizeof(abCheck));
+  unsigned nLow, nHigh;  std::string sError;
+  if (!LoadIntelHex(argv[optind], abData, sizeof(abData), nLow, nHigh, sError)
+   || !LoadIntelHex(argv[optind], abCheck, sizeof(abCheck), nLow, nHigh, sError)) {
+    fprintf(stderr, "hexcrc: %s\n", sError.c_str());  return EXIT_ERROR;
+  }
+  if (nLow > nHigh) {
+    fprintf(stderr, "hexcrc: %s is empty\n", argv[optind]);  return EXIT_ERROR;
+  }
+  if (nAddress == ~0U) nAddress = nLow;
+  if (nEnd == ~0U) nEnd = nHigh;
+  if (nAddress > nEnd) {
+    fprintf(stderr, "hexcrc: 0x%04X is past 0x%04X\n", nAddress, nEnd);  return EXIT_ERROR;
+  }
+
+  // Fill in, or complain about, anything that wasn't loaded ...
+  unsigned nMissing = 0, nFirst = 0;
+  for (unsigned i = nAddress;  i <= nEnd;  ++i) {
+    if (abData[i] == abCheck[i]) continue;
+    if (nMissing++ == 0) nFirst = i;
+    abData[i] = (BYTE) nFill;
+  }
+  if ((nMissing != 0) && (nFill == ~0U)) {
+    fprintf(stderr, "hexcrc: %u bytes, starting at 0x%04X, aren't in the file (use -f)\n",
+      nMissing, nFirst);
+    return EXIT_ERROR;
+  }
+
+  printf("CHECKSUM %04X %04X = %04X\n", nAddress, nEnd,
+    Crc16(abData+nAddress, nEnd-nAddress+1));
+  return EXIT_OK;
+}
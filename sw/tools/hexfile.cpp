@@ -0,0 +1,161 @@
+//++
+//hexfile.cpp - Intel HEX file reader and writer
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   This module implements the Intel HEX file routines.  See hexfile.hpp ...
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#include <stdio.h>		// FILE, fopen(), sprintf(), etc ...
+#include <string.h>		// strlen(), ...
+#include <ctype.h>		// isxdigit(), ...
+#include <string>		// C++ std::string class
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "hexfile.hpp"		// declarations for this module
+
+
+static int HexByte (const char *psz)
+{
+  //++
+  // Convert two hex digits to a byte, or return -1 if they aren't hex ...
+  //--
+  int n = 0;
+  for (unsigned i = 0;  i < 2;  ++i) {
+    char c = psz[i];
+    if (!isxdigit((unsigned char) c)) return -1;
+    n = (n << 4) | (isdigit((unsigned char) c) ? (c-'0') : ((toupper(c)-'A')+10));
+  }
+  return n;
+}
+
+
+bool LoadIntelHex (const char *pszFile, BYTE *pbData, unsigned cbData,
+		   unsigned &nLow, unsigned &nHigh, std::string &sError)
+{
+  //++
+  //   Read an Intel HEX file into the buffer.  The lowest and highest addresses
+  // loaded are returned in nLow and nHigh.  If anything goes wrong, we return
+  // false and sError describes the problem ...
+  //--
+  char szLine[600], szError[256];  szError[0] = '\0';
+  unsigned nLine = 0, nUpper = 0;
+  nLow = cbData;  nHigh = 0;
+  FILE *f = fopen(pszFile, "rt");
+  if (f == NULL) {
+    sError = std::string("unable to open ") + pszFile;  return false;
+  }
+  while (fgets(szLine, sizeof(szLine), f) != NULL) {
+    ++nLine;
+    // Ignore anything that doesn't start with a ":" ...
+    char *psz = strchr(szLine, ':');
+    if (psz == NULL) continue;
+    ++psz;
+    int nCount = HexByte(psz);
+    if ((nCount < 0) || (strlen(psz) < (size_t) (2*nCount+10))) {
+      sprintf(szError, "%s line %u: bad record", pszFile, nLine);  break;
+    }
+    BYTE abRecord[256+5];  BYTE bSum = 0;
+    for (int i = 0;  i < nCount+5;  ++i) {
+      int n = HexByte(psz + 2*i);
+      if (n < 0) {nCount = -1;  break;}
+      abRecord[i] = (BYTE) n;  bSum += (BYTE) n;
+    }
+    if (nCount < 0) {
+      sprintf(szError, "%s line %u: bad hex digit", pszFile, nLine);  break;
+    }
+    if (bSum != 0) {
+      sprintf(szError, "%s line %u: checksum error", pszFile, nLine);  break;
+    }
+    unsigned nAddress = nUpper + MKWORD(abRecord[1], abRecord[2]);
+    switch (abRecord[3]) {
+      case 0x00:
+	// Data record ...
+	if (nAddress+nCount > cbData) {
+	  sprintf(szError, "%s line %u: address %05X out of range", pszFile, nLine, nAddress);
+	  fclose(f);  sError = szError;  return false;
+	}
+	if (nCount == 0) continue;
+	memcpy(pbData+nAddress, abRecord+4, nCount);
+	if (nAddress < nLow) nLow = nAddress;
+	if (nAddress+nCount-1 > nHigh) nHigh = nAddress+nCount-1;
+	continue;
+      case 0x01:
+	// End of file ...
+	fclose(f);  return true;
+      case 0x02:
+	// Extended segment address ...
+	nUpper = MKWORD(abRecord[4], abRecord[5]) << 4;
+	continue;
+      case 0x04:
+	// Extended linear address ...
+	nUpper = MKWORD(abRecord[4], abRecord[5]) << 16;
+	continue;
+      default:
+	// Start address records (03 and 05) are ignored ...
+	continue;
+    }
+  }
+  // Here for an error, or for EOF without an end record (which is OK) ...
+  fclose(f);
+  if (szError[0] == '\0') return true;
+  sError = szError;
+  return false;
+}
+
+
+std::string IntelHexRecord (unsigned nAddress, const BYTE *pbData, unsigned cbData, BYTE bType)
+{
+  //++
+  //   Format one HEX record, complete with the leading ":" and the checksum,
+  // but without any line terminator...
+  //--
+  char sz[16];
+  BYTE bSum = (BYTE) (cbData + HIBYTE(nAddress) + LOBYTE(nAddress) + bType);
+  sprintf(sz, ":%02X%04X%02X", cbData, nAddress & 0xFFFF, bType);
+  std::string sRecord(sz);
+  for (unsigned i = 0;  i < cbData;  ++i) {
+    sprintf(sz, "%02X", pbData[i]);  sRecord += sz;  bSum += pbData[i];
+  }
+  sprintf(sz, "%02X", (BYTE) -bSum);
+  return sRecord + sz;
+}
+
+
+bool SaveIntelHex (const char *pszFile, const BYTE *pbData, unsigned cbData,
+		   unsigned nBase, std::string &sError)
+{
+  //++
+  // Write the buffer to a HEX file with 16 bytes per record ...
+  //--
+  FILE *f = fopen(pszFile, "wt");
+  if (f == NULL) {
+    sError = std::string("unable to create ") + pszFile;  return false;
+  }
+  for (unsigned i = 0;  i < cbData;  i += 16) {
+    unsigned cb = (cbData-i > 16) ? 16 : cbData-i;
+    fprintf(f, "%s\n", IntelHexRecord(nBase+i, pbData+i, cb).c_str());
+  }
+  fprintf(f, "%s\n", IntelHexRecord(0, NULL, 0, 1).c_str());
+  if (fclose(f) != 0) {
+    sError = std::string("error writing ") + pszFile;  return false;
+  }
+  return true;
+}
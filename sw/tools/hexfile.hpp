@@ -0,0 +1,48 @@
+//++
+//hexfile.hpp - Intel HEX file reader and writer
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   These routines read and write Intel HEX files in the same format that the
+// EPROM Makefile (and the monitor's own loader) uses - data records (type 00)
+// with up to 16 bytes each, and an end of file record (type 01).  Extended
+// segment and linear address records (types 02 and 04) are accepted when
+// reading, but they had better not push the address past the end of the
+// buffer.  The EPROM images are addressed from zero, so the caller tells us
+// where in the buffer address zero goes.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#ifndef _hexfile_hpp_
+#define _hexfile_hpp_
+#include <string>		// C++ std::string class
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+
+// Load a HEX file into pbData[0..cbData-1] and return the address range ...
+extern bool LoadIntelHex (const char *pszFile, BYTE *pbData, unsigned cbData,
+			  unsigned &nLow, unsigned &nHigh, std::string &sError);
+// Save pbData[0..cbData-1] to a HEX file, starting at address nBase ...
+extern bool SaveIntelHex (const char *pszFile, const BYTE *pbData, unsigned cbData,
+			  unsigned nBase, std::string &sError);
+// Format one data record (used by tools that send HEX over a serial line) ...
+extern std::string IntelHexRecord (unsigned nAddress, const BYTE *pbData,
+				   unsigned cbData, BYTE bType=0);
+
+#endif	// _hexfile_hpp_
@@ -0,0 +1,274 @@
+//++
+//hexsend.cpp - send an Intel HEX file to the Elf 2000 monitor
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   HEXSEND downloads an Intel HEX file to the Elf 2000 or PicoElf monitor
+// over a serial port, and reports how long it took.  Normally it types the
+// LOAD command and then sends the whole file as fast as the serial port will
+// go, and the monitor decodes it on the fly.  When the monitor prints its
+// summary we show that, along with the number of bytes per second actually
+// achieved.
+//
+//   With -o it uses the old ":" command instead - each record is sent as a
+// separate command line, and we wait for the monitor's prompt before sending
+// the next one.  That works with any console port (including the bit banged
+// one) but it's much slower, and comparing the two is the whole point of the
+// bytes per second figure.
+//
+//   Only the records (lines that start with ":") are sent, each one followed
+// by a carriage return.  The file is checked with LoadIntelHex() first, so
+// that we don't bother sending something that's broken to begin with.  This
+// is a POSIX program (Linux, MacOS or Cygwin) because of the serial port.
+//
+// USAGE:
+//	hexsend [-b baud] [-o] [-t seconds] port file.hex
+//
+//	-b baud		serial port baud rate (default 9600)
+//	-o		use ":" records instead of the LOAD command
+//	-t seconds	time to wait for the monitor to answer (default 5)
+//
+//   The exit status is 0 if the monitor reported no errors, 1 if it did (or
+// never answered), and 2 for anything else.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#include <stdio.h>		// printf(), fprintf(), etc ...
+#include <stdlib.h>		// exit(), strtoul(), ...
+#include <string.h>		// strlen(), strerror(), ...
+#include <errno.h>		// errno ...
+#include <fcntl.h>		// open(), O_RDWR, ...
+#include <unistd.h>		// read(), write(), getopt() ...
+#include <termios.h>		// tcsetattr(), cfsetospeed(), ...
+#include <sys/select.h>		// select() ...
+#include <sys/time.h>		// gettimeofday() ...
+#include <string>		// C++ std::string class
+#include <vector>		// C++ std::vector template
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "hexfile.hpp"		// LoadIntelHex(), ...
+
+// Exit status codes ...
+#define EXIT_OK		0	// download worked
+#define EXIT_LOADERR	1	// the monitor reported an error
+#define EXIT_ERROR	2	// anything else
+
+// Constants ...
+#define PROMPT		">>>"	// the monitor's prompt
+#define QUIET_TIME	0.1	// seconds of silence after echoing a command
+
+
+static void Usage()
+{
+  fprintf(stderr, "usage: hexsend [-b baud] [-o] [-t seconds] port file.hex\n");
+  exit(EXIT_ERROR);
+}
+
+
+static double Now()
+{
+  //++
+  // Return the current time, in seconds, for timing things ...
+  //--
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double) tv.tv_sec + (double) tv.tv_usec / 1000000.0;
+}
+
+
+static speed_t BaudToSpeed (unsigned nBaud)
+{
+  //++
+  // Convert a baud rate to the termios constant, or return B0 if invalid ...
+  //--
+  switch (nBaud) {
+    case   1200: return B1200;
+    case   2400: return B2400;
+    case   4800: return B4800;
+    case   9600: return B9600;
+    case  19200: return B19200;
+    case  38400: return B38400;
+    case  57600: return B57600;
+    case 115200: return B115200;
+    default:     return B0;
+  }
+}
+
+
+static int OpenPort (const char *pszPort, unsigned nBaud)
+{
+  //++
+  //   Open the serial port and set it to raw mode, 8N1, no flow control, at
+  // the baud rate given.  Returns the file descriptor, or -1 for an error ...
+  //--
+  int fd = open(pszPort, O_RDWR | O_NOCTTY);
+  if (fd < 0) return -1;
+  struct termios tio;
+  if (tcgetattr(fd, &tio) != 0) {close(fd);  return -1;}
+  cfmakeraw(&tio);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+  tio.c_iflag &= ~(IXON | IXOFF);
+  tio.c_cc[VMIN] = 0;  tio.c_cc[VTIME] = 0;
+  cfsetispeed(&tio, BaudToSpeed(nBaud));
+  cfsetospeed(&tio, BaudToSpeed(nBaud));
+  if (tcsetattr(fd, TCSANOW, &tio) != 0) {close(fd);  return -1;}
+  tcflush(fd, TCIOFLUSH);
+  return fd;
+}
+
+
+static bool Send (int fd, const std::string &s)
+{
+  //++
+  // Write the whole string to the serial port ...
+  //--
+  size_t cbDone = 0;
+  while (cbDone < s.length()) {
+    ssize_t cb = write(fd, s.data()+cbDone, s.length()-cbDone);
+    if (cb < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    cbDone += cb;
+  }
+  return true;
+}
+
+
+static bool Receive (int fd, std::string &sReply, double dTimeout, double dQuiet, const char *pszUntil)
+{
+  //++
+  //   Read whatever the monitor sends and append it to sReply.  We stop when
+  // pszUntil (if it's not NULL) shows up, or when nothing has arrived for
+  // dQuiet seconds (if that's not zero), or after dTimeout seconds total.  The
+  // result is true unless pszUntil was given and never appeared ...
+  //--
+  double dStart = Now(), dLast = dStart;
+  size_t nStart = sReply.length();
+  for (;;) {
+    if ((pszUntil != NULL) && (sReply.find(pszUntil, nStart) != std::string::npos)) return true;
+    double dNow = Now();
+    if (dNow-dStart >= dTimeout) return pszUntil == NULL;
+    if ((dQuiet > 0.0) && (dNow-dLast >= dQuiet)) return pszUntil == NULL;
+    fd_set fds;  FD_ZERO(&fds);  FD_SET(fd, &fds);
+    struct timeval tv = {0, 10000};
+    if (select(fd+1, &fds, NULL, NULL, &tv) <= 0) continue;
+    char ab[256];
+    ssize_t cb = read(fd, ab, sizeof(ab));
+    if (cb > 0) {sReply.append(ab, cb);  dLast = Now();}
+  }
+}
+
+
+static bool ReadRecords (const char *pszFile, std::vector<std::string> &Records,
+			 unsigned &cbData, std::string &sError)
+{
+  //++
+  //   Check the HEX file and then read all its records into a list.  cbData
+  // returns the total number of data bytes in the file ...
+  //--
+  static BYTE abCheck[65536];
+  unsigned nLow, nHigh;
+  if (!LoadIntelHex(pszFile, abCheck, sizeof(abCheck), nLow, nHigh, sError)) return false;
+  FILE *f = fopen(pszFile, "rt");
+  if (f == NULL) {
+    sError = std::string("unable to open ") + pszFile;  return false;
+  }
+  char szLine[600];  cbData = 0;
+  while (fgets(szLine, sizeof(szLine), f) != NULL) {
+    char *psz = strchr(szLine, ':');
+    if (psz == NULL) continue;
+    psz[strcspn(psz, " \t\r\n")] = '\0';
+    Records.push_back(std::string(psz));
+    unsigned nCount, nType;
+    if ((sscanf(psz+1, "%2x%*4x%2x", &nCount, &nType) == 2) && (nType == 0)) cbData += nCount;
+  }
+  fclose(f);
+  return true;
+}
+
+
+int main (int argc, char *argv[])
+{
+  unsigned nBaud = 9600;  double dTimeout = 5.0;  bool fOld = false;
+  int nOption;
+
+  // Parse the command line ...
+  while ((nOption = getopt(argc, argv, "b:ot:")) != -1) {
+    switch (nOption) {
+      case 'b': nBaud = strtoul(optarg, NULL, 10);  break;
+      case 'o': fOld = true;  break;
+      case 't': dTimeout = strtod(optarg, NULL);  break;
+      default:  Usage();
+    }
+  }
+  if ((optind != argc-2) || (BaudToSpeed(nBaud) == B0)) Usage();
+  const char *pszPort = argv[optind], *pszFile = argv[optind+1];
+
+  // Read the file and open the port ...
+  std::vector<std::string> Records;  unsigned cbData;  std::string sError;
+  if (!ReadRecords(pszFile, Records, cbData, sError)) {
+    fprintf(stderr, "hexsend: %s\n", sError.c_str());  return EXIT_ERROR;
+  }
+  int fd = OpenPort(pszPort, nBaud);
+  if (fd < 0) {
+    fprintf(stderr, "hexsend: %s: %s\n", pszPort, strerror(errno));  return EXIT_ERROR;
+  }
+
+  //   Send a carriage return and make sure the monitor is there, and then
+  // (unless we're using ":" records) type the LOAD command and give it a
+  // moment to get started ...
+  std::string sReply;  bool fOK = true;
+  if (!Send(fd, "\r") || !Receive(fd, sReply, dTimeout, 0.0, PROMPT)) {
+    fprintf(stderr, "hexsend: no response from the monitor\n");  return EXIT_ERROR;
+  }
+  if (!fOld) {
+    Send(fd, "LOAD\r");  Receive(fd, sReply, dTimeout, QUIET_TIME, NULL);
+  }
+
+  //   Send all the records.  In the old mode wait for the prompt after each
+  // one, and in the new mode just wait for the output to drain ...
+  size_t nReply = sReply.length();
+  unsigned cbSent = 0;
+  double dStart = Now();
+  for (size_t i = 0;  fOK && (i < Records.size());  ++i) {
+    std::string sRecord = Records[i] + "\r";
+    fOK = Send(fd, sRecord);  cbSent += sRecord.length();
+    if (fOld && fOK) fOK = Receive(fd, sReply, dTimeout, 0.0, PROMPT);
+  }
+  if (!fOld && fOK) fOK = (tcdrain(fd) == 0);
+
+  //   Wait for the monitor to finish up.  For LOAD that's the summary, and for
+  // ":" it's the "EOF" message ...
+  if (!fOld && fOK) fOK = Receive(fd, sReply, dTimeout, 0.0, PROMPT);
+  double dTotal = Now() - dStart;
+  close(fd);
+  std::string sResult = sReply.substr(nReply);
+  if (!fOld) fputs(sResult.c_str(), stdout);
+  if (!fOK) {
+    fprintf(stderr, "\nhexsend: no response from the monitor\n");  return EXIT_LOADERR;
+  }
+  printf("\n%u records, %u data bytes, %u bytes sent in %.2f seconds\n",
+    (unsigned) Records.size(), cbData, cbSent, dTotal);
+  if (dTotal > 0.0)
+    printf("%.0f bytes/second (%.0f data bytes/second), line limit %u bytes/second\n",
+      cbSent/dTotal, cbData/dTotal, nBaud/10);
+  return (sResult.find('?') != std::string::npos) ? EXIT_LOADERR : EXIT_OK;
+}
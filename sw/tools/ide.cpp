@@ -0,0 +1,329 @@
+//++
+//ide.cpp - IDE/ATA drive emulation
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   This module implements the CIDE class.  See ide.hpp for details.
+//
+//   Data always goes thru the one sector buffer.  A read command fills it
+// with the first sector and sets DRQ, and every time the last byte is read
+// we either refill it with the next sector or, if that was the last one,
+// clear DRQ.  Writes work the same way in reverse.  READ and WRITE MULTIPLE
+// are really no different from READ and WRITE SECTORS here, since the drive
+// never has to wait for anything, except that they're aborted unless SET
+// MULTIPLE MODE has been done first, the same as a real drive.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+// 17-Oct-26    RLA     Answer the status reads for the missing slave.
+//--
+#include <stdio.h>		// FILE, fopen(), etc ...
+#include <string.h>		// memset(), memcpy() ...
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "ide.hpp"		// declarations for this module
+
+
+CIDE::CIDE()
+{
+  //++
+  //--
+  m_fModified = false;
+  m_qSectorsRead = m_qSectorsWritten = 0;
+  Reset();
+}
+
+
+bool CIDE::LoadImage (const char *pszFile)
+{
+  //++
+  //   Load the drive image.  It has to be a whole number of sectors, and at
+  // least one of them!
+  //--
+  FILE *f = fopen(pszFile, "rb");
+  if (f == NULL) return false;
+  BYTE ab[4096];  size_t cb;
+  m_abImage.clear();
+  while ((cb = fread(ab, 1, sizeof(ab), f)) > 0)
+    m_abImage.insert(m_abImage.end(), ab, ab+cb);
+  fclose(f);
+  if (m_abImage.empty() || ((m_abImage.size() % SECTOR_SIZE) != 0)) {
+    m_abImage.clear();  return false;
+  }
+  m_fModified = false;
+  return true;
+}
+
+
+bool CIDE::SaveImage (const char *pszFile) const
+{
+  //++
+  // Write the drive image back to a file ...
+  //--
+  FILE *f = fopen(pszFile, "wb");
+  if (f == NULL) return false;
+  bool fOK = fwrite(m_abImage.data(), 1, m_abImage.size(), f) == m_abImage.size();
+  return (fclose(f) == 0) && fOK;
+}
+
+
+void CIDE::Reset()
+{
+  //++
+  //   A hardware reset (or SRST) sets the task file to the ATA "signature"
+  // and cancels any command in progress.  It also cancels SET MULTIPLE MODE.
+  //--
+  m_bFeatures = 0;  m_bCount = m_bLBA0 = 1;
+  m_bLBA1 = m_bLBA2 = m_bLBA3 = 0;
+  m_bStatus = STS_DRDY|STS_DSC;  m_bError = 1;
+  m_bCommand = 0;  m_nMultiple = 0;  m_nRemaining = 0;  m_nIndex = 0;
+}
+
+
+void CIDE::SetLBA (unsigned nLBA)
+{
+  //++
+  // Update the LBA registers (e.g. after an error, or at the end) ...
+  //--
+  m_bLBA0 = nLBA & 0xFF;  m_bLBA1 = (nLBA >> 8) & 0xFF;
+  m_bLBA2 = (nLBA >> 16) & 0xFF;
+  m_bLBA3 = (m_bLBA3 & 0xF0) | ((nLBA >> 24) & 0x0F);
+}
+
+
+void CIDE::Abort (BYTE bError)
+{
+  //++
+  // Finish the current command with an error ...
+  //--
+  m_bError = bError;  m_bStatus = STS_DRDY|STS_DSC|STS_ERR;
+  m_nRemaining = 0;  m_bCommand = 0;
+}
+
+
+void CIDE::Identify()
+{
+  //++
+  //   Build the IDENTIFY DEVICE data in the sector buffer.  Only the words
+  // that anybody is likely to look at are filled in.  Strings are stored two
+  // characters per word, first character in the high byte, as ATA says ...
+  //--
+  WORD aw[SECTOR_SIZE/2];
+  memset(aw, 0, sizeof(aw));
+  unsigned nSectors = GetSectors();
+  auto String = [&aw] (unsigned nWord, unsigned nLength, const char *psz) {
+    for (unsigned i = 0;  i < nLength;  i += 2) {
+      BYTE b1 = *psz ? *psz++ : ' ';  BYTE b2 = *psz ? *psz++ : ' ';
+      aw[nWord + i/2] = (b1 << 8) | b2;
+    }
+  };
+  aw[0]  = 0x848A;			// CompactFlash, removable
+  aw[1]  = (WORD) (nSectors / (16*63));	// default cylinders
+  aw[3]  = 16;				//  ... heads
+  aw[6]  = 63;				//  ... sectors per track
+  String(10, 20, "ELFEMU0001");
+  String(23, 8,  "1.0");
+  String(27, 40, "ELFEMU CompactFlash");
+  aw[47] = 0x8000 | MAX_MULTIPLE;	// READ/WRITE MULTIPLE supported
+  aw[49] = 0x0200;			// LBA supported
+  aw[59] = (m_nMultiple != 0) ? (0x0100 | m_nMultiple) : 0;
+  aw[60] = nSectors & 0xFFFF;		// total LBA sectors
+  aw[61] = nSectors >> 16;		// ...
+  for (unsigned i = 0;  i < SECTOR_SIZE/2;  ++i) {
+    m_abBuffer[2*i] = aw[i] & 0xFF;  m_abBuffer[2*i+1] = aw[i] >> 8;
+  }
+}
+
+
+bool CIDE::StartRead()
+{
+  //++
+  //   Load the next sector into the buffer and set DRQ, or abort the command
+  // with IDNF if we've run off the end of the drive ...
+  //--
+  unsigned nLBA = GetLBA();
+  if (nLBA >= GetSectors()) {Abort(ERR_IDNF);  return false;}
+  memcpy(m_abBuffer, &m_abImage[(size_t) nLBA*SECTOR_SIZE], SECTOR_SIZE);
+  ++m_qSectorsRead;
+  m_nIndex = 0;  m_bStatus = STS_DRDY|STS_DSC|STS_DRQ;
+  return true;
+}
+
+
+void CIDE::StartWrite()
+{
+  //++
+  // Get ready to accept another sector from the host ...
+  //--
+  if (GetLBA() >= GetSectors()) {Abort(ERR_IDNF);  return;}
+  m_nIndex = 0;  m_bStatus = STS_DRDY|STS_DSC|STS_DRQ;
+}
+
+
+void CIDE::EndOfSector()
+{
+  //++
+  //   Called when the host has read or written the last byte of a sector.
+  // Write the sector to the image if it's a write, then step the LBA and
+  // either start the next sector or finish the command ...
+  //--
+  bool fWrite = (m_bCommand == CMD_WRITE_SECTORS) || (m_bCommand == CMD_WRITE_SECTORS_NR)
+	     || (m_bCommand == CMD_WRITE_MULTIPLE);
+  if (fWrite) {
+    memcpy(&m_abImage[(size_t) GetLBA()*SECTOR_SIZE], m_abBuffer, SECTOR_SIZE);
+    m_fModified = true;  ++m_qSectorsWritten;
+  }
+  if (m_bCommand == CMD_IDENTIFY) m_nRemaining = 1;
+  if (--m_nRemaining == 0) {
+    if (m_bCommand != CMD_IDENTIFY) SetLBA(GetLBA());
+    m_bCount = 0;  m_bCommand = 0;
+    m_bStatus = STS_DRDY|STS_DSC;
+    return;
+  }
+  SetLBA(GetLBA()+1);  --m_bCount;
+  if (fWrite) StartWrite(); else StartRead();
+}
+
+
+void CIDE::DoCommand (BYTE bCommand)
+{
+  //++
+  // Start a new command ...
+  //--
+  m_bError = 0;  m_bCommand = bCommand;
+  m_nRemaining = (m_bCount == 0) ? 256 : m_bCount;
+  switch (bCommand) {
+    case CMD_IDENTIFY:
+      Identify();
+      m_nIndex = 0;  m_bStatus = STS_DRDY|STS_DSC|STS_DRQ;
+      break;
+
+    case CMD_READ_MULTIPLE:
+      if (m_nMultiple == 0) {Abort();  break;}
+      // Fall thru ...
+    case CMD_READ_SECTORS:
+    case CMD_READ_SECTORS_NR:
+      if ((m_bLBA3 & LBA3_LBA) == 0) {Abort();  break;}
+      StartRead();
+      break;
+
+    case CMD_WRITE_MULTIPLE:
+      if (m_nMultiple == 0) {Abort();  break;}
+      // Fall thru ...
+    case CMD_WRITE_SECTORS:
+    case CMD_WRITE_SECTORS_NR:
+      if ((m_bLBA3 & LBA3_LBA) == 0) {Abort();  break;}
+      StartWrite();
+      break;
+
+    case CMD_SET_MULTIPLE:
+      //   The block size has to be a power of two no bigger than the maximum
+      // (and zero disables multiple mode) ...
+      if ((m_bCount > MAX_MULTIPLE) || ((m_bCount & (m_bCount-1)) != 0)) {Abort();  break;}
+      m_nMultiple = m_bCount;
+      m_bCommand = 0;  m_bStatus = STS_DRDY|STS_DSC;
+      break;
+
+    case CMD_SET_FEATURES:
+      //   8 bit transfers on or off, and the write cache and the read look
+      // ahead, are accepted and ignored.  Anything else is aborted ...
+      switch (m_bFeatures) {
+	case 0x01: case 0x81: case 0x02: case 0x82: case 0x55: case 0xAA:
+	  m_bCommand = 0;  m_bStatus = STS_DRDY|STS_DSC;
+	  break;
+	default:
+	  Abort();
+      }
+      break;
+
+    case CMD_RECALIBRATE:
+    case CMD_INITIALIZE:
+    case 0xE0: case 0xE1: case 0xE2: case 0xE3: case 0xE5: case 0xE6:
+      // Nothing to do for these ...
+      m_bCommand = 0;  m_bStatus = STS_DRDY|STS_DSC;
+      if (bCommand == 0xE5) m_bCount = 0xFF;
+      break;
+
+    default:
+      Abort();
+  }
+}
+
+
+BYTE CIDE::Read (unsigned nRegister)
+{
+  //++
+  //   Read a drive register.  With no drive at all the bus just floats, but
+  // with the (absent) slave selected we answer the status reads for it ...
+  //--
+  if (!IsAttached()) return 0xFF;
+  if (!IsSelected()) {
+    if ((nRegister & CS1) != 0)
+      return ((nRegister & 7) == ALTSTATUS) ? 0x00 : 0xFF;
+    return ((nRegister & 7) == STATUS) ? 0x00 : 0xFF;
+  }
+  if ((nRegister & CS1) != 0)
+    return ((nRegister & 7) == ALTSTATUS) ? m_bStatus : 0xFF;
+  switch (nRegister & 7) {
+    case DATA:
+      if ((m_bStatus & STS_DRQ) == 0) return 0xFF;
+      {
+	BYTE b = m_abBuffer[m_nIndex++];
+	if (m_nIndex >= SECTOR_SIZE) EndOfSector();
+	return b;
+      }
+    case ERROR:   return m_bError;
+    case COUNT:   return m_bCount;
+    case LBA0:    return m_bLBA0;
+    case LBA1:    return m_bLBA1;
+    case LBA2:    return m_bLBA2;
+    case LBA3:    return m_bLBA3;
+    case STATUS:  return m_bStatus;
+  }
+  return 0xFF;
+}
+
+
+void CIDE::Write (unsigned nRegister, BYTE bData)
+{
+  //++
+  //   Write a drive register.  The task file registers are written even if
+  // the drive isn't selected (they're on both drives), but commands are
+  // ignored unless it is ...
+  //--
+  if ((nRegister & CS1) != 0) {
+    if (((nRegister & 7) == CONTROL) && ((bData & CONTROL_SRST) != 0)) Reset();
+    return;
+  }
+  switch (nRegister & 7) {
+    case DATA:
+      if (!IsSelected() || ((m_bStatus & STS_DRQ) == 0) || (m_bCommand == CMD_IDENTIFY)) break;
+      m_abBuffer[m_nIndex++] = bData;
+      if (m_nIndex >= SECTOR_SIZE) EndOfSector();
+      break;
+    case FEATURES:  m_bFeatures = bData;  break;
+    case COUNT:     m_bCount = bData;     break;
+    case LBA0:      m_bLBA0 = bData;      break;
+    case LBA1:      m_bLBA1 = bData;      break;
+    case LBA2:      m_bLBA2 = bData;      break;
+    case LBA3:      m_bLBA3 = bData;      break;
+    case COMMAND:
+      if (IsSelected() && IsAttached()) DoCommand(bData);
+      break;
+  }
+}
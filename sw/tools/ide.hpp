@@ -0,0 +1,130 @@
+//++
+//ide.hpp - IDE/ATA drive emulation
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   The CIDE class emulates a single IDE drive (a CompactFlash card, really)
+// attached as the master on the Elf 2000 or PicoElf IDE bus.  The drive's
+// contents come from an image file, which is just the sectors in LBA order,
+// and the size of the file is the size of the drive.  The monitor and the
+// BIOS talk to the drive with 8 bit PIO transfers, so that's all we do - every
+// read or write of the data register moves one byte.
+//
+//   Only LBA addressing and the commands that the BIOS and monitor use are
+// implemented - IDENTIFY DEVICE, READ and WRITE SECTORS, READ and WRITE
+// MULTIPLE, SET MULTIPLE MODE, SET FEATURES, INITIALIZE DEVICE PARAMETERS,
+// RECALIBRATE and the power management commands.  Anything else is aborted.
+// The drive is infinitely fast - BSY is never set and DRQ is set as soon as
+// a command is written - so any time measured by the emulator is only the
+// time taken by the CPU to move the data.  There's no slave, and with the
+// slave selected the bus reads as $FF except for the status registers - the
+// ATA spec has device 0 answer those for an absent device 1 with $00, so
+// that software waiting for BSY to clear doesn't wait forever.  The task
+// file registers still float, so a probe that writes and reads them back
+// (like the monitor's PROBE) finds no slave.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#ifndef _ide_hpp_
+#define _ide_hpp_
+#include <vector>		// C++ std::vector template
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+
+class CIDE {
+  //++
+  // ATA register addresses, bits and commands ...
+  //--
+public:
+  enum {
+    // Command block registers (CS0) ...
+    DATA = 0, ERROR = 1, FEATURES = 1, COUNT = 2, LBA0 = 3, LBA1 = 4,
+    LBA2 = 5, LBA3 = 6, STATUS = 7, COMMAND = 7,
+    // Control block registers (CS1) ...
+    CS1 = 8, ALTSTATUS = 6, CONTROL = 6,
+    // Status register bits ...
+    STS_BSY = 0x80, STS_DRDY = 0x40, STS_DSC = 0x10, STS_DRQ = 0x08,
+    STS_ERR = 0x01,
+    // Error register bits ...
+    ERR_ABRT = 0x04, ERR_IDNF = 0x10,
+    // Device/head register bits and device control bits ...
+    LBA3_DEV = 0x10, LBA3_LBA = 0x40, CONTROL_SRST = 0x04,
+    // Commands ...
+    CMD_RECALIBRATE = 0x10, CMD_READ_SECTORS = 0x20, CMD_READ_SECTORS_NR = 0x21,
+    CMD_WRITE_SECTORS = 0x30, CMD_WRITE_SECTORS_NR = 0x31,
+    CMD_INITIALIZE = 0x91, CMD_READ_MULTIPLE = 0xC4,
+    CMD_WRITE_MULTIPLE = 0xC5, CMD_SET_MULTIPLE = 0xC6,
+    CMD_IDENTIFY = 0xEC, CMD_SET_FEATURES = 0xEF,
+    // Other magic numbers ...
+    SECTOR_SIZE = 512,		// bytes per sector
+    MAX_MULTIPLE = 16		// largest READ/WRITE MULTIPLE block
+  };
+
+  // Constructor and destructor ...
+public:
+  CIDE();
+  virtual ~CIDE() {};
+
+  // Public methods ...
+public:
+  // Attach (load) and save the image file ...
+  bool LoadImage (const char *pszFile);
+  bool SaveImage (const char *pszFile) const;
+  bool IsAttached() const {return !m_abImage.empty();}
+  bool IsModified() const {return m_fModified;}
+  // Hardware reset ...
+  void Reset();
+  // Read or write a register (CS1 registers have the CS1 bit set) ...
+  BYTE Read (unsigned nRegister);
+  void Write (unsigned nRegister, BYTE bData);
+  // Statistics ...
+  QUAD GetSectorsRead() const {return m_qSectorsRead;}
+  QUAD GetSectorsWritten() const {return m_qSectorsWritten;}
+
+  // Private methods ...
+private:
+  bool IsSelected() const {return (m_bLBA3 & LBA3_DEV) == 0;}
+  unsigned GetLBA() const
+    {return ((m_bLBA3 & 0x0F) << 24) | (m_bLBA2 << 16) | (m_bLBA1 << 8) | m_bLBA0;}
+  void SetLBA (unsigned nLBA);
+  unsigned GetSectors() const
+    {return (unsigned) (m_abImage.size() / SECTOR_SIZE);}
+  void DoCommand (BYTE bCommand);
+  void Abort (BYTE bError=ERR_ABRT);
+  void Identify();
+  bool StartRead();
+  void StartWrite();
+  void EndOfSector();
+
+  // Private member data ...
+private:
+  std::vector<BYTE> m_abImage;		// the whole drive
+  bool     m_fModified;			// true if the image was written
+  BYTE     m_bFeatures, m_bCount;	// task file registers
+  BYTE     m_bLBA0, m_bLBA1, m_bLBA2, m_bLBA3;
+  BYTE     m_bStatus, m_bError;		// ...
+  BYTE     m_bCommand;			// command in progress
+  unsigned m_nMultiple;			// current READ/WRITE MULTIPLE block
+  unsigned m_nRemaining;		// sectors left in this command
+  BYTE     m_abBuffer[SECTOR_SIZE];	// sector buffer
+  unsigned m_nIndex;			// next byte in the buffer
+  QUAD     m_qSectorsRead, m_qSectorsWritten;
+};
+
+#endif	// _ide_hpp_
@@ -0,0 +1,156 @@
+//++
+//ide.cpp - IDE/ATA drive emulation
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+//
+// DESCRIPTION:
+//   This module implements the CPPI class.  See ppi.hpp for details.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "ppi.hpp"		// declarations for this module
+
+
+void CPPI::Reset()
+{
+  //++
+  // A reset puts all three ports in mode 0 as inputs ...
+  //--
+  SetMode(CTL_RESET);
+}
+
+
+void CPPI::SetMode (BYTE bControl)
+{
+  //++
+  //   Set the mode.  Like the real thing, this clears all the output latches
+  // and the handshake flip flops ...
+  //--
+  m_bControl = bControl;
+  m_bA = m_bB = m_bC = m_bAIn = 0;
+  m_fOBF = true;  m_fIBF = m_fINTE1 = m_fINTE2 = false;
+}
+
+
+void CPPI::SetBit (BYTE bControl)
+{
+  //++
+  //   Handle a port C bit set/reset control word.  In mode 2 bits 6 and 4 are
+  // the interrupt enables, and bits 3, 5 and 7 belong to the handshake, so
+  // writing them does nothing ...
+  //--
+  unsigned nBit = (bControl & CTL_BIT) >> 1;
+  bool fSet = (bControl & CTL_SET) != 0;
+  if (IsMode2() && (nBit >= 3)) {
+    if (nBit == 6) m_fINTE1 = fSet;
+    if (nBit == 4) m_fINTE2 = fSet;
+    return;
+  }
+  if (fSet) m_bC |= (1 << nBit);  else m_bC &= ~(1 << nBit);
+}
+
+
+BYTE CPPI::GetStatus() const
+{
+  //++
+  //   Return the top five bits of port C in mode 2.  INTRA is set when either
+  // half of the handshake wants attention and its interrupt is enabled ...
+  //--
+  BYTE bStatus = 0;
+  if (m_fOBF) bStatus |= STS_OBF;
+  if (m_fINTE1) bStatus |= STS_INTE1;
+  if (m_fIBF) bStatus |= STS_IBF;
+  if (m_fINTE2) bStatus |= STS_INTE2;
+  if ((m_fINTE1 && m_fOBF) || (m_fINTE2 && m_fIBF)) bStatus |= STS_INTRA;
+  return bStatus;
+}
+
+
+BYTE CPPI::Read (unsigned nRegister)
+{
+  //++
+  //   Read a register.  Input pins read as ones, since nothing is connected
+  // to them, and outputs read back their latches ...
+  //--
+  BYTE bData, bUpper;
+  switch (nRegister & 3) {
+    case PORTA:
+      if (IsMode2()) {m_fIBF = false;  return m_bAIn;}
+      return ((m_bControl & CTL_A_INPUT) != 0) ? 0xFF : m_bA;
+    case PORTB:
+      return ((m_bControl & CTL_B_INPUT) != 0) ? 0xFF : m_bB;
+    case PORTC:
+      bData = ((m_bControl & CTL_CL_INPUT) != 0) ? 0x0F : (m_bC & 0x0F);
+      if (IsMode2())
+	bUpper = GetStatus();
+      else
+	bUpper = ((m_bControl & CTL_CU_INPUT) != 0) ? 0xF0 : (m_bC & 0xF0);
+      return bData | bUpper;
+    default:
+      return m_bControl;
+  }
+}
+
+
+void CPPI::Write (unsigned nRegister, BYTE bData)
+{
+  //++
+  //   Write a register.  In mode 2 writing port A clears OBF until the other
+  // side acknowledges it.  Output latches are always written, even for input
+  // ports, the same as the real chip ...
+  //--
+  switch (nRegister & 3) {
+    case PORTA:
+      m_bA = bData;
+      if (IsMode2()) m_fOBF = false;
+      break;
+    case PORTB:
+      m_bB = bData;  break;
+    case PORTC:
+      m_bC = bData;  break;
+    default:
+      if ((bData & CTL_MODE_SET) != 0) SetMode(bData);  else SetBit(bData);
+      break;
+  }
+}
+
+
+bool CPPI::Strobe (BYTE bData)
+{
+  //++
+  //   The other side strobes a byte into port A.  That only works in mode 2,
+  // and not while the last byte is still waiting to be read ...
+  //--
+  if (!IsMode2() || m_fIBF) return false;
+  m_bAIn = bData;  m_fIBF = true;
+  return true;
+}
+
+
+BYTE CPPI::Acknowledge()
+{
+  //++
+  //   The other side takes the byte that the CPU wrote to port A.  Call this
+  // only when IsOutputFull() is true ...
+  //--
+  m_fOBF = true;
+  return m_bA;
+}
@@ -0,0 +1,100 @@
+//++
+//ide.hpp - IDE/ATA drive emulation
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+//
+// DESCRIPTION:
+//   The CPPI class emulates the Intel 8255 (well, 82C55) programmable
+// peripheral interface on the Elf 2000 GPIO card.  Modes 0 and 2 are
+// implemented, and mode 1 is treated as mode 0.  Nothing is connected to the
+// pins in mode 0, so input ports read as $FF and output ports read back the
+// last thing written.  The control word also reads back, the way the CMOS
+// parts do - the monitor's POST uses that to find the PPI.
+//
+//   In mode 2 port A is strobed and bidirectional, and the other side of it
+// belongs to whoever calls Strobe() and Acknowledge().  Strobe() latches a
+// byte into port A and sets IBF, and reading port A clears IBF again.
+// Writing port A clears OBF (it's active low) and Acknowledge() takes the
+// byte and sets it again.  Reading port C returns the mode 2 status - OBF,
+// INTE1, IBF, INTE2 and INTRA - in the top five bits.  INTRA is computed but
+// it isn't connected to anything on the GPIO card.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#ifndef _ppi_hpp_
+#define _ppi_hpp_
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+
+class CPPI {
+  //++
+  // 8255 register addresses and bits ...
+  //--
+public:
+  enum {
+    // Register addresses (A1 and A0) ...
+    PORTA = 0, PORTB = 1, PORTC = 2, CONTROL = 3,
+    // Mode set control word bits ...
+    CTL_MODE_SET = 0x80, CTL_A_MODE2 = 0x40,
+    CTL_A_INPUT = 0x10, CTL_CU_INPUT = 0x08, CTL_B_INPUT = 0x02,
+    CTL_CL_INPUT = 0x01,
+    // Bit set/reset control word fields ...
+    CTL_BIT = 0x0E, CTL_SET = 0x01,
+    // Port C status bits in mode 2 ...
+    STS_OBF = 0x80, STS_INTE1 = 0x40, STS_IBF = 0x20, STS_INTE2 = 0x10,
+    STS_INTRA = 0x08,
+    // What the control register holds after a reset (all inputs) ...
+    CTL_RESET = 0x9B
+  };
+
+  // Constructor and destructor ...
+public:
+  CPPI() {Reset();}
+  virtual ~CPPI() {};
+
+  // Public methods ...
+public:
+  // Hardware reset ...
+  void Reset();
+  // Read or write a register (from the CPU side) ...
+  BYTE Read (unsigned nRegister);
+  void Write (unsigned nRegister, BYTE bData);
+  // The other side of port A in mode 2 ...
+  bool IsMode2() const {return (m_bControl & CTL_A_MODE2) != 0;}
+  bool IsInputFull() const {return m_fIBF;}
+  bool IsOutputFull() const {return !m_fOBF;}
+  bool Strobe (BYTE bData);
+  BYTE Acknowledge();
+
+  // Private methods ...
+private:
+  void SetMode (BYTE bControl);
+  void SetBit (BYTE bControl);
+  BYTE GetStatus() const;
+
+  // Private member data ...
+private:
+  BYTE     m_bControl;			// last mode set control word
+  BYTE     m_bA, m_bB, m_bC;		// output latches
+  BYTE     m_bAIn;			// port A input latch (mode 2)
+  bool     m_fOBF, m_fIBF;		// mode 2 handshake (OBF is active low!)
+  bool     m_fINTE1, m_fINTE2;		// mode 2 interrupt enables
+};
+
+#endif	// _ppi_hpp_
@@ -0,0 +1,279 @@
+//++
+//ppilink.cpp - host side of the monitor's PARALLEL transfers
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+//
+// DESCRIPTION:
+//   This module implements the CPPILink class.  See ppilink.hpp for the
+// details, and boots.asm for the monitor's side of it.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#include <stdio.h>		// sprintf(), ...
+#include <string.h>		// strcmp(), strerror(), ...
+#include <errno.h>		// errno, EINTR, ...
+#include <unistd.h>		// read(), write(), close() ...
+#include <fcntl.h>		// open(), O_RDWR, ...
+#include <termios.h>		// tcgetattr(), cfmakeraw(), ...
+#include <sys/select.h>		// select() ...
+#include <sys/time.h>		// gettimeofday() ...
+#include <string>		// C++ std::string class
+#include <deque>		// C++ std::deque template
+#include <vector>		// C++ std::vector template
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "ppilink.hpp"		// declarations for this module
+
+// Timeouts ...
+#define REPLY_TIME	1.0	// seconds to wait for any reply
+#define MIN_RATE	1000.0	// plus a second for every this many bytes
+
+
+static double Now()
+{
+  //++
+  // Return the current time, in seconds, for timeouts ...
+  //--
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double) tv.tv_sec + (double) tv.tv_usec / 1000000.0;
+}
+
+
+CPPILink::CPPILink()
+{
+  //++
+  //   The constructor doesn't do much - Open() and Connect() do the real
+  // work ...
+  //--
+  m_fd = -1;  m_bVersion = 0;
+  m_qSent = m_qReceived = 0;
+  m_fLoopback = false;  m_wAddress = 0;  m_cbData = 0;
+}
+
+
+bool CPPILink::Open (const char *pszBridge)
+{
+  //++
+  //   Open the bridge.  It's a character device, and if it's a tty (they
+  // usually are) then set it to raw mode.  The baud rate doesn't matter to a
+  // USB bridge, but flow control does - the USB FIFO takes care of that.
+  // The name "loopback" gets the stand-in instead ...
+  //--
+  Close();
+  if (strcmp(pszBridge, "loopback") == 0) {
+    m_fLoopback = true;  m_abMemory.assign(65536, 0);
+    m_sHeader.clear();  m_cbData = 0;  m_Reply.clear();
+    return true;
+  }
+  int fd = open(pszBridge, O_RDWR | O_NOCTTY);
+  if (fd < 0) return Error(std::string(pszBridge) + ": " + strerror(errno));
+  struct termios tio;
+  if (isatty(fd)) {
+    if (tcgetattr(fd, &tio) == 0) {
+      cfmakeraw(&tio);
+      tio.c_cflag |= CLOCAL | CREAD;
+      tio.c_iflag &= ~(IXON | IXOFF);
+      tio.c_cc[VMIN] = 0;  tio.c_cc[VTIME] = 0;
+      tcsetattr(fd, TCSANOW, &tio);
+    }
+    tcflush(fd, TCIOFLUSH);
+  }
+  m_fd = fd;
+  return true;
+}
+
+
+void CPPILink::Close()
+{
+  //++
+  // Close the bridge (it's harmless if it isn't open) ...
+  //--
+  if (m_fd >= 0) close(m_fd);
+  m_fd = -1;  m_fLoopback = false;
+}
+
+
+void CPPILink::LoopbackByte (BYTE bData)
+{
+  //++
+  //   The loopback stand-in gets one byte from the host.  This does just what
+  // PARCMD in boots.asm does, except that the replies go into m_Reply ...
+  //--
+  if (m_cbData != 0) {
+    m_abMemory[m_wAddress++] = bData;
+    if (--m_cbData == 0) m_Reply.push_back(ACK);
+    return;
+  }
+  m_sHeader += (char) bData;
+  if (m_sHeader.length() < HEADER_SIZE) return;
+  WORD wAddress = (WORD) ((((BYTE) m_sHeader[1]) << 8) | (BYTE) m_sHeader[2]);
+  unsigned cbCount = (((BYTE) m_sHeader[3]) << 8) | (BYTE) m_sHeader[4];
+  switch (m_sHeader[0]) {
+    case 'W':
+      m_wAddress = wAddress;  m_cbData = cbCount;
+      if (cbCount == 0) m_Reply.push_back(ACK);
+      break;
+    case 'R':
+      for (unsigned i = 0;  i < cbCount;  ++i) m_Reply.push_back(m_abMemory[(WORD) (wAddress+i)]);
+      break;
+    case 'I':
+      m_Reply.push_back(ACK);  m_Reply.push_back(0);  break;
+    case 'Q':
+      m_Reply.push_back(ACK);  break;
+    default:
+      m_Reply.push_back(NAK);  break;
+  }
+  m_sHeader.clear();
+}
+
+
+bool CPPILink::Send (const std::string &s)
+{
+  //++
+  // Write the whole string to the bridge ...
+  //--
+  if (m_fLoopback) {
+    for (size_t i = 0;  i < s.length();  ++i) LoopbackByte((BYTE) s[i]);
+    m_qSent += s.length();
+    return true;
+  }
+  size_t cbDone = 0;
+  while (cbDone < s.length()) {
+    ssize_t cb = write(m_fd, s.data()+cbDone, s.length()-cbDone);
+    if (cb < 0) {
+      if (errno == EINTR) continue;
+      return Error(std::string("write error: ") + strerror(errno));
+    }
+    cbDone += cb;
+  }
+  m_qSent += s.length();
+  return true;
+}
+
+
+bool CPPILink::Receive (std::string &s, size_t cbWant, unsigned cbTransfer)
+{
+  //++
+  //   Read from the bridge and append to s until it's cbWant bytes long.  The
+  // Elf has to move the cbTransfer bytes of this command (in either direction)
+  // at MIN_RATE bytes a second or better, and we give up if it doesn't.
+  // Return true if we got them all ...
+  //--
+  double dEnd = Now() + REPLY_TIME + cbTransfer / MIN_RATE;
+  while (s.length() < cbWant) {
+    if (m_fLoopback) {
+      if (m_Reply.empty()) return Error("no response from the loopback");
+      s += m_Reply.front();  m_Reply.pop_front();  ++m_qReceived;
+      continue;
+    }
+    double dLeft = dEnd - Now();
+    if (dLeft <= 0.0) return Error("no response from the monitor (is it running PARALLEL?)");
+    fd_set fds;  FD_ZERO(&fds);  FD_SET(m_fd, &fds);
+    struct timeval tv = {(long) dLeft, (long) ((dLeft - (long) dLeft) * 1000000.0)};
+    if (select(m_fd+1, &fds, NULL, NULL, &tv) <= 0) continue;
+    char ab[4096];
+    size_t cbRead = cbWant - s.length();
+    ssize_t cb = read(m_fd, ab, (cbRead < sizeof(ab)) ? cbRead : sizeof(ab));
+    if (cb > 0) {s.append(ab, cb);  m_qReceived += cb;}
+  }
+  return true;
+}
+
+
+bool CPPILink::Command (char cCommand, WORD wAddress, unsigned cbCount, const BYTE *pbData)
+{
+  //++
+  //   Send a command, and for W the data that goes with it, all at once.  The
+  // bridge and the PPI's handshake take care of the flow control ...
+  //--
+  std::string s;
+  s += cCommand;
+  s += (char) (wAddress >> 8);  s += (char) (wAddress & 0xFF);
+  s += (char) (cbCount >> 8);  s += (char) (cbCount & 0xFF);
+  if (pbData != NULL) s.append((const char *) pbData, cbCount);
+  return Send(s);
+}
+
+
+bool CPPILink::WaitACK (unsigned cbTransfer)
+{
+  //++
+  //   Wait for the ACK that ends a W, I or Q.  For W it doesn't come until
+  // the Elf has read all cbTransfer data bytes ...
+  //--
+  std::string s;
+  if (!Receive(s, 1, cbTransfer)) return false;
+  if ((BYTE) s[0] == NAK) return Error("the monitor didn't understand the command");
+  if ((BYTE) s[0] != ACK) return Error("out of step with the monitor");
+  return true;
+}
+
+
+bool CPPILink::Connect()
+{
+  //++
+  //   Make sure the monitor is there and find out its version.  Anything left
+  // over from before gets thrown away first ...
+  //--
+  if (!m_fLoopback && isatty(m_fd)) tcflush(m_fd, TCIOFLUSH);
+  std::string s;
+  if (!Command('I', 0, 0) || !WaitACK() || !Receive(s, 1, 0)) return false;
+  m_bVersion = (BYTE) s[0];
+  return true;
+}
+
+
+bool CPPILink::Quit()
+{
+  //++
+  // Send the monitor back to its prompt ...
+  //--
+  return Command('Q', 0, 0) && WaitACK();
+}
+
+
+bool CPPILink::Write (WORD wAddress, const BYTE *pbData, unsigned cbData)
+{
+  //++
+  // Write memory, MAXCOUNT bytes at a time ...
+  //--
+  while (cbData > 0) {
+    unsigned cb = (cbData < MAXCOUNT) ? cbData : (unsigned) MAXCOUNT;
+    if (!Command('W', wAddress, cb, pbData) || !WaitACK(cb)) return false;
+    wAddress += cb;  pbData += cb;  cbData -= cb;
+  }
+  return true;
+}
+
+
+bool CPPILink::Read (WORD wAddress, BYTE *pbData, unsigned cbData)
+{
+  //++
+  // Read memory, MAXCOUNT bytes at a time ...
+  //--
+  while (cbData > 0) {
+    unsigned cb = (cbData < MAXCOUNT) ? cbData : (unsigned) MAXCOUNT;
+    std::string s;
+    if (!Command('R', wAddress, cb) || !Receive(s, cb, cb)) return false;
+    memcpy(pbData, s.data(), cb);
+    wAddress += cb;  pbData += cb;  cbData -= cb;
+  }
+  return true;
+}
@@ -0,0 +1,120 @@
+//++
+//ppilink.hpp - host side of the monitor's PARALLEL transfers
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+//
+// DESCRIPTION:
+//   The CPPILink class is the host side of the monitor's PARALLEL command,
+// which loads and saves memory thru port A of the GPIO card's 8255 PPI in
+// mode 2.  On the host end of the cable there's a USB to parallel bridge -
+// an FT245 style USB FIFO or a little microcontroller - that drives STB and
+// ACK and looks like a serial port to us, so every byte we write is strobed
+// into port A and every byte the Elf writes comes back to us.  See the
+// PARALLEL section of boots.asm for the protocol - in short, a command is
+//
+//	cmd addrhi addrlo counthi countlo [data ...]
+//
+// and W answers with an ACK, R with the data, I with an ACK and MONVER and
+// Q with an ACK.  The user has to type PARALLEL at the console first.
+//
+//   Open("loopback") gives you a stand-in for the bridge and the Elf both.
+// It answers the same commands from 64K of memory right here, so the rest of
+// a program can be tested without any hardware (ELFEMU -G stands in for the
+// bridge and the real monitor code, and that's the better test).  Its MONVER
+// is zero.
+//
+//   There are no checksums - the PPI handshake doesn't lose bytes the way a
+// serial line does - so if you want to be sure, read it back and compare.
+// This is POSIX code (Linux, MacOS or Cygwin) because of the bridge.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#ifndef _ppilink_hpp_
+#define _ppilink_hpp_
+#include <string>		// C++ std::string class
+#include <deque>		// C++ std::deque template
+#include <vector>		// C++ std::vector template
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+
+class CPPILink {
+  //++
+  // Public constants ...
+  //--
+public:
+  enum {
+    ACK         = 0x06,		// the command worked
+    NAK         = 0x15,		// unknown command
+    HEADER_SIZE = 5,		// cmd, addrhi, addrlo, counthi, countlo
+    MAXCOUNT    = 65535		// longest R or W
+  };
+
+  // Constructor and destructor ...
+public:
+  CPPILink();
+  virtual ~CPPILink() {Close();}
+private:
+  // Disallow copy and assignments!
+  CPPILink (const CPPILink &) = delete;
+  CPPILink& operator= (const CPPILink &) = delete;
+
+  // Public methods ...
+public:
+  // Open and close the bridge (or the "loopback" stand-in) ...
+  bool Open (const char *pszBridge);
+  void Close();
+  bool IsOpen() const {return (m_fd >= 0) || m_fLoopback;}
+  bool IsLoopback() const {return m_fLoopback;}
+  // Make sure the monitor is there, and send it back to the prompt ...
+  bool Connect();
+  bool Quit();
+  // Memory ...
+  bool Read (WORD wAddress, BYTE *pbData, unsigned cbData);
+  bool Write (WORD wAddress, const BYTE *pbData, unsigned cbData);
+  // The monitor version, line statistics and the last error ...
+  BYTE GetVersion() const {return m_bVersion;}
+  QUAD GetBytesSent() const {return m_qSent;}
+  QUAD GetBytesReceived() const {return m_qReceived;}
+  const std::string &GetError() const {return m_sError;}
+
+  // Private methods ...
+private:
+  bool Send (const std::string &s);
+  bool Receive (std::string &s, size_t cbWant, unsigned cbTransfer);
+  bool Command (char cCommand, WORD wAddress, unsigned cbCount, const BYTE *pbData=NULL);
+  bool WaitACK (unsigned cbTransfer=0);
+  void LoopbackByte (BYTE bData);
+  bool Error (const std::string &s) {m_sError = s;  return false;}
+
+  // Private member data ...
+private:
+  int         m_fd;			// bridge file descriptor
+  BYTE        m_bVersion;		// monitor version (MONVER)
+  QUAD        m_qSent, m_qReceived;	// bytes sent and received
+  std::string m_sError;			// description of the last error
+  // The loopback stand-in ...
+  bool        m_fLoopback;		// true for Open("loopback")
+  std::vector<BYTE> m_abMemory;		// its memory
+  std::string m_sHeader;		// the command it's collecting
+  WORD        m_wAddress;		// where W data goes next
+  unsigned    m_cbData;			// W data still to come
+  std::deque<char> m_Reply;		// and what it sends back
+};
+
+#endif	// _ppilink_hpp_
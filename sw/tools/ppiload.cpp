@@ -0,0 +1,196 @@
+//++
+//ppiload.cpp - load and save the Elf's memory thru the GPIO card's PPI
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   PPILOAD uses CPPILink to load an Intel HEX file into the Elf's memory, or
+// save a range of memory to one, thru the monitor's PARALLEL command and a
+// USB to parallel bridge on the GPIO card's PPI.  With -t instead it writes
+// a block of pseudo random data, reads it back and compares it, and reports
+// how many bytes per second each direction managed.  Either way we end with
+// a Q to get the monitor back to its prompt.
+//
+//   RAM that the file doesn't load is left alone.  To find out which bytes
+// those are the file is simply loaded twice, over 00s and then over FFs, the
+// same as HEXCRC does it, and each run of bytes that didn't change is sent
+// with one W.  ELFEMU -G gives you a pseudo terminal in place of the bridge,
+// and the bridge name "loopback" needs no Elf at all.
+//
+// USAGE:
+//	ppiload [-l file] [-s file] [-t] [-a address] [-n bytes] bridge
+//
+//	-l file		load a HEX file
+//	-s file		save -n bytes from -a to a HEX file
+//	-t		time writing and reading -n bytes at -a
+//	-a address	where to start (hex, default 1000)
+//	-n bytes	how many bytes (default 4096)
+//
+//   The exit status is 0 if everything worked, 1 if the -t data didn't
+// compare, and 2 for anything else.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#include <stdio.h>		// printf(), fprintf(), etc ...
+#include <stdlib.h>		// exit(), strtoul(), ...
+#include <unistd.h>		// getopt() ...
+#include <sys/time.h>		// gettimeofday() ...
+#include <string>		// C++ std::string class
+#include <vector>		// C++ std::vector template
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "hexfile.hpp"		// LoadIntelHex(), SaveIntelHex(), ...
+#include "ppilink.hpp"		// CPPILink class
+
+// Exit status codes ...
+#define EXIT_OK		0	// everything worked
+#define EXIT_COMPARE	1	// the data read back was wrong
+#define EXIT_ERROR	2	// anything else
+
+
+static void Usage()
+{
+  fprintf(stderr, "usage: ppiload [-l file] [-s file] [-t] [-a address] [-n bytes] bridge\n");
+  exit(EXIT_ERROR);
+}
+
+
+static double Now()
+{
+  //++
+  // Return the current time, in seconds, for timing things ...
+  //--
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double) tv.tv_sec + (double) tv.tv_usec / 1000000.0;
+}
+
+
+static bool Load (CPPILink &Link, const char *pszFile)
+{
+  //++
+  //   Load a HEX file twice, over 00s and over FFs, and write every run of
+  // bytes that's the same both times ...
+  //--
+  std::vector<BYTE> abZeros(65536, 0x00), abOnes(65536, 0xFF);
+  unsigned nLow, nHigh, nLow2, nHigh2;  std::string sError;
+  if (!LoadIntelHex(pszFile, abZeros.data(), 65536, nLow, nHigh, sError)
+   || !LoadIntelHex(pszFile, abOnes.data(), 65536, nLow2, nHigh2, sError)) {
+    fprintf(stderr, "ppiload: %s\n", sError.c_str());  return false;
+  }
+  unsigned cbTotal = 0, nRuns = 0;
+  double dStart = Now();
+  for (unsigned nStart = nLow;  nStart <= nHigh;  ) {
+    if (abZeros[nStart] != abOnes[nStart]) {++nStart;  continue;}
+    unsigned nEnd = nStart;
+    while ((nEnd < nHigh) && (abZeros[nEnd+1] == abOnes[nEnd+1])) ++nEnd;
+    if (!Link.Write((WORD) nStart, abZeros.data()+nStart, nEnd-nStart+1)) {
+      fprintf(stderr, "ppiload: %s\n", Link.GetError().c_str());  return false;
+    }
+    cbTotal += nEnd-nStart+1;  ++nRuns;  nStart = nEnd+1;
+  }
+  double dTime = Now() - dStart;
+  printf("loaded %u bytes (%04X..%04X, %u runs) in %.2f seconds\n", cbTotal, nLow, nHigh, nRuns, dTime);
+  return true;
+}
+
+
+static bool Save (CPPILink &Link, const char *pszFile, unsigned nAddress, unsigned cbData)
+{
+  //++
+  // Read memory and write it to a HEX file ...
+  //--
+  std::vector<BYTE> abData(cbData);  std::string sError;
+  if (!Link.Read((WORD) nAddress, abData.data(), cbData)) {
+    fprintf(stderr, "ppiload: %s\n", Link.GetError().c_str());  return false;
+  }
+  if (!SaveIntelHex(pszFile, abData.data(), cbData, nAddress, sError)) {
+    fprintf(stderr, "ppiload: %s\n", sError.c_str());  return false;
+  }
+  printf("saved %04X..%04X to %s\n", nAddress, nAddress+cbData-1, pszFile);
+  return true;
+}
+
+
+static int Test (CPPILink &Link, unsigned nAddress, unsigned cbData)
+{
+  //++
+  //   Make up some data that isn't all the same byte, with a simple linear
+  // congruential generator, and write it, read it back and compare ...
+  //--
+  std::vector<BYTE> abData(cbData), abCheck(cbData);
+  LONG lSeed = 1802;
+  for (unsigned i = 0;  i < cbData;  ++i) {
+    lSeed = lSeed*1103515245UL + 12345UL;  abData[i] = (BYTE) (lSeed >> 16);
+  }
+  double dStart = Now();
+  if (!Link.Write((WORD) nAddress, abData.data(), cbData)) {
+    fprintf(stderr, "ppiload: %s\n", Link.GetError().c_str());  return EXIT_ERROR;
+  }
+  double dWrite = Now() - dStart;
+  dStart = Now();
+  if (!Link.Read((WORD) nAddress, abCheck.data(), cbData)) {
+    fprintf(stderr, "ppiload: %s\n", Link.GetError().c_str());  return EXIT_ERROR;
+  }
+  double dRead = Now() - dStart;
+  printf("write  %u bytes in %.2f seconds, %.0f bytes/second\n", cbData, dWrite, cbData/dWrite);
+  printf("read   %u bytes in %.2f seconds, %.0f bytes/second\n", cbData, dRead, cbData/dRead);
+  if (abData != abCheck) {
+    fprintf(stderr, "ppiload: the data read back doesn't match\n");  return EXIT_COMPARE;
+  }
+  return EXIT_OK;
+}
+
+
+int main (int argc, char *argv[])
+{
+  unsigned nAddress = 0x1000, cbData = 4096;  bool fTest = false;
+  const char *pszLoad = NULL, *pszSave = NULL;
+  int nOption;
+
+  // Parse the command line ...
+  while ((nOption = getopt(argc, argv, "l:s:ta:n:")) != -1) {
+    switch (nOption) {
+      case 'l': pszLoad = optarg;  break;
+      case 's': pszSave = optarg;  break;
+      case 't': fTest = true;  break;
+      case 'a': nAddress = strtoul(optarg, NULL, 16);  break;
+      case 'n': cbData = strtoul(optarg, NULL, 10);  break;
+      default:  Usage();
+    }
+  }
+  if ((optind != argc-1) || (cbData == 0) || (nAddress+cbData > 65536)) Usage();
+  if ((pszLoad == NULL) && (pszSave == NULL) && !fTest) Usage();
+
+  // Open the bridge and make sure the monitor is listening ...
+  CPPILink Link;
+  if (!Link.Open(argv[optind]) || !Link.Connect()) {
+    fprintf(stderr, "ppiload: %s\n", Link.GetError().c_str());  return EXIT_ERROR;
+  }
+  printf("monitor version %u\n", Link.GetVersion());
+
+  // Do whatever we were asked, and get back to the prompt ...
+  int nStatus = EXIT_OK;
+  if ((pszLoad != NULL) && !Load(Link, pszLoad)) nStatus = EXIT_ERROR;
+  if ((nStatus == EXIT_OK) && (pszSave != NULL) && !Save(Link, pszSave, nAddress, cbData)) nStatus = EXIT_ERROR;
+  if ((nStatus == EXIT_OK) && fTest) nStatus = Test(Link, nAddress, cbData);
+  if (!Link.Quit()) {
+    fprintf(stderr, "ppiload: %s\n", Link.GetError().c_str());  return EXIT_ERROR;
+  }
+  return nStatus;
+}
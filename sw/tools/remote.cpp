@@ -0,0 +1,457 @@
+//++
+//remote.cpp - host side of the monitor's REMOTE binary protocol
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   This file implements the CRemote class - see remote.hpp for the details.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#include <stdio.h>		// sprintf(), ...
+#include <string.h>		// memcpy(), ...
+#include <errno.h>		// errno ...
+#include <fcntl.h>		// open(), O_RDWR, ...
+#include <unistd.h>		// read(), write(), close() ...
+#include <termios.h>		// tcsetattr(), cfsetospeed(), ...
+#include <sys/select.h>		// select() ...
+#include <sys/time.h>		// gettimeofday() ...
+#include <string>		// C++ std::string class
+#include <map>			// C++ std::map template
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "remote.hpp"		// declarations for this module
+
+// CRC parameters (these have to agree with CRCTAB in boots.asm!) ...
+#define CRC_POLY	0x1021	// CRC-16/XMODEM polynomial
+#define CRC_INIT	0x0000	// and the initial value
+
+// Other constants ...
+#define PROMPT		">>>"	// the monitor's prompt
+#define PROMPT_TIME	2.0	// seconds to wait for the prompt
+#define REPLY_TIME	0.5	// seconds to wait for a reply (plus the wire time)
+#define MARK		0x79	// the breakpoint is MARK ...
+#define SEP_R1		0xD1	//  ... and SEP R1
+
+
+static double Now()
+{
+  //++
+  // Return the current time, in seconds, for timeouts ...
+  //--
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double) tv.tv_sec + (double) tv.tv_usec / 1000000.0;
+}
+
+
+static speed_t BaudToSpeed (unsigned nBaud)
+{
+  //++
+  // Convert a baud rate to the termios constant, or return B0 if invalid ...
+  //--
+  switch (nBaud) {
+    case   1200: return B1200;
+    case   2400: return B2400;
+    case   4800: return B4800;
+    case   9600: return B9600;
+    case  19200: return B19200;
+    case  38400: return B38400;
+    case  57600: return B57600;
+    case 115200: return B115200;
+    default:     return B0;
+  }
+}
+
+
+CRemote::CRemote()
+{
+  //++
+  //   The constructor doesn't do much - Open() and Connect() do the real
+  // work ...
+  //--
+  m_fd = -1;  m_nBaud = 0;
+  m_bVersion = 0;  m_cbMaxWrite = 0;  m_wRegisters = 0;
+  m_qSent = m_qReceived = 0;
+}
+
+
+bool CRemote::Open (const char *pszPort, unsigned nBaud)
+{
+  //++
+  //   Open the serial port and set it to raw mode, 8N1, no flow control, at
+  // the baud rate given ...
+  //--
+  Close();
+  if (BaudToSpeed(nBaud) == B0) return Error("invalid baud rate");
+  int fd = open(pszPort, O_RDWR | O_NOCTTY);
+  if (fd < 0) return Error(std::string(pszPort) + ": " + strerror(errno));
+  struct termios tio;
+  if (tcgetattr(fd, &tio) != 0) {
+    close(fd);  return Error(std::string(pszPort) + ": " + strerror(errno));
+  }
+  cfmakeraw(&tio);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+  tio.c_iflag &= ~(IXON | IXOFF);
+  tio.c_cc[VMIN] = 0;  tio.c_cc[VTIME] = 0;
+  cfsetispeed(&tio, BaudToSpeed(nBaud));
+  cfsetospeed(&tio, BaudToSpeed(nBaud));
+  if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+    close(fd);  return Error(std::string(pszPort) + ": " + strerror(errno));
+  }
+  tcflush(fd, TCIOFLUSH);
+  m_fd = fd;  m_nBaud = nBaud;
+  return true;
+}
+
+
+void CRemote::Close()
+{
+  //++
+  // Close the serial port (it's harmless if it isn't open) ...
+  //--
+  if (m_fd >= 0) close(m_fd);
+  m_fd = -1;
+}
+
+
+WORD CRemote::UpdateCRC (WORD wCRC, BYTE bData)
+{
+  //++
+  //   Add one byte to a CRC-16/XMODEM.  This is the same CRC that CHECKSUM
+  // and HEXCRC use, and the same table driven calculation too ...
+  //--
+  static WORD awTable[256];  static bool fTable = false;
+  if (!fTable) {
+    for (unsigned i = 0;  i < 256;  ++i) {
+      WORD w = (WORD) (i << 8);
+      for (unsigned j = 0;  j < 8;  ++j)
+	w = (WORD) ((w & 0x8000) ? ((w << 1) ^ CRC_POLY) : (w << 1));
+      awTable[i] = w;
+    }
+    fTable = true;
+  }
+  return (WORD) ((wCRC << 8) ^ awTable[((wCRC >> 8) ^ bData) & 0xFF]);
+}
+
+
+bool CRemote::Send (const std::string &s)
+{
+  //++
+  // Write the whole string to the serial port ...
+  //--
+  size_t cbDone = 0;
+  while (cbDone < s.length()) {
+    ssize_t cb = write(m_fd, s.data()+cbDone, s.length()-cbDone);
+    if (cb < 0) {
+      if (errno == EINTR) continue;
+      return Error(std::string("write error: ") + strerror(errno));
+    }
+    cbDone += cb;
+  }
+  m_qSent += s.length();
+  return true;
+}
+
+
+bool CRemote::Receive (std::string &s, size_t cbWant, double dTimeout)
+{
+  //++
+  //   Read from the serial port and append to s until it's cbWant bytes long,
+  // or until dTimeout seconds have passed.  Return true if we got them all ...
+  //--
+  double dEnd = Now() + dTimeout;
+  while (s.length() < cbWant) {
+    double dLeft = dEnd - Now();
+    if (dLeft <= 0.0) return Error("timeout");
+    fd_set fds;  FD_ZERO(&fds);  FD_SET(m_fd, &fds);
+    struct timeval tv = {(long) dLeft, (long) ((dLeft - (long) dLeft) * 1000000.0)};
+    if (select(m_fd+1, &fds, NULL, NULL, &tv) <= 0) continue;
+    char ab[256];
+    size_t cbRead = cbWant - s.length();
+    ssize_t cb = read(m_fd, ab, (cbRead < sizeof(ab)) ? cbRead : sizeof(ab));
+    if (cb > 0) {s.append(ab, cb);  m_qReceived += cb;}
+  }
+  return true;
+}
+
+
+bool CRemote::WaitFor (const std::string &sWanted, double dTimeout)
+{
+  //++
+  //   Read (and throw away) everything the monitor sends until sWanted shows
+  // up.  Return false if it doesn't within dTimeout seconds ...
+  //--
+  double dEnd = Now() + dTimeout;
+  std::string s;
+  while (s.find(sWanted) == std::string::npos) {
+    double dLeft = dEnd - Now();
+    if ((dLeft <= 0.0) || !Receive(s, s.length()+1, dLeft)) return Error("no response from the monitor");
+  }
+  return true;
+}
+
+
+bool CRemote::Type (const char *psz)
+{
+  //++
+  //   Type a command to the monitor one character at a time, waiting for the
+  // echo of each one.  At the faster baud rates the monitor can't keep up
+  // with a whole line sent at once, the way it can with binary packets (it
+  // has the FIFOs turned on for those).  The carriage return at the end is
+  // just sent ...
+  //--
+  for (;  *psz != '\0';  ++psz) {
+    if (!Send(std::string(1, *psz))) return false;
+    if ((*psz != '\r') && !WaitFor(std::string(1, *psz), PROMPT_TIME)) return false;
+  }
+  return true;
+}
+
+
+bool CRemote::Connect()
+{
+  //++
+  //   Get the monitor into REMOTE mode.  A BREAK gets it back to the prompt
+  // from wherever it was (even in the middle of a REMOTE packet), and then
+  // we type REMOTE and wait for the monitor's ACK.  The end of the echo comes
+  // first, so we just look for the three bytes of an empty ACK packet in
+  // whatever arrives.  And then ask for the monitor's parameters ...
+  //--
+  tcflush(m_fd, TCIOFLUSH);
+  tcsendbreak(m_fd, 0);
+  if (!Send("\r") || !WaitFor(PROMPT, PROMPT_TIME)) return false;
+  WORD wCRC = UpdateCRC(CRC_INIT, ACK);
+  std::string sACK;
+  sACK += (char) ACK;  sACK += (char) HIBYTE(wCRC);  sACK += (char) LOBYTE(wCRC);
+  if (!Type("REMOTE\r") || !WaitFor(sACK, PROMPT_TIME)) return false;
+  BYTE abInfo[4];
+  if (!Transaction('I', 0, 0, NULL, abInfo, sizeof(abInfo))) return false;
+  m_bVersion = abInfo[0];  m_cbMaxWrite = abInfo[1];
+  m_wRegisters = MKWORD(abInfo[2], abInfo[3]);
+  return true;
+}
+
+
+bool CRemote::Transaction (char cCommand, WORD wAddress, BYTE bLength,
+			   const BYTE *pbData, BYTE *pbReply, unsigned cbReply)
+{
+  //++
+  //   Send one command packet and wait for the reply.  pbData is the data for
+  // a W (bLength bytes of it), and pbReply gets cbReply bytes of data from
+  // the reply.  The result is false for a NAK, a bad CRC or a timeout ...
+  //--
+  std::string sPacket;
+  sPacket += cCommand;
+  sPacket += (char) HIBYTE(wAddress);  sPacket += (char) LOBYTE(wAddress);
+  sPacket += (char) bLength;
+  if (pbData != NULL) sPacket.append((const char *) pbData, bLength);
+  WORD wCRC = CRC_INIT;
+  for (size_t i = 0;  i < sPacket.length();  ++i) wCRC = UpdateCRC(wCRC, sPacket[i]);
+  sPacket += (char) HIBYTE(wCRC);  sPacket += (char) LOBYTE(wCRC);
+  if (!Send(sPacket)) return false;
+
+  //   Both packets take a while to send, so allow for that.  The status comes
+  // first, and a NAK never has any data ...
+  double dTimeout = REPLY_TIME + (sPacket.length() + 3 + cbReply) * 10.0 / m_nBaud;
+  std::string sReply;
+  if (!Receive(sReply, 1, dTimeout)) return false;
+  if ((BYTE) sReply[0] != ACK) cbReply = 0;
+  if (!Receive(sReply, 3+cbReply, dTimeout)) return false;
+  wCRC = CRC_INIT;
+  for (size_t i = 0;  i < sReply.length();  ++i) wCRC = UpdateCRC(wCRC, sReply[i]);
+  if (wCRC != 0) return Error("bad CRC in reply");
+  if ((BYTE) sReply[0] != ACK) return Error("command rejected (NAK)");
+  if (cbReply != 0) memcpy(pbReply, sReply.data()+1, cbReply);
+  return true;
+}
+
+
+bool CRemote::Exchange (char cCommand, WORD wAddress, BYTE bLength,
+			const BYTE *pbData, BYTE *pbReply, unsigned cbReply)
+{
+  //++
+  //   Do a transaction, and if it fails then reconnect and try again.  That's
+  // only safe for the commands that can be repeated (R, W and I) ...
+  //--
+  for (unsigned nTry = 0;  nTry < RETRIES;  ++nTry) {
+    if (Transaction(cCommand, wAddress, bLength, pbData, pbReply, cbReply)) return true;
+    std::string sError = m_sError;
+    if (!Connect()) return Error(sError + " (and " + m_sError + ")");
+  }
+  return false;
+}
+
+
+bool CRemote::Read (WORD wAddress, BYTE *pbData, unsigned cbData)
+{
+  //++
+  // Read a block of memory, as many R commands as it takes ...
+  //--
+  while (cbData > 0) {
+    unsigned cb = (cbData < (unsigned) MAXREAD) ? cbData : (unsigned) MAXREAD;
+    if (!Exchange('R', wAddress, (BYTE) cb, NULL, pbData, cb)) return false;
+    wAddress += cb;  pbData += cb;  cbData -= cb;
+  }
+  return true;
+}
+
+
+bool CRemote::Write (WORD wAddress, const BYTE *pbData, unsigned cbData)
+{
+  //++
+  // Write a block of memory, as many W commands as it takes ...
+  //--
+  while (cbData > 0) {
+    unsigned cb = (cbData < m_cbMaxWrite) ? cbData : m_cbMaxWrite;
+    if (!Exchange('W', wAddress, (BYTE) cb, pbData, NULL, 0)) return false;
+    wAddress += cb;  pbData += cb;  cbData -= cb;
+  }
+  return true;
+}
+
+
+bool CRemote::GetRegisters (REGISTERS &Regs)
+{
+  //++
+  //   Read the registers saved by the last breakpoint.  The monitor keeps
+  // them as X/P, D, DF and then R0 thru RF, high byte first ...
+  //--
+  BYTE ab[REGS_SIZE];
+  if (!Read(m_wRegisters, ab, sizeof(ab))) return false;
+  Regs.bXP = ab[0];  Regs.bD = ab[1];  Regs.bDF = ab[2];
+  for (unsigned i = 0;  i < 16;  ++i) Regs.awR[i] = MKWORD(ab[3+2*i], ab[4+2*i]);
+  return true;
+}
+
+
+bool CRemote::SetRegisters (const REGISTERS &Regs)
+{
+  //++
+  // Change the registers that CONTINUE will restore ...
+  //--
+  BYTE ab[REGS_SIZE];
+  ab[0] = Regs.bXP;  ab[1] = Regs.bD;  ab[2] = Regs.bDF;
+  for (unsigned i = 0;  i < 16;  ++i) {
+    ab[3+2*i] = HIBYTE(Regs.awR[i]);  ab[4+2*i] = LOBYTE(Regs.awR[i]);
+  }
+  return Write(m_wRegisters, ab, sizeof(ab));
+}
+
+
+bool CRemote::SetBreakpoint (WORD wAddress)
+{
+  //++
+  //   Patch a breakpoint into the program, after saving whatever was there.
+  // Setting the same breakpoint twice is harmless ...
+  //--
+  if (m_Breakpoints.count(wAddress) != 0) return true;
+  BYTE abOld[BREAK_SIZE], abBreak[BREAK_SIZE] = {MARK, SEP_R1};
+  if (!Read(wAddress, abOld, sizeof(abOld))) return false;
+  if (!Write(wAddress, abBreak, sizeof(abBreak))) return false;
+  m_Breakpoints[wAddress] = std::string((const char *) abOld, sizeof(abOld));
+  return true;
+}
+
+
+bool CRemote::ClearBreakpoint (WORD wAddress)
+{
+  //++
+  // Put back the original code at a breakpoint ...
+  //--
+  std::map<WORD, std::string>::iterator it = m_Breakpoints.find(wAddress);
+  if (it == m_Breakpoints.end()) {
+    char sz[40];  sprintf(sz, "no breakpoint at %04X", wAddress);
+    return Error(sz);
+  }
+  if (!Write(wAddress, (const BYTE *) it->second.data(), it->second.length())) return false;
+  m_Breakpoints.erase(it);
+  return true;
+}
+
+
+bool CRemote::WaitBreakpoint (WORD &wAddress, double dTimeout)
+{
+  //++
+  //   Wait for the program to hit one of our breakpoints.  The monitor types
+  // the registers and its prompt, and then we get back into REMOTE mode and
+  // look at the user's PC - it points just past the SEP R1.  Back it up to
+  // the breakpoint, and undo the MARK's decrement of R2, then remove the
+  // breakpoint, so that CONTINUE picks up where the program would have been
+  // without it.  Note that the MARK still overwrote the byte at M(R2) ...
+  //--
+  if (!WaitFor(PROMPT, dTimeout) || !Connect()) return false;
+  REGISTERS Regs;
+  if (!GetRegisters(Regs)) return false;
+  unsigned nP = Regs.bXP & 0x0F;
+  wAddress = Regs.awR[nP] - BREAK_SIZE;
+  if (m_Breakpoints.count(wAddress) == 0) {
+    char sz[60];  sprintf(sz, "stopped at %04X, which isn't a breakpoint", Regs.awR[nP]);
+    return Error(sz);
+  }
+  Regs.awR[nP] = wAddress;  ++Regs.awR[2];
+  return SetRegisters(Regs) && ClearBreakpoint(wAddress);
+}
+
+
+bool CRemote::Go (WORD wAddress)
+{
+  //++
+  //   Call the program at wAddress.  The monitor ACKs the G before it calls
+  // the program, and again when (if!) it returns - see WaitReturn().  The
+  // program runs with the monitor's registers, so it can RETURN to it, and
+  // with R1 pointing to the breakpoint trap.  None of the commands that
+  // start a program are retried, since they can't be repeated safely ...
+  //--
+  return Transaction('G', wAddress, 0, NULL, NULL, 0);
+}
+
+
+bool CRemote::WaitReturn (double dTimeout)
+{
+  //++
+  // Wait for the ACK that the monitor sends when a Go() program returns ...
+  //--
+  std::string sReply;
+  if (!Receive(sReply, 3, dTimeout)) return false;
+  WORD wCRC = CRC_INIT;
+  for (size_t i = 0;  i < sReply.length();  ++i) wCRC = UpdateCRC(wCRC, sReply[i]);
+  if (((BYTE) sReply[0] != ACK) || (wCRC != 0)) return Error("bad reply after the program returned");
+  return true;
+}
+
+
+bool CRemote::Continue()
+{
+  //++
+  //   Continue after a breakpoint, with the registers as they are now.  The
+  // monitor leaves REMOTE mode and we have to Connect() again after the next
+  // breakpoint (WaitBreakpoint() does that) ...
+  //--
+  return Transaction('C', 0, 0, NULL, NULL, 0);
+}
+
+
+bool CRemote::Quit()
+{
+  //++
+  // Leave REMOTE mode and wait for the monitor's prompt ...
+  //--
+  return Transaction('Q', 0, 0, NULL, NULL, 0) && WaitFor(PROMPT, PROMPT_TIME);
+}
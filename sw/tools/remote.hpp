@@ -0,0 +1,144 @@
+//++
+//remote.hpp - host side of the monitor's REMOTE binary protocol
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   The CRemote class talks to the monitor's REMOTE command over a serial
+// port, so that a loader or debugger on the host can read and write the
+// Elf's memory and registers, set breakpoints and run programs without
+// generating and parsing the monitor's text output.  See the REMOTE section
+// of boots.asm for the packet format - in short, a command is
+//
+//	cmd addrhi addrlo len [data ...] crchi crclo
+//
+// and the reply is ACK or NAK, any data, and a CRC-16/XMODEM of the lot.
+//
+//   Connect() types REMOTE at the monitor's prompt and waits for the first
+// ACK.  If the monitor is somewhere else, or a packet got lost, it sends a
+// BREAK first, which gets the monitor back to its prompt from anywhere.
+// Every transaction is retried (with a Connect() in between) a few times
+// before we give up, so a single glitch on the line doesn't lose anything.
+//
+//   The registers saved by a breakpoint are just memory (SAVEXP and REGS in
+// the monitor's data page), so GetRegisters() and SetRegisters() are a read
+// and a write of that.  Breakpoints are MARK/SEP R1 ($79 $D1) patched into
+// the program - we remember what was there so ClearBreakpoint() can put it
+// back.  When a breakpoint is hit the monitor types the registers and the
+// prompt, and WaitBreakpoint() waits for that, reconnects, backs the user's
+// PC up to the start of the breakpoint and removes it, so that Continue()
+// then executes the original instruction.
+//
+//   This is POSIX code (Linux, MacOS or Cygwin) because of the serial port.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#ifndef _remote_hpp_
+#define _remote_hpp_
+#include <string>		// C++ std::string class
+#include <map>			// C++ std::map template
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+
+class CRemote {
+  //++
+  // Public constants ...
+  //--
+public:
+  enum {
+    ACK         = 0x06,		// the command worked
+    NAK         = 0x15,		// bad command, length or CRC
+    MAXREAD     = 255,		// longest R the monitor allows
+    REGS_SIZE   = 3+16*2,	// X/P, D, DF and R0..RF
+    BREAK_SIZE  = 2,		// MARK, SEP R1
+    RETRIES     = 3		// times to retry a failed transaction
+  };
+
+  // The user's registers, as saved by a breakpoint ...
+  struct REGISTERS {
+    BYTE bXP, bD, bDF;		// X and P (XP), D and DF
+    WORD awR[16];		// R0..RF (R0 and R1 are always zero)
+  };
+
+  // Constructor and destructor ...
+public:
+  CRemote();
+  virtual ~CRemote() {Close();}
+private:
+  // Disallow copy and assignments!
+  CRemote (const CRemote &) = delete;
+  CRemote& operator= (const CRemote &) = delete;
+
+  // Public methods ...
+public:
+  // Open and close the serial port ...
+  bool Open (const char *pszPort, unsigned nBaud);
+  void Close();
+  bool IsOpen() const {return m_fd >= 0;}
+  // Get into REMOTE mode (and get out again) ...
+  bool Connect();
+  bool Quit();
+  // Memory and registers ...
+  bool Read (WORD wAddress, BYTE *pbData, unsigned cbData);
+  bool Write (WORD wAddress, const BYTE *pbData, unsigned cbData);
+  bool GetRegisters (REGISTERS &Regs);
+  bool SetRegisters (const REGISTERS &Regs);
+  // Breakpoints ...
+  bool SetBreakpoint (WORD wAddress);
+  bool ClearBreakpoint (WORD wAddress);
+  bool WaitBreakpoint (WORD &wAddress, double dTimeout);
+  // Run a program, or continue after a breakpoint ...
+  bool Go (WORD wAddress);
+  bool WaitReturn (double dTimeout);
+  bool Continue();
+  // Things the I command tells us ...
+  BYTE GetVersion() const {return m_bVersion;}
+  unsigned GetMaxWrite() const {return m_cbMaxWrite;}
+  WORD GetRegisterAddress() const {return m_wRegisters;}
+  // Line statistics (for benchmarks) and the last error ...
+  QUAD GetBytesSent() const {return m_qSent;}
+  QUAD GetBytesReceived() const {return m_qReceived;}
+  const std::string &GetError() const {return m_sError;}
+  // The CRC used for the packets (and by the CHECKSUM command) ...
+  static WORD UpdateCRC (WORD wCRC, BYTE bData);
+
+  // Private methods ...
+private:
+  bool Send (const std::string &s);
+  bool Receive (std::string &s, size_t cbWant, double dTimeout);
+  bool WaitFor (const std::string &sWanted, double dTimeout);
+  bool Type (const char *psz);
+  bool Transaction (char cCommand, WORD wAddress, BYTE bLength,
+		    const BYTE *pbData, BYTE *pbReply, unsigned cbReply);
+  bool Exchange (char cCommand, WORD wAddress, BYTE bLength,
+		 const BYTE *pbData, BYTE *pbReply, unsigned cbReply);
+  bool Error (const std::string &s) {m_sError = s;  return false;}
+
+  // Private member data ...
+private:
+  int         m_fd;			// serial port file descriptor
+  unsigned    m_nBaud;			// and its baud rate
+  BYTE        m_bVersion;		// monitor version (MONVER)
+  unsigned    m_cbMaxWrite;		// longest W (RMTMAX)
+  WORD        m_wRegisters;		// address of SAVEXP
+  QUAD        m_qSent, m_qReceived;	// bytes sent and received
+  std::string m_sError;			// description of the last error
+  std::map<WORD, std::string> m_Breakpoints;	// original code at each breakpoint
+};
+
+#endif	// _remote_hpp_
@@ -0,0 +1,204 @@
+//++
+//rmtbench.cpp - measure the throughput of the monitor's REMOTE protocol
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   RMTBENCH uses CRemote to write a block of pseudo random data to the Elf's
+// memory, read it back and compare it, and then reports how many data bytes
+// per second each direction managed and how that compares to the line rate.
+// It also reports the average round trip time for a one byte read, which is
+// pretty much the fixed cost of every packet.  The same amount of data as HEX
+// records, for comparison, is at least 2.75 times the bytes on the wire (and
+// EXAMINE output is 3.5 times or so).
+//
+//   It's also a quick test of CRemote and of the monitor's REMOTE command, and
+// with -g it plants a breakpoint in a little program, runs it, checks the
+// registers at the breakpoint, continues it, and waits for it to return.
+// Either way we end with a Q to get the monitor back to its prompt.  Any RAM
+// address that's not used by the monitor will do for the test data.  ELFEMU
+// -P gives you a pseudo terminal to try it without any hardware.
+//
+// USAGE:
+//	rmtbench [-b baud] [-a address] [-n bytes] [-g] port
+//
+//	-b baud		serial port baud rate (default 9600)
+//	-a address	where to put the test data (hex, default 1000)
+//	-n bytes	how much test data (default 4096)
+//	-g		test breakpoints, G and CONTINUE too
+//
+//   The exit status is 0 if everything worked, 1 if the data didn't compare
+// or the breakpoint test failed, and 2 for anything else.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#include <stdio.h>		// printf(), fprintf(), etc ...
+#include <stdlib.h>		// exit(), strtoul(), ...
+#include <string.h>		// memcmp(), ...
+#include <unistd.h>		// getopt() ...
+#include <sys/time.h>		// gettimeofday() ...
+#include <string>		// C++ std::string class
+#include <vector>		// C++ std::vector template
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "remote.hpp"		// CRemote class
+
+// Exit status codes ...
+#define EXIT_OK		0	// everything worked
+#define EXIT_COMPARE	1	// the data or the registers were wrong
+#define EXIT_ERROR	2	// anything else
+
+// Constants ...
+#define PINGS		20	// number of one byte reads to time
+#define RUN_TIME	2.0	// seconds to wait for the -g program
+
+
+static void Usage()
+{
+  fprintf(stderr, "usage: rmtbench [-b baud] [-a address] [-n bytes] [-g] port\n");
+  exit(EXIT_ERROR);
+}
+
+
+static double Now()
+{
+  //++
+  // Return the current time, in seconds, for timing things ...
+  //--
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double) tv.tv_sec + (double) tv.tv_usec / 1000000.0;
+}
+
+
+static void Report (const char *pszWhat, unsigned cbData, QUAD qWire, double dTime, unsigned nBaud)
+{
+  //++
+  //   Print the data rate for one test, and how that compares to the line
+  // rate and to the bytes actually sent and received ...
+  //--
+  printf("%-6s %u bytes in %.2f seconds, %.0f bytes/second, %.0f%% of the line rate, %.0f%% efficient\n",
+    pszWhat, cbData, dTime, cbData/dTime, 100.0*cbData/dTime/(nBaud/10.0), 100.0*cbData/qWire);
+}
+
+
+static bool TestBreakpoint (CRemote &Remote, WORD wAddress)
+{
+  //++
+  //   Load a little program that counts in RF, set a breakpoint in the middle
+  // of it, and run it.  At the breakpoint RF should be $1235, and then after
+  // CONTINUE the program returns to the monitor with $1235 in D ...
+  //
+  //	LDI $12; PHI RF; LDI $34; PLO RF; INC RF; <break> GLO RF; SEP R5
+  //--
+  static const BYTE abProgram[] = {
+    0xF8, 0x12, 0xBF, 0xF8, 0x34, 0xAF, 0x1F, 0x8F, 0xD5, 0xC4, 0xC4
+  };
+  WORD wBreak = wAddress + 7, wStopped;
+  CRemote::REGISTERS Regs;
+  if (!Remote.Write(wAddress, abProgram, sizeof(abProgram))
+   || !Remote.SetBreakpoint(wBreak) || !Remote.Go(wAddress)
+   || !Remote.WaitBreakpoint(wStopped, RUN_TIME) || !Remote.GetRegisters(Regs)) {
+    fprintf(stderr, "rmtbench: %s\n", Remote.GetError().c_str());  return false;
+  }
+  printf("break  at %04X, RF=%04X, P=%X X=%X\n", wStopped, Regs.awR[15], Regs.bXP & 0xF, Regs.bXP >> 4);
+  if ((wStopped != wBreak) || (Regs.awR[15] != 0x1235)) return false;
+  BYTE abCheck[2];
+  if (!Remote.Read(wBreak, abCheck, sizeof(abCheck)) || (memcmp(abCheck, abProgram+7, 2) != 0)) {
+    fprintf(stderr, "rmtbench: breakpoint wasn't removed\n");  return false;
+  }
+  if (!Remote.Continue()) {
+    fprintf(stderr, "rmtbench: %s\n", Remote.GetError().c_str());  return false;
+  }
+  if (!Remote.WaitReturn(RUN_TIME)) {
+    fprintf(stderr, "rmtbench: %s\n", Remote.GetError().c_str());  return false;
+  }
+  printf("continued and returned\n");
+  return true;
+}
+
+
+int main (int argc, char *argv[])
+{
+  unsigned nBaud = 9600, nAddress = 0x1000, cbData = 4096;  bool fGo = false;
+  int nOption;
+
+  // Parse the command line ...
+  while ((nOption = getopt(argc, argv, "b:a:n:g")) != -1) {
+    switch (nOption) {
+      case 'b': nBaud = strtoul(optarg, NULL, 10);  break;
+      case 'a': nAddress = strtoul(optarg, NULL, 16);  break;
+      case 'n': cbData = strtoul(optarg, NULL, 10);  break;
+      case 'g': fGo = true;  break;
+      default:  Usage();
+    }
+  }
+  if ((optind != argc-1) || (cbData == 0) || (nAddress+cbData > 65536)) Usage();
+
+  // Open the port and get into REMOTE mode ...
+  CRemote Remote;
+  if (!Remote.Open(argv[optind], nBaud) || !Remote.Connect()) {
+    fprintf(stderr, "rmtbench: %s\n", Remote.GetError().c_str());  return EXIT_ERROR;
+  }
+  printf("monitor version %u, longest write %u bytes, registers at %04X\n",
+    Remote.GetVersion(), Remote.GetMaxWrite(), Remote.GetRegisterAddress());
+
+  //   Make up some data that isn't all the same byte, with a simple linear
+  // congruential generator, and write it, read it back and compare ...
+  std::vector<BYTE> abData(cbData), abCheck(cbData);
+  LONG lSeed = 1802;
+  for (unsigned i = 0;  i < cbData;  ++i) {
+    lSeed = lSeed*1103515245UL + 12345UL;  abData[i] = (BYTE) (lSeed >> 16);
+  }
+  QUAD qWire = Remote.GetBytesSent() + Remote.GetBytesReceived();
+  double dStart = Now();
+  if (!Remote.Write((WORD) nAddress, abData.data(), cbData)) {
+    fprintf(stderr, "rmtbench: %s\n", Remote.GetError().c_str());  return EXIT_ERROR;
+  }
+  double dWrite = Now() - dStart;
+  QUAD qWrite = Remote.GetBytesSent() + Remote.GetBytesReceived() - qWire;
+  qWire += qWrite;  dStart = Now();
+  if (!Remote.Read((WORD) nAddress, abCheck.data(), cbData)) {
+    fprintf(stderr, "rmtbench: %s\n", Remote.GetError().c_str());  return EXIT_ERROR;
+  }
+  double dRead = Now() - dStart;
+  QUAD qRead = Remote.GetBytesSent() + Remote.GetBytesReceived() - qWire;
+  Report("write", cbData, qWrite, dWrite, nBaud);
+  Report("read", cbData, qRead, dRead, nBaud);
+  int nStatus = EXIT_OK;
+  if (abData != abCheck) {
+    fprintf(stderr, "rmtbench: the data read back doesn't match\n");  nStatus = EXIT_COMPARE;
+  }
+
+  // Time the fixed cost of a packet ...
+  dStart = Now();
+  for (unsigned i = 0;  i < PINGS;  ++i) {
+    BYTE ab[1];
+    if (!Remote.Read((WORD) nAddress, ab, 1)) {
+      fprintf(stderr, "rmtbench: %s\n", Remote.GetError().c_str());  return EXIT_ERROR;
+    }
+  }
+  printf("round trip for a one byte read %.1f milliseconds\n", (Now()-dStart)*1000.0/PINGS);
+
+  // Test breakpoints, and get back to the prompt ...
+  if (fGo && !TestBreakpoint(Remote, (WORD) nAddress)) nStatus = EXIT_COMPARE;
+  if (!Remote.Quit()) {
+    fprintf(stderr, "rmtbench: %s\n", Remote.GetError().c_str());  return EXIT_ERROR;
+  }
+  return nStatus;
+}
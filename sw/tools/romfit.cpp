@@ -0,0 +1,139 @@
+//++
+//romfit.cpp - check that the EPROM components don't overlap the monitor
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   Most of the monitor extensions (MONEXT2, MONEXT4, MONEXT14 and so on) live
+// in the leftover space at the end of somebody else's program - XMODEM, SEDIT,
+// EDTASM, Visual/02, Forth or the BIOS.  The monitor checks that it doesn't run
+// past the end of each extension (that's the MONXnTOP symbols), but nothing in
+// the monitor knows where the other programs end, and ROMMERGE will happily
+// let a later file overwrite an earlier one.  If one of those programs ever
+// grows, the result is an EPROM that's broken in some obscure way.
+//
+//   ROMFIT closes that hole.  It's given a list of the address ranges that
+// belong to the monitor, and a list of HEX files for everything else in the
+// EPROM, and it fails if any of those files loads even one byte into any of
+// the monitor's ranges.  Note that it's any byte at all, even $FF - a program
+// that pads itself out with $FFs has claimed that space just the same.  To
+// find out which bytes are loaded, each file is simply loaded twice, over 00s
+// and then over FFs, and compared - anything that didn't change wasn't loaded.
+//
+// USAGE:
+//	romfit -r base:top [-r base:top ...] file.hex ...
+//
+//	-r base:top	a monitor range, from base up to (but not including) top
+//
+// The addresses are in hex, and a trailing "H" is allowed (and ignored), so
+// the values in the config.* files can be used as is (e.g. "-r0AEA0H:0B000H").
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#include <stdio.h>		// printf(), fprintf(), etc ...
+#include <stdlib.h>		// exit(), strtoul(), ...
+#include <string.h>		// memset(), ...
+#include <ctype.h>		// toupper() ...
+#include <unistd.h>		// getopt() ...
+#include <string>		// C++ std::string class
+#include <vector>		// C++ std::vector template
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "hexfile.hpp"		// LoadIntelHex() ...
+
+// Exit status codes ...
+#define EXIT_OK		0	// everything fits
+#define EXIT_ERROR	1	// something overlaps, or anything else
+
+// One of the monitor's address ranges ...
+struct RANGE {
+  unsigned nBase;		// first address
+  unsigned nTop;		// last address (+1)
+};
+
+
+static void Usage()
+{
+  fprintf(stderr, "usage: romfit -r base:top [-r base:top ...] file.hex ...\n");
+  exit(EXIT_ERROR);
+}
+
+
+static bool ParseAddress (const char *psz, char chEnd, const char *&pszNext, unsigned &nAddress)
+{
+  //++
+  //   Parse one hex address, with an optional trailing "H", that's followed
+  // by chEnd.  The next character after chEnd is returned in pszNext ...
+  //--
+  char *pszEnd;
+  if (!isxdigit((unsigned char) *psz)) return false;
+  nAddress = strtoul(psz, &pszEnd, 16);
+  if (toupper(*pszEnd) == 'H') ++pszEnd;
+  if ((*pszEnd != chEnd) || (nAddress > 0x10000)) return false;
+  pszNext = pszEnd + ((chEnd != '\0') ? 1 : 0);
+  return true;
+}
+
+
+int main (int argc, char *argv[])
+{
+  //++
+  //--
+  std::vector<RANGE> vRanges;
+  int ch;
+  while ((ch = getopt(argc, argv, "r:")) != -1) {
+    switch (ch) {
+      case 'r': {
+	RANGE r;  const char *psz;
+	if (!ParseAddress(optarg, ':', psz, r.nBase)
+	 || !ParseAddress(psz, '\0', psz, r.nTop)
+	 || (r.nBase >= r.nTop)) Usage();
+	vRanges.push_back(r);
+	break;
+      }
+      default:  Usage();
+    }
+  }
+  if (optind >= argc) Usage();
+
+  // Check each file against every range ...
+  static BYTE abData[65536], abCheck[65536];
+  unsigned nErrors = 0;
+  for (int i = optind;  i < argc;  ++i) {
+    memset(abData, 0x00, sizeof(abData));
+    memset(abCheck, 0xFF, sizeof(abCheck));
+    unsigned nLow, nHigh;  std::string sError;
+    if (!LoadIntelHex(argv[i], abData, sizeof(abData), nLow, nHigh, sError)
+     || !LoadIntelHex(argv[i], abCheck, sizeof(abCheck), nLow, nHigh, sError)) {
+      fprintf(stderr, "romfit: %s\n", sError.c_str());  return EXIT_ERROR;
+    }
+    for (unsigned j = 0;  j < vRanges.size();  ++j) {
+      unsigned nCount = 0, nFirst = 0, nLast = 0;
+      for (unsigned a = vRanges[j].nBase;  a < vRanges[j].nTop;  ++a) {
+	if (abData[a] != abCheck[a]) continue;
+	if (nCount++ == 0) nFirst = a;
+	nLast = a;
+      }
+      if (nCount == 0) continue;
+      fprintf(stderr, "romfit: %s loads %u bytes (0x%04X to 0x%04X) in the monitor's 0x%04X to 0x%04X\n",
+	argv[i], nCount, nFirst, nLast, vRanges[j].nBase, vRanges[j].nTop-1);
+      ++nErrors;
+    }
+  }
+  return (nErrors != 0) ? EXIT_ERROR : EXIT_OK;
+}
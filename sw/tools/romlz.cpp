@@ -0,0 +1,237 @@
+//++
+//romlz.cpp - compress EPROM text for the monitor's LZDEC
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   ROMLZ reads a HEX file containing a null terminated string (normally the
+// help text, straight out of romtext) and writes another HEX file, at the
+// same address, with the same text compressed for LZDEC in the monitor.  The
+// monitor has nowhere to put the whole text once it's expanded, so the text
+// is cut into blocks of 255 characters and LZDEC expands one block at a time
+// into the top half of DSKBUF.  Before it starts on the next block LZDEC
+// slides the top half of DSKBUF, the last block and its null, down into the
+// bottom half, so every block except the first can refer back to the one
+// before it as well as to itself.  The blocks are always as long as possible
+// - the monitor just types one after another, so it doesn't matter if a block
+// ends in the middle of a line.
+//
+//   A block is a series of tokens, and each token starts with a control byte
+// -
+//
+//	00		end of the block
+//	01..7F		that many literal bytes follow
+//	1LLLLLLD dddddddd
+//			copy LLLLLL+3 (3..66) bytes that start Dddddddd+1
+//			(1..512) bytes back in the output
+//
+// and an empty block (just a 00) marks the end of the text.  This byte
+// oriented format doesn't compress as well as the bit oriented ones, but
+// the 1802 can decode it with no shifting and without calling a subroutine
+// for every byte, and that's the point.  The compressor, on the other hand,
+// can take all the time it likes - it finds the longest match at every
+// position and then picks the cheapest way to code the whole block (the
+// classic "optimal parse").  The result is decompressed again and compared
+// with the original before anything is written, just to be safe.
+//
+// USAGE:
+//	romlz [-a address] [-e end] input.hex output.hex
+//
+//	-a address	address of the text (default the lowest address loaded)
+//	-e end		first address the compressed text must not reach
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+// 17-Oct-26    RLA     Add -e to check that the text fits.
+// 17-Oct-26    RLA     Don't end blocks at line breaks - it wastes space.
+// 17-Oct-26    RLA     Let each block refer back to the one before it.
+//--
+#include <stdio.h>		// printf(), fprintf(), etc ...
+#include <stdlib.h>		// exit(), strtoul(), ...
+#include <string.h>		// memset(), ...
+#include <unistd.h>		// getopt() ...
+#include <string>		// C++ std::string class
+#include <vector>		// C++ std::vector template
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "hexfile.hpp"		// LoadIntelHex(), SaveIntelHex() ...
+
+// Exit status codes ...
+#define EXIT_OK		0	// everything worked
+#define EXIT_ERROR	1	// anything else
+
+// Format constants (these have to agree with LZDEC in boots.asm!) ...
+#define BLOCK_MAX	255	// longest block (half of DSKBUF less the null)
+#define HISTORY		256	// previous block (and its null) kept by LZDEC
+#define LITERAL_MAX	127	// longest literal run
+#define MATCH_MIN	3	// shortest match
+#define MATCH_MAX	66	//  ... and the longest
+#define DISTANCE_MAX	512	// farthest back a match can reach
+
+
+static void Usage()
+{
+  fprintf(stderr, "usage: romlz [-a address] [-e end] input.hex output.hex\n");
+  exit(EXIT_ERROR);
+}
+
+
+static void CompressBlock (const std::string &sHistory, const BYTE *pbText, unsigned cbText, std::vector<BYTE> &Out)
+{
+  //++
+  //   Compress one block and append it, including the 00 that ends it, to
+  // Out.  sHistory is whatever LZDEC will have in DSKBUF just before the block
+  // (empty for the first one) and matches can reach back into that too.  First
+  // find the longest match (and the closest one of that length) at every
+  // position, then work backwards from the end to find the cheapest way to
+  // code everything from each position to the end of the block ...
+  //--
+  std::string sWindow = sHistory + std::string((const char *) pbText, cbText);
+  const char *pchBlock = sWindow.data() + sHistory.length();
+  std::vector<unsigned> anLength(cbText, 0), anDistance(cbText, 0);
+  for (unsigned i = 0;  i < cbText;  ++i) {
+    for (unsigned d = 1;  (d <= DISTANCE_MAX) && (d <= i+sHistory.length());  ++d) {
+      unsigned n = 0;
+      while ((n < MATCH_MAX) && (i+n < cbText) && (pchBlock[(int) (i+n) - (int) d] == pchBlock[i+n])) ++n;
+      if (n > anLength[i]) {anLength[i] = n;  anDistance[i] = d;}
+    }
+  }
+
+  //   anCost[i] is the fewest bytes that will code pbText[i..cbText-1], and
+  // anStep[i] is how far the first token goes (negative for a literal run) ...
+  std::vector<unsigned> anCost(cbText+1, 0);
+  std::vector<int> anStep(cbText+1, 0);
+  for (int i = (int) cbText-1;  i >= 0;  --i) {
+    anCost[i] = ~0U;
+    for (unsigned n = MATCH_MIN;  n <= anLength[i];  ++n) {
+      if (2+anCost[i+n] < anCost[i]) {anCost[i] = 2+anCost[i+n];  anStep[i] = n;}
+    }
+    for (unsigned n = 1;  (n <= LITERAL_MAX) && (i+n <= cbText);  ++n) {
+      if (1+n+anCost[i+n] < anCost[i]) {anCost[i] = 1+n+anCost[i+n];  anStep[i] = -(int) n;}
+    }
+  }
+
+  // And now just follow the steps ...
+  for (unsigned i = 0;  i < cbText; ) {
+    if (anStep[i] < 0) {
+      unsigned n = -anStep[i];
+      Out.push_back((BYTE) n);
+      Out.insert(Out.end(), pbText+i, pbText+i+n);
+      i += n;
+    } else {
+      unsigned n = anStep[i], d = anDistance[i]-1;
+      Out.push_back((BYTE) (0x80 | ((n-MATCH_MIN) << 1) | (d >> 8)));
+      Out.push_back((BYTE) (d & 0xFF));
+      i += n;
+    }
+  }
+  Out.push_back(0);
+}
+
+
+static bool Expand (const std::vector<BYTE> &Data, std::string &sText)
+{
+  //++
+  //   Expand the compressed text exactly the way LZDEC does, one block at a
+  // time.  Returns false if the data is malformed ...
+  //--
+  size_t i = 0;  std::string sHistory;
+  for (;;) {
+    if (i >= Data.size()) return false;
+    if (Data[i] == 0) return i+1 == Data.size();
+    std::string sBlock = sHistory;  size_t nStart = sHistory.length();
+    while (i < Data.size()) {
+      BYTE b = Data[i++];
+      if (b == 0) break;
+      if ((b & 0x80) == 0) {
+	if (i+b > Data.size()) return false;
+	sBlock.append((const char *) &Data[i], b);  i += b;
+      } else {
+	if (i >= Data.size()) return false;
+	unsigned n = ((b & 0x7E) >> 1) + MATCH_MIN;
+	unsigned d = (((b & 1) << 8) | Data[i++]) + 1;
+	if (d > sBlock.length()) return false;
+	for (unsigned j = 0;  j < n;  ++j) sBlock += sBlock[sBlock.length()-d];
+      }
+    }
+    if (sBlock.length()-nStart > BLOCK_MAX) return false;
+    sText += sBlock.substr(nStart);
+    sHistory = sBlock.substr(nStart) + '\0';
+  }
+}
+
+
+int main (int argc, char *argv[])
+{
+  //++
+  //--
+  unsigned nAddress = ~0U, nEnd = ~0U;
+  int ch;
+  while ((ch = getopt(argc, argv, "a:e:")) != -1) {
+    switch (ch) {
+      case 'a': nAddress = strtoul(optarg, NULL, 0);  break;
+      case 'e': nEnd = strtoul(optarg, NULL, 0);  break;
+      default:  Usage();
+    }
+  }
+  if (optind != argc-2) Usage();
+
+  // Load the text ...
+  static BYTE abROM[65536];
+  memset(abROM, 0xFF, sizeof(abROM));
+  unsigned nLow, nHigh;  std::string sError;
+  if (!LoadIntelHex(argv[optind], abROM, sizeof(abROM), nLow, nHigh, sError)) {
+    fprintf(stderr, "romlz: %s\n", sError.c_str());  return EXIT_ERROR;
+  }
+  if (nAddress == ~0U) nAddress = nLow;
+  if ((nAddress < nLow) || (nAddress > nHigh)) {
+    fprintf(stderr, "romlz: nothing loaded at 0x%04X\n", nAddress);  return EXIT_ERROR;
+  }
+  unsigned cbText = 0;
+  while ((nAddress+cbText <= nHigh) && (abROM[nAddress+cbText] != 0)) ++cbText;
+  const BYTE *pbText = abROM+nAddress;
+
+  // Cut it into blocks of BLOCK_MAX bytes and compress each one ...
+  std::vector<BYTE> Out;  std::string sHistory;
+  unsigned nBlocks = 0;
+  for (unsigned i = 0;  i < cbText;  ++nBlocks) {
+    unsigned n = cbText-i;
+    if (n > BLOCK_MAX) n = BLOCK_MAX;
+    CompressBlock(sHistory, pbText+i, n, Out);
+    sHistory = std::string((const char *) pbText+i, n) + '\0';
+    i += n;
+  }
+  Out.push_back(0);
+
+  // Check it and write it out ...
+  std::string sCheck;
+  if (!Expand(Out, sCheck) || (sCheck != std::string((const char *) pbText, cbText))) {
+    fprintf(stderr, "romlz: compressed text doesn't match the original!\n");  return EXIT_ERROR;
+  }
+  if ((nEnd != ~0U) && (nAddress+Out.size() > nEnd)) {
+    fprintf(stderr, "romlz: compressed text ends at 0x%04X, past 0x%04X\n",
+      nAddress+(unsigned) Out.size()-1, nEnd);
+    return EXIT_ERROR;
+  }
+  if (!SaveIntelHex(argv[optind+1], Out.data(), (unsigned) Out.size(), nAddress, sError)) {
+    fprintf(stderr, "romlz: %s\n", sError.c_str());  return EXIT_ERROR;
+  }
+  printf("romlz: %u bytes at 0x%04X compressed to %u (%.1f%%, %u blocks), ends at 0x%04X\n",
+    cbText, nAddress, (unsigned) Out.size(), 100.0*Out.size()/cbText, nBlocks,
+    nAddress+(unsigned) Out.size()-1);
+  return EXIT_OK;
+}
@@ -0,0 +1,56 @@
+//++
+//standard.hpp - standard types for the Elf 2000 host side tools
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   This is the host (i.e. Linux/Windows PC) equivalent of the standard.h file
+// used by the GPIO firmware.  It defines the same BYTE, WORD and LONG types
+// and the same modified Hungarian naming conventions, so that code which runs
+// on the PC side looks like code that runs on the Elf side...
+//
+//	n  -> numeric (e.g. int, unsigned; we don't care about the size)
+//	b  -> BYTE	 w  -> WORD	 l  -> LONG	 q  -> QUAD
+//	c  -> char	 f  -> flag (bool)
+//	cb -> count of bytes	sz -> zero terminated string
+//	p  -> pointer		a  -> array
+//	m_ -> class member	g_ -> global
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#ifndef _standard_hpp_
+#define _standard_hpp_
+#include <stdint.h>		// uint8_t, uint16_t, etc ...
+
+// Fixed size data types ...
+typedef uint8_t	 BYTE;		// 8 bits, unsigned
+typedef uint16_t WORD;		// 16 bits, unsigned
+typedef uint32_t LONG;		// 32 bits, unsigned
+typedef uint64_t QUAD;		// 64 bits, unsigned (cycle counts!)
+
+// Assemble and disassemble bytes and words ...
+#define LOBYTE(w)	((BYTE) ((w) & 0xFF))
+#define HIBYTE(w)	((BYTE) (((w) >> 8) & 0xFF))
+#define MKWORD(h,l)	((WORD) ((((h) & 0xFF) << 8) | ((l) & 0xFF)))
+
+// Other useful macros ...
+#define UNUSED(x)	((void) (x))
+#define COUNTOF(a)	(sizeof(a) / sizeof((a)[0]))
+
+#endif	// _standard_hpp_
@@ -0,0 +1,366 @@
+//++
+//uart.cpp - 8250/16450/16550 UART emulation
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   This module implements the CUART class.  See uart.hpp for the details.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#include <deque>		// C++ std::deque template
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "uart.hpp"		// declarations for this module
+
+// "Never" for the purposes of NextEvent() ...
+#define NEVER	((QUAD) -1)
+
+
+CUART::CUART (CHost *pHost, bool f16550)
+{
+  m_pHost = pHost;  m_f16550 = f16550;
+  m_qCharacterTime = 0;  m_wDivisor = 0;
+  m_nOverruns = m_nRxHighWater = 0;
+  m_fIRQ = false;
+  Reset();
+}
+
+
+void CUART::Reset()
+{
+  //++
+  //   Reset the UART to its power on state.  Note that the divisor latch and
+  // the scratch register are NOT affected by a master reset ...
+  //--
+  m_bIER = m_bFCR = m_bLCR = m_bMCR = 0;
+  m_bLSR = LSR_THRE | LSR_TEMT;  m_bMSR = 0;
+  m_RxFIFO.clear();  m_TxFIFO.clear();
+  m_fTxShift = m_fTHREPending = false;
+  m_qTxDone = m_qRxLast = 0;
+  UpdateModemStatus();
+  m_bMSR &= ~(MSR_DCTS|MSR_DDSR|MSR_TERI|MSR_DDCD);
+  UpdateInterrupts();
+}
+
+
+unsigned CUART::RxTrigger() const
+{
+  //++
+  // Return the receiver FIFO trigger level (1, 4, 8 or 14 characters) ...
+  //--
+  static const unsigned anTrigger[4] = {1, 4, 8, 14};
+  return anTrigger[(m_bFCR & FCR_TRIGGER) >> 6];
+}
+
+
+void CUART::UpdateModemStatus()
+{
+  //++
+  //   Figure out the current state of the modem status inputs.  In loopback
+  // mode the modem control outputs are connected to the inputs (RTS->CTS,
+  // DTR->DSR, OUT1->RI and OUT2->DCD).  Otherwise we pretend that the host
+  // always has CTS, DSR and DCD asserted.  If anything changes, set the
+  // corresponding delta bit ...
+  //--
+  BYTE bNew;
+  if ((m_bMCR & MCR_LOOP) != 0) {
+    bNew = 0;
+    if ((m_bMCR & MCR_RTS)  != 0) bNew |= MSR_CTS;
+    if ((m_bMCR & MCR_DTR)  != 0) bNew |= MSR_DSR;
+    if ((m_bMCR & MCR_OUT1) != 0) bNew |= MSR_RI;
+    if ((m_bMCR & MCR_OUT2) != 0) bNew |= MSR_DCD;
+  } else
+    bNew = MSR_CTS | MSR_DSR | MSR_DCD;
+  BYTE bOld = m_bMSR & 0xF0;
+  if (((bOld ^ bNew) & MSR_CTS) != 0) m_bMSR |= MSR_DCTS;
+  if (((bOld ^ bNew) & MSR_DSR) != 0) m_bMSR |= MSR_DDSR;
+  if (((bOld & MSR_RI) != 0) && ((bNew & MSR_RI) == 0)) m_bMSR |= MSR_TERI;
+  if (((bOld ^ bNew) & MSR_DCD) != 0) m_bMSR |= MSR_DDCD;
+  m_bMSR = (m_bMSR & 0x0F) | bNew;
+}
+
+
+void CUART::UpdateInterrupts()
+{
+  //++
+  //   Recompute the interrupt request output and, if it has changed, tell the
+  // system about it.  The priority logic is done by Read(IIR) ...
+  //--
+  bool fIRQ = false;
+  if (((m_bIER & IER_ELSI) != 0) && ((m_bLSR & (LSR_OE|LSR_PE|LSR_FE|LSR_BI)) != 0)) fIRQ = true;
+  if (((m_bIER & IER_ERBFI) != 0) && !m_RxFIFO.empty()) {
+    //   In FIFO mode the receiver interrupt happens when the trigger level is
+    // reached, or when there's a character timeout (which is checked by
+    // Clock()).  In 16450 mode it happens whenever DR is set...
+    if (!IsFIFO() || (m_RxFIFO.size() >= RxTrigger())) fIRQ = true;
+    if (IsFIFO() && ((m_bLSR & LSR_ERR) != 0)) fIRQ = true;
+  }
+  if (((m_bIER & IER_ETBEI) != 0) && m_fTHREPending) fIRQ = true;
+  if (((m_bIER & IER_EDSSI) != 0) && ((m_bMSR & 0x0F) != 0)) fIRQ = true;
+  if (fIRQ != m_fIRQ) {
+    m_fIRQ = fIRQ;  m_pHost->UpdateIRQ();
+  }
+}
+
+
+void CUART::RxCharacter (BYTE bData, QUAD qNow)
+{
+  //++
+  //   Put a character into the receiver buffer.  If the buffer is full, then
+  // set the overrun error bit and count it.  On the 16450 the new character
+  // replaces the old one; on the 16550 the FIFO is unchanged and the new
+  // character is lost ...
+  //--
+  unsigned nSize = IsFIFO() ? FIFO_SIZE : 1;
+  if (m_RxFIFO.size() >= nSize) {
+    m_bLSR |= LSR_OE;  ++m_nOverruns;
+    if (!IsFIFO()) m_RxFIFO.back() = bData;
+  } else
+    m_RxFIFO.push_back(bData);
+  if (m_RxFIFO.size() > m_nRxHighWater) m_nRxHighWater = m_RxFIFO.size();
+  m_bLSR |= LSR_DR;  m_qRxLast = qNow;
+  //   The character timeout is the same as "DR is set and the trigger isn't
+  // reached", so we use the LSR_ERR bit to remember that it has timed out.
+  // A new character always resets the timeout ...
+  m_bLSR &= ~LSR_ERR;
+  UpdateInterrupts();
+}
+
+
+bool CUART::Receive (BYTE bData, QUAD qNow)
+{
+  //++
+  //   Receive a character from the host.  In loopback mode the receiver is
+  // disconnected from the outside world, and the character is just lost...
+  //--
+  Clock(qNow);
+  if ((m_bMCR & MCR_LOOP) != 0) return true;
+  unsigned nOverruns = m_nOverruns;
+  RxCharacter(bData, qNow);
+  return nOverruns == m_nOverruns;
+}
+
+
+bool CUART::IsReceiverReady() const
+{
+  //++
+  // Return true if another character can be received without an overrun ...
+  //--
+  if ((m_bMCR & MCR_LOOP) != 0) return false;
+  return m_RxFIFO.size() < (IsFIFO() ? (unsigned) FIFO_SIZE : 1U);
+}
+
+
+void CUART::Clock (QUAD qNow)
+{
+  //++
+  //   Advance the UART's idea of time to qNow.  This finishes transmitting any
+  // characters whose time has come, and checks for a receiver character time
+  // out (in FIFO mode only)...
+  //--
+  while (m_fTxShift && (qNow >= m_qTxDone)) {
+    // The shift register is done with this character ...
+    BYTE bData = m_TxFIFO.front();  m_TxFIFO.pop_front();
+    if ((m_bMCR & MCR_LOOP) != 0)
+      RxCharacter(bData, m_qTxDone);
+    else
+      m_pHost->Transmit(bData);
+    if (m_TxFIFO.empty()) {
+      m_fTxShift = false;  m_bLSR |= LSR_TEMT;
+    } else
+      m_qTxDone += m_qCharacterTime;
+  }
+  //   Note that the holding register (or FIFO) is "empty" as soon as the last
+  // character moves into the shift register ...
+  if (!(m_bLSR & LSR_THRE) && (m_TxFIFO.size() <= 1) && m_fTxShift) {
+    m_bLSR |= LSR_THRE;  m_fTHREPending = true;
+  }
+  if (m_TxFIFO.empty() && !(m_bLSR & LSR_THRE)) {
+    m_bLSR |= LSR_THRE;  m_fTHREPending = true;
+  }
+  //   Check for a character timeout - four character times with no activity
+  // and at least one character (but less than the trigger level) in the FIFO.
+  if (IsFIFO() && !m_RxFIFO.empty() && !(m_bLSR & LSR_ERR)
+   && (qNow >= m_qRxLast + 4*m_qCharacterTime))
+    m_bLSR |= LSR_ERR;
+  UpdateInterrupts();
+}
+
+
+QUAD CUART::NextEvent() const
+{
+  //++
+  // Return the next time the UART needs Clock() to be called ...
+  //--
+  QUAD qNext = NEVER;
+  if (m_fTxShift) qNext = m_qTxDone;
+  if (IsFIFO() && !m_RxFIFO.empty() && !(m_bLSR & LSR_ERR)) {
+    QUAD qTimeout = m_qRxLast + 4*m_qCharacterTime;
+    if (qTimeout < qNext) qNext = qTimeout;
+  }
+  return qNext;
+}
+
+
+BYTE CUART::Read (unsigned nRegister, QUAD qNow)
+{
+  //++
+  // Read a UART register ...
+  //--
+  BYTE bData = 0xFF;
+  Clock(qNow);
+  switch (nRegister & 7) {
+    case RBR:
+      if ((m_bLCR & LCR_DLAB) != 0) return LOBYTE(m_wDivisor);
+      if (m_RxFIFO.empty()) return 0;
+      bData = m_RxFIFO.front();  m_RxFIFO.pop_front();
+      if (m_RxFIFO.empty()) m_bLSR &= ~LSR_DR;
+      m_bLSR &= ~LSR_ERR;  m_qRxLast = qNow;
+      break;
+
+    case IER:
+      if ((m_bLCR & LCR_DLAB) != 0) return HIBYTE(m_wDivisor);
+      return m_bIER;
+
+    case IIR:
+      //   Figure out the highest priority pending interrupt.  Note that
+      // reading the IIR when the THRE interrupt is the highest priority
+      // clears it ...
+      if (((m_bIER & IER_ELSI) != 0) && ((m_bLSR & (LSR_OE|LSR_PE|LSR_FE|LSR_BI)) != 0))
+	bData = IIR_RLS;
+      else if (((m_bIER & IER_ERBFI) != 0) && !m_RxFIFO.empty()
+	    && (!IsFIFO() || (m_RxFIFO.size() >= RxTrigger())))
+	bData = IIR_RDA;
+      else if (((m_bIER & IER_ERBFI) != 0) && IsFIFO() && ((m_bLSR & LSR_ERR) != 0))
+	bData = IIR_CTI;
+      else if (((m_bIER & IER_ETBEI) != 0) && m_fTHREPending) {
+	bData = IIR_THRE;  m_fTHREPending = false;
+      } else if (((m_bIER & IER_EDSSI) != 0) && ((m_bMSR & 0x0F) != 0))
+	bData = IIR_MS;
+      else
+	bData = IIR_NONE;
+      if (IsFIFO()) bData |= IIR_FIFO;
+      break;
+
+    case LCR:
+      return m_bLCR;
+
+    case MCR:
+      return m_bMCR;
+
+    case LSR:
+      //   Reading the LSR clears all the error bits.  LSR_ERR is only visible
+      // in FIFO mode and we use it internally for the character timeout, so
+      // don't return it otherwise...
+      bData = m_bLSR & ~LSR_ERR;
+      m_bLSR &= ~(LSR_OE|LSR_PE|LSR_FE|LSR_BI);
+      break;
+
+    case MSR:
+      bData = m_bMSR;  m_bMSR &= 0xF0;
+      break;
+
+    case SCR:
+      return m_bSCR;
+  }
+  UpdateInterrupts();
+  return bData;
+}
+
+
+void CUART::Write (unsigned nRegister, BYTE bData, QUAD qNow)
+{
+  //++
+  // Write a UART register ...
+  //--
+  Clock(qNow);
+  switch (nRegister & 7) {
+    case THR:
+      if ((m_bLCR & LCR_DLAB) != 0) {
+	m_wDivisor = MKWORD(HIBYTE(m_wDivisor), bData);  return;
+      }
+      //   If the character time is zero, then this character is "transmitted"
+      // immediately and THRE never clears.  Otherwise it goes to the FIFO and
+      // the shift register starts up if it's idle ...
+      m_fTHREPending = false;
+      if (m_qCharacterTime == 0) {
+	if ((m_bMCR & MCR_LOOP) != 0)
+	  RxCharacter(bData, qNow);
+	else
+	  m_pHost->Transmit(bData);
+	m_fTHREPending = true;
+      } else {
+	if (m_TxFIFO.size() >= (IsFIFO() ? (unsigned) FIFO_SIZE+1 : 2U)) break;
+	m_TxFIFO.push_back(bData);
+	if (!m_fTxShift) {
+	  m_fTxShift = true;  m_qTxDone = qNow + m_qCharacterTime;
+	  m_bLSR &= ~LSR_TEMT;
+	  //   The character moves straight into the shift register, so the
+	  // holding register is still empty...
+	  m_fTHREPending = true;
+	} else
+	  m_bLSR &= ~LSR_THRE;
+      }
+      break;
+
+    case IER:
+      if ((m_bLCR & LCR_DLAB) != 0) {
+	m_wDivisor = MKWORD(bData, LOBYTE(m_wDivisor));  return;
+      }
+      //   Enabling the THRE interrupt while the holding register is empty
+      // causes an immediate interrupt ...
+      if (((bData & ~m_bIER & IER_ETBEI) != 0) && ((m_bLSR & LSR_THRE) != 0))
+	m_fTHREPending = true;
+      m_bIER = bData & 0x0F;
+      break;
+
+    case FCR:
+      if (!m_f16550) break;
+      //   Changing the FIFO enable bit clears both FIFOs.  The reset bits are
+      // self clearing...
+      if (((bData ^ m_bFCR) & FCR_ENABLE) != 0)  bData |= FCR_RCVR_RESET|FCR_XMIT_RESET;
+      if ((bData & FCR_RCVR_RESET) != 0) {
+	m_RxFIFO.clear();  m_bLSR &= ~(LSR_DR|LSR_ERR);
+      }
+      if ((bData & FCR_XMIT_RESET) != 0) {
+	while (m_TxFIFO.size() > (m_fTxShift ? 1U : 0U)) m_TxFIFO.pop_back();
+	m_bLSR |= LSR_THRE;
+      }
+      m_bFCR = bData & (FCR_ENABLE|FCR_TRIGGER);
+      break;
+
+    case LCR:
+      m_bLCR = bData;
+      break;
+
+    case MCR:
+      m_bMCR = bData & 0x1F;  UpdateModemStatus();
+      break;
+
+    case LSR:
+    case MSR:
+      // These are read only ...
+      break;
+
+    case SCR:
+      m_bSCR = bData;
+      break;
+  }
+  UpdateInterrupts();
+}
@@ -0,0 +1,145 @@
+//++
+//uart.hpp - 8250/16450/16550 UART emulation
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   The CUART class emulates the National 16450 or 16550 UART used on the
+// Elf 2000 Disk/UART/RTC/NVR card and the PicoElf UART/RTC card.  All the
+// registers are implemented, including the divisor latch, loopback mode (the
+// monitor's POST depends on it!), the modem control and status bits, the
+// 16550 receive and transmit FIFOs, and the interrupt identification logic.
+//
+//   Characters are moved to and from the host by the system, which calls
+// Receive() to give the UART a character and implements the Transmit() call
+// back to take characters away.  If a character time is set (in CPU machine
+// cycles) then the UART paces the transmitter and detects receiver overruns
+// just like the real chip; if the character time is zero then everything
+// happens instantly.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#ifndef _uart_hpp_
+#define _uart_hpp_
+#include <deque>		// C++ std::deque template
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+
+class CUART {
+  //++
+  // UART register offsets and bits ...
+  //--
+public:
+  enum {
+    // Register offsets (the low three bits of the select register) ...
+    RBR = 0, THR = 0, DLL = 0, IER = 1, DLM = 1, IIR = 2, FCR = 2,
+    LCR = 3, MCR = 4, LSR = 5, MSR = 6, SCR = 7,
+    // IER bits ...
+    IER_ERBFI = 0x01, IER_ETBEI = 0x02, IER_ELSI = 0x04, IER_EDSSI = 0x08,
+    // IIR values ...
+    IIR_NONE = 0x01, IIR_RLS = 0x06, IIR_RDA = 0x04, IIR_CTI = 0x0C,
+    IIR_THRE = 0x02, IIR_MS = 0x00, IIR_FIFO = 0xC0,
+    // FCR bits ...
+    FCR_ENABLE = 0x01, FCR_RCVR_RESET = 0x02, FCR_XMIT_RESET = 0x04,
+    FCR_TRIGGER = 0xC0,
+    // LCR and MCR bits ...
+    LCR_DLAB = 0x80,
+    MCR_DTR = 0x01, MCR_RTS = 0x02, MCR_OUT1 = 0x04, MCR_OUT2 = 0x08,
+    MCR_LOOP = 0x10,
+    // LSR bits ...
+    LSR_DR = 0x01, LSR_OE = 0x02, LSR_PE = 0x04, LSR_FE = 0x08,
+    LSR_BI = 0x10, LSR_THRE = 0x20, LSR_TEMT = 0x40, LSR_ERR = 0x80,
+    // MSR bits ...
+    MSR_DCTS = 0x01, MSR_DDSR = 0x02, MSR_TERI = 0x04, MSR_DDCD = 0x08,
+    MSR_CTS = 0x10, MSR_DSR = 0x20, MSR_RI = 0x40, MSR_DCD = 0x80,
+    // Other magic numbers ...
+    FIFO_SIZE = 16		// size of the 16550 FIFOs
+  };
+
+  //++
+  //   The system provides one of these to receive transmitted characters, and
+  // to be notified when the UART's interrupt request output changes ...
+  //--
+public:
+  class CHost {
+  public:
+    virtual ~CHost() {};
+    virtual void Transmit (BYTE bData) = 0;
+    virtual void UpdateIRQ () = 0;
+  };
+
+  // Constructor and destructor ...
+public:
+  CUART (CHost *pHost, bool f16550=true);
+  virtual ~CUART() {};
+
+  // Public methods ...
+public:
+  // Master reset (like the RESET pin) ...
+  void Reset();
+  // Read or write a UART register ...
+  BYTE Read (unsigned nRegister, QUAD qNow);
+  void Write (unsigned nRegister, BYTE bData, QUAD qNow);
+  // Receive a character from the host (returns false for an overrun) ...
+  bool Receive (BYTE bData, QUAD qNow);
+  // Can the receiver accept another character without an overrun?
+  bool IsReceiverReady() const;
+  // Advance time and return the next time something will happen ...
+  void Clock (QUAD qNow);
+  QUAD NextEvent() const;
+  // Get the interrupt request output ...
+  bool IsIRQ() const {return m_fIRQ;}
+  // Get the RTS output (for flow control) ...
+  bool IsRTS() const {return (m_bMCR & MCR_RTS) != 0;}
+  // Set the character time (in CPU cycles, zero for infinitely fast) ...
+  void SetCharacterTime (QUAD qCycles) {m_qCharacterTime = qCycles;}
+  // Return the baud rate divisor (for the system to compute timing) ...
+  WORD GetDivisor() const {return m_wDivisor;}
+  // Return statistics ...
+  unsigned GetOverruns() const {return m_nOverruns;}
+  unsigned GetFIFOHighWater() const {return m_nRxHighWater;}
+
+  // Private methods ...
+private:
+  bool IsFIFO() const {return (m_bFCR & FCR_ENABLE) != 0;}
+  unsigned RxTrigger() const;
+  void RxCharacter (BYTE bData, QUAD qNow);
+  void UpdateInterrupts();
+  void UpdateModemStatus();
+
+  // Private member data ...
+private:
+  CHost   *m_pHost;			// system interface
+  bool     m_f16550;			// true if FIFOs are implemented
+  BYTE     m_bIER, m_bFCR, m_bLCR;	// interrupt enable, FIFO, line control
+  BYTE     m_bMCR, m_bLSR, m_bMSR;	// modem control, line and modem status
+  BYTE     m_bSCR;			// scratch register
+  WORD     m_wDivisor;			// baud rate divisor
+  std::deque<BYTE> m_RxFIFO;		// receiver buffer (one byte for a 16450)
+  std::deque<BYTE> m_TxFIFO;		// transmitter buffer (ditto)
+  bool     m_fTxShift;			// true if the shift register is busy
+  QUAD     m_qTxDone;			// time the transmit shift register empties
+  QUAD     m_qRxLast;			// time of the last receiver activity
+  bool     m_fTHREPending;		// THRE interrupt is pending
+  bool     m_fIRQ;			// current interrupt request output
+  QUAD     m_qCharacterTime;		// CPU cycles per character
+  unsigned m_nOverruns;			// count of receiver overruns
+  unsigned m_nRxHighWater;		// most characters ever in the RxFIFO
+};
+
+#endif	// _uart_hpp_
@@ -0,0 +1,246 @@
+//++
+//vt1802.cpp - VT1802 (Intel 8275 CRTC) 80 column video card emulation
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   This module implements the CVT1802 class.  See vt1802.hpp for the details.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#include <string.h>		// memset(), memcpy() ...
+#include <string>		// C++ std::string class
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+#include "vt1802.hpp"		// declarations for this module
+
+// "Never" for the purposes of NextEvent() ...
+#define NEVER	((QUAD) -1)
+
+
+CVT1802::CVT1802 (CHost *pHost, QUAD qCyclesPerSecond)
+{
+  //++
+  //   The 8275 powers up in some random state, but we pick the Elf 2000 format
+  // (80x24, two rows of vertical retrace, 10 scan lines) just so that the
+  // timing calculations never divide by zero ...
+  //--
+  m_pHost = pHost;  m_qCyclesPerSecond = qCyclesPerSecond;
+  m_bStatus = m_bCommand = 0;  m_nParameters = 0;
+  memset(m_abParameters, 0, sizeof(m_abParameters));
+  m_nColumns = 80;  m_nRows = 24;  m_nVRTCRows = 2;  m_nLines = 10;  m_nHRTC = 16;
+  m_fRowEnd = m_fRowActive = m_fCRTCIRQ = m_fStopFrame = false;
+  m_qFrameStart = 0;  m_nNextRow = 0;
+  m_nFrames = 0;  m_qDMACycles = 0;
+  memset(m_abFetch, ' ', sizeof(m_abFetch));
+  memset(m_abScreen, ' ', sizeof(m_abScreen));
+  Reset();
+}
+
+
+void CVT1802::Reset()
+{
+  //++
+  //   A system reset clears the VIDEO_ON flip flop (which inhibits DMA and
+  // interrupts) and the end of row flip flop, but the 8275 keeps running ...
+  //--
+  m_fVideoOn = m_fRowEnd = false;
+}
+
+
+QUAD CVT1802::RowTime (unsigned nRow) const
+{
+  //++
+  //   Return the time, in CPU cycles relative to the start of the frame, at
+  // which the given character row starts.  This is computed from the start of
+  // the frame every time so that rounding errors don't accumulate ...
+  //--
+  QUAD qCharacters = (QUAD) nRow * m_nLines * (m_nColumns + m_nHRTC);
+  return (qCharacters * DOTS_PER_CHARACTER * m_qCyclesPerSecond) / DOT_CLOCK;
+}
+
+
+void CVT1802::StartFrame (QUAD qNow)
+{
+  //++
+  //   Start a new frame now (after START or PRESET COUNTERS).  The first row
+  // time is the last row of vertical retrace, which fetches the first row ...
+  //--
+  m_qFrameStart = qNow - RowTime(FrameRows()-1);
+  m_nNextRow = FrameRows()-1;
+}
+
+
+BYTE CVT1802::ReadStatus()
+{
+  //++
+  //   Reading the status register clears the interrupt request and all the
+  // error flags.  On the VT1802 it also sets VIDEO_ON ...
+  //--
+  BYTE bStatus = m_bStatus;
+  m_bStatus &= ~(STS_IR | STS_LP | STS_IC | STS_DU | STS_FO);
+  m_fCRTCIRQ = false;  m_fVideoOn = true;
+  m_pHost->UpdateIRQ();
+  return bStatus;
+}
+
+
+void CVT1802::WriteCommand (BYTE bCommand, QUAD qNow)
+{
+  //++
+  //   Execute an 8275 command.  A new command while the last one is still
+  // waiting for parameters sets the IMPROPER COMMAND flag ...
+  //--
+  if (m_nParameters != 0) {m_bStatus |= STS_IC;  m_nParameters = 0;}
+  m_bCommand = bCommand & CMD_MASK;
+  switch (m_bCommand) {
+    case CMD_RESET:
+      // RESET stops the display and disables interrupts ...
+      m_bStatus &= ~(STS_VE | STS_IE);  m_nParameters = 4;
+      break;
+    case CMD_START:
+      if ((m_bStatus & STS_VE) == 0) StartFrame(qNow);
+      m_bStatus |= STS_VE;
+      break;
+    case CMD_STOP:
+      m_bStatus &= ~STS_VE;
+      break;
+    case CMD_LDCURS:
+      m_nParameters = 2;
+      break;
+    case CMD_EI:
+      m_bStatus |= STS_IE;
+      break;
+    case CMD_DI:
+      m_bStatus &= ~STS_IE;
+      break;
+    case CMD_PRESET:
+      StartFrame(qNow);
+      break;
+    default:
+      // READ LIGHT PEN just returns two bytes we don't implement ...
+      break;
+  }
+}
+
+
+void CVT1802::WriteParameter (BYTE bData)
+{
+  //++
+  //   Store a command parameter.  When the last one for RESET arrives, the
+  // screen format is decoded from them ...
+  //--
+  if (m_nParameters == 0) {m_bStatus |= STS_IC;  return;}
+  unsigned nCount = (m_bCommand == CMD_RESET) ? 4 : 2;
+  m_abParameters[nCount - m_nParameters] = bData;
+  if ((--m_nParameters == 0) && (m_bCommand == CMD_RESET)) {
+    m_nColumns  = (m_abParameters[0] & 0x7F) + 1;
+    m_nRows     = (m_abParameters[1] & 0x3F) + 1;
+    m_nVRTCRows = ((m_abParameters[1] >> 6) & 3) + 1;
+    m_nLines    = (m_abParameters[2] & 0x0F) + 1;
+    m_nHRTC     = ((m_abParameters[3] & 0x1F) + 1) * 2;
+    if (m_nColumns > MAXCOLUMNS) m_nColumns = MAXCOLUMNS;
+  }
+}
+
+
+void CVT1802::FetchRow (unsigned nRow)
+{
+  //++
+  //   DMA one character row from the frame buffer.  Each byte is one DMA OUT
+  // cycle stolen from the CPU.  When the burst is over the bus GAL sets its
+  // ROW_END flip flop, which interrupts the CPU ...
+  //--
+  if (((m_bStatus & STS_VE) == 0) || !m_fVideoOn) return;
+  memset(m_abFetch[nRow], ' ', sizeof(m_abFetch[nRow]));
+  if (m_fStopFrame) return;
+  m_fRowActive = true;
+  for (unsigned i = 0;  i < m_nColumns;  ++i) {
+    BYTE bData = m_pHost->DMAOut();  ++m_qDMACycles;
+    if (bData == CHR_EOR_STOP) break;
+    if (bData == CHR_EOS_STOP) {m_fStopFrame = true;  break;}
+    m_abFetch[nRow][i] = bData;
+  }
+  m_fRowActive = false;  m_fRowEnd = true;
+}
+
+
+void CVT1802::DoRow (unsigned nRow)
+{
+  //++
+  //   Here at the start of every row time.  During a display row the next
+  // row is fetched, and during the last row of vertical retrace the first
+  // row is.  The 8275 requests its interrupt (if enabled) at the start of
+  // the last display row, and that's when we save the frame too ...
+  //--
+  if (nRow+1 < m_nRows) {
+    FetchRow(nRow+1);
+  } else if (nRow+1 == m_nRows) {
+    memcpy(m_abScreen, m_abFetch, sizeof(m_abScreen));  ++m_nFrames;
+    if ((m_bStatus & STS_IE) != 0) {m_bStatus |= STS_IR;  m_fCRTCIRQ = true;}
+  } else if (nRow+1 == FrameRows()) {
+    m_fStopFrame = false;  FetchRow(0);
+  }
+  m_pHost->UpdateIRQ();
+}
+
+
+void CVT1802::Clock (QUAD qNow)
+{
+  //++
+  // Do everything that should have happened by now ...
+  //--
+  if ((m_bStatus & STS_VE) == 0) return;
+  while (m_qFrameStart + RowTime(m_nNextRow) <= qNow) {
+    DoRow(m_nNextRow);
+    if (++m_nNextRow >= FrameRows()) {
+      m_qFrameStart += RowTime(FrameRows());  m_nNextRow = 0;
+    }
+  }
+}
+
+
+QUAD CVT1802::NextEvent() const
+{
+  //++
+  // Return the time of the next row, or "never" if the display is stopped ...
+  //--
+  if ((m_bStatus & STS_VE) == 0) return NEVER;
+  return m_qFrameStart + RowTime(m_nNextRow);
+}
+
+
+std::string CVT1802::GetScreen() const
+{
+  //++
+  //   Return the text of the last complete frame, one line per row.  Field
+  // attribute codes and anything else that isn't printable ASCII shows up as
+  // a space, and trailing spaces are removed ...
+  //--
+  std::string sScreen;
+  for (unsigned nRow = 0;  nRow < m_nRows;  ++nRow) {
+    std::string sLine;
+    for (unsigned i = 0;  i < m_nColumns;  ++i) {
+      BYTE b = m_abScreen[nRow][i];
+      sLine += ((b >= ' ') && (b < 0x7F)) ? (char) b : ' ';
+    }
+    sLine.erase(sLine.find_last_not_of(' ') + 1);
+    sScreen += sLine + "\n";
+  }
+  return sScreen;
+}
@@ -0,0 +1,153 @@
+//++
+//vt1802.hpp - VT1802 (Intel 8275 CRTC) 80 column video card emulation
+//
+// Copyright (C) 2026 by Spare Time Gizmos.  All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 2 of the License, or (at your option)
+// any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+// more details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+// Place, Suite 330, Boston, MA  02111-1307  USA.
+//
+// DESCRIPTION:
+//   The CVT1802 class emulates the Elf 2000 VT1802 video card - an Intel 8275
+// CRT controller plus the glue logic in the card's bus GAL (see bus.pld).  The
+// parts that matter to the firmware are all here - the RESET, START, STOP,
+// LOAD CURSOR, ENABLE/DISABLE INTERRUPT and PRESET COUNTERS commands, the
+// status register (including the IMPROPER COMMAND bit that INIT75 uses to
+// find the card), the row by row DMA from the 1802 and the two interrupts.
+//
+//   The 8275 fetches each character row with a burst of DMA OUT cycles one
+// row time before the row is displayed (the first row is fetched during the
+// last row of vertical retrace).  When a burst is finished the bus GAL sets
+// its ROW_END flip flop and interrupts the CPU, and the 8275 itself requests
+// an interrupt at the start of the last display row.  The two are OR'ed
+// together and EF1 is the same signal, and ROW_END is cleared by the CPU's
+// interrupt acknowledge cycle while the 8275 request is cleared only by
+// reading the status register.  That's how VIDISR tells them apart.  Finally,
+// the DMA and interrupts are inhibited after a reset until the firmware reads
+// the status register (the VIDEO_ON flip flop).
+//
+//   Timing comes from the 11.34MHz dot clock and 8 pixels per character, and
+// the frame format from the RESET parameters, so the DMA steals exactly as
+// many CPU cycles as it would on the real thing.  The characters fetched for
+// the last complete frame are saved so that the caller can see what's on the
+// screen.  Light pens, character attributes and the end of row/screen codes
+// other than the two "stop DMA" ones aren't implemented.
+//
+// REVISION HISTORY:
+// dd-mmm-yy    who     description
+// 17-Oct-26    RLA     New file.
+//--
+#ifndef _vt1802_hpp_
+#define _vt1802_hpp_
+#include <string>		// C++ std::string class
+#include "standard.hpp"		// BYTE, WORD, QUAD, etc ...
+
+class CVT1802 {
+  //++
+  // 8275 commands, status bits and other magic numbers ...
+  //--
+public:
+  enum {
+    // Commands (the upper three bits of the command register) ...
+    CMD_MASK = 0xE0, CMD_RESET = 0x00, CMD_START = 0x20, CMD_STOP = 0x40,
+    CMD_READLP = 0x60, CMD_LDCURS = 0x80, CMD_EI = 0xA0, CMD_DI = 0xC0,
+    CMD_PRESET = 0xE0,
+    // Status register bits ...
+    STS_IE = 0x40, STS_IR = 0x20, STS_LP = 0x10, STS_IC = 0x08,
+    STS_VE = 0x04, STS_DU = 0x02, STS_FO = 0x01,
+    // Special characters that stop the DMA ...
+    CHR_EOR_STOP = 0xF1, CHR_EOS_STOP = 0xF3,
+    // Timing ...
+    DOT_CLOCK = 11340000,	// VT1802 pixel clock (Hz)
+    DOTS_PER_CHARACTER = 8,	// pixels per character cell
+    // Limits of the 8275 ...
+    MAXCOLUMNS = 128, MAXROWS = 64
+  };
+
+  //++
+  //   The system provides one of these to do DMA cycles (the 8275 reads the
+  // frame buffer with 1802 DMA OUT cycles) and to be notified when the video
+  // card's interrupt request changes ...
+  //--
+public:
+  class CHost {
+  public:
+    virtual ~CHost() {};
+    virtual BYTE DMAOut() = 0;
+    virtual void UpdateIRQ() = 0;
+  };
+
+  // Constructor and destructor ...
+public:
+  CVT1802 (CHost *pHost, QUAD qCyclesPerSecond);
+  virtual ~CVT1802() {};
+private:
+  // Disallow copy and assignments!
+  CVT1802 (const CVT1802 &) = delete;
+  CVT1802& operator= (const CVT1802 &) = delete;
+
+  // Public methods ...
+public:
+  //   System reset - note that the 8275 has no reset input, so this only
+  // clears the VIDEO_ON flip flop ...
+  void Reset();
+  // Read the status register, or write a command or a parameter ...
+  BYTE ReadStatus();
+  void WriteCommand (BYTE bCommand, QUAD qNow);
+  void WriteParameter (BYTE bData);
+  // Advance time and return the next time something will happen ...
+  void Clock (QUAD qNow);
+  QUAD NextEvent() const;
+  // Interrupt request (which is also EF1) and the interrupt acknowledge ...
+  bool IsIRQ() const
+    {return m_fVideoOn && ((m_fRowEnd && !m_fRowActive) || m_fCRTCIRQ);}
+  void InterruptAcknowledge() {m_fRowEnd = false;}
+  // Return the text displayed in the last complete frame ...
+  std::string GetScreen() const;
+  // Statistics ...
+  unsigned GetFrames() const {return m_nFrames;}
+  QUAD GetDMACycles() const {return m_qDMACycles;}
+  QUAD GetFrameCycles() const {return RowTime(FrameRows());}
+
+  // Private methods ...
+private:
+  unsigned FrameRows() const {return m_nRows + m_nVRTCRows;}
+  QUAD RowTime (unsigned nRow) const;
+  void StartFrame (QUAD qNow);
+  void DoRow (unsigned nRow);
+  void FetchRow (unsigned nRow);
+
+  // Private member data ...
+private:
+  CHost   *m_pHost;			// system interface
+  QUAD     m_qCyclesPerSecond;		// CPU machine cycles per second
+  BYTE     m_bStatus;			// 8275 status register
+  BYTE     m_bCommand;			// command awaiting parameters
+  unsigned m_nParameters;		// number of parameters still expected
+  BYTE     m_abParameters[4];		// parameters for that command
+  unsigned m_nColumns, m_nRows;		// characters per row, rows per frame
+  unsigned m_nVRTCRows, m_nLines;	// rows of vertical retrace, scan lines per row
+  unsigned m_nHRTC;			// character times of horizontal retrace
+  bool     m_fVideoOn;			// the card's VIDEO_ON flip flop
+  bool     m_fRowEnd, m_fRowActive;	// the bus GAL's end of row logic
+  bool     m_fCRTCIRQ;			// the 8275's IRQ output
+  bool     m_fStopFrame;		// end of screen - stop DMA was seen
+  QUAD     m_qFrameStart;		// time the current frame started
+  unsigned m_nNextRow;			// next row time (0 .. FrameRows()-1)
+  unsigned m_nFrames;			// count of frames displayed
+  QUAD     m_qDMACycles;		// count of DMA cycles stolen
+  BYTE     m_abFetch[MAXROWS][MAXCOLUMNS];// rows fetched for this frame
+  BYTE     m_abScreen[MAXROWS][MAXCOLUMNS];// and the last complete frame
+};
+
+#endif	// _vt1802_hpp_
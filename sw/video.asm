@@ -51,10 +51,10 @@
 ; 	 * Display test screen		      (ESC T)
 ;
 ; WARNING
-;   With the exception of the INIT75 and VIDISR routines, _everything_ else
-; in this module is called via the VTPUTC function, and VTPUTC is called by
-; the BIOS F_TYPE function.  The issue is that pretty much all code everywhere
-; expects F_TYPE to preserve all the registers, so that means (with the two
+;   With the exception of the INIT75, VTFAST and VIDISR routines, _everything_
+; else in this module is called via the VTPUTC (or VTPUTS) function, and VTPUTC
+; is called by the BIOS F_TYPE function.  The issue is that pretty much all code everywhere
+; expects F_TYPE to preserve all the registers, so that means (with the three
 ; exceptions previously mentioned) every routine in this module is expected to
 ; save and restore any registers it uses.
 ;
@@ -137,8 +137,20 @@
 ;
 ; 024	-- a "SEP PC" is missing from INIT75 during the 8275 presence test!
 ; 	   Thanks go to Ian May, fps16xn3@yahoo.com, for figuring this out.
+;
+; 025	-- Replace the per row DMA pointer check with a chain of row handlers
+;	   set up by the end of frame interrupt.  This halves the interrupt
+;	   overhead again.  Also fix the speaker off OUT in EOFISR, which used
+;	   X=PC0 (the DMA pointer!) instead of INTPC.
+;
+; 026	-- Add VTFAST, which turns the display (and its DMA) off and on again.
+;
+; 027	-- Add BFILL, an unrolled block fill, and use it for EEOS, EEOL, CLRLIN
+;	   and FILL.  Make VTPUTS an entry vector that takes the string in P1
+;	   and saves the registers only once per string.  Move BELL to the end
+;	   of the ISR page to make room.
 ;--
-VIDVER	.EQU	24
+VIDVER	.EQU	27
 
 	.EJECT
 ;	.SBTTL	Frame Buffer and RAM Storage Map
@@ -174,6 +186,7 @@ SAVCHR:	.BLOCK	1		; save one character for escape sequences
 ; DON'T CHANGE THE GROUPING OF FRAME AND BELCNT!!
 FRAME:	.BLOCK	1		; incremented by the end of frame ISR
 BELCNT:	.BLOCK	1		; timer for ^G bell beeper
+VIDOFF:	.BLOCK	1		; non-zero while the display is off (VTFAST)
 DTALEN	.EQU	$-SCREEN	; total size of our RAM space
 
 	.EJECT
@@ -191,6 +204,8 @@ DTALEN	.EQU	$-SCREEN	; total size of our RAM space
 	LBR	INIT75_		; initialize the video card
 	LBR	VTPUTC_		; output a character to the virtual VT52
 	.DB 0 \ .DW RIGHTS	; dummy vector for the copyright notice
+	LBR	VTFAST_		; turn the display off or on
+	LBR	VTPUTS_		; output a whole string to the VT52
 
 ; Copyright notice, in plain ASCII...
 RIGHTS:	.TEXT	"VT1802 Video Card Firmware V"
@@ -333,97 +348,6 @@ NO8275:	CDF			; return DF=0
 	LDI	0		;  and D=0
 	RETURN
 
-	.EJECT
-	.ORG	VIDEO+256+$30-2+10;; TEMPORARY - for alignment only!
-	.EJECT
-;	.SBTTL	8275 Interrupt Service
-
-;   The ElfVideo card interrupts the 1802 CPU at the end of every display row
-; and once again at the end of each frame.  For a 24 line display, that's a
-; total of 25 interrupts per frame!  We'd like to do away with with interrupt
-; per character row, but it's essential to the way scrolling is handled that
-; we check the DMA pointer at the end of each row...
-
-; Here to exit from the interrupt (and leave the PC pointing to VIDISR!)...
-VIDRET:	INC	SP		; [2] point SP back to the saved D register
-VIDRE1:	LDXA			; [2] restore the D register from the stack
-	RET			; [2] and return from the interrupt
-
-;   Here is the video interrupt service routine.  Note that the only context
-; this saves is X, P and D - be very, very careful not to change anything else,
-; especially DF!!!
-VIDISR:	DEC	SP		; [2] make a space on the stack
-	SAV			; [2] and push T (the saved X,P)
-	DEC	SP		; [2] make another spot
-	STXD			; [2] and now save the D register too
-	B1	EOFISR		; [2] branch for end of frame interrupt
-
-;   At the end of each chararacter row we have to check the DMA pointer to
-; see if it's reached the end of the screen buffer and, if it has, wrap it
-; around back to the start of the buffer.  The scrolling depends on this, and
-; it's the reason why we need interrupts at the end of each row...
-ROWEND:	GHI	DMAPTR		; [2] get the high byte of the DMA pointer
-	XRI	HIGH(SCREND)	; [2] compare to the end of the screen buffer
-	BNZ	VIDRET		; [2] not the same - just return
-	GLO	DMAPTR		; [2] do the same for the low byte
-	XRI	LOW(SCREND)	; [2] ...
-	BNZ	VIDRET		; [2] return if not the end of the buffer
-
-; We've reached the end of the screen buffer - wrap around...
-	RLDI(DMAPTR,SCREEN)	; [8] reset the DMA pointer back to the start
-	BR	VIDRET		; [2] and return from interrupt
-
-
-;   Here for the end of frame interrupt.  In this case we need to compute the
-; address of the first line on the screen, based on TOPLIN, and initialize
-; the DMA pointer to that row in the screen buffer.  BTW, since this interrupt
-; occurs only once per frame we don't have to be quite so careful about speed.
-EOFISR:	PUSHR(P1)		; [8] save a temporary register
-	INP	CRTCS		; [2] read the status register to clear the IRQ
-	SHLC			; [2] and save DF
-	STR	SP		; [2] ...
-	RLDI(P1,TOPLIN)		; [8] point to TOPLIN
-	LDN	P1		; [2] load the value of TOPLIN
-	SHL			; [2] multiply it by two
-	ADI	LOW(LINTAB)	; [2] index into the line pointer table
-	PLO	P1		; [2] save that
-	LDI	HIGH(LINTAB)	; [2] compute the high byte
-	ADCI	0		; [2] with carry
-	PHI	P1		; [2] ...
-	LDA	P1		; [2] get the first byte of the line address
-	PHI	DMAPTR		; [2] update the DMA pointer for the next frame
-	LDN	P1		; [2] next byte too
-	PLO	DMAPTR		; [2] ...
-
-;  Increment the frame counter - this is used by the POST to determine whether
-; the interrupts are working, and it's used to keep track of time (e.g. for
-; beeping the beeper) ...
-	RLDI(P1,FRAME)		; [8] point at FRAME
-	LDN	P1		; [2] get the current count
-	ADI	1		; [2] and increment it
-	STR	P1		; [2] ignoring any carry
-
-;   If the bell timer (BELCNT, which is conveniently located at FRAME+1!) is
-; non-zero, then the GPIO beeper is turned on and we should decrement BELCNT.
-; When BELCNT reaches zero, we turn off the GPIO speaker.  This is used to
-; implement the ^G bell function of the VT52...
-	INC	P1		; [2] point to BELCNT
-	LDN	P1		; [2]  get the value now
-	BZ	EOFIS1		; [2] just return now if it's zero
-	SMI	1		; [2] otherwise decrement it
-	STR	P1		; [2] and update BELCNT
-	BNZ	EOFIS1		; [2] just keep going until it reaches zero
-	SEX	PC0		; [2] it's done - turn off the speaker now
-	OUT	GPIO		; [2]  ...
-	.DB	SPOFF		; [2] (speaker off function code)
-	SEX	SP		; [2]  ...
-
-; Here to return from the frame interrupt...
-EOFIS1:	LDXA			; [2] restore DF
-	SHRC			; [2] ...
-	POPR(P1)		; [8] restore P1
-	BR	VIDRE1		; [2] and return
-
 	.EJECT
 ;	.SBTTL	Compute the Address of Any Line
 
@@ -657,90 +581,123 @@ RLF:	RLDI(DP,CURSY)		; load the current Y location of the cursor
 ;	.SBTTL	Screen Erase Functions
 
 ;   This routine will erase all characters from the current cursor location
-; to the end of the screen, including the character under the cursor.
+; to the end of the screen, including the character under the cursor.  The
+; screen buffer is circular, so unless the cursor is before the top line in
+; the buffer this takes two blocks - from the cursor to SCREND, and then from
+; SCREEN up to the top line.
 EEOS:	PUSHR(P2)		; save P2
 	RLDI(DP,TOPLIN)		; find the line that's on the top of the screen
 	LDN	DP		; ...
 	CALL(LINADD)		; then calculate its address in P1
-	RCOPY(P2,P1)		; put that address in P1 for a while
-	CALL(WHERE)		; and find out where the cursor is
-EEOS1:	LDI	' '		; clear this character
-	STR	P1		; ...
-	INC	P1		; and increment the pointer
-	GLO	P1		; get the low bits of the address
-	XRI	LOW(SCREND)	; have we reached the end of the screen space ?
-	BNZ	EEOS2		; jump if we haven't
-	GHI	P1		; yes -- check the high order bits too
-	XRI	HIGH(SCREND)	; well, ???
-	BNZ	EEOS2		; again jump if we haven't
-	RLDI(P1,SCREEN)		; yes -- wrap around to the start of the screen
-EEOS2:	GLO	P1		; get the low byte of the address (again!)
+	RCOPY(P2,P1)		; and keep that in P2 for a while
+	CALL(WHERE)		; find out where the cursor is
+	GLO	P2		; is the cursor before the top line?
 	STR	SP		; ...
-	GLO	P2		; have we reached the top of the screen yet ?
-	XOR			; ???
-	BNZ	EEOS1		; keep clearing if we haven't
-	GHI	P1		; maybe -- we need to check the high byte too
+	GLO	P1		; ...
+	SM			; ...
+	GHI	P2		; ...
 	STR	SP		; ...
-	GHI	P2		; ????
-	XOR			; ...
-	BNZ	EEOS1		; keep on going if we aren't there yet
+	GHI	P1		; ...
+	SMB			; ...
+	BNF	EEOS1		; yes - just clear up to the top line
+	RLDI(DP,SCREND)		; no - clear to the end of the buffer first
+	CALL(CLRBLK)		; ...
+	RLDI(P1,SCREEN)		; and then wrap around to the start
+EEOS1:	RCOPY(DP,P2)		; clear everything up to the top line
+	CALL(CLRBLK)		; ...
 	IRX			; return and restore P2
 	POPRL(P2)		; ...
-	RETURN			; otherwise that's all there is to it
-
-;   This routine will clear 80 characters in the display RAM.  This is normally
-; used to erase lines for scrolling purposes. It expects the address of the
-; first byte to be passed in P1; this byte and the next 79 are set to a space
-; character.
-CLRLIN:	PUSHR(T1)		; save T1.0 so we can use it as a temporary
-	LDI	MAXX		; get the number of characters per line
-	PLO	T1		; and store that here
-CLRLI1: LDI	' '		; set this byte to a space
-	STR	P1		; ...
-	INC	P1		; and advance to the next one
-	DEC	T1		; decrement the counter
-	GLO	T1		; and loop if there are more bytes to be done
-	BNZ	CLRLI1		; ...
-	IRX			; restore T1.0 before we return
-	POPRL(T1)		;  ...
-	RETURN			; and that's all for now
+	RETURN			; that's all there is to it
 
 ;   This routine will erase all characters from the current cursor location to
 ; the end of the line, including the character under the cursor.
-EEOL:	PUSHR(T1)		; save T1 so we can use it as a temporary
-	CALL(WHERE)		; set P1 = address of the cursor
+EEOL:	CALL(WHERE)		; set P1 = address of the cursor
 	RLDI(DP,CURSX)		; get the current column of the cursor
 	LDN	DP		; ... and then figure out how many characters
-	SMI	MAXX		; ... remain until the end of the line
-	PLO	T1		; and save that for later
-EEOL1:	LDI	' '		; clear this character to a blank
-	STR	P1		; ...
-	INC	P1		; ... and advance to the next character
-	INC	T1		; count the number of characters cleared
-	GLO	T1		; have we reached the end of the line yet ??
-	BNZ	EEOL1		; nope - keep going
-	IRX			; restore T1 before we return
-	POPRL(T1)		; ...
-	RETURN			; then that's all there is
+	SDI	MAXX		; ... remain until the end of the line
+	BR	CLRLI1		; and clear them
 
-	.EJECT
-;	.SBTTL	Bell (^G) Function
+;   This routine will clear 80 characters in the display RAM.  This is normally
+; used to erase lines for scrolling purposes. It expects the address of the
+; first byte to be passed in P1; this byte and the next 79 are set to a space
+; character.  CLRLI1 is the same, but it clears the number of bytes in D.
+CLRLIN:	LDI	MAXX		; get the number of characters per line
+CLRLI1:	STR	SP		; compute the end of the block in DP
+	GLO	P1		; ...
+	ADD			; ...
+	PLO	DP		; ...
+	GHI	P1		; ...
+	ADCI	0		; ...
+	PHI	DP		; ...
 
-;   Just like a real terminal, we have a bell that can be sounded by the ^G
-; character.  This is implemented using the speaker and fixed frequency tone
-; generator on the GPIO card - all we have to do is turn it on (easy) and then
-; turn it off again in a little bit (harder!).  To arrange for the speaker
-; to be turned off, we set the location BELCNT to a non-zero value.  When ever
-; BELCNT is non-zero the end of video frame ISR will decrement the counter
-; and, when BELCNT makes the 1->0 transition, turns off the speaker.
+; Clear the block from P1 up to, but not including, DP to spaces...
+CLRBLK:	LDI	' '		; fill it with spaces
+				; and fall into BFILL
 
-BELL:	OUTI(GPIO,SPTONE)	; turn on the speaker
-	RLDI(DP,BELCNT)		; point to BELCNT
-;  The value we store into BELCNT determines the length of the tone, in frames.
-; About one sixth of a second sounds like a good value...
-	LDI	10		; ...
-	STR	DP		; set BELCNT=30
-	RETURN			; that's all we have to do!
+;   This routine fills the block of the screen buffer from P1 up to, but not
+; including, DP with the byte in D.  Rather than storing one byte per trip
+; around a loop, it points X at the last byte and runs down a string of sixteen
+; STXD instructions, so that most bytes cost just one instruction.  The first
+; trip jumps into the middle of the string to take care of the odd bytes.
+;
+;   The jump is done by switching the PC to DP, which keeps the fill byte in D,
+; and the string of STXDs does a SEP PC to come back here when it's done.  The
+; block has to be less than 4K bytes long (the whole screen is only 1920) and
+; BFILL trashes both P1 and DP, but it saves T1...
+BFILL:	PLO	BAUD		; save the fill byte for a moment
+	PUSHR(T1)		; T1 is the loop counter
+	GLO	P1		; compute the length of the block
+	STR	SP		; ...
+	GLO	DP		; ...
+	SM			; ...
+	PLO	T1		; ...
+	GHI	P1		; ...
+	STR	SP		; ...
+	GHI	DP		; ...
+	SMB			; ...
+	PHI	T1		; ...
+	DEC	DP		; and point P1 at the last byte
+	RCOPY(P1,DP)		; ...
+	GLO	T1		; the first trip does the length MOD 16 bytes
+	ANI	$0F		; ...
+	SDI	LOW(BFILLX)	; ... by jumping into the middle
+	PLO	DP		; ...
+	LDI	HIGH(BFILLX)	; ...
+	PHI	DP		; ...
+	GHI	T1		; and the loop count is the length/16
+	SHL \ SHL \ SHL \ SHL	; ...
+	STR	SP		; ...
+	GLO	T1		; ...
+	SHR \ SHR \ SHR \ SHR	; ...
+	OR			; ...
+	PLO	T1		; ...
+	GLO	BAUD		; and the fill byte lives in T1.1
+	PHI	T1		; ...
+	SEX	P1		; STXD stores thru P1
+	SEP	DP		; go fill the block
+	SEX	SP		; back to the stack
+	IRX			; restore T1
+	POPRL(T1)		; ...
+	RETURN			; and we're done
+
+; The fill loop proper, which runs with P=DP and X=P1...
+BFILL1:	GHI	T1		; get the fill byte back
+	STXD \ STXD \ STXD \ STXD	; and store sixteen bytes
+	STXD \ STXD \ STXD \ STXD	; ...
+	STXD \ STXD \ STXD \ STXD	; ...
+	STXD \ STXD \ STXD \ STXD	; ...
+BFILLX:	GLO	T1		; any more to do?
+	BZ	BFILL9		; no - we're done
+	DEC	T1		; yes - count another sixteen
+	BR	BFILL1		; ...
+BFILL9:	SEP	PC		; return to BFILL
+
+;   The jump into the middle of the STXD string only changes the low byte of
+; the PC, so they'd better all be on the same page.  The BR and BZ will catch
+; most problems, but not all...
+#if (HIGH(BFILLX-16) != HIGH(BFILLX))
+	.ECHO	"**** ERROR **** BFILL crosses a page boundary!"
+#endif
 
 	.EJECT
 ;	.SBTTL	Clear Screen (<ESC>E or ^L/FF) Function
@@ -752,26 +709,12 @@ ERASE:	LDI	' '		; fill the screen with a blank character
 
 ;   This is a local routine to home the cursor and fill the screen with the
 ; character contained in D.
-FILL:	PLO	P1		; save the fill character for a while
-	PUSHR(T1)		; save T1 for a temporary register
-	PUSHR(P2)		; we need to use P2 also
-	GLO	P1		; now move the fill character to a safe
-	PLO	T1		;  ... place
+FILL:	PUSHD			; save the fill character for a while
 	CALL(HOME)		; go move the cursor to home
-	RLDI(P1,SCREEN)		; then point to the start of the screen space
-	RLDI(P2,MAXX*MAXY)	; and load the number of characters here
-FILL1:	GLO	T1		; get the filler byte back
-	STR	P1		; put the fill character in this location
-	INC	P1		; and move to the next one
-	DEC	P2		; decrement the counter
-	GLO	P2		; all done?
-	BNZ	FILL1		; nope - keep going
-	GHI	P2		; check both halves
-	BNZ	FILL1		; ...
-	IRX			; restore T1 and P2 before we return
-	POPR(P2)		; ...
-	POPRL(T1)		; ...
-	RETURN			; all done!
+	RLDI(P1,SCREEN)		; then fill from the start of the screen space
+	RLDI(DP,SCREND)		;  ... to the end
+	POPD			; get the fill character back
+	BR	BFILL		; and go do it
 
 	.EJECT
 ;	.SBTTL	Write Characters to the Screen
@@ -851,14 +794,14 @@ ESCAP1:	LDI	0		; set the next state to zero
 	RLDI(DP,CURCHR)		; get the current character back again
 	LDN	DP		; ....
 	SMI	'A'		; is it less than 'A' ?
-	BNF	ESCRET		; bad sequence if it is
+	BNF	ESCAP9		; bad sequence if it is
 	SMI	'Z'-'A'+1	; check the other end of the sequence
-	BDF	ESCRET		; still bad
+	BDF	ESCAP9		; still bad
 	LDN	DP		; get the escape character back again
 	SMI	'A'		; convert to a zero based index
 	CALL(LBRI)		; and dispatch to the right routine
 	.DW	ESCCHR		; ...
-	RETURN			; just return
+ESCAP9:	RETURN			; just return
 
 	.EJECT
 ;	.SBTTL	Raster Test (<ESC>Q) Function
@@ -1070,6 +1013,7 @@ LBRI1:	LDA	DP		; get the high byte of the address
 	PLO	PC		; ...
 	SEP	PC		; and away we go!
 
+
 	.EJECT
 ;	.SBTTL	Interpret Characters
 
@@ -1128,30 +1072,44 @@ VTPUT1:	LDX			; restore the original character
 VTPUT2:	CALL(LBRI)		; branch to the next state in escape processing
 	.DW	ESTATE		; table of escape states
 	BR	VTPUT9		; and return
-
+	
 	.EJECT
 ;	.SBTTL	Output Text String
 
-;   This little routine will pass an entire string of characters to VTPUTC.
-; The pointer to the string is passed inline after the CALL(VTPUTS), and the
-; the string should be terminated by a NULL byte.  It's actually only used
-; internally to this module...
-VTPUTS:	PUSHR(P1)		; save P1
-	LDA	A		; get the address of the string
-	PHI	P1		; save it here
-	LDA	A		; ...
-	PLO	P1		; ...
-
-;   Remember that VTPUTC saves _all_ registers, so we conveniently don't have to
-; worry about saving P1!...
-PUTS1:	LDA	P1		; get the next byte
+;   This routine will send an entire string of characters to the terminal.
+; It's the same as calling VTPUTC for every character, except that the
+; registers are saved only once per string and ordinary printing characters go
+; straight to NORMAL.  Control characters, escape sequences and anything else
+; that's even a little bit special still go thru VTPUTC.  The string is passed
+; in P1 and is terminated by a NULL byte, and P1 is returned pointing past the
+; NULL (just like F_MSG).  All the other registers are preserved...
+VTPUTS_:SEX	SP		; (see the note in VTPUTC)
+	PUSHR(DP)		; save DP
+	PUSHR(P2)		; and P2, which is the string pointer
+	RCOPY(P2,P1)		; ...
+PUTS1:	LDA	P2		; get the next byte
 	BZ	PUTS9		; quit when we find a NULL
-	CALL(VTPUTC)		; otherwise send it out
-	BR	PUTS1		; and keep going
+	PLO	BAUD		; save it for a moment
+	RLDI(DP,ESCSTA)		; are we in the middle of an escape sequence?
+	LDN	DP		; ...
+	BNZ	PUTS2		; yes - let VTPUTC deal with it
+	GLO	BAUD		; is this a plain printing character?
+	SMI	' '		; ...
+	BNF	PUTS2		; no - it's a control character
+	SMI	$7F-' '		; RUBOUT and the eight bit codes go the long
+	BDF	PUTS2		;  ... way too
+	GLO	BAUD		; it's a printing character
+	CALL(NORMAL)		; so just display it
+	BR	PUTS1		; and on to the next one
+PUTS2:	GLO	BAUD		; do this one the hard way
+	CALL(VTPUTC_)		; ...
+	BR	PUTS1		; ...
 
 ; Here when we reach the end of the string...
-PUTS9:	IRX			; restore P1
-	POPRL(P1)		;  ...
+PUTS9:	RCOPY(P1,P2)		; return the updated string pointer
+	IRX			; and restore the registers
+	POPR(P2)		; ...
+	POPRL(DP)		; ...
 	RETURN			; and we're done
 	
 	.EJECT
@@ -1270,15 +1228,8 @@ TEST10:	RLDI(P1,CURSX)		; reset X to our right margin
 
 ; Store 72 spaces in screen memory starting at the current cursor location..
 	CALL(WHERE)		; get the screen buffer address in P1
-	LDI	0		; count the characters stored
-	PLO	DP		; here...
-TEST11:	LDI	' '		; store spaces
-	STR	P1		; ...
-	INC	P1		; ...
-	INC	DP		; count the characters stored
-	GLO	DP		; ...
-	SMI	72		; have we done a line?
-	BL	TEST11		; nope - keep going
+	LDI	72		; and clear 72 characters there
+	CALL(CLRLI1)		; ...
 
 ; Advance to the next line ...
 	RLDI(P1,CURSY)		; get the current Y location
@@ -1286,18 +1237,17 @@ TEST11:	LDI	' '		; store spaces
 	ADI	1		; increment the line number
 	STR	P1		; put it back
 	SMI	22		; have we done 18 lines?
-	BL	TEST10		; nope - go do more
+	LBNF	TEST10		; nope - go do more
 
 ;   Now we have a "frame" of pin cushion symbols with a blank rectangle in the
 ; middle.  Let's fill all that in with demos of the various video attributes,
 ; and the character sets...
-	CALL(VTPUTS)		; first a little self promotion
-	.DW	TSTMS1		;  ...
-	CALL(VTPUTS)		; display the name and version number
-	.DW	RIGHTS		;  ... of this firmware
-	CALL(VTPUTS)		; then display everything else
-	.DW	TSTMS2		; ...
-	RETURN			; and we're done here!
+	RLDI(P1,TSTMS1)		; first a little self promotion
+	CALL(VTPUTS_)		;  ...
+	RLDI(P1,RIGHTS)		; display the name and version number
+	CALL(VTPUTS_)		;  ... of this firmware
+	RLDI(P1,TSTMS2)		; then display everything else
+	LBR	VTPUTS_		; and we're done here!
 
 ; Messages...
 TSTMS1:	.TEXT	"\033Y$'Spare Time Gizmos COSMAC Elf 2000 \000"
@@ -1311,5 +1261,273 @@ TSTMS2:	.TEXT	"\033Y'e\033N@\033Y')NORMAL TEXT\033N UNDERLINED TEXT"
 	.TEXT	"\033Y-I`abcdefghijklmnopqrstuvwxyz{|}~"
 	.DB	0
 
+	.EJECT
+;	.SBTTL	Turn the Display Off and On (Fast Mode)
+
+;   The display DMA and the interrupts take more than half of the CPU's time,
+; which hurts when all you want is for a long RAM test or a BASIC program to
+; finish.  Like the ZX81's FAST mode, VTFAST turns the display off to get all
+; that time back, and then on again when it's wanted.  VTPUTC goes right on
+; updating the frame buffer while the display is off, so nothing is lost - the
+; screen is simply blank until it's turned back on.  Call it with D != 0 to
+; turn the display off, or D == 0 to turn it on.  It returns the old state,
+; also zero for on, in D.  Uses T1 and T2, and turning the display off doesn't
+; change DF (BOOTS depends on that).
+;
+;   STOP DISPLAY stops the DMA, and with it the end of row interrupts, but the
+; 8275 would still interrupt at the end of every frame so that's disabled too.
+; Turning the display back on is just like INIT75 - INTPC and the DMA pointer
+; are loaded for the current TOPLIN before the display is started again.  The
+; CPU's interrupts stay enabled (INIT75 turned them on) while the display is
+; off, and R0 and R1 still belong to us...
+VTFAST_:PLO	T2		; save the new state
+	RLDI(T1,VIDOFF)		; and get the current one
+	LDN	T1		; ...
+	PHI	T2		; ...
+	GLO	T2		; turning it on or off?
+	BZ	VTFAS1		; branch if on
+	GHI	T2		; is it already off?
+	BNZ	VTFAS9		; yes - nothing to do
+	SEX	PC		; stop the display and its DMA
+	OUT	CRTCC		; ...
+	.DB	CRTC_STOP	; ...
+	OUT	CRTCC		; and disable the end of frame interrupt
+	.DB	CRTC_DI		; ...
+	OUT	GPIO		; the bell might be on, and nothing would
+	.DB	SPOFF		;  ... ever turn it off now!
+	SEX	SP		; ...
+	LDI	$FF		; remember that the display is off
+	STR	T1		; ...
+	BR	VTFAS9		; and we're done
+
+; Here to turn the display back on...
+VTFAS1:	GHI	T2		; is it off now?
+	BZ	VTFAS9		; no - nothing to do
+	LDI	0		; it won't be in a moment
+	STR	T1		; ...
+	INT_OFF			; no interrupts while we change R0 and R1
+	RLDI(T1,TOPLIN)		; get the top line on the screen
+	LDN	T1		; ...
+	SHL			; and look up its address in LINTAB
+	ADI	LOW(LINTAB)	; ...
+	PLO	T1		; ...
+	LDI	HIGH(LINTAB)	; ...
+	ADCI	0		; ...
+	PHI	T1		; ...
+	LDA	T1		; that's where the DMA starts
+	PHI	DMAPTR		; ...
+	LDN	T1		; ...
+	PLO	DMAPTR		; ...
+	RLDI(INTPC,VIDISR)	; and the next interrupt is the end of frame
+	SEX	PC		; now start the display the same way INIT75 does
+	OUT	CRTCC		; enable CRTC interrupts
+	.DB	CRTC_EI		;  ...
+	OUT	CRTCC		; preload the counters
+	.DB	CRTC_PRESET	;  ...
+	OUT	CRTCC		; and turn on the video
+	.DB	CRTC_START+3	;  ...
+	INT_ON			; (this leaves X=SP)
+VTFAS9:	GHI	T2		; return the old state
+	RETURN			; ...
+
+	.EJECT
+;	.SBTTL	8275 Interrupt Service
+
+;   The ElfVideo card interrupts the 1802 CPU at the end of every display row
+; and once again at the end of each frame.  For a 24 line display, that's a
+; total of 25 interrupts per frame!  The row interrupt comes from the bus GAL
+; on the video card, not the 8275, and there's no way to turn it off.  The
+; only reason we care about it is that the screen buffer is circular - TOPLIN
+; is the buffer line that's displayed at the top of the screen, and the DMA
+; pointer has to wrap around from SCREND back to SCREEN after the last line in
+; the buffer, wherever that happens to fall on the screen.
+;
+;   Rather than checking the DMA pointer at the end of every row, the end of
+; frame interrupt uses TOPLIN to figure out which row the wrap will happen on
+; and leaves INTPC pointing into a chain of row handlers, ROWCHN, such that
+; exactly 23-TOPLIN of them do nothing before we reach the one, ROWWRP, that
+; wraps the DMA pointer.  Every handler leaves INTPC pointing to the next one
+; when it returns, and the ones that do nothing don't even touch D.  After the
+; wrap INTPC points to VIDISR, which handles the remaining rows and the end of
+; frame.  If a row interrupt is ever lost the chain just ends a row late, and
+; the still pending end of frame interrupt runs through the rest of it to get
+; back to VIDISR, so the worst that can happen is one bad frame.
+;
+;   For the 80x24 display, with 10 scan lines per row and 16 characters of
+; horizontal retrace, a frame is 26 rows or 3939 machine cycles at 1.79MHz, and
+; the DMA steals 1920 of those.  The old ISR took 23 or 29 cycles for every
+; row and 39 for the wrap, about 665 cycles in all per frame.  This one takes
+; 9 cycles for each row before the wrap, 23 for the wrap and 11 for each row
+; after it - a total of about 340 cycles per frame.  That's roughly a quarter
+; more time for the foreground code while the display is on...
+;
+;   All of this must be in one page - the EOF code jumps into the chain with
+; a "PLO INTPC", and everything after the chain uses short branches...
+	.ORG	VIDEO+$700
+
+;   Here's the chain of row handlers.  The end of frame code "returns" to
+; ROWCHN+5*TOPLIN, which is always a "LDXA\ RET" pair that restores D and
+; leaves INTPC pointing at the next handler.  Each handler, when entered from
+; an interrupt, executes "DEC SP\ SAV\ SKP\ RET" and leaves INTPC pointing to
+; the next one.  There are 23 of these - one for each row that can come
+; before the wrap (the wrap always happens on or before the 24th row)...
+#define ROWNUL	DEC SP\ SAV\ SKP\ LDXA\ RET
+ROWCHN:	LDXA			; entry for TOPLIN=0
+	RET			; ...
+	ROWNUL			; [9] row 1 of 23
+	ROWNUL			; [9] row 2
+	ROWNUL			; [9] row 3
+	ROWNUL			; [9] row 4
+	ROWNUL			; [9] row 5
+	ROWNUL			; [9] row 6
+	ROWNUL			; [9] row 7
+	ROWNUL			; [9] row 8
+	ROWNUL			; [9] row 9
+	ROWNUL			; [9] row 10
+	ROWNUL			; [9] row 11
+	ROWNUL			; [9] row 12
+	ROWNUL			; [9] row 13
+	ROWNUL			; [9] row 14
+	ROWNUL			; [9] row 15
+	ROWNUL			; [9] row 16
+	ROWNUL			; [9] row 17
+	ROWNUL			; [9] row 18
+	ROWNUL			; [9] row 19
+	ROWNUL			; [9] row 20
+	ROWNUL			; [9] row 21
+	ROWNUL			; [9] row 22
+	ROWNUL			; [9] row 23
+
+;   The DMA pointer has reached the end of the screen buffer - wrap around to
+; the start.  Note that the code for TOPLIN=0 wraps it too, but in that case
+; it's already at SCREND, so it doesn't matter...
+ROWWRP:	DEC	SP		; [2] make a space on the stack
+	SAV			; [2] and push T (the saved X,P)
+	DEC	SP		; [2] make another spot
+	STXD			; [2] and now save the D register too
+	RLDI(DMAPTR,SCREEN)	; [8] reset the DMA pointer back to the start
+				;     and fall into VIDRET
+
+; Here to exit from the interrupt (and leave the PC pointing to VIDISR!)...
+VIDRET:	INC	SP		; [2] point SP back to the saved D register
+VIDRE1:	LDXA			; [2] restore the D register from the stack
+VIDRT:	RET			; [2] and return from the interrupt
+
+;   Here is the video interrupt service routine for the rows after the wrap
+; and the end of frame.  Note that the only context this saves is X, P and D
+; - be very, very careful not to change anything else, especially DF!!!
+VIDISR:	DEC	SP		; [2] make a space on the stack
+	SAV			; [2] and push T (the saved X,P)
+	B1	EOFISR		; [2] branch for end of frame interrupt
+	BR	VIDRT		; [2] otherwise just return
+
+;   Here for the end of frame interrupt.  In this case we need to compute the
+; address of the first line on the screen, based on TOPLIN, and initialize
+; the DMA pointer to that row in the screen buffer.  The DMA is idle until the
+; first row is fetched during the last row of vertical retrace, so we can use
+; DMAPTR itself as a temporary until then.  The stack frame here is, from the
+; top down, X/P, D, the chain address and DF...
+EOFISR:	DEC	SP		; [2] save the D register
+	STXD			; [2] ...
+	DEC	SP		; [2] leave a space for the chain address
+	INP	CRTCS		; [2] read the status register to clear the IRQ
+	SHLC			; [2] and save DF
+	STR	SP		; [2] ...
+
+;  Increment the frame counter - this is used by the POST to determine whether
+; the interrupts are working, and it's used to keep track of time (e.g. for
+; beeping the beeper) ...
+	RLDI(DMAPTR,FRAME)	; [8] point at FRAME
+	SEX	DMAPTR		; [2] (remember that LDN R0 is really IDL!)
+	LDX			; [2] get the current count
+	ADI	1		; [2] and increment it
+	STR	DMAPTR		; [2] ignoring any carry
+
+;   If the bell timer (BELCNT, which is conveniently located at FRAME+1!) is
+; non-zero, then the GPIO beeper is turned on and we should decrement BELCNT.
+; When BELCNT reaches zero, we turn off the GPIO speaker.  This is used to
+; implement the ^G bell function of the VT52...
+	INC	DMAPTR		; [2] point to BELCNT
+	LDX			; [2]  get the value now
+	BZ	EOFIS1		; [2] just keep going if it's zero
+	SMI	1		; [2] otherwise decrement it
+	STR	DMAPTR		; [2] and update BELCNT
+	BNZ	EOFIS1		; [2] just keep going until it reaches zero
+	SEX	INTPC		; [2] it's done - turn off the speaker now
+	OUT	GPIO		; [2]  ...
+	.DB	SPOFF		; [2] (speaker off function code)
+
+;   Figure out where the next frame enters the row handler chain - that's
+; ROWCHN+5*TOPLIN - and store it on the stack for later...
+EOFIS1:	RLDI(DMAPTR,TOPLIN)	; [8] point to TOPLIN
+	SEX	DMAPTR		; [2] ...
+	LDX			; [2] load the value of TOPLIN
+	SHL			; [2] multiply it by four
+	SHL			; [2] ...
+	ADD			; [2] and add it once more
+	ADI	LOW(ROWCHN)	; [2] index into the chain
+	INC	SP		; [2] store that in the chain address slot
+	STR	SP		; [2] ...
+	DEC	SP		; [2] ...
+
+; Now load the DMA pointer with the address of the top line...
+	LDX			; [2] load TOPLIN again
+	SHL			; [2] multiply it by two
+	ADI	LOW(LINTAB)	; [2] index into the line pointer table
+	PLO	DMAPTR		; [2] save that
+	LDI	HIGH(LINTAB)	; [2] compute the high byte
+	ADCI	0		; [2] with carry
+	PHI	DMAPTR		; [2] ...
+	LDA	DMAPTR		; [2] get the first byte of the line address
+	DEC	SP		; [2] and save it on the stack for a moment
+	STR	SP		; [2] ...
+	LDX			; [2] get the second byte
+	PLO	DMAPTR		; [2] ...
+	SEX	SP		; [2] ...
+	LDXA			; [2] and then the first one again
+	PHI	DMAPTR		; [2] the DMA pointer is ready for the next frame
+
+; Restore DF and jump into the chain to restore D and return...
+	LDXA			; [2] restore DF
+	SHRC			; [2] ...
+	LDXA			; [2] get the chain address
+	PLO	INTPC		; [2] and go there to return
+
+; Make sure all the above really did fit in one page...
+#if (HIGH($) != HIGH(ROWCHN))
+	.ECHO	"**** ERROR **** Video ISR crosses a page boundary!"
+#endif
+
+	.EJECT
+;	.SBTTL	Bell (^G) Function
+
+;   Just like a real terminal, we have a bell that can be sounded by the ^G
+; character.  This is implemented using the speaker and fixed frequency tone
+; generator on the GPIO card - all we have to do is turn it on (easy) and then
+; turn it off again in a little bit (harder!).  To arrange for the speaker
+; to be turned off, we set the location BELCNT to a non-zero value.  When ever
+; BELCNT is non-zero the end of video frame ISR will decrement the counter
+; and, when BELCNT makes the 1->0 transition, turns off the speaker.
+
+;   If the display is off (see VTFAST) there are no frames to time the bell
+; with, so it just doesn't ring...
+BELL:	RLDI(DP,VIDOFF)		; is the display off?
+	LDN	DP		; ...
+	BNZ	BELL1		; yes - no bell
+	OUTI(GPIO,SPTONE)	; turn on the speaker
+	RLDI(DP,BELCNT)		; point to BELCNT
+;  The value we store into BELCNT determines the length of the tone, in frames.
+; About one sixth of a second sounds like a good value...
+	LDI	10		; ...
+	STR	DP		; set BELCNT=30
+BELL1:	RETURN			; that's all we have to do!
+
+;   The bell lives down here, in the leftovers of the ISR page, only because
+; there's no room for it anywhere else.  Make sure we haven't run off the end
+; of our ROM space...
+#if ($ > (VIDEO+$800))
+	.ECHO	"**** ERROR **** Video firmware is too big!"
+#endif
+
 	.EJECT
 	.END